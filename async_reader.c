@@ -0,0 +1,200 @@
+/*
+ *  Copyright (c) 2017 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <stdlib.h>
+
+#include "./async_reader.h"
+#include "./vpx_config.h"
+#include "vpx_util/vpx_thread.h"
+
+struct reader_slot {
+  vpx_image_t img;
+  // Frame storage for Y4M input, which converts into a buffer of its own
+  // layout rather than into an allocated image.
+  unsigned char *buf;
+  int64_t position;
+};
+
+struct async_reader {
+  struct VpxInputContext *input;
+  struct reader_slot *slots;
+  int num_slots;
+  int limit;
+  int frames_read;
+  // Index of the oldest filled slot and the number of filled slots. The
+  // oldest slot is the one handed out by async_reader_read_frame() while
+  // |held| is set.
+  int head;
+  int count;
+  int held;
+  int eof;
+  int64_t position;
+  int threaded;
+#if CONFIG_MULTITHREAD
+  int stop;
+  pthread_t thread;
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+#endif
+};
+
+static int fill_slot(struct async_reader *reader, struct reader_slot *slot) {
+  struct VpxInputContext *const input = reader->input;
+  int ok;
+
+  if (reader->limit && reader->frames_read >= reader->limit) return 0;
+
+  if (input->file_type == FILE_TYPE_Y4M) {
+    unsigned char *const dst_buf = input->y4m.dst_buf;
+    input->y4m.dst_buf = slot->buf;
+    ok = y4m_input_fetch_frame(&input->y4m, input->file, &slot->img) > 0;
+    input->y4m.dst_buf = dst_buf;
+  } else {
+    ok = !read_yuv_frame(input, &slot->img);
+  }
+  if (!ok) return 0;
+
+  slot->position = input->length ? ftello(input->file) : -1;
+  ++reader->frames_read;
+  return 1;
+}
+
+#if CONFIG_MULTITHREAD
+static THREADFN reader_thread(void *arg) {
+  struct async_reader *const reader = (struct async_reader *)arg;
+
+  for (;;) {
+    struct reader_slot *slot;
+    int ok;
+
+    pthread_mutex_lock(&reader->mutex);
+    while (reader->count == reader->num_slots && !reader->stop)
+      pthread_cond_wait(&reader->cond, &reader->mutex);
+    if (reader->stop) {
+      pthread_mutex_unlock(&reader->mutex);
+      break;
+    }
+    slot = &reader->slots[(reader->head + reader->count) % reader->num_slots];
+    pthread_mutex_unlock(&reader->mutex);
+
+    ok = fill_slot(reader, slot);
+
+    pthread_mutex_lock(&reader->mutex);
+    if (ok)
+      ++reader->count;
+    else
+      reader->eof = 1;
+    pthread_cond_signal(&reader->cond);
+    pthread_mutex_unlock(&reader->mutex);
+    if (!ok) break;
+  }
+  return THREAD_RETURN(NULL);
+}
+#endif  // CONFIG_MULTITHREAD
+
+struct async_reader *async_reader_open(struct VpxInputContext *input,
+                                       int num_buffers, int limit) {
+  struct async_reader *reader = calloc(1, sizeof(*reader));
+  int i;
+
+  if (!reader) fatal("Failed to allocate input reader");
+#if !CONFIG_MULTITHREAD
+  num_buffers = 1;
+#endif
+  reader->input = input;
+  reader->num_slots = num_buffers > 1 ? num_buffers : 1;
+  reader->limit = limit;
+  reader->slots = calloc(reader->num_slots, sizeof(*reader->slots));
+  if (!reader->slots) fatal("Failed to allocate input reader");
+
+  for (i = 0; i < reader->num_slots; ++i) {
+    struct reader_slot *const slot = &reader->slots[i];
+    if (input->file_type == FILE_TYPE_Y4M) {
+      slot->buf = malloc(input->y4m.dst_buf_sz);
+      if (!slot->buf) fatal("Failed to allocate input frame buffer");
+    } else if (!vpx_img_alloc(&slot->img, input->fmt, input->width,
+                              input->height, 32)) {
+      fatal("Failed to allocate input frame buffer");
+    }
+  }
+
+#if CONFIG_MULTITHREAD
+  if (reader->num_slots > 1) {
+    pthread_mutex_init(&reader->mutex, NULL);
+    pthread_cond_init(&reader->cond, NULL);
+    reader->threaded = !pthread_create(&reader->thread, NULL, reader_thread,
+                                       reader);
+    if (!reader->threaded) {
+      pthread_cond_destroy(&reader->cond);
+      pthread_mutex_destroy(&reader->mutex);
+    }
+  }
+#endif
+  return reader;
+}
+
+vpx_image_t *async_reader_read_frame(struct async_reader *reader) {
+  struct reader_slot *slot = NULL;
+
+  if (reader->threaded) {
+#if CONFIG_MULTITHREAD
+    pthread_mutex_lock(&reader->mutex);
+    if (reader->held) {
+      reader->head = (reader->head + 1) % reader->num_slots;
+      --reader->count;
+      reader->held = 0;
+      pthread_cond_signal(&reader->cond);
+    }
+    while (!reader->count && !reader->eof)
+      pthread_cond_wait(&reader->cond, &reader->mutex);
+    if (reader->count) {
+      slot = &reader->slots[reader->head];
+      reader->held = 1;
+    }
+    pthread_mutex_unlock(&reader->mutex);
+#endif
+  } else if (!reader->eof) {
+    reader->eof = !fill_slot(reader, &reader->slots[0]);
+    if (!reader->eof) slot = &reader->slots[0];
+  }
+
+  if (!slot) return NULL;
+  reader->position = slot->position;
+  return &slot->img;
+}
+
+int64_t async_reader_position(const struct async_reader *reader) {
+  return reader->position;
+}
+
+void async_reader_close(struct async_reader *reader) {
+  int i;
+
+  if (!reader) return;
+#if CONFIG_MULTITHREAD
+  if (reader->threaded) {
+    pthread_mutex_lock(&reader->mutex);
+    reader->stop = 1;
+    pthread_cond_signal(&reader->cond);
+    pthread_mutex_unlock(&reader->mutex);
+    pthread_join(reader->thread, NULL);
+    pthread_cond_destroy(&reader->cond);
+    pthread_mutex_destroy(&reader->mutex);
+  }
+#endif
+  for (i = 0; i < reader->num_slots; ++i) {
+    if (reader->input->file_type == FILE_TYPE_Y4M)
+      free(reader->slots[i].buf);
+    else
+      vpx_img_free(&reader->slots[i].img);
+  }
+  free(reader->slots);
+  free(reader);
+}
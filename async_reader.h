@@ -0,0 +1,47 @@
+/*
+ *  Copyright (c) 2017 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef ASYNC_READER_H_
+#define ASYNC_READER_H_
+
+#include "vpx/vpx_image.h"
+#include "vpx/vpx_integer.h"
+#include "./tools_common.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct async_reader;
+
+// Starts reading raw or Y4M frames from an opened input into a ring of
+// |num_buffers| preallocated images. With CONFIG_MULTITHREAD the frames are
+// read, and Y4M chroma converted, on a separate thread that stays up to
+// |num_buffers| - 1 frames ahead of the caller. At most |limit| frames are
+// read when |limit| is non-zero. The input must not be accessed directly until
+// the reader is closed.
+struct async_reader *async_reader_open(struct VpxInputContext *input,
+                                       int num_buffers, int limit);
+
+// Returns the next frame, or NULL at the end of the input. The image remains
+// valid until the next call.
+vpx_image_t *async_reader_read_frame(struct async_reader *reader);
+
+// Returns the input file position just after the last frame returned, or -1
+// if the input is not seekable.
+int64_t async_reader_position(const struct async_reader *reader);
+
+void async_reader_close(struct async_reader *reader);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // ASYNC_READER_H_
@@ -0,0 +1,145 @@
+/*
+ *  Copyright (c) 2017 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <stdlib.h>
+
+#include "./async_writer.h"
+#include "./tools_common.h"
+#include "./vpx_config.h"
+#include "vpx_util/vpx_thread.h"
+
+struct async_writer {
+  unsigned char *jobs;
+  size_t job_size;
+  int num_jobs;
+  async_writer_fn write_job;
+  async_writer_fn free_job;
+  void *priv;
+  // Index of the oldest queued job and the number of queued jobs.
+  int head;
+  int count;
+  int threaded;
+#if CONFIG_MULTITHREAD
+  int stop;
+  pthread_t thread;
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+#endif
+};
+
+static void *get_job(const struct async_writer *writer, int index) {
+  return writer->jobs + (index % writer->num_jobs) * writer->job_size;
+}
+
+#if CONFIG_MULTITHREAD
+static THREADFN writer_thread(void *arg) {
+  struct async_writer *const writer = (struct async_writer *)arg;
+
+  pthread_mutex_lock(&writer->mutex);
+  for (;;) {
+    while (!writer->count && !writer->stop)
+      pthread_cond_wait(&writer->cond, &writer->mutex);
+    if (!writer->count) break;
+    pthread_mutex_unlock(&writer->mutex);
+
+    writer->write_job(writer->priv, get_job(writer, writer->head));
+
+    pthread_mutex_lock(&writer->mutex);
+    writer->head = (writer->head + 1) % writer->num_jobs;
+    --writer->count;
+    pthread_cond_signal(&writer->cond);
+  }
+  pthread_mutex_unlock(&writer->mutex);
+  return THREAD_RETURN(NULL);
+}
+#endif  // CONFIG_MULTITHREAD
+
+struct async_writer *async_writer_open(int num_jobs, size_t job_size,
+                                       async_writer_fn write_job,
+                                       async_writer_fn free_job, void *priv) {
+  struct async_writer *writer = calloc(1, sizeof(*writer));
+
+  if (!writer) fatal("Failed to allocate output writer");
+#if !CONFIG_MULTITHREAD
+  num_jobs = 1;
+#endif
+  writer->num_jobs = num_jobs > 1 ? num_jobs : 1;
+  writer->job_size = job_size;
+  writer->write_job = write_job;
+  writer->free_job = free_job;
+  writer->priv = priv;
+  writer->jobs = calloc(writer->num_jobs, job_size);
+  if (!writer->jobs) fatal("Failed to allocate output writer");
+
+#if CONFIG_MULTITHREAD
+  if (writer->num_jobs > 1) {
+    pthread_mutex_init(&writer->mutex, NULL);
+    pthread_cond_init(&writer->cond, NULL);
+    writer->threaded =
+        !pthread_create(&writer->thread, NULL, writer_thread, writer);
+    if (!writer->threaded) {
+      pthread_cond_destroy(&writer->cond);
+      pthread_mutex_destroy(&writer->mutex);
+    }
+  }
+#endif
+  return writer;
+}
+
+void *async_writer_next_job(struct async_writer *writer) {
+#if CONFIG_MULTITHREAD
+  if (writer->threaded) {
+    int index;
+    pthread_mutex_lock(&writer->mutex);
+    while (writer->count == writer->num_jobs)
+      pthread_cond_wait(&writer->cond, &writer->mutex);
+    index = writer->head + writer->count;
+    pthread_mutex_unlock(&writer->mutex);
+    return get_job(writer, index);
+  }
+#endif
+  return get_job(writer, 0);
+}
+
+void async_writer_submit(struct async_writer *writer) {
+  if (writer->threaded) {
+#if CONFIG_MULTITHREAD
+    pthread_mutex_lock(&writer->mutex);
+    ++writer->count;
+    pthread_cond_signal(&writer->cond);
+    pthread_mutex_unlock(&writer->mutex);
+#endif
+  } else {
+    writer->write_job(writer->priv, get_job(writer, 0));
+  }
+}
+
+void async_writer_close(struct async_writer *writer) {
+  int i;
+
+  if (!writer) return;
+#if CONFIG_MULTITHREAD
+  if (writer->threaded) {
+    pthread_mutex_lock(&writer->mutex);
+    writer->stop = 1;
+    pthread_cond_signal(&writer->cond);
+    pthread_mutex_unlock(&writer->mutex);
+    pthread_join(writer->thread, NULL);
+    pthread_cond_destroy(&writer->cond);
+    pthread_mutex_destroy(&writer->mutex);
+  }
+#endif
+  if (writer->free_job) {
+    for (i = 0; i < writer->num_jobs; ++i)
+      writer->free_job(writer->priv, get_job(writer, i));
+  }
+  free(writer->jobs);
+  free(writer);
+}
@@ -0,0 +1,47 @@
+/*
+ *  Copyright (c) 2017 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef ASYNC_WRITER_H_
+#define ASYNC_WRITER_H_
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct async_writer;
+
+// Called with the writer's private data and a job.
+typedef void (*async_writer_fn)(void *priv, void *job);
+
+// Creates a queue of |num_jobs| zero-initialized jobs of |job_size| bytes.
+// Submitted jobs are passed to |write_job| in submission order, on a separate
+// thread with CONFIG_MULTITHREAD and synchronously otherwise. Job memory is
+// recycled, so buffers a job owns can be reused by the next job that gets the
+// same slot; |free_job| releases them when the writer is closed.
+struct async_writer *async_writer_open(int num_jobs, size_t job_size,
+                                       async_writer_fn write_job,
+                                       async_writer_fn free_job, void *priv);
+
+// Returns a job to fill in, waiting for one to be written if all are queued.
+void *async_writer_next_job(struct async_writer *writer);
+
+// Queues the job returned by the last async_writer_next_job() call.
+void async_writer_submit(struct async_writer *writer);
+
+// Writes all queued jobs and frees the writer.
+void async_writer_close(struct async_writer *writer);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // ASYNC_WRITER_H_
@@ -0,0 +1,119 @@
+/*
+ *  Copyright (c) 2017 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#include <sys/time.h>
+#endif
+
+#include "./bench_stats.h"
+#include "./tools_common.h"
+
+void latency_stats_add(struct latency_stats *stats, int64_t usec) {
+  if (stats->count == stats->capacity) {
+    const int capacity = stats->capacity ? 2 * stats->capacity : 256;
+    int64_t *const samples =
+        realloc(stats->samples, capacity * sizeof(*stats->samples));
+    if (!samples) fatal("Failed to allocate latency samples");
+    stats->samples = samples;
+    stats->capacity = capacity;
+  }
+  stats->samples[stats->count++] = usec;
+}
+
+void latency_stats_merge(struct latency_stats *dst,
+                         const struct latency_stats *src) {
+  int i;
+  for (i = 0; i < src->count; ++i) latency_stats_add(dst, src->samples[i]);
+}
+
+static int compare_int64(const void *a, const void *b) {
+  const int64_t x = *(const int64_t *)a;
+  const int64_t y = *(const int64_t *)b;
+  return (x > y) - (x < y);
+}
+
+int64_t latency_stats_percentile(struct latency_stats *stats, int percentile) {
+  int rank;
+
+  if (!stats->count) return 0;
+  qsort(stats->samples, stats->count, sizeof(*stats->samples), compare_int64);
+  rank = (int)(((int64_t)percentile * stats->count + 99) / 100);
+  if (rank < 1) rank = 1;
+  if (rank > stats->count) rank = stats->count;
+  return stats->samples[rank - 1];
+}
+
+void latency_stats_reset(struct latency_stats *stats) { stats->count = 0; }
+
+void latency_stats_free(struct latency_stats *stats) {
+  free(stats->samples);
+  memset(stats, 0, sizeof(*stats));
+}
+
+int parse_bench_list(const char *list, int *values, int max_values) {
+  const char *p = list;
+  int count = 0;
+
+  while (*p) {
+    char *end;
+    const long value = strtol(p, &end, 10);
+    if (end == p || (*end && *end != ',') || count == max_values) return -1;
+    values[count++] = (int)value;
+    if (!*end) break;
+    // A separator must be followed by another value.
+    if (!end[1]) return -1;
+    p = end + 1;
+  }
+  return count;
+}
+
+int64_t get_process_cpu_usec(void) {
+#if defined(_WIN32)
+  FILETIME creation, exit, kernel, user;
+  ULARGE_INTEGER k, u;
+
+  if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user))
+    return -1;
+  k.LowPart = kernel.dwLowDateTime;
+  k.HighPart = kernel.dwHighDateTime;
+  u.LowPart = user.dwLowDateTime;
+  u.HighPart = user.dwHighDateTime;
+  // FILETIME is in units of 100 nanoseconds.
+  return (int64_t)((k.QuadPart + u.QuadPart) / 10);
+#else
+  struct rusage usage;
+
+  if (getrusage(RUSAGE_SELF, &usage)) return -1;
+  return (int64_t)(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000 +
+         usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+#endif
+}
+
+int64_t get_peak_rss_kb(void) {
+#if defined(_WIN32)
+  return -1;
+#else
+  struct rusage usage;
+
+  if (getrusage(RUSAGE_SELF, &usage)) return -1;
+#if defined(__APPLE__)
+  // Reported in bytes rather than kilobytes.
+  return (int64_t)usage.ru_maxrss / 1024;
+#else
+  return (int64_t)usage.ru_maxrss;
+#endif
+#endif
+}
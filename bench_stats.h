@@ -0,0 +1,57 @@
+/*
+ *  Copyright (c) 2017 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef BENCH_STATS_H_
+#define BENCH_STATS_H_
+
+#include "vpx/vpx_integer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Per-frame latencies, in microseconds, collected by the --bench modes.
+struct latency_stats {
+  int64_t *samples;
+  int count;
+  int capacity;
+};
+
+void latency_stats_add(struct latency_stats *stats, int64_t usec);
+
+// Appends the samples of |src| to |dst|.
+void latency_stats_merge(struct latency_stats *dst,
+                         const struct latency_stats *src);
+
+// Returns the nearest-rank |percentile| (0 to 100) of the samples, or 0 when
+// there are none. Sorts the samples.
+int64_t latency_stats_percentile(struct latency_stats *stats, int percentile);
+
+void latency_stats_reset(struct latency_stats *stats);
+
+void latency_stats_free(struct latency_stats *stats);
+
+// Parses a comma separated list of at most |max_values| integers into
+// |values|. Returns the number of values, or -1 if the list is malformed.
+int parse_bench_list(const char *list, int *values, int max_values);
+
+// Returns the user plus system CPU time consumed by the process so far, or -1
+// if it is not available.
+int64_t get_process_cpu_usec(void);
+
+// Returns the peak resident set size of the process so far in kilobytes, or -1
+// if it is not available.
+int64_t get_peak_rss_kb(void);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // BENCH_STATS_H_
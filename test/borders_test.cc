@@ -37,6 +37,7 @@ class BordersTest
       encoder->Control(VP8E_SET_ARNR_MAXFRAMES, 7);
       encoder->Control(VP8E_SET_ARNR_STRENGTH, 5);
       encoder->Control(VP8E_SET_ARNR_TYPE, 3);
+      encoder->Control(VP9E_SET_ROW_MT, cfg_.g_threads > 1);
     }
   }
 
@@ -79,6 +80,23 @@ TEST_P(BordersTest, TestLowBitrate) {
   ASSERT_NO_FATAL_FAILURE(RunLoop(&video));
 }
 
+TEST_P(BordersTest, TestEncodeHighBitrateMultiThreaded) {
+  // Same as TestEncodeHighBitrate with the loop filter, and with it the
+  // extension of the reconstructed frame's borders, spread over several
+  // worker threads.
+  cfg_.g_threads = 4;
+  cfg_.g_lag_in_frames = 25;
+  cfg_.rc_2pass_vbr_minsection_pct = 5;
+  cfg_.rc_2pass_vbr_maxsection_pct = 2000;
+  cfg_.rc_target_bitrate = 2000;
+  cfg_.rc_max_quantizer = 10;
+
+  ::libvpx_test::I420VideoSource video("hantro_odd.yuv", 208, 144, 30, 1, 0,
+                                       40);
+
+  ASSERT_NO_FATAL_FAILURE(RunLoop(&video));
+}
+
 VP9_INSTANTIATE_TEST_CASE(BordersTest,
                           ::testing::Values(::libvpx_test::kTwoPassGood));
 }  // namespace
@@ -914,6 +914,60 @@ TEST_P(ConvolveTest, CheckScalingFiltering) {
   }
 }
 
+/* Compares the scaled 2D filter against the C reference on random input for
+   every filter bank, initial fractional position and scaling step. */
+TEST_P(ConvolveTest, ScaledMatchesReference) {
+  uint8_t *const in = input();
+  uint8_t *const out = output();
+#if CONFIG_VP9_HIGHBITDEPTH
+  uint8_t ref8[kOutputStride * kMaxDimension];
+  uint16_t ref16[kOutputStride * kMaxDimension];
+  uint8_t *const ref = UUT_->use_highbd_ == 0 ? ref8 : CAST_TO_BYTEPTR(ref16);
+#else
+  uint8_t ref[kOutputStride * kMaxDimension];
+#endif
+
+  for (int filter_bank = 0; filter_bank < kNumFilterBanks; ++filter_bank) {
+    const InterpKernel *filters =
+        vp9_filter_kernels[static_cast<INTERP_FILTER>(filter_bank)];
+
+    for (int frac = 0; frac < 16; ++frac) {
+      for (int step = 1; step <= 32; ++step) {
+        const int16_t *const filter_x = filters[frac];
+        const int16_t *const filter_y = filters[(frac + step) & SUBPEL_MASK];
+#if CONFIG_VP9_HIGHBITDEPTH
+        if (UUT_->use_highbd_ != 0) {
+          vpx_highbd_convolve8_c(CAST_TO_SHORTPTR(in), kInputStride,
+                                 CAST_TO_SHORTPTR(ref), kOutputStride, filter_x,
+                                 step, filter_y, step, Width(), Height(),
+                                 UUT_->use_highbd_);
+        } else {
+          vpx_scaled_2d_c(in, kInputStride, ref, kOutputStride, filter_x,
+                          step, filter_y, step, Width(), Height());
+        }
+#else
+        vpx_scaled_2d_c(in, kInputStride, ref, kOutputStride, filter_x, step,
+                        filter_y, step, Width(), Height());
+#endif
+        ASM_REGISTER_STATE_CHECK(
+            UUT_->shv8_[0](in, kInputStride, out, kOutputStride, filter_x,
+                           step, filter_y, step, Width(), Height()));
+
+        CheckGuardBlocks();
+
+        for (int y = 0; y < Height(); ++y) {
+          for (int x = 0; x < Width(); ++x) {
+            ASSERT_EQ(lookup(ref, y * kOutputStride + x),
+                      lookup(out, y * kOutputStride + x))
+                << "mismatch at (" << x << "," << y << "), filter bank "
+                << filter_bank << ", frac " << frac << ", step " << step;
+          }
+        }
+      }
+    }
+  }
+}
+
 using std::tr1::make_tuple;
 
 #if CONFIG_VP9_HIGHBITDEPTH
@@ -981,8 +1035,18 @@ WRAP(convolve8_vert_avx2, 12)
 WRAP(convolve8_avg_avx2, 12)
 WRAP(convolve8_avg_horiz_avx2, 12)
 WRAP(convolve8_avg_vert_avx2, 12)
+
+WRAP(scaled_2d_avx2, 8)
+WRAP(scaled_2d_avx2, 10)
+WRAP(scaled_2d_avx2, 12)
 #endif  // HAVE_AVX2
 
+#if HAVE_SSE4_1
+WRAP(scaled_2d_sse4_1, 8)
+WRAP(scaled_2d_sse4_1, 10)
+WRAP(scaled_2d_sse4_1, 12)
+#endif  // HAVE_SSE4_1
+
 #if HAVE_NEON
 WRAP(convolve_copy_neon, 8)
 WRAP(convolve_avg_neon, 8)
@@ -1128,6 +1192,35 @@ INSTANTIATE_TEST_CASE_P(SSSE3, ConvolveTest,
                         ::testing::ValuesIn(kArrayConvolve8_ssse3));
 #endif
 
+#if HAVE_SSE4_1 && CONFIG_VP9_HIGHBITDEPTH
+const ConvolveFunctions convolve8_sse4_1(
+    wrap_convolve_copy_c_8, wrap_convolve_avg_c_8, wrap_convolve8_horiz_c_8,
+    wrap_convolve8_avg_horiz_c_8, wrap_convolve8_vert_c_8,
+    wrap_convolve8_avg_vert_c_8, wrap_convolve8_c_8, wrap_convolve8_avg_c_8,
+    wrap_convolve8_horiz_c_8, wrap_convolve8_avg_horiz_c_8,
+    wrap_convolve8_vert_c_8, wrap_convolve8_avg_vert_c_8,
+    wrap_scaled_2d_sse4_1_8, wrap_convolve8_avg_c_8, 8);
+const ConvolveFunctions convolve10_sse4_1(
+    wrap_convolve_copy_c_10, wrap_convolve_avg_c_10, wrap_convolve8_horiz_c_10,
+    wrap_convolve8_avg_horiz_c_10, wrap_convolve8_vert_c_10,
+    wrap_convolve8_avg_vert_c_10, wrap_convolve8_c_10, wrap_convolve8_avg_c_10,
+    wrap_convolve8_horiz_c_10, wrap_convolve8_avg_horiz_c_10,
+    wrap_convolve8_vert_c_10, wrap_convolve8_avg_vert_c_10,
+    wrap_scaled_2d_sse4_1_10, wrap_convolve8_avg_c_10, 10);
+const ConvolveFunctions convolve12_sse4_1(
+    wrap_convolve_copy_c_12, wrap_convolve_avg_c_12, wrap_convolve8_horiz_c_12,
+    wrap_convolve8_avg_horiz_c_12, wrap_convolve8_vert_c_12,
+    wrap_convolve8_avg_vert_c_12, wrap_convolve8_c_12, wrap_convolve8_avg_c_12,
+    wrap_convolve8_horiz_c_12, wrap_convolve8_avg_horiz_c_12,
+    wrap_convolve8_vert_c_12, wrap_convolve8_avg_vert_c_12,
+    wrap_scaled_2d_sse4_1_12, wrap_convolve8_avg_c_12, 12);
+const ConvolveParam kArrayConvolve8_sse4_1[] = { ALL_SIZES(convolve8_sse4_1),
+                                                 ALL_SIZES(convolve10_sse4_1),
+                                                 ALL_SIZES(convolve12_sse4_1) };
+INSTANTIATE_TEST_CASE_P(SSE4_1, ConvolveTest,
+                        ::testing::ValuesIn(kArrayConvolve8_sse4_1));
+#endif  // HAVE_SSE4_1 && CONFIG_VP9_HIGHBITDEPTH
+
 #if HAVE_AVX2
 #if CONFIG_VP9_HIGHBITDEPTH
 const ConvolveFunctions convolve8_avx2(
@@ -1136,23 +1229,24 @@ const ConvolveFunctions convolve8_avx2(
     wrap_convolve8_vert_avx2_8, wrap_convolve8_avg_vert_avx2_8,
     wrap_convolve8_avx2_8, wrap_convolve8_avg_avx2_8, wrap_convolve8_horiz_c_8,
     wrap_convolve8_avg_horiz_c_8, wrap_convolve8_vert_c_8,
-    wrap_convolve8_avg_vert_c_8, wrap_convolve8_c_8, wrap_convolve8_avg_c_8, 8);
+    wrap_convolve8_avg_vert_c_8, wrap_scaled_2d_avx2_8, wrap_convolve8_avg_c_8,
+    8);
 const ConvolveFunctions convolve10_avx2(
     wrap_convolve_copy_avx2_10, wrap_convolve_avg_avx2_10,
     wrap_convolve8_horiz_avx2_10, wrap_convolve8_avg_horiz_avx2_10,
     wrap_convolve8_vert_avx2_10, wrap_convolve8_avg_vert_avx2_10,
     wrap_convolve8_avx2_10, wrap_convolve8_avg_avx2_10,
     wrap_convolve8_horiz_c_10, wrap_convolve8_avg_horiz_c_10,
-    wrap_convolve8_vert_c_10, wrap_convolve8_avg_vert_c_10, wrap_convolve8_c_10,
-    wrap_convolve8_avg_c_10, 10);
+    wrap_convolve8_vert_c_10, wrap_convolve8_avg_vert_c_10,
+    wrap_scaled_2d_avx2_10, wrap_convolve8_avg_c_10, 10);
 const ConvolveFunctions convolve12_avx2(
     wrap_convolve_copy_avx2_12, wrap_convolve_avg_avx2_12,
     wrap_convolve8_horiz_avx2_12, wrap_convolve8_avg_horiz_avx2_12,
     wrap_convolve8_vert_avx2_12, wrap_convolve8_avg_vert_avx2_12,
     wrap_convolve8_avx2_12, wrap_convolve8_avg_avx2_12,
     wrap_convolve8_horiz_c_12, wrap_convolve8_avg_horiz_c_12,
-    wrap_convolve8_vert_c_12, wrap_convolve8_avg_vert_c_12, wrap_convolve8_c_12,
-    wrap_convolve8_avg_c_12, 12);
+    wrap_convolve8_vert_c_12, wrap_convolve8_avg_vert_c_12,
+    wrap_scaled_2d_avx2_12, wrap_convolve8_avg_c_12, 12);
 const ConvolveParam kArrayConvolve8_avx2[] = { ALL_SIZES(convolve8_avx2),
                                                ALL_SIZES(convolve10_avx2),
                                                ALL_SIZES(convolve12_avx2) };
@@ -1164,7 +1258,7 @@ const ConvolveFunctions convolve8_avx2(
     vpx_convolve8_avg_horiz_ssse3, vpx_convolve8_vert_avx2,
     vpx_convolve8_avg_vert_ssse3, vpx_convolve8_avx2, vpx_convolve8_avg_ssse3,
     vpx_scaled_horiz_c, vpx_scaled_avg_horiz_c, vpx_scaled_vert_c,
-    vpx_scaled_avg_vert_c, vpx_scaled_2d_c, vpx_scaled_avg_2d_c, 0);
+    vpx_scaled_avg_vert_c, vpx_scaled_2d_avx2, vpx_scaled_avg_2d_c, 0);
 const ConvolveParam kArrayConvolve8_avx2[] = { ALL_SIZES(convolve8_avx2) };
 INSTANTIATE_TEST_CASE_P(AVX2, ConvolveTest,
                         ::testing::ValuesIn(kArrayConvolve8_avx2));
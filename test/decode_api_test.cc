@@ -170,6 +170,43 @@ TEST(DecodeAPI, Vp9PeekSI) {
               vpx_codec_peek_stream_info(codec, data, data_sz, &si));
   }
 }
+
+TEST(DecodeAPI, Vp9FrameStats) {
+  const vpx_codec_iface_t *const codec = &vpx_codec_vp9_dx_algo;
+  libvpx_test::IVFVideoSource video("vp90-2-09-subpixel-00.ivf");
+  video.Init();
+  video.Begin();
+  ASSERT_TRUE(!HasFailure());
+
+  vpx_codec_ctx_t dec;
+  vpx_dec_frame_stats_t stats;
+  EXPECT_EQ(VPX_CODEC_OK, vpx_codec_dec_init(&dec, codec, NULL, 0));
+  const uint32_t frame_size = static_cast<uint32_t>(video.frame_size());
+  EXPECT_EQ(VPX_CODEC_OK,
+            vpx_codec_decode(&dec, video.cxdata(), frame_size, NULL, 0));
+  vpx_codec_iter_t iter = NULL;
+  EXPECT_TRUE(vpx_codec_get_frame(&dec, &iter) != NULL);
+
+#if CONFIG_STAGE_TIMING
+  EXPECT_EQ(VPX_CODEC_INVALID_PARAM,
+            vpx_codec_control(&dec, VP9D_GET_FRAME_STATS,
+                              static_cast<vpx_dec_frame_stats_t *>(NULL)));
+  ASSERT_EQ(VPX_CODEC_OK,
+            vpx_codec_control(&dec, VP9D_GET_FRAME_STATS, &stats));
+  EXPECT_EQ(1, stats.num_tiles);
+  uint32_t blocks = 0;
+  for (int i = 0; i < VPX_DEC_STATS_BLOCK_SIZES; ++i) blocks += stats.blocks[i];
+  EXPECT_GT(blocks, 0u);
+  EXPECT_LE(stats.skip_blocks, blocks);
+  EXPECT_GE(stats.header_us, 0);
+  EXPECT_GE(stats.tile_decode_us, 0);
+#else
+  EXPECT_EQ(VPX_CODEC_INCAPABLE,
+            vpx_codec_control(&dec, VP9D_GET_FRAME_STATS, &stats));
+#endif
+
+  EXPECT_EQ(VPX_CODEC_OK, vpx_codec_destroy(&dec));
+}
 #endif  // CONFIG_VP9_DECODER
 
 TEST(DecodeAPI, HighBitDepthCapability) {
@@ -8,9 +8,17 @@
  *  be found in the AUTHORS file in the root of the source tree.
  */
 
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
 #include "third_party/googletest/src/include/gtest/gtest.h"
 
 #include "./vpx_config.h"
+#include "test/codec_factory.h"
+#include "test/encode_test_driver.h"
+#include "test/video_source.h"
 #include "vpx/vp8cx.h"
 #include "vpx/vpx_encoder.h"
 
@@ -79,4 +87,532 @@ TEST(EncodeAPI, HighBitDepthCapability) {
 #endif
 }
 
+#if CONFIG_VP9_ENCODER
+TEST(EncodeAPI, StageTiming) {
+  uint8_t buf[64 * 64 * 3 / 2] = { 0 };
+  vpx_image_t img;
+  vpx_codec_ctx_t enc;
+  vpx_codec_enc_cfg_t cfg;
+  vpx_stage_timing_t timing;
+
+  EXPECT_EQ(&img, vpx_img_wrap(&img, VPX_IMG_FMT_I420, 64, 64, 1, buf));
+  EXPECT_EQ(VPX_CODEC_OK,
+            vpx_codec_enc_config_default(&vpx_codec_vp9_cx_algo, &cfg, 0));
+  cfg.g_w = 64;
+  cfg.g_h = 64;
+  cfg.g_lag_in_frames = 0;
+  EXPECT_EQ(VPX_CODEC_OK,
+            vpx_codec_enc_init(&enc, &vpx_codec_vp9_cx_algo, &cfg, 0));
+
+#if CONFIG_STAGE_TIMING
+  EXPECT_EQ(VPX_CODEC_INVALID_PARAM,
+            vpx_codec_control(&enc, VP9E_GET_STAGE_TIMING,
+                              static_cast<vpx_stage_timing_t *>(NULL)));
+  // Enough frames for some stage to take a measurable time.
+  const int kFrames = 10;
+  int64_t max_stage_us = 0;
+  for (int frame = 0; frame < kFrames; ++frame) {
+    for (int i = 0; i < NELEMENTS(buf); ++i) {
+      buf[i] = static_cast<uint8_t>(i % 64 * (frame + 1) + i / 64);
+    }
+    EXPECT_EQ(VPX_CODEC_OK,
+              vpx_codec_encode(&enc, &img, frame, 1, 0, VPX_DL_REALTIME));
+    EXPECT_EQ(VPX_CODEC_OK,
+              vpx_codec_control(&enc, VP9E_GET_STAGE_TIMING, &timing));
+    EXPECT_GT(timing.total_us, 0);
+    // The lookahead copy is the only stage timed outside of total_us.
+    int64_t stage_sum_us = 0;
+    for (int i = 0; i < VPX_ENC_STAGE_COUNT; ++i) {
+      if (i != VPX_ENC_STAGE_LOOKAHEAD) stage_sum_us += timing.stage_us[i];
+      if (timing.stage_us[i] > max_stage_us) max_stage_us = timing.stage_us[i];
+    }
+    EXPECT_LE(stage_sum_us, timing.total_us);
+  }
+  EXPECT_GT(max_stage_us, 0);
+#else
+  EXPECT_EQ(VPX_CODEC_OK,
+            vpx_codec_encode(&enc, &img, 0, 1, 0, VPX_DL_REALTIME));
+  EXPECT_EQ(VPX_CODEC_INCAPABLE,
+            vpx_codec_control(&enc, VP9E_GET_STAGE_TIMING, &timing));
+#endif
+
+  EXPECT_EQ(VPX_CODEC_OK, vpx_codec_destroy(&enc));
+}
+
+struct CountingAllocator {
+  unsigned int num_allocs;
+  unsigned int num_frees;
+};
+
+void *CountingAlloc(void *priv, size_t size, size_t align) {
+  CountingAllocator *const counter = static_cast<CountingAllocator *>(priv);
+  uint8_t *const mem =
+      static_cast<uint8_t *>(malloc(size + align + sizeof(void *)));
+  if (mem == NULL) return NULL;
+  uintptr_t addr = reinterpret_cast<uintptr_t>(mem + sizeof(void *));
+  addr = (addr + align - 1) & ~static_cast<uintptr_t>(align - 1);
+  reinterpret_cast<void **>(addr)[-1] = mem;
+  ++counter->num_allocs;
+  return reinterpret_cast<void *>(addr);
+}
+
+void CountingFree(void *priv, void *mem) {
+  CountingAllocator *const counter = static_cast<CountingAllocator *>(priv);
+  ++counter->num_frees;
+  free(static_cast<void **>(mem)[-1]);
+}
+
+size_t ReadStats(void *priv, uint64_t offset, void *buf, size_t size) {
+  const std::string *const stats = static_cast<const std::string *>(priv);
+  if (offset >= stats->size()) return 0;
+  return stats->copy(static_cast<char *>(buf), size,
+                     static_cast<size_t>(offset));
+}
+
+// Scenes of varying length and motion. The frames in the resize range are
+// half size.
+class SceneVideoSource : public ::libvpx_test::DummyVideoSource {
+ public:
+  SceneVideoSource(unsigned int width, unsigned int height, unsigned int limit)
+      : full_width_(width), full_height_(height), resize_start_(0),
+        resize_end_(0) {
+    SetSize(width, height);
+    set_limit(limit);
+  }
+
+  void set_resize_range(unsigned int start, unsigned int end) {
+    resize_start_ = start;
+    resize_end_ = end;
+  }
+
+ protected:
+  virtual void Begin() {
+    frame_ = 0;
+    ResizeFrame();
+    FillFrame();
+  }
+
+  virtual void Next() {
+    ++frame_;
+    ResizeFrame();
+    FillFrame();
+  }
+
+  void ResizeFrame() {
+    const bool half = frame_ >= resize_start_ && frame_ < resize_end_;
+    SetSize(half ? full_width_ / 2 : full_width_,
+            half ? full_height_ / 2 : full_height_);
+  }
+
+  virtual void FillFrame() {
+    if (img_ == NULL) return;
+    const unsigned int stride = img_->stride[VPX_PLANE_Y];
+    const unsigned int scene = frame_ / 45 + frame_ / 70;
+    for (size_t i = 0; i < raw_sz_; ++i) {
+      img_->img_data[i] = static_cast<uint8_t>(
+          (i % stride + frame_ * (scene % 3 + 1)) * (scene + 1) + i / stride);
+    }
+  }
+
+  unsigned int full_width_;
+  unsigned int full_height_;
+  unsigned int resize_start_;
+  unsigned int resize_end_;
+};
+
+// Encodes a SceneVideoSource and keeps the compressed data.
+class VP9SceneEncodeTest : public ::libvpx_test::EncoderTest,
+                           public ::testing::Test {
+ protected:
+  VP9SceneEncodeTest() : EncoderTest(&::libvpx_test::kVP9), cpu_used_(7) {}
+  virtual ~VP9SceneEncodeTest() {}
+
+  virtual void SetUp() { InitializeConfig(); }
+
+  virtual void BeginPassHook(unsigned int /*pass*/) { data_.clear(); }
+
+  virtual void PreEncodeFrameHook(::libvpx_test::VideoSource *video,
+                                  ::libvpx_test::Encoder *encoder) {
+    if (video->frame() == 0) encoder->Control(VP8E_SET_CPUUSED, cpu_used_);
+  }
+
+  virtual void FramePktHook(const vpx_codec_cx_pkt_t *pkt) {
+    data_.append(static_cast<const char *>(pkt->data.frame.buf),
+                 pkt->data.frame.sz);
+  }
+
+  int cpu_used_;
+  std::string data_;
+};
+
+// Encodes with |memory_profile_| and reads the memory footprint at the end of
+// the stream.
+class VP9MemoryProfileTest : public VP9SceneEncodeTest {
+ protected:
+  VP9MemoryProfileTest()
+      : memory_profile_(VP9E_MEMORY_PROFILE_DEFAULT), memory_footprint_(0) {}
+
+  virtual void SetUp() {
+    VP9SceneEncodeTest::SetUp();
+    SetMode(::libvpx_test::kRealTime);
+    // The low profile requires no lag.
+    cfg_.g_lag_in_frames = 0;
+    cfg_.rc_end_usage = VPX_CBR;
+  }
+
+  virtual void PreEncodeFrameHook(::libvpx_test::VideoSource *video,
+                                  ::libvpx_test::Encoder *encoder) {
+    VP9SceneEncodeTest::PreEncodeFrameHook(video, encoder);
+    if (video->frame() == 0) {
+      encoder->Control(VP9E_SET_MEMORY_PROFILE, memory_profile_);
+    }
+    if (video->img() == NULL) {
+      encoder->Control(VP9E_GET_MEMORY_FOOTPRINT, &memory_footprint_);
+    }
+  }
+
+  int memory_profile_;
+  size_t memory_footprint_;
+};
+
+TEST_F(VP9MemoryProfileTest, MemoryProfile) {
+  SceneVideoSource video(176, 144, 5);
+
+  ASSERT_NO_FATAL_FAILURE(RunLoop(&video));
+  const std::string default_data = data_;
+  const size_t default_footprint = memory_footprint_;
+  memory_profile_ = VP9E_MEMORY_PROFILE_LOW;
+  ASSERT_NO_FATAL_FAILURE(RunLoop(&video));
+
+  // The profile only changes what is allocated, not the bitstream.
+  EXPECT_FALSE(default_data.empty());
+  EXPECT_EQ(default_data, data_);
+  EXPECT_GT(memory_footprint_, 0u);
+  EXPECT_LT(memory_footprint_, default_footprint);
+}
+
+TEST(EncodeAPI, MemoryProfileInvalid) {
+  vpx_codec_ctx_t enc;
+  vpx_codec_enc_cfg_t cfg;
+
+  EXPECT_EQ(VPX_CODEC_OK,
+            vpx_codec_enc_config_default(&vpx_codec_vp9_cx_algo, &cfg, 0));
+  cfg.g_w = 64;
+  cfg.g_h = 64;
+  cfg.g_lag_in_frames = 25;
+  EXPECT_EQ(VPX_CODEC_OK,
+            vpx_codec_enc_init(&enc, &vpx_codec_vp9_cx_algo, &cfg, 0));
+  // The low profile requires no lag.
+  EXPECT_EQ(VPX_CODEC_INVALID_PARAM,
+            vpx_codec_control(&enc, VP9E_SET_MEMORY_PROFILE,
+                              VP9E_MEMORY_PROFILE_LOW));
+  EXPECT_EQ(VPX_CODEC_INVALID_PARAM,
+            vpx_codec_control(&enc, VP9E_SET_MEMORY_PROFILE,
+                              VP9E_MEMORY_PROFILE_INVALID));
+  EXPECT_EQ(VPX_CODEC_INVALID_PARAM,
+            vpx_codec_control(&enc, VP9E_GET_MEMORY_FOOTPRINT,
+                              static_cast<size_t *>(NULL)));
+  EXPECT_EQ(VPX_CODEC_OK, vpx_codec_destroy(&enc));
+}
+
+// Installs a counting scratch memory allocator on the second of two encodes
+// and reads the allocator stats once the first frames are encoded and at the
+// end of the stream.
+class VP9MemoryAllocatorTest : public VP9SceneEncodeTest {
+ protected:
+  VP9MemoryAllocatorTest() : counter_(NULL) {
+    memset(&eos_counter_, 0, sizeof(eos_counter_));
+    memset(&warm_stats_, 0, sizeof(warm_stats_));
+    memset(&eos_stats_, 0, sizeof(eos_stats_));
+  }
+
+  virtual void SetUp() {
+    VP9SceneEncodeTest::SetUp();
+    // Realtime row based multi-threading does not give the same bitstream
+    // every run when the frame size changes, so use good quality.
+    SetMode(::libvpx_test::kOnePassGood);
+    cfg_.g_lag_in_frames = 0;
+    cfg_.rc_end_usage = VPX_CBR;
+    cfg_.g_threads = 2;
+    cpu_used_ = 5;
+  }
+
+  virtual void PreEncodeFrameHook(::libvpx_test::VideoSource *video,
+                                  ::libvpx_test::Encoder *encoder) {
+    VP9SceneEncodeTest::PreEncodeFrameHook(video, encoder);
+    if (video->frame() == 0) {
+      encoder->Control(VP9E_SET_TILE_COLUMNS, 1);
+      encoder->Control(VP9E_SET_ROW_MT, 1);
+      if (counter_ != NULL) {
+        vpx_memory_allocator_t allocator = { CountingAlloc, CountingFree,
+                                             counter_ };
+        encoder->Control(VP9E_SET_MEMORY_ALLOCATOR, &allocator);
+      }
+    } else if (video->frame() == 2) {
+      // The first two frames have been encoded.
+      encoder->Control(VP9E_GET_MEMORY_ALLOCATOR_STATS, &warm_stats_);
+    }
+    if (video->img() == NULL) {
+      encoder->Control(VP9E_GET_MEMORY_ALLOCATOR_STATS, &eos_stats_);
+      if (counter_ != NULL) eos_counter_ = *counter_;
+    }
+  }
+
+  // The scratch memory allocator counts into |counter_| when it is set.
+  CountingAllocator *counter_;
+  CountingAllocator eos_counter_;
+  vpx_memory_allocator_stats_t warm_stats_;
+  vpx_memory_allocator_stats_t eos_stats_;
+};
+
+TEST_F(VP9MemoryAllocatorTest, MemoryAllocator) {
+  CountingAllocator counter = { 0, 0 };
+  SceneVideoSource video(352, 288, 12);
+
+  video.set_resize_range(4, 8);
+  ASSERT_NO_FATAL_FAILURE(RunLoop(&video));
+  const std::string default_data = data_;
+  EXPECT_GT(eos_stats_.bytes_in_use, 0u);
+  EXPECT_LE(eos_stats_.bytes_in_use, eos_stats_.bytes_reserved);
+  counter_ = &counter;
+  ASSERT_NO_FATAL_FAILURE(RunLoop(&video));
+
+  EXPECT_FALSE(default_data.empty());
+  EXPECT_EQ(default_data, data_);
+  EXPECT_GT(eos_stats_.bytes_in_use, 0u);
+  EXPECT_LE(eos_stats_.bytes_in_use, eos_stats_.bytes_reserved);
+  // Every block the encoder held came from |counter|, and nothing was
+  // requested once the first frames at the largest size had been encoded.
+  EXPECT_GT(warm_stats_.num_allocs, 0u);
+  EXPECT_EQ(warm_stats_.num_allocs, eos_stats_.num_allocs);
+  EXPECT_EQ(eos_stats_.num_allocs - eos_stats_.num_frees,
+            eos_counter_.num_allocs - eos_counter_.num_frees);
+  EXPECT_EQ(counter.num_allocs, counter.num_frees);
+}
+
+TEST(EncodeAPI, MemoryAllocatorInvalid) {
+  vpx_codec_ctx_t enc;
+  vpx_codec_enc_cfg_t cfg;
+  vpx_memory_allocator_t allocator = { CountingAlloc, NULL, NULL };
+
+  EXPECT_EQ(VPX_CODEC_OK,
+            vpx_codec_enc_config_default(&vpx_codec_vp9_cx_algo, &cfg, 0));
+  cfg.g_w = 64;
+  cfg.g_h = 64;
+  EXPECT_EQ(VPX_CODEC_OK,
+            vpx_codec_enc_init(&enc, &vpx_codec_vp9_cx_algo, &cfg, 0));
+  EXPECT_EQ(VPX_CODEC_INVALID_PARAM,
+            vpx_codec_control(&enc, VP9E_SET_MEMORY_ALLOCATOR, &allocator));
+  // NULL selects the default allocator.
+  EXPECT_EQ(VPX_CODEC_OK,
+            vpx_codec_control(&enc, VP9E_SET_MEMORY_ALLOCATOR,
+                              static_cast<vpx_memory_allocator_t *>(NULL)));
+  EXPECT_EQ(VPX_CODEC_INVALID_PARAM,
+            vpx_codec_control(&enc, VP9E_GET_MEMORY_ALLOCATOR_STATS,
+                              static_cast<vpx_memory_allocator_stats_t *>(
+                                  NULL)));
+  EXPECT_EQ(VPX_CODEC_OK, vpx_codec_destroy(&enc));
+}
+
+// Collects the first pass stats of a two pass encode. The second pass reads
+// them through a stats source when |use_stats_source_| is set.
+class VP9TwoPassStatsSourceTest : public VP9SceneEncodeTest {
+ protected:
+  VP9TwoPassStatsSourceTest() : use_stats_source_(false) {}
+
+  virtual void SetUp() {
+    VP9SceneEncodeTest::SetUp();
+    SetMode(::libvpx_test::kTwoPassGood);
+    cfg_.g_lag_in_frames = 25;
+    cfg_.rc_end_usage = VPX_VBR;
+    cfg_.kf_max_dist = 30;
+    cpu_used_ = 5;
+  }
+
+  virtual void BeginPassHook(unsigned int pass) {
+    VP9SceneEncodeTest::BeginPassHook(pass);
+    if (pass == 0) first_pass_stats_.clear();
+    // Leave rc_twopass_stats_in unset so that only the source is read.
+    if (pass == 1 && use_stats_source_) stats_.Reset();
+  }
+
+  virtual void PreEncodeFrameHook(::libvpx_test::VideoSource *video,
+                                  ::libvpx_test::Encoder *encoder) {
+    VP9SceneEncodeTest::PreEncodeFrameHook(video, encoder);
+    if (video->frame() == 0 && use_stats_source_ &&
+        cfg_.g_pass == VPX_RC_LAST_PASS) {
+      vpx_twopass_stats_source_t source = { ReadStats, first_pass_stats_.size(),
+                                            &first_pass_stats_ };
+      encoder->Control(VP9E_SET_TWOPASS_STATS_SOURCE, &source);
+    }
+  }
+
+  virtual void StatsPktHook(const vpx_codec_cx_pkt_t *pkt) {
+    first_pass_stats_.append(
+        static_cast<const char *>(pkt->data.twopass_stats.buf),
+        pkt->data.twopass_stats.sz);
+  }
+
+  bool use_stats_source_;
+  std::string first_pass_stats_;
+};
+
+TEST_F(VP9TwoPassStatsSourceTest, TwoPassStatsSource) {
+  // Enough frames for the stats window to slide.
+  SceneVideoSource video(64, 64, 400);
+
+  ASSERT_NO_FATAL_FAILURE(RunLoop(&video));
+  const std::string buffer_data = data_;
+  use_stats_source_ = true;
+  ASSERT_NO_FATAL_FAILURE(RunLoop(&video));
+
+  EXPECT_FALSE(buffer_data.empty());
+  EXPECT_EQ(buffer_data, data_);
+}
+
+TEST(EncodeAPI, TwoPassStatsSourceInvalid) {
+  std::string stats(100, 0);
+  vpx_twopass_stats_source_t source = { ReadStats, stats.size(), &stats };
+  vpx_codec_ctx_t enc;
+  vpx_codec_enc_cfg_t cfg;
+  uint8_t buf[64 * 64 * 3 / 2] = { 0 };
+  vpx_image_t img;
+
+  EXPECT_EQ(VPX_CODEC_OK,
+            vpx_codec_enc_config_default(&vpx_codec_vp9_cx_algo, &cfg, 0));
+  cfg.g_w = 64;
+  cfg.g_h = 64;
+  EXPECT_EQ(VPX_CODEC_OK,
+            vpx_codec_enc_init(&enc, &vpx_codec_vp9_cx_algo, &cfg, 0));
+  // Only the second pass reads stats.
+  EXPECT_EQ(VPX_CODEC_INVALID_PARAM,
+            vpx_codec_control(&enc, VP9E_SET_TWOPASS_STATS_SOURCE, &source));
+  EXPECT_EQ(VPX_CODEC_OK, vpx_codec_destroy(&enc));
+
+  cfg.g_pass = VPX_RC_LAST_PASS;
+  EXPECT_EQ(VPX_CODEC_OK,
+            vpx_codec_enc_init(&enc, &vpx_codec_vp9_cx_algo, &cfg, 0));
+  // Truncated packet.
+  EXPECT_EQ(VPX_CODEC_INVALID_PARAM,
+            vpx_codec_control(&enc, VP9E_SET_TWOPASS_STATS_SOURCE, &source));
+  // Neither rc_twopass_stats_in nor a source is set.
+  EXPECT_EQ(&img, vpx_img_wrap(&img, VPX_IMG_FMT_I420, 64, 64, 1, buf));
+  EXPECT_EQ(VPX_CODEC_INVALID_PARAM,
+            vpx_codec_encode(&enc, &img, 0, 1, 0, VPX_DL_GOOD_QUALITY));
+  EXPECT_EQ(VPX_CODEC_OK, vpx_codec_destroy(&enc));
+}
+
+// Records the key frames of an encode, which runs a lookahead pass
+// |lookahead_pass_| frames ahead when it is not 0.
+class VP9LookaheadPassTest : public VP9SceneEncodeTest {
+ protected:
+  VP9LookaheadPassTest() : lookahead_pass_(0), num_stats_pkts_(0) {}
+
+  virtual void SetUp() {
+    VP9SceneEncodeTest::SetUp();
+    SetMode(::libvpx_test::kTwoPassGood);
+    cfg_.g_lag_in_frames = 25;
+    cfg_.rc_end_usage = VPX_VBR;
+    cfg_.kf_max_dist = 30;
+    cpu_used_ = 5;
+  }
+
+  virtual void BeginPassHook(unsigned int pass) {
+    VP9SceneEncodeTest::BeginPassHook(pass);
+    key_frames_.clear();
+    num_stats_pkts_ = 0;
+    // The lookahead pass replaces the first pass of a two pass encode.
+    if (lookahead_pass_ != 0 && passes_ == 1) cfg_.g_pass = VPX_RC_LAST_PASS;
+  }
+
+  virtual void PreEncodeFrameHook(::libvpx_test::VideoSource *video,
+                                  ::libvpx_test::Encoder *encoder) {
+    VP9SceneEncodeTest::PreEncodeFrameHook(video, encoder);
+    if (video->frame() == 0 && lookahead_pass_ != 0) {
+      encoder->Control(VP9E_SET_LOOKAHEAD_PASS, lookahead_pass_);
+    }
+  }
+
+  virtual void FramePktHook(const vpx_codec_cx_pkt_t *pkt) {
+    VP9SceneEncodeTest::FramePktHook(pkt);
+    if (pkt->data.frame.flags & VPX_FRAME_IS_KEY) {
+      key_frames_.push_back(pkt->data.frame.pts);
+    }
+  }
+
+  virtual void StatsPktHook(const vpx_codec_cx_pkt_t * /*pkt*/) {
+    ++num_stats_pkts_;
+  }
+
+  unsigned int lookahead_pass_;
+  int num_stats_pkts_;
+  std::vector<vpx_codec_pts_t> key_frames_;
+};
+
+TEST_F(VP9LookaheadPassTest, LookaheadPass) {
+  SceneVideoSource video(64, 64, 400);
+
+  ASSERT_NO_FATAL_FAILURE(RunLoop(&video));
+  const std::string two_pass_data = data_;
+  const std::vector<vpx_codec_pts_t> two_pass_key_frames = key_frames_;
+  SetMode(::libvpx_test::kOnePassGood);
+  ASSERT_NO_FATAL_FAILURE(RunLoop(&video));
+  const std::string one_pass_data = data_;
+  const std::vector<vpx_codec_pts_t> one_pass_key_frames = key_frames_;
+  lookahead_pass_ = 64;
+  ASSERT_NO_FATAL_FAILURE(RunLoop(&video));
+  const std::string lookahead_data = data_;
+  ASSERT_NO_FATAL_FAILURE(RunLoop(&video));
+
+  // The lookahead pass runs on its own thread, but its stats reach the second
+  // pass in the same order every time. They are not output.
+  EXPECT_EQ(0, num_stats_pkts_);
+  EXPECT_FALSE(lookahead_data.empty());
+  EXPECT_EQ(lookahead_data, data_);
+  // It finds the scene cuts a first pass over the whole sequence finds, which
+  // a one pass encode does not, and spends a rate close to the two pass one.
+  EXPECT_EQ(two_pass_key_frames, key_frames_);
+  EXPECT_NE(one_pass_key_frames, key_frames_);
+  EXPECT_NE(one_pass_data, lookahead_data);
+  EXPECT_LT(labs(static_cast<long>(lookahead_data.size()) -
+                 static_cast<long>(two_pass_data.size())),
+            labs(static_cast<long>(lookahead_data.size()) -
+                 static_cast<long>(one_pass_data.size())));
+}
+
+TEST(EncodeAPI, LookaheadPassInvalid) {
+  vpx_codec_ctx_t enc;
+  vpx_codec_enc_cfg_t cfg;
+  uint8_t buf[64 * 64 * 3 / 2] = { 0 };
+  vpx_image_t img;
+
+  EXPECT_EQ(VPX_CODEC_OK,
+            vpx_codec_enc_config_default(&vpx_codec_vp9_cx_algo, &cfg, 0));
+  cfg.g_w = 64;
+  cfg.g_h = 64;
+  EXPECT_EQ(VPX_CODEC_OK,
+            vpx_codec_enc_init(&enc, &vpx_codec_vp9_cx_algo, &cfg, 0));
+  // Only the second pass takes the lookahead pass.
+  EXPECT_EQ(VPX_CODEC_INVALID_PARAM,
+            vpx_codec_control(&enc, VP9E_SET_LOOKAHEAD_PASS, 64));
+  EXPECT_EQ(VPX_CODEC_OK, vpx_codec_destroy(&enc));
+
+  cfg.g_pass = VPX_RC_LAST_PASS;
+  EXPECT_EQ(VPX_CODEC_OK,
+            vpx_codec_enc_init(&enc, &vpx_codec_vp9_cx_algo, &cfg, 0));
+  EXPECT_EQ(VPX_CODEC_INVALID_PARAM,
+            vpx_codec_control(&enc, VP9E_SET_LOOKAHEAD_PASS, 16));
+  EXPECT_EQ(VPX_CODEC_INVALID_PARAM,
+            vpx_codec_control(&enc, VP9E_SET_LOOKAHEAD_PASS, 601));
+  EXPECT_EQ(VPX_CODEC_OK, vpx_codec_control(&enc, VP9E_SET_LOOKAHEAD_PASS, 64));
+  // The lookahead pass cannot be changed once it runs.
+  EXPECT_EQ(VPX_CODEC_INVALID_PARAM,
+            vpx_codec_control(&enc, VP9E_SET_LOOKAHEAD_PASS, 128));
+  EXPECT_EQ(&img, vpx_img_wrap(&img, VPX_IMG_FMT_I420, 64, 64, 1, buf));
+  EXPECT_EQ(VPX_CODEC_OK,
+            vpx_codec_encode(&enc, &img, 0, 1, 0, VPX_DL_GOOD_QUALITY));
+  EXPECT_EQ(VPX_CODEC_OK, vpx_codec_destroy(&enc));
+}
+#endif  // CONFIG_VP9_ENCODER
+
 }  // namespace
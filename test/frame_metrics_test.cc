@@ -0,0 +1,438 @@
+/*
+ *  Copyright (c) 2017 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <string.h>
+
+#include "third_party/googletest/src/include/gtest/gtest.h"
+
+#include "./vpx_config.h"
+#include "./vpx_dsp_rtcd.h"
+#include "test/acm_random.h"
+#include "test/clear_system_state.h"
+#include "test/register_state_check.h"
+#include "test/util.h"
+#include "vpx/vpx_frame_metrics.h"
+#include "vpx_dsp/frame_metrics.h"
+#include "vpx_dsp/psnr.h"
+#include "vpx_dsp/ssim.h"
+#include "vpx_ports/mem.h"
+#include "vpx_scale/yv12config.h"
+
+using libvpx_test::ACMRandom;
+
+namespace {
+
+// width, height, bit depth
+typedef std::tr1::tuple<int, int, int> FrameMetricsParam;
+
+class FrameMetricsTest : public ::testing::TestWithParam<FrameMetricsParam> {
+ protected:
+  virtual void SetUp() {
+    width_ = GET_PARAM(0);
+    height_ = GET_PARAM(1);
+    bit_depth_ = GET_PARAM(2);
+    memset(&source_, 0, sizeof(source_));
+    memset(&dest_, 0, sizeof(dest_));
+    ASSERT_EQ(0, Alloc(&source_));
+    ASSERT_EQ(0, Alloc(&dest_));
+    rnd_.Reset(ACMRandom::DeterministicSeed());
+    Fill();
+  }
+
+  virtual void TearDown() {
+    vpx_free_frame_buffer(&source_);
+    vpx_free_frame_buffer(&dest_);
+    libvpx_test::ClearSystemState();
+  }
+
+  int Alloc(YV12_BUFFER_CONFIG *ybf) {
+    return vpx_alloc_frame_buffer(ybf, width_, height_, 1, 1,
+#if CONFIG_VP9_HIGHBITDEPTH
+                                  bit_depth_ > 8,
+#endif
+                                  32, 16);
+  }
+
+  // The destination is a noisy copy of a smooth gradient so every metric
+  // lands in a meaningful range.
+  void FillPlane(uint8_t *src8, uint8_t *dst8, int stride, int w, int h) {
+    const int max = (1 << bit_depth_) - 1;
+    for (int r = 0; r < h; ++r) {
+      for (int c = 0; c < w; ++c) {
+        const int s = ((r * 3 + c * 5) << (bit_depth_ - 8)) % (max + 1);
+        int d = s + rnd_(9 << (bit_depth_ - 8)) - (4 << (bit_depth_ - 8));
+        d = d < 0 ? 0 : d > max ? max : d;
+#if CONFIG_VP9_HIGHBITDEPTH
+        if (bit_depth_ > 8) {
+          CONVERT_TO_SHORTPTR(src8)[r * stride + c] = s;
+          CONVERT_TO_SHORTPTR(dst8)[r * stride + c] = d;
+          continue;
+        }
+#endif
+        src8[r * stride + c] = s;
+        dst8[r * stride + c] = d;
+      }
+    }
+  }
+
+  void Fill() {
+    FillPlane(source_.y_buffer, dest_.y_buffer, source_.y_stride,
+              source_.y_crop_width, source_.y_crop_height);
+    FillPlane(source_.u_buffer, dest_.u_buffer, source_.uv_stride,
+              source_.uv_crop_width, source_.uv_crop_height);
+    FillPlane(source_.v_buffer, dest_.v_buffer, source_.uv_stride,
+              source_.uv_crop_width, source_.uv_crop_height);
+  }
+
+  int width_;
+  int height_;
+  int bit_depth_;
+  YV12_BUFFER_CONFIG source_;
+  YV12_BUFFER_CONFIG dest_;
+  ACMRandom rnd_;
+};
+
+TEST_P(FrameMetricsTest, MatchesIndividualMetrics) {
+  const uint32_t bd = bit_depth_;
+  FRAME_METRICS metrics;
+  PSNR_STATS psnr;
+  double ssim, weight;
+  double fastssim[4], psnrhvs[4];
+
+  vpx_frame_metrics_calc(&source_, &dest_, VPX_METRIC_ALL, bd, bd, &metrics);
+
+#if CONFIG_VP9_HIGHBITDEPTH
+  if (bit_depth_ > 8) {
+    vpx_calc_highbd_psnr(&source_, &dest_, &psnr, bd, bd);
+    ssim = vpx_highbd_calc_ssim(&source_, &dest_, &weight, bd, bd);
+  } else {
+    vpx_calc_psnr(&source_, &dest_, &psnr);
+    ssim = vpx_calc_ssim(&source_, &dest_, &weight);
+  }
+#else
+  vpx_calc_psnr(&source_, &dest_, &psnr);
+  ssim = vpx_calc_ssim(&source_, &dest_, &weight);
+#endif
+  fastssim[0] = vpx_calc_fastssim(&source_, &dest_, &fastssim[1], &fastssim[2],
+                                  &fastssim[3], bd, bd);
+  psnrhvs[0] = vpx_psnrhvs(&source_, &dest_, &psnrhvs[1], &psnrhvs[2],
+                           &psnrhvs[3], bd, bd);
+
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_EQ(psnr.sse[i], metrics.psnr.sse[i]);
+    EXPECT_EQ(psnr.samples[i], metrics.psnr.samples[i]);
+    EXPECT_DOUBLE_EQ(psnr.psnr[i], metrics.psnr.psnr[i]);
+    EXPECT_DOUBLE_EQ(fastssim[i], metrics.fastssim[i]);
+    // Band sums are added in a different order than a single full-frame pass.
+    EXPECT_NEAR(psnrhvs[i], metrics.psnrhvs[i], 1e-9);
+  }
+  EXPECT_NEAR(ssim, metrics.ssim, 1e-12);
+}
+
+TEST_P(FrameMetricsTest, JobOrderDoesNotMatter) {
+  const uint32_t bd = bit_depth_;
+  FRAME_METRICS expected, actual;
+  FRAME_METRICS_CTX ctx;
+
+  vpx_frame_metrics_calc(&source_, &dest_, VPX_METRIC_ALL, bd, bd, &expected);
+
+  vpx_frame_metrics_init(&ctx, &source_, &dest_, VPX_METRIC_ALL, bd, bd);
+  ASSERT_LE(vpx_frame_metrics_num_jobs(&ctx), VPX_METRICS_MAX_JOBS);
+  for (int i = vpx_frame_metrics_num_jobs(&ctx) - 1; i >= 0; --i)
+    vpx_frame_metrics_job(&ctx, i);
+  vpx_frame_metrics_finish(&ctx, &actual);
+
+  EXPECT_EQ(0, memcmp(&expected, &actual, sizeof(expected)));
+}
+
+TEST_P(FrameMetricsTest, SubsetOfMetrics) {
+  const uint32_t bd = bit_depth_;
+  FRAME_METRICS all, psnr_only;
+
+  vpx_frame_metrics_calc(&source_, &dest_, VPX_METRIC_ALL, bd, bd, &all);
+  vpx_frame_metrics_calc(&source_, &dest_, VPX_METRIC_PSNR, bd, bd,
+                         &psnr_only);
+
+  EXPECT_EQ(0, memcmp(&all.psnr, &psnr_only.psnr, sizeof(all.psnr)));
+  EXPECT_EQ(0, psnr_only.ssim);
+  EXPECT_EQ(0, psnr_only.fastssim[0]);
+  EXPECT_EQ(0, psnr_only.psnrhvs[0]);
+}
+
+// Describes a frame buffer as a vpx_image_t, the way the public API sees it.
+void WrapFrameBuffer(const YV12_BUFFER_CONFIG &ybf, int bit_depth,
+                     vpx_image_t *img) {
+  const int bytes_per_sample = bit_depth > 8 ? 2 : 1;
+  memset(img, 0, sizeof(*img));
+  img->fmt = bit_depth > 8 ? VPX_IMG_FMT_I42016 : VPX_IMG_FMT_I420;
+  img->bit_depth = bit_depth;
+  img->d_w = ybf.y_crop_width;
+  img->d_h = ybf.y_crop_height;
+  img->x_chroma_shift = img->y_chroma_shift = 1;
+  img->planes[VPX_PLANE_Y] = ybf.y_buffer;
+  img->planes[VPX_PLANE_U] = ybf.u_buffer;
+  img->planes[VPX_PLANE_V] = ybf.v_buffer;
+#if CONFIG_VP9_HIGHBITDEPTH
+  if (bit_depth > 8) {
+    img->planes[VPX_PLANE_Y] = (uint8_t *)CONVERT_TO_SHORTPTR(ybf.y_buffer);
+    img->planes[VPX_PLANE_U] = (uint8_t *)CONVERT_TO_SHORTPTR(ybf.u_buffer);
+    img->planes[VPX_PLANE_V] = (uint8_t *)CONVERT_TO_SHORTPTR(ybf.v_buffer);
+  }
+#endif
+  img->stride[VPX_PLANE_Y] = ybf.y_stride * bytes_per_sample;
+  img->stride[VPX_PLANE_U] = img->stride[VPX_PLANE_V] =
+      ybf.uv_stride * bytes_per_sample;
+}
+
+TEST_P(FrameMetricsTest, ImageApiMatchesAnyThreadCount) {
+  const uint32_t bd = bit_depth_;
+  FRAME_METRICS expected;
+  vpx_image_t source, recon;
+
+  vpx_frame_metrics_calc(&source_, &dest_, VPX_METRIC_ALL, bd, bd, &expected);
+  WrapFrameBuffer(source_, bit_depth_, &source);
+  WrapFrameBuffer(dest_, bit_depth_, &recon);
+
+  for (int threads = 1; threads <= 8; threads *= 2) {
+    vpx_frame_metrics_t metrics;
+    ASSERT_EQ(VPX_CODEC_OK,
+              vpx_calc_frame_metrics(&source, &recon, 0, VPX_METRIC_ALL,
+                                     threads, &metrics));
+    for (int i = 0; i < 4; ++i) {
+      EXPECT_EQ(expected.psnr.sse[i], metrics.sse[i]);
+      EXPECT_EQ(expected.psnr.samples[i], metrics.samples[i]);
+      EXPECT_EQ(expected.psnr.psnr[i], metrics.psnr[i]);
+      EXPECT_EQ(expected.fastssim[i], metrics.fastssim[i]);
+      EXPECT_EQ(expected.psnrhvs[i], metrics.psnrhvs[i]);
+    }
+    EXPECT_EQ(expected.ssim, metrics.ssim);
+  }
+}
+
+TEST_P(FrameMetricsTest, ImageApiRejectsMismatchedImages) {
+  vpx_image_t source, recon;
+  vpx_frame_metrics_t metrics;
+
+  WrapFrameBuffer(source_, bit_depth_, &source);
+  WrapFrameBuffer(dest_, bit_depth_, &recon);
+  --recon.d_w;
+  EXPECT_EQ(VPX_CODEC_INVALID_PARAM,
+            vpx_calc_frame_metrics(&source, &recon, 0, VPX_METRIC_ALL, 1,
+                                   &metrics));
+  ++recon.d_w;
+  EXPECT_EQ(VPX_CODEC_INVALID_PARAM,
+            vpx_calc_frame_metrics(&source, &recon, 0, VPX_METRIC_ALL, 0,
+                                   &metrics));
+  EXPECT_EQ(VPX_CODEC_INVALID_PARAM,
+            vpx_calc_frame_metrics(&source, &recon, bit_depth_ + 1,
+                                   VPX_METRIC_ALL, 1, &metrics));
+}
+
+const int kNumIterations = 10000;
+// Room for an 8x8 block at any of the tested strides and offsets.
+const int kMaxStride = 64;
+const int kBufferSize = 8 * kMaxStride;
+
+// Runs |ref| and |tst| on one 8x8 block and checks that they agree. Both
+// start from the same random sums, as the functions add to them.
+template <typename Pixel, typename SsimParmsFunc>
+void CheckSsimParms(SsimParmsFunc ref, SsimParmsFunc tst, const Pixel *s,
+                    int sp, const Pixel *r, int rp, ACMRandom *rnd) {
+  uint32_t ref_sums[5], tst_sums[5];
+  for (int i = 0; i < 5; ++i) {
+    ref_sums[i] = tst_sums[i] = (rnd->Rand16() << 15) ^ rnd->Rand16();
+  }
+
+  ref(s, sp, r, rp, &ref_sums[0], &ref_sums[1], &ref_sums[2], &ref_sums[3],
+      &ref_sums[4]);
+  ASM_REGISTER_STATE_CHECK(tst(s, sp, r, rp, &tst_sums[0], &tst_sums[1],
+                               &tst_sums[2], &tst_sums[3], &tst_sums[4]));
+
+  for (int i = 0; i < 5; ++i) {
+    ASSERT_EQ(ref_sums[i], tst_sums[i])
+        << "C output does not match optimized output for sum " << i;
+  }
+}
+
+typedef void (*SsimParmsFunc)(const uint8_t *s, int sp, const uint8_t *r,
+                              int rp, uint32_t *sum_s, uint32_t *sum_r,
+                              uint32_t *sum_sq_s, uint32_t *sum_sq_r,
+                              uint32_t *sum_sxr);
+typedef std::tr1::tuple<SsimParmsFunc, SsimParmsFunc> SsimParmsParam;
+
+class SsimParmsTest : public ::testing::TestWithParam<SsimParmsParam> {
+ protected:
+  virtual void SetUp() {
+    ref_func_ = GET_PARAM(0);
+    tst_func_ = GET_PARAM(1);
+    rnd_.Reset(ACMRandom::DeterministicSeed());
+  }
+
+  virtual void TearDown() { libvpx_test::ClearSystemState(); }
+
+  // Checks a block at a random stride and offset, so that the loads are
+  // unaligned.
+  void CheckBlock(uint8_t *s, uint8_t *r) {
+    const int sp = 8 + rnd_(kMaxStride - 8 + 1);
+    const int rp = 8 + rnd_(kMaxStride - 8 + 1);
+    CheckSsimParms(ref_func_, tst_func_, s + rnd_(sp - 7), sp, r + rnd_(rp - 7),
+                   rp, &rnd_);
+  }
+
+  SsimParmsFunc ref_func_;
+  SsimParmsFunc tst_func_;
+  ACMRandom rnd_;
+};
+
+TEST_P(SsimParmsTest, RandomValues) {
+  DECLARE_ALIGNED(32, uint8_t, s[kBufferSize + kMaxStride]);
+  DECLARE_ALIGNED(32, uint8_t, r[kBufferSize + kMaxStride]);
+
+  for (int k = 0; k < kNumIterations; ++k) {
+    for (int i = 0; i < kBufferSize + kMaxStride; ++i) {
+      s[i] = rnd_.Rand8();
+      r[i] = rnd_.Rand8();
+    }
+    ASSERT_NO_FATAL_FAILURE(CheckBlock(s, r));
+  }
+}
+
+TEST_P(SsimParmsTest, ExtremeValues) {
+  DECLARE_ALIGNED(32, uint8_t, s[kBufferSize + kMaxStride]);
+  DECLARE_ALIGNED(32, uint8_t, r[kBufferSize + kMaxStride]);
+
+  for (int k = 0; k < kNumIterations; ++k) {
+    // Flat blocks of 0 or 255 for the first four, then a mix of the two.
+    for (int i = 0; i < kBufferSize + kMaxStride; ++i) {
+      s[i] = (k < 4 ? (k & 1) : rnd_(2)) * 255;
+      r[i] = (k < 4 ? (k >> 1) : rnd_(2)) * 255;
+    }
+    ASSERT_NO_FATAL_FAILURE(CheckBlock(s, r));
+  }
+}
+
+#if CONFIG_VP9_HIGHBITDEPTH
+typedef void (*HighbdSsimParmsFunc)(const uint16_t *s, int sp,
+                                    const uint16_t *r, int rp,
+                                    uint32_t *sum_s, uint32_t *sum_r,
+                                    uint32_t *sum_sq_s, uint32_t *sum_sq_r,
+                                    uint32_t *sum_sxr);
+// C function, optimized function, bit depth
+typedef std::tr1::tuple<HighbdSsimParmsFunc, HighbdSsimParmsFunc, int>
+    HighbdSsimParmsParam;
+
+class HighbdSsimParmsTest
+    : public ::testing::TestWithParam<HighbdSsimParmsParam> {
+ protected:
+  virtual void SetUp() {
+    ref_func_ = GET_PARAM(0);
+    tst_func_ = GET_PARAM(1);
+    max_ = (1 << GET_PARAM(2)) - 1;
+    rnd_.Reset(ACMRandom::DeterministicSeed());
+  }
+
+  virtual void TearDown() { libvpx_test::ClearSystemState(); }
+
+  void CheckBlock(uint16_t *s, uint16_t *r) {
+    const int sp = 8 + rnd_(kMaxStride - 8 + 1);
+    const int rp = 8 + rnd_(kMaxStride - 8 + 1);
+    CheckSsimParms(ref_func_, tst_func_, s + rnd_(sp - 7), sp, r + rnd_(rp - 7),
+                   rp, &rnd_);
+  }
+
+  HighbdSsimParmsFunc ref_func_;
+  HighbdSsimParmsFunc tst_func_;
+  int max_;
+  ACMRandom rnd_;
+};
+
+TEST_P(HighbdSsimParmsTest, RandomValues) {
+  DECLARE_ALIGNED(32, uint16_t, s[kBufferSize + kMaxStride]);
+  DECLARE_ALIGNED(32, uint16_t, r[kBufferSize + kMaxStride]);
+
+  for (int k = 0; k < kNumIterations; ++k) {
+    for (int i = 0; i < kBufferSize + kMaxStride; ++i) {
+      s[i] = rnd_.Rand16() & max_;
+      r[i] = rnd_.Rand16() & max_;
+    }
+    ASSERT_NO_FATAL_FAILURE(CheckBlock(s, r));
+  }
+}
+
+TEST_P(HighbdSsimParmsTest, ExtremeValues) {
+  DECLARE_ALIGNED(32, uint16_t, s[kBufferSize + kMaxStride]);
+  DECLARE_ALIGNED(32, uint16_t, r[kBufferSize + kMaxStride]);
+
+  for (int k = 0; k < kNumIterations; ++k) {
+    // Flat blocks of 0 or the maximum for the first four, then a mix of the
+    // two.
+    for (int i = 0; i < kBufferSize + kMaxStride; ++i) {
+      s[i] = (k < 4 ? (k & 1) : rnd_(2)) * max_;
+      r[i] = (k < 4 ? (k >> 1) : rnd_(2)) * max_;
+    }
+    ASSERT_NO_FATAL_FAILURE(CheckBlock(s, r));
+  }
+}
+#endif  // CONFIG_VP9_HIGHBITDEPTH
+
+using std::tr1::make_tuple;
+
+const FrameMetricsParam kFrameMetricsParams[] = {
+  // Single band, odd dimensions.
+  make_tuple(99, 37, 8), make_tuple(352, 288, 8),
+  // More rows than VPX_METRICS_MAX_BANDS bands of the minimum height.
+  make_tuple(64, 4200, 8),
+#if CONFIG_VP9_HIGHBITDEPTH
+  make_tuple(99, 37, 10), make_tuple(352, 288, 10), make_tuple(176, 144, 12),
+#endif
+};
+
+INSTANTIATE_TEST_CASE_P(C, FrameMetricsTest,
+                        ::testing::ValuesIn(kFrameMetricsParams));
+
+#if HAVE_SSE2 && ARCH_X86_64
+INSTANTIATE_TEST_CASE_P(
+    SSE2, SsimParmsTest,
+    ::testing::Values(make_tuple(&vpx_ssim_parms_8x8_c,
+                                 &vpx_ssim_parms_8x8_sse2)));
+#endif  // HAVE_SSE2 && ARCH_X86_64
+
+#if HAVE_AVX2
+INSTANTIATE_TEST_CASE_P(
+    AVX2, SsimParmsTest,
+    ::testing::Values(make_tuple(&vpx_ssim_parms_8x8_c,
+                                 &vpx_ssim_parms_8x8_avx2)));
+#endif  // HAVE_AVX2
+
+#if CONFIG_VP9_HIGHBITDEPTH
+#if HAVE_SSE2
+INSTANTIATE_TEST_CASE_P(
+    SSE2, HighbdSsimParmsTest,
+    ::testing::Values(make_tuple(&vpx_highbd_ssim_parms_8x8_c,
+                                 &vpx_highbd_ssim_parms_8x8_sse2, 8),
+                      make_tuple(&vpx_highbd_ssim_parms_8x8_c,
+                                 &vpx_highbd_ssim_parms_8x8_sse2, 10),
+                      make_tuple(&vpx_highbd_ssim_parms_8x8_c,
+                                 &vpx_highbd_ssim_parms_8x8_sse2, 12)));
+#endif  // HAVE_SSE2
+
+#if HAVE_AVX2
+INSTANTIATE_TEST_CASE_P(
+    AVX2, HighbdSsimParmsTest,
+    ::testing::Values(make_tuple(&vpx_highbd_ssim_parms_8x8_c,
+                                 &vpx_highbd_ssim_parms_8x8_avx2, 8),
+                      make_tuple(&vpx_highbd_ssim_parms_8x8_c,
+                                 &vpx_highbd_ssim_parms_8x8_avx2, 10),
+                      make_tuple(&vpx_highbd_ssim_parms_8x8_c,
+                                 &vpx_highbd_ssim_parms_8x8_avx2, 12)));
+#endif  // HAVE_AVX2
+#endif  // CONFIG_VP9_HIGHBITDEPTH
+
+}  // namespace
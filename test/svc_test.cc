@@ -64,6 +64,7 @@ class SvcTest : public ::testing::Test {
 
     tile_columns_ = 0;
     tile_rows_ = 0;
+    row_mt_ = 0;
   }
 
   virtual void TearDown() {
@@ -78,6 +79,7 @@ class SvcTest : public ::testing::Test {
     vpx_codec_control(&codec_, VP8E_SET_CPUUSED, 4);  // Make the test faster
     vpx_codec_control(&codec_, VP9E_SET_TILE_COLUMNS, tile_columns_);
     vpx_codec_control(&codec_, VP9E_SET_TILE_ROWS, tile_rows_);
+    vpx_codec_control(&codec_, VP9E_SET_ROW_MT, row_mt_);
     codec_initialized_ = true;
   }
 
@@ -303,6 +305,16 @@ class SvcTest : public ::testing::Test {
     }
   }
 
+  void CompareBitstreams(const struct vpx_fixed_buf *const expected,
+                         const struct vpx_fixed_buf *const actual,
+                         const int n) {
+    for (int i = 0; i < n; ++i) {
+      ASSERT_EQ(expected[i].sz, actual[i].sz) << "super frame: " << i;
+      EXPECT_EQ(0, memcmp(expected[i].buf, actual[i].buf, actual[i].sz))
+          << "super frame: " << i;
+    }
+  }
+
   SvcContext svc_;
   vpx_codec_ctx_t codec_;
   struct vpx_codec_enc_cfg codec_enc_;
@@ -312,6 +324,7 @@ class SvcTest : public ::testing::Test {
   Decoder *decoder_;
   int tile_columns_;
   int tile_rows_;
+  int row_mt_;
 };
 
 TEST_F(SvcTest, SvcInit) {
@@ -499,6 +512,52 @@ TEST_F(SvcTest, TwoPassEncode2SpatialLayersDecodeBaseLayerOnly) {
   FreeBitstreamBuffers(&outputs[0], 10);
 }
 
+TEST_F(SvcTest, TwoPassEncode2SpatialLayersWithRowMt) {
+  // First pass encode
+  std::string stats_buf;
+  codec_enc_.g_threads = 4;
+  row_mt_ = 1;
+  Pass1EncodeNFrames(10, 2, &stats_buf);
+
+  // Second pass encode
+  codec_enc_.g_pass = VPX_RC_LAST_PASS;
+  vpx_svc_set_options(&svc_, "auto-alt-refs=1,1");
+  tile_columns_ = 1;
+  tile_rows_ = 1;
+  vpx_fixed_buf outputs[10];
+  memset(&outputs[0], 0, sizeof(outputs));
+  Pass2EncodeNFrames(&stats_buf, 10, 2, &outputs[0]);
+  DecodeNFrames(&outputs[0], 10);
+
+  // With more than one thread row-mt is bit exact (row_mt_bit_exact), so both
+  // layers must match a 2 thread encode.
+  codec_enc_.g_threads = 2;
+  vpx_svc_set_options(&svc_, "auto-alt-refs=1,1");
+  vpx_fixed_buf two_thread_outputs[10];
+  memset(&two_thread_outputs[0], 0, sizeof(two_thread_outputs));
+  Pass2EncodeNFrames(&stats_buf, 10, 2, &two_thread_outputs[0]);
+  CompareBitstreams(&two_thread_outputs[0], &outputs[0], 10);
+
+  // With a single thread row_mt_bit_exact is off and the speed features are
+  // those of an encode without row-mt, so the two must match.
+  codec_enc_.g_threads = 1;
+  vpx_svc_set_options(&svc_, "auto-alt-refs=1,1");
+  vpx_fixed_buf single_thread_outputs[10];
+  memset(&single_thread_outputs[0], 0, sizeof(single_thread_outputs));
+  Pass2EncodeNFrames(&stats_buf, 10, 2, &single_thread_outputs[0]);
+  row_mt_ = 0;
+  vpx_svc_set_options(&svc_, "auto-alt-refs=1,1");
+  vpx_fixed_buf no_row_mt_outputs[10];
+  memset(&no_row_mt_outputs[0], 0, sizeof(no_row_mt_outputs));
+  Pass2EncodeNFrames(&stats_buf, 10, 2, &no_row_mt_outputs[0]);
+  CompareBitstreams(&no_row_mt_outputs[0], &single_thread_outputs[0], 10);
+
+  FreeBitstreamBuffers(&outputs[0], 10);
+  FreeBitstreamBuffers(&two_thread_outputs[0], 10);
+  FreeBitstreamBuffers(&single_thread_outputs[0], 10);
+  FreeBitstreamBuffers(&no_row_mt_outputs[0], 10);
+}
+
 TEST_F(SvcTest, TwoPassEncode5SpatialLayersDecode54321Layers) {
   // First pass encode
   std::string stats_buf;
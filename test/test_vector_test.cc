@@ -12,11 +12,13 @@
 #include <cstdlib>
 #include <set>
 #include <string>
+#include <vector>
 #include "third_party/googletest/src/include/gtest/gtest.h"
 #include "../tools_common.h"
 #include "./vpx_config.h"
 #include "test/codec_factory.h"
 #include "test/decode_test_driver.h"
+#include "test/i420_video_source.h"
 #include "test/ivf_video_source.h"
 #include "test/md5_helper.h"
 #include "test/test_vectors.h"
@@ -170,6 +172,158 @@ INSTANTIATE_TEST_CASE_P(
                                 libvpx_test::kVP8TestVectors +
                                     libvpx_test::kNumVP8TestVectors))));
 
+#if CONFIG_POSTPROC
+typedef std::vector<std::string> CompressedFrames;
+
+// Post-processing flag sets to compare across thread counts. Add-noise draws
+// from rand(), so every decode starts from the same seed.
+const int kVP8PostProcFlags[] = { VP8_DEMACROBLOCK | VP8_DEBLOCK | VP8_ADDNOISE,
+                                  VP8_DEBLOCK, VP8_DEMACROBLOCK,
+                                  VP8_MFQE | VP8_DEBLOCK,
+                                  VP8_MFQE | VP8_DEMACROBLOCK };
+
+void ReadIVFFrames(const std::string &filename, CompressedFrames *frames) {
+  libvpx_test::IVFVideoSource video(filename);
+  video.Init();
+  for (video.Begin(); video.cxdata(); video.Next()) {
+    frames->push_back(std::string(
+        reinterpret_cast<const char *>(video.cxdata()), video.frame_size()));
+  }
+}
+
+// Decodes |frames| with |threads| threads and the post-processing in |flags|.
+// Returns the md5 of the post-processed frames.
+std::string DecodeVP8PostProc(const CompressedFrames &frames, int threads,
+                              int flags) {
+  vpx_codec_dec_cfg_t cfg = vpx_codec_dec_cfg_t();
+  cfg.threads = threads;
+  libvpx_test::VP8Decoder decoder(cfg, VPX_CODEC_USE_POSTPROC);
+  vp8_postproc_cfg_t pp_cfg = { flags, 8, 2 };
+  decoder.Control(VP8_SET_POSTPROC, &pp_cfg);
+  srand(0);
+
+  libvpx_test::MD5 md5;
+  for (size_t i = 0; i < frames.size(); ++i) {
+    const vpx_codec_err_t res = decoder.DecodeFrame(
+        reinterpret_cast<const uint8_t *>(frames[i].data()), frames[i].size());
+    if (res != VPX_CODEC_OK) {
+      EXPECT_EQ(VPX_CODEC_OK, res) << decoder.DecodeError();
+      break;
+    }
+
+    libvpx_test::DxDataIterator dec_iter = decoder.GetDxData();
+    const vpx_image_t *img = NULL;
+    while ((img = dec_iter.Next())) md5.Add(img);
+  }
+  return std::string(md5.Get());
+}
+
+// The multi-threaded decoder post-processes rows on its threads. The result
+// must not depend on the number of threads.
+void CheckVP8PostProcThreads(const CompressedFrames &frames,
+                             const std::string &name) {
+  for (int i = 0; i < static_cast<int>(sizeof(kVP8PostProcFlags) /
+                                       sizeof(kVP8PostProcFlags[0]));
+       ++i) {
+    const int flags = kVP8PostProcFlags[i];
+    const std::string expected_md5 = DecodeVP8PostProc(frames, 1, flags);
+    for (int threads = 2; threads <= 8; ++threads) {
+      EXPECT_EQ(expected_md5, DecodeVP8PostProc(frames, threads, flags))
+          << name << " flags: " << flags << " threads: " << threads;
+    }
+  }
+}
+
+class VP8PostProcTest : public ::testing::TestWithParam<const char *> {};
+
+TEST_P(VP8PostProcTest, MD5MatchesSingleThread) {
+  const std::string filename = GetParam();
+  CompressedFrames frames;
+  ReadIVFFrames(filename, &frames);
+  CheckVP8PostProcThreads(frames, filename);
+}
+
+INSTANTIATE_TEST_CASE_P(
+    VP8, VP8PostProcTest,
+    ::testing::ValuesIn(libvpx_test::kVP8TestVectors,
+                        libvpx_test::kVP8TestVectors +
+                            libvpx_test::kNumVP8TestVectors));
+
+#if CONFIG_VP8_ENCODER
+// Encodes a two layer temporal scalable stream with four token partitions.
+// The quantizers of the layers are pinned far apart, so each enhancement
+// layer frame follows a much better base layer frame. That is what enables
+// MFQE in the decoder.
+void EncodeVP8TemporalLayers(CompressedFrames *frames) {
+  libvpx_test::I420VideoSource video("hantro_collage_w352h288.yuv", 352, 288,
+                                     30, 1, 0, 30);
+  vpx_codec_enc_cfg_t cfg;
+  vpx_codec_ctx_t enc;
+  vpx_codec_iface_t *const iface = vpx_codec_vp8_cx();
+
+  ASSERT_EQ(VPX_CODEC_OK, vpx_codec_enc_config_default(iface, &cfg, 0));
+  cfg.g_w = 352;
+  cfg.g_h = 288;
+  cfg.g_timebase.num = 1;
+  cfg.g_timebase.den = 30;
+  cfg.g_lag_in_frames = 0;
+  cfg.g_error_resilient = 1;
+  cfg.rc_end_usage = VPX_CBR;
+  cfg.rc_dropframe_thresh = 0;
+  cfg.rc_target_bitrate = 1200;
+  cfg.ts_number_layers = 2;
+  cfg.ts_periodicity = 2;
+  cfg.ts_layer_id[0] = 0;
+  cfg.ts_layer_id[1] = 1;
+  cfg.ts_rate_decimator[0] = 2;
+  cfg.ts_rate_decimator[1] = 1;
+  cfg.ts_target_bitrate[0] = 1100;
+  cfg.ts_target_bitrate[1] = 1200;
+  ASSERT_EQ(VPX_CODEC_OK, vpx_codec_enc_init(&enc, iface, &cfg, 0));
+  ASSERT_EQ(VPX_CODEC_OK,
+            vpx_codec_control(&enc, VP8E_SET_TOKEN_PARTITIONS, 2));
+  ASSERT_EQ(VPX_CODEC_OK, vpx_codec_control(&enc, VP8E_SET_CPUUSED, -6));
+
+  for (video.Begin(); video.img(); video.Next()) {
+    // Layer 0 predicts from and updates LAST, layer 1 only updates GOLDEN.
+    const int layer = video.frame() % 2;
+    const vpx_enc_frame_flags_t flags =
+        (layer == 0)
+            ? VP8_EFLAG_NO_REF_GF | VP8_EFLAG_NO_UPD_GF | VP8_EFLAG_NO_UPD_ARF
+            : VP8_EFLAG_NO_UPD_ARF | VP8_EFLAG_NO_UPD_LAST |
+                  VP8_EFLAG_NO_UPD_ENTROPY;
+    vpx_codec_iter_t iter = NULL;
+    const vpx_codec_cx_pkt_t *pkt;
+
+    cfg.rc_min_quantizer = cfg.rc_max_quantizer = layer ? 50 : 20;
+    ASSERT_EQ(VPX_CODEC_OK, vpx_codec_enc_config_set(&enc, &cfg));
+    ASSERT_EQ(VPX_CODEC_OK,
+              vpx_codec_control(&enc, VP8E_SET_TEMPORAL_LAYER_ID, layer));
+    ASSERT_EQ(VPX_CODEC_OK,
+              vpx_codec_encode(&enc, video.img(), video.pts(),
+                               video.duration(), flags, VPX_DL_GOOD_QUALITY));
+    while ((pkt = vpx_codec_get_cx_data(&enc, &iter)) != NULL) {
+      if (pkt->kind != VPX_CODEC_CX_FRAME_PKT) continue;
+      frames->push_back(
+          std::string(reinterpret_cast<const char *>(pkt->data.frame.buf),
+                      pkt->data.frame.sz));
+    }
+  }
+  EXPECT_EQ(VPX_CODEC_OK, vpx_codec_destroy(&enc));
+}
+
+TEST(VP8PostProcMfqeTest, MD5MatchesSingleThread) {
+  CompressedFrames frames;
+  ASSERT_NO_FATAL_FAILURE(EncodeVP8TemporalLayers(&frames));
+  ASSERT_EQ(30u, frames.size());
+
+  // MFQE must change the output, or the stream does not cover it.
+  EXPECT_NE(DecodeVP8PostProc(frames, 1, VP8_DEBLOCK),
+            DecodeVP8PostProc(frames, 1, VP8_DEBLOCK | VP8_MFQE));
+  CheckVP8PostProcThreads(frames, "temporal layers");
+}
+#endif  // CONFIG_VP8_ENCODER
+#endif  // CONFIG_POSTPROC
 #endif  // CONFIG_VP8_DECODER
 
 // Test VP9 decode in serial mode with single thread.
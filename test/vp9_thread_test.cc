@@ -18,6 +18,7 @@
 #if CONFIG_WEBM_IO
 #include "test/webm_video_source.h"
 #endif
+#include "vpx/vp8.h"
 #include "vpx_util/vpx_thread.h"
 
 namespace {
@@ -154,14 +155,23 @@ struct FileList {
   const char *expected_md5;
 };
 
-// Decodes |filename| with |num_threads|. Returns the md5 of the decoded frames.
-string DecodeFile(const string &filename, int num_threads) {
+// Decodes |filename| with |num_threads| and the post-processing in
+// |postproc_flags|. Returns the md5 of the decoded frames.
+string DecodeFile(const string &filename, int num_threads,
+                  int postproc_flags = 0) {
   libvpx_test::WebMVideoSource video(filename);
   video.Init();
 
   vpx_codec_dec_cfg_t cfg = vpx_codec_dec_cfg_t();
   cfg.threads = num_threads;
-  libvpx_test::VP9Decoder decoder(cfg, 0);
+  libvpx_test::VP9Decoder decoder(cfg,
+                                  postproc_flags ? VPX_CODEC_USE_POSTPROC : 0);
+#if CONFIG_VP9_POSTPROC
+  if (postproc_flags) {
+    vp8_postproc_cfg_t pp_cfg = { postproc_flags, 8, 0 };
+    decoder.Control(VP8_SET_POSTPROC, &pp_cfg);
+  }
+#endif
 
   libvpx_test::MD5 md5;
   for (video.Begin(); video.cxdata(); video.Next()) {
@@ -313,6 +323,28 @@ TEST(VP9DecodeMultiThreadedTest, NonFrameParallel) {
 
   DecodeFiles(files);
 }
+
+#if CONFIG_VP9_POSTPROC
+TEST(VP9DecodeMultiThreadedTest, PostProc) {
+  // Add-noise is left out: it draws from rand() so two decodes never match.
+  static const int kFlags[] = { VP8_DEBLOCK, VP8_DEMACROBLOCK,
+                                VP8_DEBLOCK | VP8_MFQE,
+                                VP8_DEMACROBLOCK | VP8_MFQE };
+  static const char *const kFiles[] = { "vp90-2-03-size-226x226.webm",
+                                        "vp90-2-08-tile-4x1.webm" };
+  for (int f = 0; f < static_cast<int>(sizeof(kFiles) / sizeof(kFiles[0]));
+       ++f) {
+    for (int i = 0; i < static_cast<int>(sizeof(kFlags) / sizeof(kFlags[0]));
+         ++i) {
+      const string expected_md5 = DecodeFile(kFiles[f], 1, kFlags[i]);
+      for (int t = 2; t <= 8; t *= 2) {
+        EXPECT_EQ(expected_md5, DecodeFile(kFiles[f], t, kFlags[i]))
+            << kFiles[f] << " flags = " << kFlags[i] << " threads = " << t;
+      }
+    }
+  }
+}
+#endif  // CONFIG_VP9_POSTPROC
 #endif  // CONFIG_WEBM_IO
 
 INSTANTIATE_TEST_CASE_P(Synchronous, VPxWorkerThreadTest, ::testing::Bool());
@@ -8,15 +8,26 @@
  *  be found in the AUTHORS file in the root of the source tree.
  */
 
+#include <vector>
+
 #include "third_party/googletest/src/include/gtest/gtest.h"
 
 #include "./vpx_config.h"
 #include "./vpx_scale_rtcd.h"
+#if CONFIG_VP9_ENCODER
+#include "./vp9_rtcd.h"
+#endif
+#include "test/acm_random.h"
 #include "test/clear_system_state.h"
 #include "test/register_state_check.h"
+#include "test/util.h"
 #include "vpx_mem/vpx_mem.h"
+#include "vpx_ports/mem.h"
+#include "vpx_ports/vpx_timer.h"
 #include "vpx_scale/yv12config.h"
 
+using libvpx_test::ACMRandom;
+
 namespace {
 
 typedef void (*ExtendFrameBorderFunc)(YV12_BUFFER_CONFIG *ybf);
@@ -233,4 +244,310 @@ TEST_P(CopyFrameTest, CopyFrame) { ASSERT_NO_FATAL_FAILURE(RunTest()); }
 
 INSTANTIATE_TEST_CASE_P(C, CopyFrameTest,
                         ::testing::Values(vp8_yv12_copy_frame_c));
+
+typedef void (*ExtendPlaneFunc)(uint8_t *src, int src_stride, int width,
+                                int height, int extend_top, int extend_left,
+                                int extend_bottom, int extend_right);
+
+// reference function, function to test, bytes per pixel
+typedef std::tr1::tuple<ExtendPlaneFunc, ExtendPlaneFunc, int>
+    ExtendPlaneParam;
+
+class ExtendPlaneTest : public ::testing::TestWithParam<ExtendPlaneParam> {
+ public:
+  virtual ~ExtendPlaneTest() {}
+
+ protected:
+  virtual void SetUp() {
+    ref_fn_ = GET_PARAM(0);
+    extend_fn_ = GET_PARAM(1);
+    bytes_per_pixel_ = GET_PARAM(2);
+    rnd_.Reset(ACMRandom::DeterministicSeed());
+  }
+
+  virtual void TearDown() { libvpx_test::ClearSystemState(); }
+
+  void ResetPlane(int width, int height, int top, int left, int bottom,
+                  int right) {
+    width_ = width;
+    height_ = height;
+    top_ = top;
+    left_ = left;
+    bottom_ = bottom;
+    right_ = right;
+    // Leave a little slack after the right border so overwrites are caught.
+    stride_ = left + width + right + 3;
+    const int size = stride_ * (top + height + bottom) * bytes_per_pixel_;
+    ref_buf_.resize(size);
+    buf_.resize(size);
+    for (int i = 0; i < size; ++i) ref_buf_[i] = rnd_.Rand8();
+    buf_ = ref_buf_;
+  }
+
+  void Extend(ExtendPlaneFunc fn, std::vector<uint8_t> *buf) {
+    uint8_t *const src =
+        &(*buf)[(top_ * stride_ + left_) * bytes_per_pixel_];
+#if CONFIG_VP9_HIGHBITDEPTH
+    if (bytes_per_pixel_ == 2) {
+      fn(CONVERT_TO_BYTEPTR(src), stride_, width_, height_, top_, left_,
+         bottom_, right_);
+      return;
+    }
+#endif
+    fn(src, stride_, width_, height_, top_, left_, bottom_, right_);
+  }
+
+  ExtendPlaneFunc ref_fn_;
+  ExtendPlaneFunc extend_fn_;
+  int bytes_per_pixel_;
+  int width_;
+  int height_;
+  int top_;
+  int left_;
+  int bottom_;
+  int right_;
+  int stride_;
+  std::vector<uint8_t> ref_buf_;
+  std::vector<uint8_t> buf_;
+  ACMRandom rnd_;
+};
+
+TEST_P(ExtendPlaneTest, MatchesReference) {
+  static const int kSizes[] = { 1, 2, 7, 16, 33, 145 };
+  // Full and inner VP9 borders, VP8 borders, and the chroma halves of each,
+  // plus the alignment padding added to the right and bottom borders.
+  static const int kBorders[] = { 160, 96, 80, 48, 32, 16, 0 };
+  for (int w = 0; w < static_cast<int>(sizeof(kSizes) / sizeof(kSizes[0]));
+       ++w) {
+    for (int h = 0; h < static_cast<int>(sizeof(kSizes) / sizeof(kSizes[0]));
+         ++h) {
+      for (int b = 0;
+           b < static_cast<int>(sizeof(kBorders) / sizeof(kBorders[0])); ++b) {
+        const int border = kBorders[b];
+        const int pad = (w + h + b) % 8;
+        ResetPlane(kSizes[w], kSizes[h], border, border, border + pad,
+                   border + pad);
+        Extend(ref_fn_, &ref_buf_);
+        ASM_REGISTER_STATE_CHECK(Extend(extend_fn_, &buf_));
+        ASSERT_TRUE(ref_buf_ == buf_) << "width " << width_ << " height "
+                                      << height_ << " border " << border;
+      }
+    }
+  }
+}
+
+TEST_P(ExtendPlaneTest, DISABLED_Speed) {
+  ResetPlane(1920, 1080, 160, 160, 168, 168);
+  vpx_usec_timer timer;
+  vpx_usec_timer_start(&timer);
+  for (int i = 0; i < 1000; ++i) Extend(extend_fn_, &buf_);
+  vpx_usec_timer_mark(&timer);
+  const int elapsed_time = static_cast<int>(vpx_usec_timer_elapsed(&timer));
+  printf("Extend plane (%d bytes per pixel) 1920x1080 time: %5d us\n",
+         bytes_per_pixel_, elapsed_time);
+}
+
+using std::tr1::make_tuple;
+
+INSTANTIATE_TEST_CASE_P(
+    C, ExtendPlaneTest,
+    ::testing::Values(make_tuple(&vpx_extend_plane_c, &vpx_extend_plane_c, 1)));
+
+#if HAVE_SSE2
+INSTANTIATE_TEST_CASE_P(SSE2, ExtendPlaneTest,
+                        ::testing::Values(make_tuple(&vpx_extend_plane_c,
+                                                     &vpx_extend_plane_sse2,
+                                                     1)));
+#endif  // HAVE_SSE2
+
+#if HAVE_AVX2
+INSTANTIATE_TEST_CASE_P(AVX2, ExtendPlaneTest,
+                        ::testing::Values(make_tuple(&vpx_extend_plane_c,
+                                                     &vpx_extend_plane_avx2,
+                                                     1)));
+#endif  // HAVE_AVX2
+
+#if CONFIG_VP9_HIGHBITDEPTH
+INSTANTIATE_TEST_CASE_P(C_HBD, ExtendPlaneTest,
+                        ::testing::Values(make_tuple(
+                            &vpx_highbd_extend_plane_c,
+                            &vpx_highbd_extend_plane_c, 2)));
+
+#if HAVE_SSE2
+INSTANTIATE_TEST_CASE_P(SSE2_HBD, ExtendPlaneTest,
+                        ::testing::Values(make_tuple(
+                            &vpx_highbd_extend_plane_c,
+                            &vpx_highbd_extend_plane_sse2, 2)));
+#endif  // HAVE_SSE2
+
+#if HAVE_AVX2
+INSTANTIATE_TEST_CASE_P(AVX2_HBD, ExtendPlaneTest,
+                        ::testing::Values(make_tuple(
+                            &vpx_highbd_extend_plane_c,
+                            &vpx_highbd_extend_plane_avx2, 2)));
+#endif  // HAVE_AVX2
+#endif  // CONFIG_VP9_HIGHBITDEPTH
+
+#if CONFIG_VP9
+// Extending the inner borders in bands of rows, as the encoder's loop filter
+// does, must give the same frame as extending the whole frame at once.
+TEST(ExtendInnerBordersRowsTest, MatchesFullFrame) {
+  static const int kSizes[][2] = { { 1, 1 }, { 33, 17 }, { 208, 144 },
+                                   { 351, 287 } };
+  for (int s = 0; s < static_cast<int>(sizeof(kSizes) / sizeof(kSizes[0]));
+       ++s) {
+    for (int band_rows = 1; band_rows <= 64; band_rows *= 4) {
+      YV12_BUFFER_CONFIG full, rows;
+      memset(&full, 0, sizeof(full));
+      memset(&rows, 0, sizeof(rows));
+      ASSERT_EQ(0, vpx_alloc_frame_buffer(&full, kSizes[s][0], kSizes[s][1],
+                                          1, 1,
+#if CONFIG_VP9_HIGHBITDEPTH
+                                          0,
+#endif
+                                          VP9INNERBORDERINPIXELS * 2, 32));
+      ASSERT_EQ(0, vpx_alloc_frame_buffer(&rows, kSizes[s][0], kSizes[s][1],
+                                          1, 1,
+#if CONFIG_VP9_HIGHBITDEPTH
+                                          0,
+#endif
+                                          VP9INNERBORDERINPIXELS * 2, 32));
+      for (int i = 0; i < static_cast<int>(full.frame_size); ++i)
+        full.buffer_alloc[i] = i % 251;
+      memcpy(rows.buffer_alloc, full.buffer_alloc, full.frame_size);
+
+      vpx_extend_frame_inner_borders_c(&full);
+      for (int plane = 0; plane < 3; ++plane) {
+        const int height = plane ? rows.uv_crop_height : rows.y_crop_height;
+        for (int row = 0; row < height; row += band_rows) {
+          vpx_extend_frame_inner_borders_rows(
+              &rows, plane, row,
+              row + band_rows < height ? row + band_rows : height);
+        }
+      }
+      EXPECT_EQ(0, memcmp(full.buffer_alloc, rows.buffer_alloc,
+                          full.frame_size))
+          << kSizes[s][0] << "x" << kSizes[s][1] << " bands of " << band_rows;
+
+      vpx_free_frame_buffer(&full);
+      vpx_free_frame_buffer(&rows);
+    }
+  }
+}
+#endif  // CONFIG_VP9
+
+#if CONFIG_VP9_ENCODER
+typedef void (*ScaleFrameFunc)(const YV12_BUFFER_CONFIG *src,
+                               YV12_BUFFER_CONFIG *dst,
+                               INTERP_FILTER filter_type, int phase_scaler);
+
+class ScaleFrameTest : public ::testing::TestWithParam<ScaleFrameFunc> {
+ public:
+  virtual ~ScaleFrameTest() {}
+
+ protected:
+  virtual void SetUp() {
+    scale_fn_ = GetParam();
+    rnd_.Reset(ACMRandom::DeterministicSeed());
+    memset(&src_, 0, sizeof(src_));
+    memset(&ref_, 0, sizeof(ref_));
+    memset(&dst_, 0, sizeof(dst_));
+  }
+
+  virtual void TearDown() {
+    FreeFrames();
+    libvpx_test::ClearSystemState();
+  }
+
+  static int Alloc(YV12_BUFFER_CONFIG *ybf, int width, int height) {
+    return vpx_alloc_frame_buffer(ybf, width, height, 1, 1,
+#if CONFIG_VP9_HIGHBITDEPTH
+                                  0,
+#endif
+                                  VP9_ENC_BORDER_IN_PIXELS, 0);
+  }
+
+  void FreeFrames() {
+    vpx_free_frame_buffer(&src_);
+    vpx_free_frame_buffer(&ref_);
+    vpx_free_frame_buffer(&dst_);
+  }
+
+  void ResetFrames(int src_w, int src_h, int dst_w, int dst_h) {
+    FreeFrames();
+    ASSERT_EQ(0, Alloc(&src_, src_w, src_h));
+    ASSERT_EQ(0, Alloc(&ref_, dst_w, dst_h));
+    ASSERT_EQ(0, Alloc(&dst_, dst_w, dst_h));
+    for (int i = 0; i < static_cast<int>(src_.frame_size); ++i)
+      src_.buffer_alloc[i] = rnd_.Rand8();
+    memset(ref_.buffer_alloc, kBufFiller, ref_.frame_size);
+    memset(dst_.buffer_alloc, kBufFiller, dst_.frame_size);
+  }
+
+  static const int kBufFiller = 123;
+
+  ScaleFrameFunc scale_fn_;
+  YV12_BUFFER_CONFIG src_;
+  YV12_BUFFER_CONFIG ref_;
+  YV12_BUFFER_CONFIG dst_;
+  ACMRandom rnd_;
+};
+
+TEST_P(ScaleFrameTest, MatchesReference) {
+  // Source and destination sizes: 2:1, 4:3 and 3:2 down, 1:2 and 3:4 up,
+  // including odd and unaligned dimensions.
+  static const int kSizes[][4] = {
+    { 64, 64, 32, 32 },     { 350, 288, 175, 144 }, { 130, 66, 65, 33 },
+    { 320, 240, 240, 180 }, { 198, 98, 132, 66 },   { 64, 48, 128, 96 },
+    { 88, 72, 176, 144 },   { 66, 34, 132, 68 },    { 120, 90, 160, 120 },
+  };
+  static const int kPhases[] = { 0, 3, 8, 13 };
+  for (int s = 0; s < static_cast<int>(sizeof(kSizes) / sizeof(kSizes[0]));
+       ++s) {
+    ASSERT_NO_FATAL_FAILURE(
+        ResetFrames(kSizes[s][0], kSizes[s][1], kSizes[s][2], kSizes[s][3]));
+    for (int filter = EIGHTTAP; filter <= BILINEAR; ++filter) {
+      for (int p = 0;
+           p < static_cast<int>(sizeof(kPhases) / sizeof(kPhases[0])); ++p) {
+        const INTERP_FILTER filter_type = static_cast<INTERP_FILTER>(filter);
+        vp9_scale_and_extend_frame_c(&src_, &ref_, filter_type, kPhases[p]);
+        ASM_REGISTER_STATE_CHECK(
+            scale_fn_(&src_, &dst_, filter_type, kPhases[p]));
+        ASSERT_EQ(0,
+                  memcmp(ref_.buffer_alloc, dst_.buffer_alloc, ref_.frame_size))
+            << kSizes[s][0] << "x" << kSizes[s][1] << " to " << kSizes[s][2]
+            << "x" << kSizes[s][3] << " filter " << filter << " phase "
+            << kPhases[p];
+      }
+    }
+  }
+}
+
+TEST_P(ScaleFrameTest, DISABLED_Speed) {
+  static const int kSizes[][4] = { { 1920, 1080, 960, 540 },
+                                   { 1280, 720, 960, 540 },
+                                   { 1920, 1080, 1280, 720 },
+                                   { 640, 360, 1280, 720 } };
+  for (int s = 0; s < static_cast<int>(sizeof(kSizes) / sizeof(kSizes[0]));
+       ++s) {
+    ASSERT_NO_FATAL_FAILURE(
+        ResetFrames(kSizes[s][0], kSizes[s][1], kSizes[s][2], kSizes[s][3]));
+    vpx_usec_timer timer;
+    vpx_usec_timer_start(&timer);
+    for (int i = 0; i < 100; ++i) scale_fn_(&src_, &dst_, EIGHTTAP, 8);
+    vpx_usec_timer_mark(&timer);
+    const int elapsed_time = static_cast<int>(vpx_usec_timer_elapsed(&timer));
+    printf("Scale frame %dx%d to %dx%d time: %5d us\n", kSizes[s][0],
+           kSizes[s][1], kSizes[s][2], kSizes[s][3], elapsed_time);
+  }
+}
+
+INSTANTIATE_TEST_CASE_P(C, ScaleFrameTest,
+                        ::testing::Values(&vp9_scale_and_extend_frame_c));
+
+#if HAVE_SSSE3
+INSTANTIATE_TEST_CASE_P(SSSE3, ScaleFrameTest,
+                        ::testing::Values(&vp9_scale_and_extend_frame_ssse3));
+#endif  // HAVE_SSSE3
+#endif  // CONFIG_VP9_ENCODER
 }  // namespace
@@ -254,6 +254,25 @@ int vpx_img_read(vpx_image_t *img, FILE *file) {
   return 1;
 }
 
+void vpx_img_copy(const vpx_image_t *src, vpx_image_t *dst) {
+  int plane;
+
+  for (plane = 0; plane < 3; ++plane) {
+    const unsigned char *src_buf = src->planes[plane];
+    unsigned char *dst_buf = dst->planes[plane];
+    const int w = vpx_img_plane_width(src, plane) *
+                  ((src->fmt & VPX_IMG_FMT_HIGHBITDEPTH) ? 2 : 1);
+    const int h = vpx_img_plane_height(src, plane);
+    int y;
+
+    for (y = 0; y < h; ++y) {
+      memcpy(dst_buf, src_buf, w);
+      src_buf += src->stride[plane];
+      dst_buf += dst->stride[plane];
+    }
+  }
+}
+
 // TODO(dkovalev) change sse_to_psnr signature: double -> int64_t
 double sse_to_psnr(double samples, double peak, double sse) {
   static const double kMaxPSNR = 100.0;
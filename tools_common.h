@@ -150,6 +150,9 @@ int vpx_img_plane_width(const vpx_image_t *img, int plane);
 int vpx_img_plane_height(const vpx_image_t *img, int plane);
 void vpx_img_write(const vpx_image_t *img, FILE *file);
 int vpx_img_read(vpx_image_t *img, FILE *file);
+// Copies the pixels of |src| into |dst|, which must have the same format and
+// dimensions.
+void vpx_img_copy(const vpx_image_t *src, vpx_image_t *dst);
 
 double sse_to_psnr(double samples, double peak, double mse);
 
@@ -217,7 +217,7 @@ static int qualify_inter_mb(const MODE_INFO *mode_info_context, int *map) {
     int i, j;
     for (i = 0; i < 4; ++i) {
       map[i] = 1;
-      for (j = 0; j < 4 && map[j]; ++j) {
+      for (j = 0; j < 4 && map[i]; ++j) {
         map[i] &= (mode_info_context->bmi[ndx[i][j]].mv.as_mv.row <= 2 &&
                    mode_info_context->bmi[ndx[i][j]].mv.as_mv.col <= 2);
       }
@@ -231,14 +231,13 @@ static int qualify_inter_mb(const MODE_INFO *mode_info_context, int *map) {
   return (map[0] + map[1] + map[2] + map[3]);
 }
 
-void vp8_multiframe_quality_enhance(VP8_COMMON *cm) {
-  YV12_BUFFER_CONFIG *show = cm->frame_to_show;
+void vp8_multiframe_quality_enhance_mb_row(VP8_COMMON *cm,
+                                           YV12_BUFFER_CONFIG *show,
+                                           const MODE_INFO *mode_info_context,
+                                           int mb_row) {
   YV12_BUFFER_CONFIG *dest = &cm->post_proc_buffer;
 
   FRAME_TYPE frame_type = cm->frame_type;
-  /* Point at base of Mb MODE_INFO list has motion vectors etc */
-  const MODE_INFO *mode_info_context = cm->show_frame_mi;
-  int mb_row;
   int mb_col;
   int totmap, map[4];
   int qcurr = cm->base_qindex;
@@ -248,83 +247,82 @@ void vp8_multiframe_quality_enhance(VP8_COMMON *cm) {
   unsigned char *yd_ptr, *ud_ptr, *vd_ptr;
 
   /* Set up the buffer pointers */
-  y_ptr = show->y_buffer;
-  u_ptr = show->u_buffer;
-  v_ptr = show->v_buffer;
-  yd_ptr = dest->y_buffer;
-  ud_ptr = dest->u_buffer;
-  vd_ptr = dest->v_buffer;
+  y_ptr = show->y_buffer + 16 * mb_row * show->y_stride;
+  u_ptr = show->u_buffer + 8 * mb_row * show->uv_stride;
+  v_ptr = show->v_buffer + 8 * mb_row * show->uv_stride;
+  yd_ptr = dest->y_buffer + 16 * mb_row * dest->y_stride;
+  ud_ptr = dest->u_buffer + 8 * mb_row * dest->uv_stride;
+  vd_ptr = dest->v_buffer + 8 * mb_row * dest->uv_stride;
+  mode_info_context += mb_row * cm->mode_info_stride;
 
   /* postprocess each macro block */
-  for (mb_row = 0; mb_row < cm->mb_rows; ++mb_row) {
-    for (mb_col = 0; mb_col < cm->mb_cols; ++mb_col) {
-      /* if motion is high there will likely be no benefit */
-      if (frame_type == INTER_FRAME) {
-        totmap = qualify_inter_mb(mode_info_context, map);
-      } else {
-        totmap = (frame_type == KEY_FRAME ? 4 : 0);
-      }
-      if (totmap) {
-        if (totmap < 4) {
-          int i, j;
-          for (i = 0; i < 2; ++i) {
-            for (j = 0; j < 2; ++j) {
-              if (map[i * 2 + j]) {
-                multiframe_quality_enhance_block(
-                    8, qcurr, qprev, y_ptr + 8 * (i * show->y_stride + j),
-                    u_ptr + 4 * (i * show->uv_stride + j),
-                    v_ptr + 4 * (i * show->uv_stride + j), show->y_stride,
-                    show->uv_stride, yd_ptr + 8 * (i * dest->y_stride + j),
-                    ud_ptr + 4 * (i * dest->uv_stride + j),
-                    vd_ptr + 4 * (i * dest->uv_stride + j), dest->y_stride,
-                    dest->uv_stride);
-              } else {
-                /* copy a 8x8 block */
-                int k;
-                unsigned char *up = u_ptr + 4 * (i * show->uv_stride + j);
-                unsigned char *udp = ud_ptr + 4 * (i * dest->uv_stride + j);
-                unsigned char *vp = v_ptr + 4 * (i * show->uv_stride + j);
-                unsigned char *vdp = vd_ptr + 4 * (i * dest->uv_stride + j);
-                vp8_copy_mem8x8(
-                    y_ptr + 8 * (i * show->y_stride + j), show->y_stride,
-                    yd_ptr + 8 * (i * dest->y_stride + j), dest->y_stride);
-                for (k = 0; k < 4; ++k, up += show->uv_stride,
-                    udp += dest->uv_stride, vp += show->uv_stride,
-                    vdp += dest->uv_stride) {
-                  memcpy(udp, up, 4);
-                  memcpy(vdp, vp, 4);
-                }
+  for (mb_col = 0; mb_col < cm->mb_cols; ++mb_col) {
+    /* if motion is high there will likely be no benefit */
+    if (frame_type == INTER_FRAME) {
+      totmap = qualify_inter_mb(mode_info_context, map);
+    } else {
+      totmap = (frame_type == KEY_FRAME ? 4 : 0);
+    }
+    if (totmap) {
+      if (totmap < 4) {
+        int i, j;
+        for (i = 0; i < 2; ++i) {
+          for (j = 0; j < 2; ++j) {
+            if (map[i * 2 + j]) {
+              multiframe_quality_enhance_block(
+                  8, qcurr, qprev, y_ptr + 8 * (i * show->y_stride + j),
+                  u_ptr + 4 * (i * show->uv_stride + j),
+                  v_ptr + 4 * (i * show->uv_stride + j), show->y_stride,
+                  show->uv_stride, yd_ptr + 8 * (i * dest->y_stride + j),
+                  ud_ptr + 4 * (i * dest->uv_stride + j),
+                  vd_ptr + 4 * (i * dest->uv_stride + j), dest->y_stride,
+                  dest->uv_stride);
+            } else {
+              /* copy a 8x8 block */
+              int k;
+              unsigned char *up = u_ptr + 4 * (i * show->uv_stride + j);
+              unsigned char *udp = ud_ptr + 4 * (i * dest->uv_stride + j);
+              unsigned char *vp = v_ptr + 4 * (i * show->uv_stride + j);
+              unsigned char *vdp = vd_ptr + 4 * (i * dest->uv_stride + j);
+              vp8_copy_mem8x8(
+                  y_ptr + 8 * (i * show->y_stride + j), show->y_stride,
+                  yd_ptr + 8 * (i * dest->y_stride + j), dest->y_stride);
+              for (k = 0; k < 4; ++k, up += show->uv_stride,
+                  udp += dest->uv_stride, vp += show->uv_stride,
+                  vdp += dest->uv_stride) {
+                memcpy(udp, up, 4);
+                memcpy(vdp, vp, 4);
               }
             }
           }
-        } else /* totmap = 4 */
-        {
-          multiframe_quality_enhance_block(
-              16, qcurr, qprev, y_ptr, u_ptr, v_ptr, show->y_stride,
-              show->uv_stride, yd_ptr, ud_ptr, vd_ptr, dest->y_stride,
-              dest->uv_stride);
         }
-      } else {
-        vp8_copy_mem16x16(y_ptr, show->y_stride, yd_ptr, dest->y_stride);
-        vp8_copy_mem8x8(u_ptr, show->uv_stride, ud_ptr, dest->uv_stride);
-        vp8_copy_mem8x8(v_ptr, show->uv_stride, vd_ptr, dest->uv_stride);
+      } else /* totmap = 4 */
+      {
+        multiframe_quality_enhance_block(
+            16, qcurr, qprev, y_ptr, u_ptr, v_ptr, show->y_stride,
+            show->uv_stride, yd_ptr, ud_ptr, vd_ptr, dest->y_stride,
+            dest->uv_stride);
       }
-      y_ptr += 16;
-      u_ptr += 8;
-      v_ptr += 8;
-      yd_ptr += 16;
-      ud_ptr += 8;
-      vd_ptr += 8;
-      mode_info_context++; /* step to next MB */
+    } else {
+      vp8_copy_mem16x16(y_ptr, show->y_stride, yd_ptr, dest->y_stride);
+      vp8_copy_mem8x8(u_ptr, show->uv_stride, ud_ptr, dest->uv_stride);
+      vp8_copy_mem8x8(v_ptr, show->uv_stride, vd_ptr, dest->uv_stride);
     }
+    y_ptr += 16;
+    u_ptr += 8;
+    v_ptr += 8;
+    yd_ptr += 16;
+    ud_ptr += 8;
+    vd_ptr += 8;
+    mode_info_context++; /* step to next MB */
+  }
+}
 
-    y_ptr += show->y_stride * 16 - 16 * cm->mb_cols;
-    u_ptr += show->uv_stride * 8 - 8 * cm->mb_cols;
-    v_ptr += show->uv_stride * 8 - 8 * cm->mb_cols;
-    yd_ptr += dest->y_stride * 16 - 16 * cm->mb_cols;
-    ud_ptr += dest->uv_stride * 8 - 8 * cm->mb_cols;
-    vd_ptr += dest->uv_stride * 8 - 8 * cm->mb_cols;
+void vp8_multiframe_quality_enhance(VP8_COMMON *cm) {
+  int mb_row;
 
-    mode_info_context++; /* Skip border mb */
+  for (mb_row = 0; mb_row < cm->mb_rows; ++mb_row) {
+    vp8_multiframe_quality_enhance_mb_row(cm, cm->frame_to_show,
+                                          cm->show_frame_mi, mb_row);
   }
 }
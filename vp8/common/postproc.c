@@ -12,6 +12,7 @@
 #include "vpx_dsp_rtcd.h"
 #include "vp8_rtcd.h"
 #include "vpx_dsp/postproc.h"
+#include "vpx_dsp/vpx_dsp_common.h"
 #include "vpx_ports/system_state.h"
 #include "vpx_scale_rtcd.h"
 #include "vpx_scale/yv12config.h"
@@ -59,57 +60,72 @@ static void vp8_de_mblock(YV12_BUFFER_CONFIG *post, int q) {
                        post->y_width, q2mbl(q));
 }
 
+static int get_deblock_ppl(int q) {
+  double level = 6.0e-05 * q * q * q - .0067 * q * q + .306 * q + .0065;
+  return (int)(level + .5);
+}
+
+/* Deblocks macroblock row 'mbr' of 'source' into 'post'. 'mode_info_context'
+ * points at the first macroblock of the row. */
+static void deblock_mb_row(const MODE_INFO *mode_info_context,
+                           YV12_BUFFER_CONFIG *source, YV12_BUFFER_CONFIG *post,
+                           int mbr, int mb_cols, int ppl,
+                           unsigned char *limits) {
+  /* The pixel thresholds are adjusted according to if or not the macroblock
+   * is a skipped block.  */
+  unsigned char *ylimits = limits;
+  unsigned char *uvlimits = limits + 16 * mb_cols;
+  unsigned char *ylptr = ylimits;
+  unsigned char *uvlptr = uvlimits;
+  int mbc;
+
+  for (mbc = 0; mbc < mb_cols; ++mbc) {
+    unsigned char mb_ppl;
+
+    if (mode_info_context->mbmi.mb_skip_coeff) {
+      mb_ppl = (unsigned char)ppl >> 1;
+    } else {
+      mb_ppl = (unsigned char)ppl;
+    }
+
+    memset(ylptr, mb_ppl, 16);
+    memset(uvlptr, mb_ppl, 8);
+
+    ylptr += 16;
+    uvlptr += 8;
+    mode_info_context++;
+  }
+
+  vpx_post_proc_down_and_across_mb_row(
+      source->y_buffer + 16 * mbr * source->y_stride,
+      post->y_buffer + 16 * mbr * post->y_stride, source->y_stride,
+      post->y_stride, source->y_width, ylimits, 16);
+
+  vpx_post_proc_down_and_across_mb_row(
+      source->u_buffer + 8 * mbr * source->uv_stride,
+      post->u_buffer + 8 * mbr * post->uv_stride, source->uv_stride,
+      post->uv_stride, source->uv_width, uvlimits, 8);
+  vpx_post_proc_down_and_across_mb_row(
+      source->v_buffer + 8 * mbr * source->uv_stride,
+      post->v_buffer + 8 * mbr * post->uv_stride, source->uv_stride,
+      post->uv_stride, source->uv_width, uvlimits, 8);
+}
+
 void vp8_deblock(VP8_COMMON *cm, YV12_BUFFER_CONFIG *source,
                  YV12_BUFFER_CONFIG *post, int q, int low_var_thresh,
                  int flag) {
-  double level = 6.0e-05 * q * q * q - .0067 * q * q + .306 * q + .0065;
-  int ppl = (int)(level + .5);
+  int ppl = get_deblock_ppl(q);
 
   const MODE_INFO *mode_info_context = cm->show_frame_mi;
-  int mbr, mbc;
-
-  /* The pixel thresholds are adjusted according to if or not the macroblock
-   * is a skipped block.  */
-  unsigned char *ylimits = cm->pp_limits_buffer;
-  unsigned char *uvlimits = cm->pp_limits_buffer + 16 * cm->mb_cols;
+  int mbr;
   (void)low_var_thresh;
   (void)flag;
 
   if (ppl > 0) {
     for (mbr = 0; mbr < cm->mb_rows; ++mbr) {
-      unsigned char *ylptr = ylimits;
-      unsigned char *uvlptr = uvlimits;
-      for (mbc = 0; mbc < cm->mb_cols; ++mbc) {
-        unsigned char mb_ppl;
-
-        if (mode_info_context->mbmi.mb_skip_coeff) {
-          mb_ppl = (unsigned char)ppl >> 1;
-        } else {
-          mb_ppl = (unsigned char)ppl;
-        }
-
-        memset(ylptr, mb_ppl, 16);
-        memset(uvlptr, mb_ppl, 8);
-
-        ylptr += 16;
-        uvlptr += 8;
-        mode_info_context++;
-      }
-      mode_info_context++;
-
-      vpx_post_proc_down_and_across_mb_row(
-          source->y_buffer + 16 * mbr * source->y_stride,
-          post->y_buffer + 16 * mbr * post->y_stride, source->y_stride,
-          post->y_stride, source->y_width, ylimits, 16);
-
-      vpx_post_proc_down_and_across_mb_row(
-          source->u_buffer + 8 * mbr * source->uv_stride,
-          post->u_buffer + 8 * mbr * post->uv_stride, source->uv_stride,
-          post->uv_stride, source->uv_width, uvlimits, 8);
-      vpx_post_proc_down_and_across_mb_row(
-          source->v_buffer + 8 * mbr * source->uv_stride,
-          post->v_buffer + 8 * mbr * post->uv_stride, source->uv_stride,
-          post->uv_stride, source->uv_width, uvlimits, 8);
+      deblock_mb_row(mode_info_context, source, post, mbr, cm->mb_cols, ppl,
+                     cm->pp_limits_buffer);
+      mode_info_context += cm->mode_info_stride;
     }
   } else {
     vp8_yv12_copy_frame(source, post);
@@ -270,28 +286,20 @@ void vp8_blend_b_c(unsigned char *y, unsigned char *u, unsigned char *v,
 }
 
 #if CONFIG_POSTPROC
-int vp8_post_proc_frame(VP8_COMMON *oci, YV12_BUFFER_CONFIG *dest,
-                        vp8_ppflags_t *ppflags) {
-  int q = oci->filter_level * 10 / 6;
-  int flags = ppflags->post_proc_flag;
-  int deblock_level = ppflags->deblocking_level;
-  int noise_level = ppflags->noise_level;
-
-  if (!oci->frame_to_show) return -1;
-
-  if (q > 63) q = 63;
+static int get_pp_q(const VP8_COMMON *oci) {
+  const int q = oci->filter_level * 10 / 6;
+  return q > 63 ? 63 : q;
+}
 
-  if (!flags) {
-    *dest = *oci->frame_to_show;
+/* Returns whether MFQE runs on the frame counted as 'video_frame'. */
+static int use_mfqe(const VP8_COMMON *oci, int flags,
+                    unsigned int video_frame) {
+  return (flags & VP8D_MFQE) && oci->postproc_state.last_frame_valid &&
+         video_frame >= 2 && oci->postproc_state.last_base_qindex < 60 &&
+         oci->base_qindex - oci->postproc_state.last_base_qindex >= 20;
+}
 
-    /* handle problem with extending borders */
-    dest->y_width = oci->Width;
-    dest->y_height = oci->Height;
-    dest->uv_height = dest->y_height / 2;
-    oci->postproc_state.last_base_qindex = oci->base_qindex;
-    oci->postproc_state.last_frame_valid = 1;
-    return 0;
-  }
+static int alloc_post_proc_buffers(VP8_COMMON *oci, int flags) {
   if (flags & VP8D_ADDNOISE) {
     if (!oci->postproc_state.generated_noise) {
       oci->postproc_state.generated_noise = vpx_calloc(
@@ -321,13 +329,42 @@ int vp8_post_proc_frame(VP8_COMMON *oci, YV12_BUFFER_CONFIG *dest,
              (&oci->post_proc_buffer)->frame_size);
     }
   }
+  return 0;
+}
+
+int vp8_post_proc_frame(VP8_COMMON *oci, YV12_BUFFER_CONFIG *dest,
+                        vp8_ppflags_t *ppflags) {
+  int q = get_pp_q(oci);
+  int flags = ppflags->post_proc_flag;
+  int deblock_level = ppflags->deblocking_level;
+  int noise_level = ppflags->noise_level;
+  struct postproc_state *const ppstate = &oci->postproc_state;
+  int mfqe;
+
+  if (!oci->frame_to_show) return -1;
+
+  if (!flags) {
+    *dest = *oci->frame_to_show;
+
+    /* handle problem with extending borders */
+    dest->y_width = oci->Width;
+    dest->y_height = oci->Height;
+    dest->uv_height = dest->y_height / 2;
+    oci->postproc_state.last_base_qindex = oci->base_qindex;
+    oci->postproc_state.last_frame_valid = 1;
+    return 0;
+  }
+  if (alloc_post_proc_buffers(oci, flags)) return 1;
 
   vpx_clear_system_state();
 
-  if ((flags & VP8D_MFQE) && oci->postproc_state.last_frame_valid &&
-      oci->current_video_frame >= 2 &&
-      oci->postproc_state.last_base_qindex < 60 &&
-      oci->base_qindex - oci->postproc_state.last_base_qindex >= 20) {
+  if (ppstate->rows_done &&
+      !((ppstate->rows_flags ^ flags) & ~VP8D_ADDNOISE) &&
+      ppstate->rows_deblocking_level == deblock_level) {
+    /* The decoder threads already filtered the frame. */
+    mfqe = ppstate->rows_mfqe;
+  } else if (use_mfqe(oci, flags, oci->current_video_frame)) {
+    mfqe = 1;
     vp8_multiframe_quality_enhance(oci);
     if (((flags & VP8D_DEBLOCK) || (flags & VP8D_DEMACROBLOCK)) &&
         oci->post_proc_buffer_int_used) {
@@ -341,20 +378,25 @@ int vp8_post_proc_frame(VP8_COMMON *oci, YV12_BUFFER_CONFIG *dest,
                     1, 0);
       }
     }
+  } else {
+    mfqe = 0;
+    if (flags & VP8D_DEMACROBLOCK) {
+      vp8_deblock(oci, oci->frame_to_show, &oci->post_proc_buffer,
+                  q + (deblock_level - 5) * 10, 1, 0);
+      vp8_de_mblock(&oci->post_proc_buffer, q + (deblock_level - 5) * 10);
+    } else if (flags & VP8D_DEBLOCK) {
+      vp8_deblock(oci, oci->frame_to_show, &oci->post_proc_buffer, q, 1, 0);
+    } else {
+      vp8_yv12_copy_frame(oci->frame_to_show, &oci->post_proc_buffer);
+    }
+  }
+  ppstate->rows_done = 0;
+
+  if (mfqe) {
     /* Move partially towards the base q of the previous frame */
     oci->postproc_state.last_base_qindex =
         (3 * oci->postproc_state.last_base_qindex + oci->base_qindex) >> 2;
-  } else if (flags & VP8D_DEMACROBLOCK) {
-    vp8_deblock(oci, oci->frame_to_show, &oci->post_proc_buffer,
-                q + (deblock_level - 5) * 10, 1, 0);
-    vp8_de_mblock(&oci->post_proc_buffer, q + (deblock_level - 5) * 10);
-
-    oci->postproc_state.last_base_qindex = oci->base_qindex;
-  } else if (flags & VP8D_DEBLOCK) {
-    vp8_deblock(oci, oci->frame_to_show, &oci->post_proc_buffer, q, 1, 0);
-    oci->postproc_state.last_base_qindex = oci->base_qindex;
   } else {
-    vp8_yv12_copy_frame(oci->frame_to_show, &oci->post_proc_buffer);
     oci->postproc_state.last_base_qindex = oci->base_qindex;
   }
   oci->postproc_state.last_frame_valid = 1;
@@ -363,7 +405,6 @@ int vp8_post_proc_frame(VP8_COMMON *oci, YV12_BUFFER_CONFIG *dest,
     if (oci->postproc_state.last_q != q ||
         oci->postproc_state.last_noise != noise_level) {
       double sigma;
-      struct postproc_state *ppstate = &oci->postproc_state;
       vpx_clear_system_state();
       sigma = noise_level + .5 + .6 * q / 63.0;
       ppstate->clamp =
@@ -387,4 +428,131 @@ int vp8_post_proc_frame(VP8_COMMON *oci, YV12_BUFFER_CONFIG *dest,
   dest->uv_height = dest->y_height / 2;
   return 0;
 }
+
+static void copy_mb_row(const YV12_BUFFER_CONFIG *src, YV12_BUFFER_CONFIG *dst,
+                        int mb_row) {
+  int i;
+
+  for (i = 16 * mb_row; i < 16 * mb_row + 16; ++i) {
+    memcpy(dst->y_buffer + i * dst->y_stride, src->y_buffer + i * src->y_stride,
+           src->y_width);
+  }
+  for (i = 8 * mb_row; i < 8 * mb_row + 8; ++i) {
+    memcpy(dst->u_buffer + i * dst->uv_stride,
+           src->u_buffer + i * src->uv_stride, src->uv_width);
+    memcpy(dst->v_buffer + i * dst->uv_stride,
+           src->v_buffer + i * src->uv_stride, src->uv_width);
+  }
+}
+
+/* Returns the q of the deblocking filter picked by vp8_post_proc_rows_init(),
+ * which also drives the demacroblock filter. */
+static int get_rows_deblock_q(const VP8_COMMON *oci) {
+  const struct postproc_state *const ppstate = &oci->postproc_state;
+  const int q = get_pp_q(oci);
+  if (ppstate->rows_flags & VP8D_DEMACROBLOCK) {
+    return q + (ppstate->rows_deblocking_level - 5) * 10;
+  }
+  return q;
+}
+
+/* Deblocks row 'mb_row' of 'source' into post_proc_buffer, followed by the
+ * horizontal demacroblock filter when it is enabled. */
+static void deblock_rows_mb_row(VP8_COMMON *oci, YV12_BUFFER_CONFIG *source,
+                                int mb_row, unsigned char *limits) {
+  YV12_BUFFER_CONFIG *const post = &oci->post_proc_buffer;
+  const int q = get_rows_deblock_q(oci);
+  const int ppl = get_deblock_ppl(q);
+
+  if (ppl > 0) {
+    deblock_mb_row(oci->mi + mb_row * oci->mode_info_stride, source, post,
+                   mb_row, oci->mb_cols, ppl, limits);
+  } else {
+    copy_mb_row(source, post, mb_row);
+  }
+  if (oci->postproc_state.rows_flags & VP8D_DEMACROBLOCK) {
+    vpx_mbpost_proc_across_ip(post->y_buffer + 16 * mb_row * post->y_stride,
+                              post->y_stride, 16, post->y_width, q2mbl(q));
+  }
+}
+
+int vp8_post_proc_rows_init(VP8_COMMON *oci, const vp8_ppflags_t *ppflags) {
+  struct postproc_state *const ppstate = &oci->postproc_state;
+  const int flags = ppflags->post_proc_flag;
+
+  ppstate->rows_done = 0;
+  if (!oci->show_frame ||
+      !(flags & (VP8D_DEBLOCK | VP8D_DEMACROBLOCK | VP8D_MFQE))) {
+    return 0;
+  }
+  if (alloc_post_proc_buffers(oci, flags)) return 0;
+
+  ppstate->rows_flags = flags;
+  ppstate->rows_deblocking_level = ppflags->deblocking_level;
+  /* The frame counter only moves past the frame once it is decoded. */
+  ppstate->rows_mfqe = use_mfqe(oci, flags, oci->current_video_frame + 1);
+  return 1;
+}
+
+void vp8_post_proc_mb_row(VP8_COMMON *oci, YV12_BUFFER_CONFIG *show,
+                          int mb_row, unsigned char *limits) {
+  const struct postproc_state *const ppstate = &oci->postproc_state;
+
+  if (ppstate->rows_mfqe) {
+    vp8_multiframe_quality_enhance_mb_row(oci, show, oci->mi, mb_row);
+  } else if (ppstate->rows_flags & (VP8D_DEBLOCK | VP8D_DEMACROBLOCK)) {
+    /* The first and last rows read the frame borders, which are extended
+     * once the whole frame is decoded. */
+    if (mb_row == 0 || mb_row == oci->mb_rows - 1) return;
+    deblock_rows_mb_row(oci, show, mb_row, limits);
+  } else {
+    copy_mb_row(show, &oci->post_proc_buffer, mb_row);
+  }
+}
+
+int vp8_post_proc_rows_end(VP8_COMMON *oci) {
+  struct postproc_state *const ppstate = &oci->postproc_state;
+  const int flags = ppstate->rows_flags;
+
+  ppstate->rows_done = 1;
+  if (!(flags & (VP8D_DEBLOCK | VP8D_DEMACROBLOCK))) return VP8_PP_ROWS_NONE;
+  if (ppstate->rows_mfqe) {
+    if (!oci->post_proc_buffer_int_used) return VP8_PP_ROWS_NONE;
+    vp8_yv12_copy_frame(&oci->post_proc_buffer, &oci->post_proc_buffer_int);
+  }
+  return (flags & VP8D_DEMACROBLOCK) ? VP8_PP_ROWS_DOWN : VP8_PP_ROWS_DEBLOCK;
+}
+
+void vp8_post_proc_rows_finish(VP8_COMMON *oci, YV12_BUFFER_CONFIG *show,
+                               int stage, int job, int num_jobs,
+                               unsigned char *limits) {
+  const struct postproc_state *const ppstate = &oci->postproc_state;
+  YV12_BUFFER_CONFIG *const post = &oci->post_proc_buffer;
+  int mb_row;
+
+  if (stage == VP8_PP_ROWS_DEBLOCK) {
+    if (ppstate->rows_mfqe) {
+      /* MFQE wrote post_proc_buffer, which vp8_post_proc_rows_end() copied
+       * to post_proc_buffer_int. */
+      for (mb_row = job; mb_row < oci->mb_rows; mb_row += num_jobs) {
+        deblock_rows_mb_row(oci, &oci->post_proc_buffer_int, mb_row, limits);
+      }
+    } else {
+      if (job == 0) deblock_rows_mb_row(oci, show, 0, limits);
+      if (job == num_jobs - 1 && oci->mb_rows > 1) {
+        deblock_rows_mb_row(oci, show, oci->mb_rows - 1, limits);
+      }
+    }
+  } else if (stage == VP8_PP_ROWS_DOWN) {
+    /* Strips start on multiples of 16 columns, which keeps the per column
+     * dither offsets of vpx_mbpost_proc_down() unchanged. */
+    const int strip = (post->y_width / 16 + num_jobs - 1) / num_jobs * 16;
+    const int col = job * strip;
+    const int cols = VPXMIN(strip, post->y_width - col);
+    if (cols > 0) {
+      vpx_mbpost_proc_down(post->y_buffer + col, post->y_stride, post->y_height,
+                           cols, q2mbl(get_rows_deblock_q(oci)));
+    }
+  }
+}
 #endif
@@ -19,6 +19,12 @@ struct postproc_state {
   int last_frame_valid;
   int clamp;
   int8_t *generated_noise;
+  /* Filters picked by vp8_post_proc_rows_init() for the frame being decoded,
+   * and whether the frame to show already went through them. */
+  int rows_flags;
+  int rows_deblocking_level;
+  int rows_mfqe;
+  int rows_done;
 };
 #include "onyxc_int.h"
 #include "ppflags.h"
@@ -39,6 +45,44 @@ void vp8_deblock(struct VP8Common *oci, YV12_BUFFER_CONFIG *source,
 #define MFQE_PRECISION 4
 
 void vp8_multiframe_quality_enhance(struct VP8Common *cm);
+
+void vp8_multiframe_quality_enhance_mb_row(struct VP8Common *cm,
+                                           YV12_BUFFER_CONFIG *show,
+                                           const struct modeinfo *mi,
+                                           int mb_row);
+
+/* The multi-threaded decoder post-processes the frame while it is decoded:
+ * vp8_post_proc_rows_init() picks the filters vp8_post_proc_frame() would run
+ * with 'flags', vp8_post_proc_mb_row() filters each macroblock row once the
+ * loop filter has finished it and its neighbours, and the stages up to the
+ * one returned by vp8_post_proc_rows_end() finish the frame once its borders
+ * are extended. vp8_post_proc_frame() then only adds noise.
+ *
+ * Returns 0 if the frame is left to vp8_post_proc_frame(). */
+int vp8_post_proc_rows_init(struct VP8Common *oci, const vp8_ppflags_t *flags);
+
+/* 'show' is the frame being decoded and 'limits' scratch space of the size of
+ * pp_limits_buffer owned by the calling thread. Rows may run concurrently. */
+void vp8_post_proc_mb_row(struct VP8Common *oci, YV12_BUFFER_CONFIG *show,
+                          int mb_row, unsigned char *limits);
+
+enum {
+  VP8_PP_ROWS_NONE = 0,
+  /* Deblocks the rows that need the frame borders. */
+  VP8_PP_ROWS_DEBLOCK,
+  /* Runs the vertical demacroblock filter on column strips. */
+  VP8_PP_ROWS_DOWN
+};
+
+/* Called once all rows went through vp8_post_proc_mb_row(). Returns the last
+ * stage that has work left, VP8_PP_ROWS_NONE if there is none. */
+int vp8_post_proc_rows_end(struct VP8Common *oci);
+
+/* Runs part 'job' of 'num_jobs' of 'stage'. Each stage must be complete for
+ * all the jobs before the next one starts. */
+void vp8_post_proc_rows_finish(struct VP8Common *oci, YV12_BUFFER_CONFIG *show,
+                               int stage, int job, int num_jobs,
+                               unsigned char *limits);
 #ifdef __cplusplus
 }  // extern "C"
 #endif
@@ -19,7 +19,7 @@ enum {
   VP8D_DEBLOCK = 1 << 0,
   VP8D_DEMACROBLOCK = 1 << 1,
   VP8D_ADDNOISE = 1 << 2,
-  VP8D_MFQE = 1 << 3
+  VP8D_MFQE = 1 << 10
 };
 
 typedef struct {
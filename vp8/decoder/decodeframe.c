@@ -1209,6 +1209,9 @@ int vp8_decode_frame(VP8D_COMP *pbi) {
     unsigned int thread;
     vp8mt_decode_mb_rows(pbi, xd);
     vp8_yv12_extend_frame_borders(yv12_fb_new);
+#if CONFIG_POSTPROC
+    vp8mt_post_proc_frame(pbi);
+#endif
     for (thread = 0; thread < pbi->decoding_thread_count; ++thread) {
       corrupt_tokens |= pbi->mb_row_di[thread].mbd.corrupted;
     }
@@ -310,6 +310,9 @@ int vp8dx_receive_compressed_data(VP8D_COMP *pbi, size_t size,
   (void)source;
 
   pbi->common.error.error_code = VPX_CODEC_OK;
+#if CONFIG_POSTPROC
+  cm->postproc_state.rows_done = 0;
+#endif
 
   retcode = check_fragments_for_errors(pbi);
   if (retcode <= 0) return retcode;
@@ -93,9 +93,20 @@ typedef struct VP8D_COMP {
   pthread_t *h_decoding_thread;
   sem_t *h_event_start_decoding;
   sem_t h_event_end_decoding;
+
+#if CONFIG_POSTPROC
+  int mt_post_proc;       /* rows are post-processed while decoding */
+  int mt_post_proc_stage; /* VP8_PP_ROWS_* stage run by woken up threads */
+  unsigned char **mt_pp_limits; /* (decoding_thread_count + 1) x limits */
+#endif
 /* end of threading data */
 #endif
 
+#if CONFIG_POSTPROC
+  /* Post-processing the application will ask for, see vp8mt_decode_mb_rows. */
+  vp8_ppflags_t ppflags;
+#endif
+
   int64_t last_time_stamp;
   int ready_for_new_data;
 
@@ -25,6 +25,9 @@
 #include "vp8/common/reconinter.h"
 #include "vp8/common/reconintra.h"
 #include "vp8/common/setupintrarecon.h"
+#if CONFIG_POSTPROC
+#include "vp8/common/postproc.h"
+#endif
 #if CONFIG_ERROR_CONCEALMENT
 #include "error_concealment.h"
 #endif
@@ -551,6 +554,19 @@ static void mt_decode_mb_rows(VP8D_COMP *pbi, MACROBLOCKD *xd,
     /* last MB of row is ready just after extension is done */
     protected_write(&pbi->pmutex[mb_row], current_mb_col, mb_col + nsync);
 
+#if CONFIG_POSTPROC
+    if (pbi->mt_post_proc) {
+      /* The loop filter of this row has finished the row above it. */
+      unsigned char *const limits = pbi->mt_pp_limits[start_mb_row];
+      if (mb_row > 0) {
+        vp8_post_proc_mb_row(pc, yv12_fb_new, mb_row - 1, limits);
+      }
+      if (mb_row == pc->mb_rows - 1) {
+        vp8_post_proc_mb_row(pc, yv12_fb_new, mb_row, limits);
+      }
+    }
+#endif
+
     ++xd->mode_info_context; /* skip prediction column */
     xd->up_available = 1;
 
@@ -558,6 +574,15 @@ static void mt_decode_mb_rows(VP8D_COMP *pbi, MACROBLOCKD *xd,
     xd->mode_info_context += xd->mode_info_stride * pbi->decoding_thread_count;
   }
 
+#if CONFIG_POSTPROC
+  /* Other threads may still be post-processing rows once the last one is
+   * decoded, so each of them signals when it is done. */
+  if (pbi->mt_post_proc) {
+    if (start_mb_row != 0) sem_post(&pbi->h_event_end_decoding);
+    return;
+  }
+#endif
+
   /* signal end of frame decoding if this thread processed the last mb_row */
   if (last_mb_row == (pc->mb_rows - 1)) sem_post(&pbi->h_event_end_decoding);
 }
@@ -578,6 +603,16 @@ static THREAD_FUNCTION thread_decoding_proc(void *p_data) {
         MACROBLOCKD *xd = &mbrd->mbd;
         xd->left_context = &mb_row_left_context;
 
+#if CONFIG_POSTPROC
+        if (pbi->mt_post_proc_stage != VP8_PP_ROWS_NONE) {
+          vp8_post_proc_rows_finish(
+              &pbi->common, pbi->dec_fb_ref[INTRA_FRAME],
+              pbi->mt_post_proc_stage, ithread + 1,
+              pbi->decoding_thread_count + 1, pbi->mt_pp_limits[ithread + 1]);
+          sem_post(&pbi->h_event_end_decoding);
+          continue;
+        }
+#endif
         mt_decode_mb_rows(pbi, xd, ithread + 1);
       }
     }
@@ -662,6 +697,16 @@ void vp8mt_de_alloc_temp_buffers(VP8D_COMP *pbi, int mb_rows) {
   vpx_free(pbi->mt_current_mb_col);
   pbi->mt_current_mb_col = NULL;
 
+#if CONFIG_POSTPROC
+  if (pbi->mt_pp_limits) {
+    for (i = 0; i <= (int)pbi->decoding_thread_count; ++i) {
+      vpx_free(pbi->mt_pp_limits[i]);
+    }
+    vpx_free(pbi->mt_pp_limits);
+    pbi->mt_pp_limits = NULL;
+  }
+#endif
+
   /* Free above_row buffers. */
   if (pbi->mt_yabove_row) {
     for (i = 0; i < mb_rows; ++i) {
@@ -788,6 +833,15 @@ void vp8mt_alloc_temp_buffers(VP8D_COMP *pbi, int width, int prev_mb_rows) {
     for (i = 0; i < pc->mb_rows; ++i)
       CHECK_MEM_ERROR(pbi->mt_vleft_col[i],
                       vpx_calloc(sizeof(unsigned char) * 8, 1));
+
+#if CONFIG_POSTPROC
+    /* One set of post-processing limits per thread, sized like
+     * pp_limits_buffer. */
+    CALLOC_ARRAY(pbi->mt_pp_limits, pbi->decoding_thread_count + 1);
+    for (i = 0; i <= (int)pbi->decoding_thread_count; ++i)
+      CHECK_MEM_ERROR(pbi->mt_pp_limits[i],
+                      vpx_memalign(16, 24 * ((pc->mb_cols + 1) & ~1)));
+#endif
   }
 }
 
@@ -870,11 +924,49 @@ void vp8mt_decode_mb_rows(VP8D_COMP *pbi, MACROBLOCKD *xd) {
   setup_decoding_thread_data(pbi, xd, pbi->mb_row_di,
                              pbi->decoding_thread_count);
 
+#if CONFIG_POSTPROC
+  pbi->mt_post_proc = vp8_post_proc_rows_init(pc, &pbi->ppflags);
+#endif
+
   for (i = 0; i < pbi->decoding_thread_count; ++i) {
     sem_post(&pbi->h_event_start_decoding[i]);
   }
 
   mt_decode_mb_rows(pbi, xd, 0);
 
+#if CONFIG_POSTPROC
+  if (pbi->mt_post_proc) {
+    for (i = 0; i < pbi->decoding_thread_count; ++i) {
+      sem_wait(&pbi->h_event_end_decoding);
+    }
+    return;
+  }
+#endif
   sem_wait(&pbi->h_event_end_decoding); /* add back for each frame */
 }
+
+#if CONFIG_POSTPROC
+/* Finishes the post-processing started by mt_decode_mb_rows() once the
+ * borders of the decoded frame are extended. */
+void vp8mt_post_proc_frame(VP8D_COMP *pbi) {
+  const int num_jobs = pbi->decoding_thread_count + 1;
+  int last_stage, stage;
+  unsigned int i;
+
+  if (!pbi->mt_post_proc) return;
+
+  last_stage = vp8_post_proc_rows_end(&pbi->common);
+  for (stage = VP8_PP_ROWS_DEBLOCK; stage <= last_stage; ++stage) {
+    pbi->mt_post_proc_stage = stage;
+    for (i = 0; i < pbi->decoding_thread_count; ++i) {
+      sem_post(&pbi->h_event_start_decoding[i]);
+    }
+    vp8_post_proc_rows_finish(&pbi->common, pbi->dec_fb_ref[INTRA_FRAME],
+                              stage, 0, num_jobs, pbi->mt_pp_limits[0]);
+    for (i = 0; i < pbi->decoding_thread_count; ++i) {
+      sem_wait(&pbi->h_event_end_decoding);
+    }
+  }
+  pbi->mt_post_proc_stage = VP8_PP_ROWS_NONE;
+}
+#endif
@@ -130,7 +130,7 @@ void vp8_pack_tokens(vp8_writer *w, const TOKENEXTRA *p, int xcount) {
   int shift;
   int count = w->count;
   unsigned int range = w->range;
-  unsigned int lowvalue = w->lowvalue;
+  uint64_t lowvalue = w->lowvalue;
 
   while (p < stop) {
     const int t = p->Token;
@@ -160,32 +160,13 @@ void vp8_pack_tokens(vp8_writer *w, const TOKENEXTRA *p, int xcount) {
 
       shift = vp8_norm[range];
       range <<= shift;
+      lowvalue <<= shift;
       count += shift;
 
-      if (count >= 0) {
-        int offset = shift - count;
-
-        if ((lowvalue << (offset - 1)) & 0x80000000) {
-          int x = w->pos - 1;
-
-          while (x >= 0 && w->buffer[x] == 0xff) {
-            w->buffer[x] = (unsigned char)0;
-            x--;
-          }
-
-          w->buffer[x] += 1;
-        }
-
-        validate_buffer(w->buffer + w->pos, 1, w->buffer_end, w->error);
-
-        w->buffer[w->pos++] = (lowvalue >> (24 - offset));
-        lowvalue <<= offset;
-        shift = count;
-        lowvalue &= 0xffffff;
-        count -= 8;
+      if (count >= 24) {
+        lowvalue = vp8_flush_bool_bytes(w, lowvalue, count);
+        count -= 32;
       }
-
-      lowvalue <<= shift;
     } while (n);
 
     if (b->base_val) {
@@ -211,32 +192,13 @@ void vp8_pack_tokens(vp8_writer *w, const TOKENEXTRA *p, int xcount) {
 
           shift = vp8_norm[range];
           range <<= shift;
+          lowvalue <<= shift;
           count += shift;
 
-          if (count >= 0) {
-            int offset = shift - count;
-
-            if ((lowvalue << (offset - 1)) & 0x80000000) {
-              int x = w->pos - 1;
-
-              while (x >= 0 && w->buffer[x] == 0xff) {
-                w->buffer[x] = (unsigned char)0;
-                x--;
-              }
-
-              w->buffer[x] += 1;
-            }
-
-            validate_buffer(w->buffer + w->pos, 1, w->buffer_end, w->error);
-
-            w->buffer[w->pos++] = (lowvalue >> (24 - offset));
-            lowvalue <<= offset;
-            shift = count;
-            lowvalue &= 0xffffff;
-            count -= 8;
+          if (count >= 24) {
+            lowvalue = vp8_flush_bool_bytes(w, lowvalue, count);
+            count -= 32;
           }
-
-          lowvalue <<= shift;
         } while (n2);
       }
 
@@ -251,27 +213,11 @@ void vp8_pack_tokens(vp8_writer *w, const TOKENEXTRA *p, int xcount) {
         }
 
         range <<= 1;
-
-        if ((lowvalue & 0x80000000)) {
-          int x = w->pos - 1;
-
-          while (x >= 0 && w->buffer[x] == 0xff) {
-            w->buffer[x] = (unsigned char)0;
-            x--;
-          }
-
-          w->buffer[x] += 1;
-        }
-
         lowvalue <<= 1;
 
-        if (!++count) {
-          count = -8;
-
-          validate_buffer(w->buffer + w->pos, 1, w->buffer_end, w->error);
-
-          w->buffer[w->pos++] = (lowvalue >> 24);
-          lowvalue &= 0xffffff;
+        if (++count >= 24) {
+          lowvalue = vp8_flush_bool_bytes(w, lowvalue, count);
+          count -= 32;
         }
       }
     }
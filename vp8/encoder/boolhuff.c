@@ -56,6 +56,17 @@ void vp8_stop_encode(BOOL_CODER *br) {
   int i;
 
   for (i = 0; i < 32; ++i) vp8_encode_bool(br, 0, 128);
+
+  /* Write the completed bytes that have not reached a four byte flush. */
+  while (br->count >= 0) {
+    if ((br->lowvalue >> (br->count + 32)) & 1) vp8_propagate_carry(br);
+
+    validate_buffer(br->buffer + br->pos, 1, br->buffer_end, br->error);
+
+    br->buffer[br->pos++] = (unsigned char)(br->lowvalue >> (br->count + 24));
+    br->lowvalue &= ((uint64_t)1 << (br->count + 24)) - 1;
+    br->count -= 8;
+  }
 }
 
 void vp8_encode_value(BOOL_CODER *br, int data, int bits) {
@@ -25,8 +25,12 @@
 extern "C" {
 #endif
 
+// 'lowvalue' holds the low end of the coding interval along with the
+// 'count' + 32 bits that have not been written to 'buffer' yet. Completed
+// bytes are written out four at a time, so a carry walks back through the
+// buffer at most once per 32 bits.
 typedef struct {
-  unsigned int lowvalue;
+  uint64_t lowvalue;
   unsigned int range;
   int count;
   unsigned int pos;
@@ -56,12 +60,43 @@ static int validate_buffer(const unsigned char *start, size_t len,
 
   return 0;
 }
+static INLINE void vp8_propagate_carry(BOOL_CODER *br) {
+  int x = br->pos - 1;
+
+  while (x >= 0 && br->buffer[x] == 0xff) {
+    br->buffer[x] = (unsigned char)0;
+    x--;
+  }
+
+  br->buffer[x] += 1;
+}
+
+// Writes the four completed bytes above the 'count' pending bits of
+// 'lowvalue' and returns the pending bits.
+static INLINE uint64_t vp8_flush_bool_bytes(BOOL_CODER *br, uint64_t lowvalue,
+                                            int count) {
+  unsigned char *dst;
+
+  if ((lowvalue >> (count + 32)) & 1) vp8_propagate_carry(br);
+
+  validate_buffer(br->buffer + br->pos, 4, br->buffer_end, br->error);
+
+  dst = br->buffer + br->pos;
+  dst[0] = (unsigned char)(lowvalue >> (count + 24));
+  dst[1] = (unsigned char)(lowvalue >> (count + 16));
+  dst[2] = (unsigned char)(lowvalue >> (count + 8));
+  dst[3] = (unsigned char)(lowvalue >> count);
+  br->pos += 4;
+
+  return lowvalue & (((uint64_t)1 << count) - 1);
+}
+
 static void vp8_encode_bool(BOOL_CODER *br, int bit, int probability) {
   unsigned int split;
   int count = br->count;
   unsigned int range = br->range;
-  unsigned int lowvalue = br->lowvalue;
-  register int shift;
+  uint64_t lowvalue = br->lowvalue;
+  int shift;
 
 #ifdef VP8_ENTROPY_STATS
 #if defined(SECTIONBITS_OUTPUT)
@@ -86,32 +121,14 @@ static void vp8_encode_bool(BOOL_CODER *br, int bit, int probability) {
   shift = vp8_norm[range];
 
   range <<= shift;
+  lowvalue <<= shift;
   count += shift;
 
-  if (count >= 0) {
-    int offset = shift - count;
-
-    if ((lowvalue << (offset - 1)) & 0x80000000) {
-      int x = br->pos - 1;
-
-      while (x >= 0 && br->buffer[x] == 0xff) {
-        br->buffer[x] = (unsigned char)0;
-        x--;
-      }
-
-      br->buffer[x] += 1;
-    }
-
-    validate_buffer(br->buffer + br->pos, 1, br->buffer_end, br->error);
-    br->buffer[br->pos++] = (lowvalue >> (24 - offset));
-
-    lowvalue <<= offset;
-    shift = count;
-    lowvalue &= 0xffffff;
-    count -= 8;
+  if (count >= 24) {
+    lowvalue = vp8_flush_bool_bytes(br, lowvalue, count);
+    count -= 32;
   }
 
-  lowvalue <<= shift;
   br->count = count;
   br->lowvalue = lowvalue;
   br->range = range;
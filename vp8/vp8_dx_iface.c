@@ -264,6 +264,17 @@ static int update_fragments(vpx_codec_alg_priv_t *ctx, const uint8_t *data,
   return 1;
 }
 
+static void get_ppflags(const vpx_codec_alg_priv_t *ctx,
+                        vp8_ppflags_t *flags) {
+  vp8_zero(*flags);
+
+  if (ctx->base.init_flags & VPX_CODEC_USE_POSTPROC) {
+    flags->post_proc_flag = ctx->postproc_cfg.post_proc_flag;
+    flags->deblocking_level = ctx->postproc_cfg.deblocking_level;
+    flags->noise_level = ctx->postproc_cfg.noise_level;
+  }
+}
+
 static vpx_codec_err_t vp8_decode(vpx_codec_alg_priv_t *ctx,
                                   const uint8_t *data, unsigned int data_sz,
                                   void *user_priv, long deadline) {
@@ -432,6 +443,9 @@ static vpx_codec_err_t vp8_decode(vpx_codec_alg_priv_t *ctx,
     pbi->fragments = ctx->fragments;
 
     ctx->user_priv = user_priv;
+#if CONFIG_POSTPROC
+    get_ppflags(ctx, &pbi->ppflags);
+#endif
     if (vp8dx_receive_compressed_data(pbi, data_sz, data, deadline)) {
       res = update_error_state(ctx, &pbi->common.error);
     }
@@ -454,13 +468,7 @@ static vpx_image_t *vp8_get_frame(vpx_codec_alg_priv_t *ctx,
     YV12_BUFFER_CONFIG sd;
     int64_t time_stamp = 0, time_end_stamp = 0;
     vp8_ppflags_t flags;
-    vp8_zero(flags);
-
-    if (ctx->base.init_flags & VPX_CODEC_USE_POSTPROC) {
-      flags.post_proc_flag = ctx->postproc_cfg.post_proc_flag;
-      flags.deblocking_level = ctx->postproc_cfg.deblocking_level;
-      flags.noise_level = ctx->postproc_cfg.noise_level;
-    }
+    get_ppflags(ctx, &flags);
 
     if (0 == vp8dx_get_raw_frame(ctx->yv12_frame_buffers.pbi[0], &sd,
                                  &time_stamp, &time_end_stamp, &flags)) {
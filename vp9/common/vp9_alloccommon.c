@@ -106,6 +106,13 @@ void vp9_free_postproc_buffers(VP9_COMMON *cm) {
   cm->postproc_state.limits = NULL;
   vpx_free(cm->postproc_state.generated_noise);
   cm->postproc_state.generated_noise = NULL;
+  vpx_free(cm->postproc_state.worker_data);
+  cm->postproc_state.worker_data = NULL;
+  cm->postproc_state.num_workers = 0;
+  vpx_free(cm->postproc_state.prev_mip);
+  cm->postproc_state.prev_mip = NULL;
+  vpx_free(cm->postproc_state.prev_mi_grid_base);
+  cm->postproc_state.prev_mi_grid_base = NULL;
 #else
   (void)cm;
 #endif
@@ -120,17 +127,26 @@ void vp9_free_context_buffers(VP9_COMMON *cm) {
   cm->above_seg_context = NULL;
   vpx_free(cm->lf.lfm);
   cm->lf.lfm = NULL;
+  cm->lf.lfm_alloc_size = 0;
 }
 
 int vp9_alloc_loop_filter(VP9_COMMON *cm) {
-  vpx_free(cm->lf.lfm);
   // Each lfm holds bit masks for all the 8x8 blocks in a 64x64 region.  The
   // stride and rows are rounded up / truncated to a multiple of 8.
-  cm->lf.lfm_stride = (cm->mi_cols + (MI_BLOCK_SIZE - 1)) >> 3;
-  cm->lf.lfm = (LOOP_FILTER_MASK *)vpx_calloc(
-      ((cm->mi_rows + (MI_BLOCK_SIZE - 1)) >> 3) * cm->lf.lfm_stride,
-      sizeof(*cm->lf.lfm));
+  const int lfm_stride = (cm->mi_cols + (MI_BLOCK_SIZE - 1)) >> 3;
+  const int lfm_size = ((cm->mi_rows + (MI_BLOCK_SIZE - 1)) >> 3) * lfm_stride;
+  cm->lf.lfm_stride = lfm_stride;
+  // The masks are kept when the frame shrinks, so that growing back to the
+  // allocated size does not allocate again.
+  if (cm->lf.lfm != NULL && lfm_size <= cm->lf.lfm_alloc_size) {
+    memset(cm->lf.lfm, 0, lfm_size * sizeof(*cm->lf.lfm));
+    return 0;
+  }
+  vpx_free(cm->lf.lfm);
+  cm->lf.lfm_alloc_size = 0;
+  cm->lf.lfm = (LOOP_FILTER_MASK *)vpx_calloc(lfm_size, sizeof(*cm->lf.lfm));
   if (!cm->lf.lfm) return 1;
+  cm->lf.lfm_alloc_size = lfm_size;
   return 0;
 }
 
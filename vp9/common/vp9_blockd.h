@@ -85,6 +85,8 @@ typedef struct MODE_INFO {
   // TODO(slavarnway): Delete and use bmi[3].as_mv[] instead.
   int_mv mv[2];
 
+  // Only valid for blocks smaller than 8x8. Must stay the last member: the
+  // decoder does not allocate it for larger blocks.
   b_mode_info bmi[4];
 } MODE_INFO;
 
@@ -159,6 +161,9 @@ typedef struct macroblockd {
   MODE_INFO *left_mi;
   MODE_INFO *above_mi;
 
+  // Motion vector reference data around the current superblock, or NULL.
+  const struct mv_ref_cache *mv_ref_cache;
+
   unsigned int max_blocks_wide;
   unsigned int max_blocks_high;
 
@@ -1049,6 +1049,7 @@ void vp9_default_coef_probs(VP9_COMMON *cm) {
 #define COEF_MAX_UPDATE_FACTOR_KEY 112
 #define COEF_COUNT_SAT_AFTER_KEY 24
 #define COEF_MAX_UPDATE_FACTOR_AFTER_KEY 128
+#define COEF_COUNT_SAT_MAX 24
 
 static void adapt_coef_probs(VP9_COMMON *cm, TX_SIZE tx_size,
                              unsigned int count_sat,
@@ -1059,8 +1060,15 @@ static void adapt_coef_probs(VP9_COMMON *cm, TX_SIZE tx_size,
   vp9_coeff_count_model *counts = cm->counts.coef[tx_size];
   unsigned int(*eob_counts)[REF_TYPES][COEF_BANDS][COEFF_CONTEXTS] =
       cm->counts.eob_branch[tx_size];
+  // update_factor * count / count_sat for each count up to count_sat, as
+  // merge_probs() computes it.
+  int count_to_factor[COEF_COUNT_SAT_MAX + 1];
   int i, j, k, l, m;
 
+  assert(count_sat <= COEF_COUNT_SAT_MAX);
+  for (i = 0; i <= (int)count_sat; ++i)
+    count_to_factor[i] = update_factor * i / count_sat;
+
   for (i = 0; i < PLANE_TYPES; ++i)
     for (j = 0; j < REF_TYPES; ++j)
       for (k = 0; k < COEF_BANDS; ++k)
@@ -1072,15 +1080,22 @@ static void adapt_coef_probs(VP9_COMMON *cm, TX_SIZE tx_size,
           const unsigned int branch_ct[UNCONSTRAINED_NODES][2] = {
             { neob, eob_counts[i][j][k][l] - neob }, { n0, n1 + n2 }, { n1, n2 }
           };
-          for (m = 0; m < UNCONSTRAINED_NODES; ++m)
-            probs[i][j][k][l][m] =
-                merge_probs(pre_probs[i][j][k][l][m], branch_ct[m], count_sat,
-                            update_factor);
+          for (m = 0; m < UNCONSTRAINED_NODES; ++m) {
+            const vpx_prob pre_prob = pre_probs[i][j][k][l][m];
+            const unsigned int den = branch_ct[m][0] + branch_ct[m][1];
+            // A node without counts keeps its previous probability.
+            if (den == 0) {
+              probs[i][j][k][l][m] = pre_prob;
+            } else {
+              const vpx_prob prob = get_prob(branch_ct[m][0], den);
+              const int factor = count_to_factor[VPXMIN(den, count_sat)];
+              probs[i][j][k][l][m] = weighted_prob(pre_prob, prob, factor);
+            }
+          }
         }
 }
 
-void vp9_adapt_coef_probs(VP9_COMMON *cm) {
-  TX_SIZE t;
+void vp9_adapt_coef_probs_tx(VP9_COMMON *cm, TX_SIZE tx_size) {
   unsigned int count_sat, update_factor;
 
   if (frame_is_intra_only(cm)) {
@@ -1093,6 +1108,11 @@ void vp9_adapt_coef_probs(VP9_COMMON *cm) {
     update_factor = COEF_MAX_UPDATE_FACTOR;
     count_sat = COEF_COUNT_SAT;
   }
-  for (t = TX_4X4; t <= TX_32X32; t++)
-    adapt_coef_probs(cm, t, count_sat, update_factor);
+  adapt_coef_probs(cm, tx_size, count_sat, update_factor);
+}
+
+void vp9_adapt_coef_probs(VP9_COMMON *cm) {
+  TX_SIZE t;
+
+  for (t = TX_4X4; t <= TX_32X32; t++) vp9_adapt_coef_probs_tx(cm, t);
 }
@@ -120,6 +120,9 @@ typedef unsigned int vp9_coeff_stats[REF_TYPES][COEF_BANDS][COEFF_CONTEXTS]
 struct VP9Common;
 void vp9_default_coef_probs(struct VP9Common *cm);
 void vp9_adapt_coef_probs(struct VP9Common *cm);
+// Adapts the coefficient probabilities of one transform size, which do not
+// depend on those of the others.
+void vp9_adapt_coef_probs_tx(struct VP9Common *cm, TX_SIZE tx_size);
 
 // This is the index in the scan order beyond which all coefficients for
 // 8x8 transform and above are in the top band.
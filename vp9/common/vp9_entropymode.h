@@ -59,6 +59,8 @@ typedef struct frame_contexts {
   int initialized;
 } FRAME_CONTEXT;
 
+// Only unsigned int counters, which vp9_accumulate_frame_counts() sums as one
+// array.
 typedef struct FRAME_COUNTS {
   unsigned int y_mode[BLOCK_SIZE_GROUPS][INTRA_MODES];
   unsigned int uv_mode[INTRA_MODES][INTRA_MODES];
@@ -1457,6 +1457,9 @@ static void loop_filter_rows(YV12_BUFFER_CONFIG *frame_buffer, VP9_COMMON *cm,
         }
       }
     }
+
+    if (cm->lf.row_filtered)
+      cm->lf.row_filtered(cm->lf.row_filtered_priv, mi_row);
   }
 }
 
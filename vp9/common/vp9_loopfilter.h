@@ -87,6 +87,13 @@ struct loopfilter {
 
   LOOP_FILTER_MASK *lfm;
   int lfm_stride;
+  int lfm_alloc_size;  // Number of masks lfm can hold.
+
+  // Optional hook called on the filtering thread once superblock row mi_row
+  // has been filtered. At that point all rows above it are final, as are all
+  // but the last 8 pixel rows of each plane of mi_row itself.
+  void (*row_filtered)(void *priv, int mi_row);
+  void *row_filtered_priv;
 };
 
 /* assorted loopfilter functions which get used elsewhere */
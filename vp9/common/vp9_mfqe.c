@@ -195,28 +195,38 @@ static void mfqe_block(BLOCK_SIZE bs, const uint8_t *y, const uint8_t *u,
   }
 }
 
-static int mfqe_decision(MODE_INFO *mi, BLOCK_SIZE cur_bs) {
+static int mfqe_decision(MODE_INFO **mi_grid, BLOCK_SIZE cur_bs) {
   // Check the motion in current block(for inter frame),
   // or check the motion in the correlated block in last frame (for keyframe).
-  const int mv_len_square = mi->mv[0].as_mv.row * mi->mv[0].as_mv.row +
-                            mi->mv[0].as_mv.col * mi->mv[0].as_mv.col;
+  const MODE_INFO *const mi = mi_grid[0];
+  int mv_len_square;
   const int mv_threshold = 100;
+  // Outside of the frame.
+  if (mi == NULL) return 0;
+  mv_len_square = mi->mv[0].as_mv.row * mi->mv[0].as_mv.row +
+                  mi->mv[0].as_mv.col * mi->mv[0].as_mv.col;
   return mi->mode >= NEARESTMV &&  // Not an intra block
          cur_bs >= BLOCK_16X16 && mv_len_square <= mv_threshold;
 }
 
 // Process each partiton in a super block, recursively.
-static void mfqe_partition(VP9_COMMON *cm, MODE_INFO *mi, BLOCK_SIZE bs,
+static void mfqe_partition(VP9_COMMON *cm, MODE_INFO **mi, BLOCK_SIZE bs,
                            const uint8_t *y, const uint8_t *u, const uint8_t *v,
                            int y_stride, int uv_stride, uint8_t *yd,
                            uint8_t *ud, uint8_t *vd, int yd_stride,
                            int uvd_stride) {
   int mi_offset, y_offset, uv_offset;
-  const BLOCK_SIZE cur_bs = mi->sb_type;
+  BLOCK_SIZE cur_bs;
   const int qdiff = cm->base_qindex - cm->postproc_state.last_base_qindex;
   const int bsl = b_width_log2_lookup[bs];
-  PARTITION_TYPE partition = partition_lookup[bsl][cur_bs];
-  const BLOCK_SIZE subsize = get_subsize(bs, partition);
+  PARTITION_TYPE partition;
+  BLOCK_SIZE subsize;
+
+  // Outside of the frame.
+  if (mi[0] == NULL) return;
+  cur_bs = mi[0]->sb_type;
+  partition = partition_lookup[bsl][cur_bs];
+  subsize = get_subsize(bs, partition);
 
   if (cur_bs < BLOCK_8X8) {
     // If there are blocks smaller than 8x8, it must be on the boundary.
@@ -340,44 +350,48 @@ static void mfqe_partition(VP9_COMMON *cm, MODE_INFO *mi, BLOCK_SIZE bs,
   }
 }
 
-void vp9_mfqe(VP9_COMMON *cm) {
-  int mi_row, mi_col;
+void vp9_mfqe_sb_row(VP9_COMMON *cm, int mi_row) {
+  int mi_col;
   // Current decoded frame.
   const YV12_BUFFER_CONFIG *show = cm->frame_to_show;
   // Last decoded frame and will store the MFQE result.
   YV12_BUFFER_CONFIG *dest = &cm->post_proc_buffer;
-  // Loop through each super block.
-  for (mi_row = 0; mi_row < cm->mi_rows; mi_row += MI_BLOCK_SIZE) {
-    for (mi_col = 0; mi_col < cm->mi_cols; mi_col += MI_BLOCK_SIZE) {
-      MODE_INFO *mi;
-      MODE_INFO *mi_local = cm->mi + (mi_row * cm->mi_stride + mi_col);
-      // Motion Info in last frame.
-      MODE_INFO *mi_prev =
-          cm->postproc_state.prev_mi + (mi_row * cm->mi_stride + mi_col);
-      const uint32_t y_stride = show->y_stride;
-      const uint32_t uv_stride = show->uv_stride;
-      const uint32_t yd_stride = dest->y_stride;
-      const uint32_t uvd_stride = dest->uv_stride;
-      const uint32_t row_offset_y = mi_row << 3;
-      const uint32_t row_offset_uv = mi_row << 2;
-      const uint32_t col_offset_y = mi_col << 3;
-      const uint32_t col_offset_uv = mi_col << 2;
-      const uint8_t *y =
-          show->y_buffer + row_offset_y * y_stride + col_offset_y;
-      const uint8_t *u =
-          show->u_buffer + row_offset_uv * uv_stride + col_offset_uv;
-      const uint8_t *v =
-          show->v_buffer + row_offset_uv * uv_stride + col_offset_uv;
-      uint8_t *yd = dest->y_buffer + row_offset_y * yd_stride + col_offset_y;
-      uint8_t *ud = dest->u_buffer + row_offset_uv * uvd_stride + col_offset_uv;
-      uint8_t *vd = dest->v_buffer + row_offset_uv * uvd_stride + col_offset_uv;
-      if (frame_is_intra_only(cm)) {
-        mi = mi_prev;
-      } else {
-        mi = mi_local;
-      }
-      mfqe_partition(cm, mi, BLOCK_64X64, y, u, v, y_stride, uv_stride, yd, ud,
-                     vd, yd_stride, uvd_stride);
+  // Loop through each super block in the row.
+  for (mi_col = 0; mi_col < cm->mi_cols; mi_col += MI_BLOCK_SIZE) {
+    MODE_INFO **mi;
+    MODE_INFO **mi_local =
+        cm->mi_grid_visible + (mi_row * cm->mi_stride + mi_col);
+    // Motion Info in last frame.
+    MODE_INFO **mi_prev = cm->postproc_state.prev_mi_grid_visible +
+                          (mi_row * cm->mi_stride + mi_col);
+    const uint32_t y_stride = show->y_stride;
+    const uint32_t uv_stride = show->uv_stride;
+    const uint32_t yd_stride = dest->y_stride;
+    const uint32_t uvd_stride = dest->uv_stride;
+    const uint32_t row_offset_y = mi_row << 3;
+    const uint32_t row_offset_uv = mi_row << 2;
+    const uint32_t col_offset_y = mi_col << 3;
+    const uint32_t col_offset_uv = mi_col << 2;
+    const uint8_t *y = show->y_buffer + row_offset_y * y_stride + col_offset_y;
+    const uint8_t *u =
+        show->u_buffer + row_offset_uv * uv_stride + col_offset_uv;
+    const uint8_t *v =
+        show->v_buffer + row_offset_uv * uv_stride + col_offset_uv;
+    uint8_t *yd = dest->y_buffer + row_offset_y * yd_stride + col_offset_y;
+    uint8_t *ud = dest->u_buffer + row_offset_uv * uvd_stride + col_offset_uv;
+    uint8_t *vd = dest->v_buffer + row_offset_uv * uvd_stride + col_offset_uv;
+    if (frame_is_intra_only(cm)) {
+      mi = mi_prev;
+    } else {
+      mi = mi_local;
     }
+    mfqe_partition(cm, mi, BLOCK_64X64, y, u, v, y_stride, uv_stride, yd, ud,
+                   vd, yd_stride, uvd_stride);
   }
 }
+
+void vp9_mfqe(VP9_COMMON *cm) {
+  int mi_row;
+  for (mi_row = 0; mi_row < cm->mi_rows; mi_row += MI_BLOCK_SIZE)
+    vp9_mfqe_sb_row(cm, mi_row);
+}
@@ -24,6 +24,10 @@ extern "C" {
 // difference, etc.
 void vp9_mfqe(struct VP9Common *cm);
 
+// Applies MFQE to the superblock row starting at 'mi_row'. Rows only touch
+// their own blocks of cm->post_proc_buffer and may run concurrently.
+void vp9_mfqe_sb_row(struct VP9Common *cm, int mi_row);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
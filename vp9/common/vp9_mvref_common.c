@@ -11,6 +11,49 @@
 
 #include "vp9/common/vp9_mvref_common.h"
 
+void vp9_setup_mv_ref_cache(const VP9_COMMON *cm, MACROBLOCKD *xd,
+                            const TileInfo *tile, MV_REF_CACHE *cache,
+                            int mi_row, int mi_col) {
+  const int col_start =
+      VPXMAX(mi_col - MV_REF_CACHE_BORDER, tile->mi_col_start);
+  const int col_end = VPXMIN(mi_col + MI_BLOCK_SIZE, tile->mi_col_end);
+  const int row_end = VPXMIN(mi_row + MI_BLOCK_SIZE, cm->mi_rows);
+  int r, c;
+
+  assert(!(mi_row & MI_MASK) && !(mi_col & MI_MASK));
+  cache->mi_row = mi_row;
+  cache->mi_col = mi_col;
+
+  for (r = VPXMAX(mi_row - MV_REF_CACHE_BORDER, 0); r < mi_row; ++r) {
+    MODE_INFO **const mi = cm->mi_grid_visible + r * cm->mi_stride;
+    MV_REF_CANDIDATE *const above =
+        cache->above[r - mi_row + MV_REF_CACHE_BORDER] + MV_REF_CACHE_BORDER;
+    for (c = col_start; c < col_end; ++c)
+      copy_mv_ref_candidate(&above[c - mi_col], mi[c]);
+  }
+
+  if (col_start < mi_col) {
+    for (r = mi_row; r < row_end; ++r) {
+      MODE_INFO **const mi = cm->mi_grid_visible + r * cm->mi_stride;
+      MV_REF_CANDIDATE *const left =
+          cache->left[r - mi_row] + MV_REF_CACHE_BORDER;
+      for (c = col_start; c < mi_col; ++c)
+        copy_mv_ref_candidate(&left[c - mi_col], mi[c]);
+    }
+  }
+
+  cache->has_prev_frame_mvs = cm->use_prev_frame_mvs;
+  if (cache->has_prev_frame_mvs) {
+    const int cols = VPXMIN(MI_BLOCK_SIZE, cm->mi_cols - mi_col);
+    for (r = mi_row; r < row_end; ++r)
+      memcpy(cache->prev_frame_mvs[r - mi_row],
+             cm->prev_frame->mvs + r * cm->mi_cols + mi_col,
+             cols * sizeof(*cache->prev_frame_mvs[0]));
+  }
+
+  xd->mv_ref_cache = cache;
+}
+
 // This function searches the neighborhood of a given MB/SB
 // to try and find candidate reference vectors.
 static void find_mv_refs_idx(const VP9_COMMON *cm, const MACROBLOCKD *xd,
@@ -23,10 +66,10 @@ static void find_mv_refs_idx(const VP9_COMMON *cm, const MACROBLOCKD *xd,
   int different_ref_found = 0;
   int context_counter = 0;
   const MV_REF *const prev_frame_mvs =
-      cm->use_prev_frame_mvs
-          ? cm->prev_frame->mvs + mi_row * cm->mi_cols + mi_col
-          : NULL;
+      cm->use_prev_frame_mvs ? get_prev_frame_mvs(cm, xd, mi_row, mi_col)
+                             : NULL;
   const TileInfo *const tile = &xd->tile;
+  MV_REF_CANDIDATE tmp;
 
   // Blank the reference vector list
   memset(mv_ref_list, 0, sizeof(*mv_ref_list) * MAX_MV_REF_CANDIDATES);
@@ -37,18 +80,29 @@ static void find_mv_refs_idx(const VP9_COMMON *cm, const MACROBLOCKD *xd,
   for (i = 0; i < 2; ++i) {
     const POSITION *const mv_ref = &mv_ref_search[i];
     if (is_inside(tile, mi_col, mi_row, cm->mi_rows, mv_ref)) {
-      const MODE_INFO *const candidate_mi =
-          xd->mi[mv_ref->col + mv_ref->row * xd->mi_stride];
+      const MV_REF_CANDIDATE *const candidate =
+          get_mv_ref_candidate(xd, mi_row, mi_col, mv_ref, &tmp);
       // Keep counts for entropy encoding.
-      context_counter += mode_2_counter[candidate_mi->mode];
+      context_counter += mode_2_counter[candidate->mode];
       different_ref_found = 1;
 
-      if (candidate_mi->ref_frame[0] == ref_frame)
-        ADD_MV_REF_LIST(get_sub_block_mv(candidate_mi, 0, mv_ref->col, block),
-                        refmv_count, mv_ref_list, Done);
-      else if (candidate_mi->ref_frame[1] == ref_frame)
-        ADD_MV_REF_LIST(get_sub_block_mv(candidate_mi, 1, mv_ref->col, block),
-                        refmv_count, mv_ref_list, Done);
+      // Sub8x8 candidates need the sub block mvs of the mode info.
+      if (block >= 0) {
+        const MODE_INFO *const candidate_mi =
+            xd->mi[mv_ref->col + mv_ref->row * xd->mi_stride];
+        if (candidate->ref_frame[0] == ref_frame)
+          ADD_MV_REF_LIST(
+              get_sub_block_mv(candidate_mi, 0, mv_ref->col, block),
+              refmv_count, mv_ref_list, Done);
+        else if (candidate->ref_frame[1] == ref_frame)
+          ADD_MV_REF_LIST(
+              get_sub_block_mv(candidate_mi, 1, mv_ref->col, block),
+              refmv_count, mv_ref_list, Done);
+      } else if (candidate->ref_frame[0] == ref_frame) {
+        ADD_MV_REF_LIST(candidate->mv[0], refmv_count, mv_ref_list, Done);
+      } else if (candidate->ref_frame[1] == ref_frame) {
+        ADD_MV_REF_LIST(candidate->mv[1], refmv_count, mv_ref_list, Done);
+      }
     }
   }
 
@@ -58,14 +112,14 @@ static void find_mv_refs_idx(const VP9_COMMON *cm, const MACROBLOCKD *xd,
   for (; i < MVREF_NEIGHBOURS; ++i) {
     const POSITION *const mv_ref = &mv_ref_search[i];
     if (is_inside(tile, mi_col, mi_row, cm->mi_rows, mv_ref)) {
-      const MODE_INFO *const candidate_mi =
-          xd->mi[mv_ref->col + mv_ref->row * xd->mi_stride];
+      const MV_REF_CANDIDATE *const candidate =
+          get_mv_ref_candidate(xd, mi_row, mi_col, mv_ref, &tmp);
       different_ref_found = 1;
 
-      if (candidate_mi->ref_frame[0] == ref_frame)
-        ADD_MV_REF_LIST(candidate_mi->mv[0], refmv_count, mv_ref_list, Done);
-      else if (candidate_mi->ref_frame[1] == ref_frame)
-        ADD_MV_REF_LIST(candidate_mi->mv[1], refmv_count, mv_ref_list, Done);
+      if (candidate->ref_frame[0] == ref_frame)
+        ADD_MV_REF_LIST(candidate->mv[0], refmv_count, mv_ref_list, Done);
+      else if (candidate->ref_frame[1] == ref_frame)
+        ADD_MV_REF_LIST(candidate->mv[1], refmv_count, mv_ref_list, Done);
     }
   }
 
@@ -85,11 +139,11 @@ static void find_mv_refs_idx(const VP9_COMMON *cm, const MACROBLOCKD *xd,
     for (i = 0; i < MVREF_NEIGHBOURS; ++i) {
       const POSITION *mv_ref = &mv_ref_search[i];
       if (is_inside(tile, mi_col, mi_row, cm->mi_rows, mv_ref)) {
-        const MODE_INFO *const candidate_mi =
-            xd->mi[mv_ref->col + mv_ref->row * xd->mi_stride];
+        const MV_REF_CANDIDATE *const candidate =
+            get_mv_ref_candidate(xd, mi_row, mi_col, mv_ref, &tmp);
 
         // If the candidate is INTRA we don't want to consider its mv.
-        IF_DIFF_REF_FRAME_ADD_MV(candidate_mi, ref_frame, ref_sign_bias,
+        IF_DIFF_REF_FRAME_ADD_MV(candidate, ref_frame, ref_sign_bias,
                                  refmv_count, mv_ref_list, Done);
       }
     }
@@ -28,6 +28,34 @@ typedef struct position {
   int col;
 } POSITION;
 
+// Motion vector reference data of one 8x8 block.
+typedef struct {
+  int_mv mv[2];
+  MV_REFERENCE_FRAME ref_frame[2];
+  PREDICTION_MODE mode;
+} MV_REF_CANDIDATE;
+
+// Number of rows above and columns left of a superblock the reference search
+// of its blocks reaches.
+#define MV_REF_CACHE_BORDER 3
+
+// Motion vector reference data around a superblock, gathered once by
+// vp9_setup_mv_ref_cache() so the reference search of each block in it reads
+// a small contiguous buffer rather than mode info scattered across rows.
+// Only neighbours inside the tile are set.
+typedef struct mv_ref_cache {
+  int mi_row;
+  int mi_col;
+  // Blocks above the superblock, from MV_REF_CACHE_BORDER columns left of it
+  // to its right edge.
+  MV_REF_CANDIDATE above[MV_REF_CACHE_BORDER]
+                        [MV_REF_CACHE_BORDER + MI_BLOCK_SIZE];
+  MV_REF_CANDIDATE left[MI_BLOCK_SIZE][MV_REF_CACHE_BORDER];
+  // Co-located motion vectors of the previous frame, when has_prev_frame_mvs.
+  int has_prev_frame_mvs;
+  MV_REF prev_frame_mvs[MI_BLOCK_SIZE][MI_BLOCK_SIZE];
+} MV_REF_CACHE;
+
 typedef enum {
   BOTH_ZERO = 0,
   ZERO_PLUS_PREDICTED = 1,
@@ -242,6 +270,20 @@ static INLINE int_mv scale_mv(const MODE_INFO *mi, int ref,
   return mv;
 }
 
+// scale_mv() for a candidate returned by get_mv_ref_candidate().
+static INLINE int_mv scale_candidate_mv(const MV_REF_CANDIDATE *candidate,
+                                        int ref,
+                                        const MV_REFERENCE_FRAME this_ref_frame,
+                                        const int *ref_sign_bias) {
+  int_mv mv = candidate->mv[ref];
+  if (ref_sign_bias[candidate->ref_frame[ref]] !=
+      ref_sign_bias[this_ref_frame]) {
+    mv.as_mv.row *= -1;
+    mv.as_mv.col *= -1;
+  }
+  return mv;
+}
+
 // This macro is used to add a motion vector mv_ref list if it isn't
 // already in the list.  If it's the second motion vector it will also
 // skip all additional processing and jump to Done!
@@ -262,14 +304,17 @@ static INLINE int_mv scale_mv(const MODE_INFO *mi, int ref,
 #define IF_DIFF_REF_FRAME_ADD_MV(mbmi, ref_frame, ref_sign_bias, refmv_count, \
                                  mv_ref_list, Done)                           \
   do {                                                                        \
-    if (is_inter_block(mbmi)) {                                               \
+    if ((mbmi)->ref_frame[0] > INTRA_FRAME) {                                 \
       if ((mbmi)->ref_frame[0] != ref_frame)                                  \
-        ADD_MV_REF_LIST(scale_mv((mbmi), 0, ref_frame, ref_sign_bias),        \
-                        refmv_count, mv_ref_list, Done);                      \
-      if (has_second_ref(mbmi) && (mbmi)->ref_frame[1] != ref_frame &&        \
+        ADD_MV_REF_LIST(                                                      \
+            scale_candidate_mv((mbmi), 0, ref_frame, ref_sign_bias),          \
+            refmv_count, mv_ref_list, Done);                                  \
+      if ((mbmi)->ref_frame[1] > INTRA_FRAME &&                               \
+          (mbmi)->ref_frame[1] != ref_frame &&                                \
           (mbmi)->mv[1].as_int != (mbmi)->mv[0].as_int)                       \
-        ADD_MV_REF_LIST(scale_mv((mbmi), 1, ref_frame, ref_sign_bias),        \
-                        refmv_count, mv_ref_list, Done);                      \
+        ADD_MV_REF_LIST(                                                      \
+            scale_candidate_mv((mbmi), 1, ref_frame, ref_sign_bias),          \
+            refmv_count, mv_ref_list, Done);                                  \
     }                                                                         \
   } while (0)
 
@@ -283,6 +328,51 @@ static INLINE int is_inside(const TileInfo *const tile, int mi_col, int mi_row,
            mi_col + mi_pos->col >= tile->mi_col_end);
 }
 
+static INLINE void copy_mv_ref_candidate(MV_REF_CANDIDATE *dst,
+                                         const MODE_INFO *mi) {
+  dst->mv[0] = mi->mv[0];
+  dst->mv[1] = mi->mv[1];
+  dst->ref_frame[0] = mi->ref_frame[0];
+  dst->ref_frame[1] = mi->ref_frame[1];
+  dst->mode = mi->mode;
+}
+
+// Returns the motion vector reference data of the block at mi_pos from the
+// block at (mi_row, mi_col), which must be inside the tile. Blocks outside the
+// current superblock come from xd->mv_ref_cache when it is set up, the others
+// are copied from their mode info to *tmp.
+static INLINE const MV_REF_CANDIDATE *get_mv_ref_candidate(
+    const MACROBLOCKD *xd, int mi_row, int mi_col, const POSITION *mi_pos,
+    MV_REF_CANDIDATE *tmp) {
+  const MV_REF_CACHE *const cache = xd->mv_ref_cache;
+  const int row = (mi_row & MI_MASK) + mi_pos->row;
+  const int col = (mi_col & MI_MASK) + mi_pos->col;
+  const MODE_INFO *mi;
+
+  if (cache != NULL && (row < 0 || col < 0)) {
+    assert(cache->mi_row == (mi_row & ~MI_MASK) &&
+           cache->mi_col == (mi_col & ~MI_MASK));
+    return row < 0 ? &cache->above[row + MV_REF_CACHE_BORDER]
+                                  [col + MV_REF_CACHE_BORDER]
+                   : &cache->left[row][col + MV_REF_CACHE_BORDER];
+  }
+
+  mi = xd->mi[mi_pos->col + mi_pos->row * xd->mi_stride];
+  copy_mv_ref_candidate(tmp, mi);
+  return tmp;
+}
+
+// Returns the previous frame motion vectors co-located with the block at
+// (mi_row, mi_col).
+static INLINE const MV_REF *get_prev_frame_mvs(const VP9_COMMON *cm,
+                                               const MACROBLOCKD *xd,
+                                               int mi_row, int mi_col) {
+  const MV_REF_CACHE *const cache = xd->mv_ref_cache;
+  if (cache != NULL && cache->has_prev_frame_mvs)
+    return &cache->prev_frame_mvs[mi_row & MI_MASK][mi_col & MI_MASK];
+  return cm->prev_frame->mvs + mi_row * cm->mi_cols + mi_col;
+}
+
 // TODO(jingning): this mv clamping function should be block size dependent.
 static INLINE void clamp_mv2(MV *mv, const MACROBLOCKD *xd) {
   clamp_mv(mv, xd->mb_to_left_edge - LEFT_TOP_MARGIN,
@@ -300,6 +390,13 @@ static INLINE void lower_mv_precision(MV *mv, int allow_hp) {
 }
 
 typedef void (*find_mv_refs_sync)(void *const data, int mi_row);
+
+// Gathers the motion vector reference data around the superblock at
+// (mi_row, mi_col) of tile into cache and points xd at it.
+void vp9_setup_mv_ref_cache(const VP9_COMMON *cm, MACROBLOCKD *xd,
+                            const TileInfo *tile, MV_REF_CACHE *cache,
+                            int mi_row, int mi_col);
+
 void vp9_find_mv_refs(const VP9_COMMON *cm, const MACROBLOCKD *xd,
                       MODE_INFO *mi, MV_REFERENCE_FRAME ref_frame,
                       int_mv *mv_ref_list, int mi_row, int mi_col,
@@ -8,6 +8,7 @@
  *  be found in the AUTHORS file in the root of the source tree.
  */
 
+#include <assert.h>
 #include <math.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -72,6 +73,9 @@ void vp9_highbd_post_proc_down_and_across_c(const uint16_t *src_ptr,
     p_src = dst_ptr;
     p_dst = dst_ptr;
 
+    p_dst[-2] = p_dst[-1] = p_dst[0];
+    p_dst[cols] = p_dst[cols + 1] = p_dst[cols - 1];
+
     for (i = 0; i < 8; i++) d[i] = p_src[i];
 
     for (col = 0; col < cols; col++) {
@@ -116,12 +120,15 @@ void vp9_highbd_mbpost_proc_across_ip_c(uint16_t *src, int pitch, int rows,
   int r, c, i;
 
   uint16_t *s = src;
-  uint16_t d[16];
+  uint16_t d[16] = { 0 };
 
   for (r = 0; r < rows; r++) {
     int sumsq = 0;
     int sum = 0;
 
+    for (i = -8; i < 0; i++) s[i] = s[0];
+    for (i = 0; i < 17; i++) s[i + cols] = s[cols - 1];
+
     for (i = -8; i <= 6; i++) {
       sumsq += s[i] * s[i];
       sum += s[i];
@@ -159,9 +166,12 @@ void vp9_highbd_mbpost_proc_down_c(uint16_t *dst, int pitch, int rows, int cols,
     uint16_t *s = &dst[c];
     int sumsq = 0;
     int sum = 0;
-    uint16_t d[16];
+    uint16_t d[16] = { 0 };
     const int16_t *rv2 = rv3 + ((c * 17) & 127);
 
+    for (i = -8; i < 0; i++) s[i * pitch] = s[0];
+    for (i = 0; i < 17; i++) s[(i + rows) * pitch] = s[(rows - 1) * pitch];
+
     for (i = -8; i <= 6; i++) {
       sumsq += s[i * pitch] * s[i * pitch];
       sum += s[i * pitch];
@@ -183,97 +193,71 @@ void vp9_highbd_mbpost_proc_down_c(uint16_t *dst, int pitch, int rows, int cols,
 }
 #endif  // CONFIG_VP9_HIGHBITDEPTH
 
-static void deblock_and_de_macro_block(YV12_BUFFER_CONFIG *source,
-                                       YV12_BUFFER_CONFIG *post, int q,
-                                       int low_var_thresh, int flag,
-                                       uint8_t *limits) {
-  (void)low_var_thresh;
-  (void)flag;
-#if CONFIG_VP9_HIGHBITDEPTH
-  if (source->flags & YV12_FLAG_HIGHBITDEPTH) {
-    double level = 6.0e-05 * q * q * q - .0067 * q * q + .306 * q + .0065;
-    int ppl = (int)(level + .5);
-    vp9_highbd_post_proc_down_and_across(
-        CONVERT_TO_SHORTPTR(source->y_buffer),
-        CONVERT_TO_SHORTPTR(post->y_buffer), source->y_stride, post->y_stride,
-        source->y_height, source->y_width, ppl);
-
-    vp9_highbd_mbpost_proc_across_ip(CONVERT_TO_SHORTPTR(post->y_buffer),
-                                     post->y_stride, post->y_height,
-                                     post->y_width, q2mbl(q));
-
-    vp9_highbd_mbpost_proc_down(CONVERT_TO_SHORTPTR(post->y_buffer),
-                                post->y_stride, post->y_height, post->y_width,
-                                q2mbl(q));
-
-    vp9_highbd_post_proc_down_and_across(
-        CONVERT_TO_SHORTPTR(source->u_buffer),
-        CONVERT_TO_SHORTPTR(post->u_buffer), source->uv_stride, post->uv_stride,
-        source->uv_height, source->uv_width, ppl);
-    vp9_highbd_post_proc_down_and_across(
-        CONVERT_TO_SHORTPTR(source->v_buffer),
-        CONVERT_TO_SHORTPTR(post->v_buffer), source->uv_stride, post->uv_stride,
-        source->uv_height, source->uv_width, ppl);
-  } else {
-#endif  // CONFIG_VP9_HIGHBITDEPTH
-    vp9_deblock(source, post, q, limits);
-    vpx_mbpost_proc_across_ip(post->y_buffer, post->y_stride, post->y_height,
-                              post->y_width, q2mbl(q));
-    vpx_mbpost_proc_down(post->y_buffer, post->y_stride, post->y_height,
-                         post->y_width, q2mbl(q));
-#if CONFIG_VP9_HIGHBITDEPTH
-  }
-#endif  // CONFIG_VP9_HIGHBITDEPTH
-}
-
-void vp9_deblock(const YV12_BUFFER_CONFIG *src, YV12_BUFFER_CONFIG *dst, int q,
-                 uint8_t *limits) {
-  const int ppl =
-      (int)(6.0e-05 * q * q * q - 0.0067 * q * q + 0.306 * q + 0.0065 + 0.5);
+// Filters the 16 luma rows of macroblock row 'mbr' of 'src' into 'dst' and
+// the matching chroma rows. Rows are independent of each other when 'src' and
+// 'dst' differ.
+static void deblock_mb_row(const YV12_BUFFER_CONFIG *src,
+                           YV12_BUFFER_CONFIG *dst, int mbr, int ppl,
+                           uint8_t *limits) {
 #if CONFIG_VP9_HIGHBITDEPTH
   if (src->flags & YV12_FLAG_HIGHBITDEPTH) {
+    const int last = mbr == (src->y_height + 15) / 16 - 1;
+    const int y_start = 16 * mbr;
+    const int y_end = VPXMIN(y_start + 16, src->y_height);
+    const int uv_start = y_start >> src->subsampling_y;
+    const int uv_end =
+        last ? src->uv_height : (y_start + 16) >> src->subsampling_y;
     int i;
     const uint8_t *const srcs[3] = { src->y_buffer, src->u_buffer,
                                      src->v_buffer };
     const int src_strides[3] = { src->y_stride, src->uv_stride,
                                  src->uv_stride };
     const int src_widths[3] = { src->y_width, src->uv_width, src->uv_width };
-    const int src_heights[3] = { src->y_height, src->uv_height,
-                                 src->uv_height };
-
     uint8_t *const dsts[3] = { dst->y_buffer, dst->u_buffer, dst->v_buffer };
     const int dst_strides[3] = { dst->y_stride, dst->uv_stride,
                                  dst->uv_stride };
     for (i = 0; i < MAX_MB_PLANE; ++i) {
+      const int start = i ? uv_start : y_start;
+      const int rows = (i ? uv_end : y_end) - start;
+      if (rows <= 0) continue;
       vp9_highbd_post_proc_down_and_across(
-          CONVERT_TO_SHORTPTR(srcs[i]), CONVERT_TO_SHORTPTR(dsts[i]),
-          src_strides[i], dst_strides[i], src_heights[i], src_widths[i], ppl);
+          CONVERT_TO_SHORTPTR(srcs[i]) + start * src_strides[i],
+          CONVERT_TO_SHORTPTR(dsts[i]) + start * dst_strides[i],
+          src_strides[i], dst_strides[i], rows, src_widths[i], ppl);
     }
-  } else {
-#endif  // CONFIG_VP9_HIGHBITDEPTH
-    int mbr;
-    const int mb_rows = src->y_height / 16;
-    const int mb_cols = src->y_width / 16;
-
-    memset(limits, (unsigned char)ppl, 16 * mb_cols);
-
-    for (mbr = 0; mbr < mb_rows; mbr++) {
-      vpx_post_proc_down_and_across_mb_row(
-          src->y_buffer + 16 * mbr * src->y_stride,
-          dst->y_buffer + 16 * mbr * dst->y_stride, src->y_stride,
-          dst->y_stride, src->y_width, limits, 16);
-      vpx_post_proc_down_and_across_mb_row(
-          src->u_buffer + 8 * mbr * src->uv_stride,
-          dst->u_buffer + 8 * mbr * dst->uv_stride, src->uv_stride,
-          dst->uv_stride, src->uv_width, limits, 8);
-      vpx_post_proc_down_and_across_mb_row(
-          src->v_buffer + 8 * mbr * src->uv_stride,
-          dst->v_buffer + 8 * mbr * dst->uv_stride, src->uv_stride,
-          dst->uv_stride, src->uv_width, limits, 8);
-    }
-#if CONFIG_VP9_HIGHBITDEPTH
+    return;
   }
+#else
+  (void)ppl;
 #endif  // CONFIG_VP9_HIGHBITDEPTH
+  if (mbr >= src->y_height / 16) return;
+  vpx_post_proc_down_and_across_mb_row(
+      src->y_buffer + 16 * mbr * src->y_stride,
+      dst->y_buffer + 16 * mbr * dst->y_stride, src->y_stride, dst->y_stride,
+      src->y_width, limits, 16);
+  vpx_post_proc_down_and_across_mb_row(
+      src->u_buffer + 8 * mbr * src->uv_stride,
+      dst->u_buffer + 8 * mbr * dst->uv_stride, src->uv_stride, dst->uv_stride,
+      src->uv_width, limits, 8);
+  vpx_post_proc_down_and_across_mb_row(
+      src->v_buffer + 8 * mbr * src->uv_stride,
+      dst->v_buffer + 8 * mbr * dst->uv_stride, src->uv_stride, dst->uv_stride,
+      src->uv_width, limits, 8);
+}
+
+static int get_deblock_ppl(int q) {
+  return (int)(6.0e-05 * q * q * q - 0.0067 * q * q + 0.306 * q + 0.0065 +
+               0.5);
+}
+
+void vp9_deblock(const YV12_BUFFER_CONFIG *src, YV12_BUFFER_CONFIG *dst, int q,
+                 uint8_t *limits) {
+  const int ppl = get_deblock_ppl(q);
+  const int mb_rows = (src->y_height + 15) / 16;
+  int mbr;
+
+  memset(limits, (unsigned char)ppl, 16 * (src->y_width / 16));
+  for (mbr = 0; mbr < mb_rows; mbr++) deblock_mb_row(src, dst, mbr, ppl, limits);
 }
 
 void vp9_denoise(const YV12_BUFFER_CONFIG *src, YV12_BUFFER_CONFIG *dst, int q,
@@ -281,20 +265,191 @@ void vp9_denoise(const YV12_BUFFER_CONFIG *src, YV12_BUFFER_CONFIG *dst, int q,
   vp9_deblock(src, dst, q, limits);
 }
 
+typedef enum {
+  PP_STAGE_MFQE,
+  PP_STAGE_DEBLOCK,
+  PP_STAGE_MBPOST_DOWN,
+} PP_STAGE;
+
+typedef struct PostProcWorkerData {
+  VP9_COMMON *cm;
+  const YV12_BUFFER_CONFIG *src;
+  YV12_BUFFER_CONFIG *dst;
+  PP_STAGE stage;
+  int ppl;
+  int mbpost_flimit;  // 0 when the frame is only deblocked.
+  int index;
+  int num_workers;
+} PostProcWorkerData;
+
+// Runs the share of 'stage' that belongs to worker 'index'. MFQE and deblock
+// rows are interleaved over the workers; the vertical macroblock filter runs
+// down whole columns so it is split into column strips instead.
+static int postproc_worker_hook(PostProcWorkerData *const data, void *unused) {
+  const YV12_BUFFER_CONFIG *const src = data->src;
+  YV12_BUFFER_CONFIG *const dst = data->dst;
+  const int step = data->num_workers;
+  int i;
+  (void)unused;
+
+  switch (data->stage) {
+    case PP_STAGE_MFQE:
+      for (i = data->index * MI_BLOCK_SIZE; i < data->cm->mi_rows;
+           i += step * MI_BLOCK_SIZE) {
+        vp9_mfqe_sb_row(data->cm, i);
+      }
+      break;
+    case PP_STAGE_DEBLOCK: {
+      const int mb_rows = (VPXMAX(src->y_height, dst->y_height) + 15) / 16;
+      for (i = data->index; i < mb_rows; i += step) {
+        const int row = 16 * i;
+        const int rows = VPXMIN(16, dst->y_height - row);
+        deblock_mb_row(src, dst, i, data->ppl,
+                       data->cm->postproc_state.limits);
+        if (!data->mbpost_flimit || rows <= 0) continue;
+#if CONFIG_VP9_HIGHBITDEPTH
+        if (dst->flags & YV12_FLAG_HIGHBITDEPTH) {
+          vp9_highbd_mbpost_proc_across_ip(
+              CONVERT_TO_SHORTPTR(dst->y_buffer) + row * dst->y_stride,
+              dst->y_stride, rows, dst->y_width, data->mbpost_flimit);
+          continue;
+        }
+#endif  // CONFIG_VP9_HIGHBITDEPTH
+        vpx_mbpost_proc_across_ip(dst->y_buffer + row * dst->y_stride,
+                                  dst->y_stride, rows, dst->y_width,
+                                  data->mbpost_flimit);
+      }
+      break;
+    }
+    case PP_STAGE_MBPOST_DOWN: {
+      // Strips start on multiples of 16 columns, which keeps the per column
+      // dither offsets of vpx_mbpost_proc_down() unchanged.
+      const int strip =
+          ALIGN_POWER_OF_TWO((dst->y_width + step - 1) / step, 4);
+      const int col = data->index * strip;
+      const int cols = VPXMIN(strip, dst->y_width - col);
+      if (cols > 0) {
+        vpx_mbpost_proc_down(dst->y_buffer + col, dst->y_stride,
+                             dst->y_height, cols, data->mbpost_flimit);
+      }
+      break;
+    }
+    default: assert(0);
+  }
+  return 1;
+}
+
+// Runs 'stage' on 'num_workers' workers, the last of which runs on the calling
+// thread, and waits for all of them. Without workers the whole stage runs on
+// the calling thread.
+static void run_postproc_stage(VP9_COMMON *cm, PP_STAGE stage,
+                               const YV12_BUFFER_CONFIG *src,
+                               YV12_BUFFER_CONFIG *dst, int ppl,
+                               int mbpost_flimit, VPxWorker *workers,
+                               int num_workers) {
+  const VPxWorkerInterface *const winterface = vpx_get_worker_interface();
+  struct postproc_state *const ppstate = &cm->postproc_state;
+  PostProcWorkerData local_data;
+  int i;
+
+  if (workers != NULL && num_workers > 1 &&
+      num_workers > ppstate->num_workers) {
+    vpx_free(ppstate->worker_data);
+    ppstate->worker_data =
+        vpx_calloc(num_workers, sizeof(*ppstate->worker_data));
+    ppstate->num_workers = ppstate->worker_data ? num_workers : 0;
+  }
+  if (workers == NULL || num_workers <= 1 ||
+      num_workers > ppstate->num_workers) {
+    workers = NULL;
+    num_workers = 1;
+  }
+
+  for (i = 0; i < num_workers; ++i) {
+    PostProcWorkerData *const data =
+        workers ? &ppstate->worker_data[i] : &local_data;
+    data->cm = cm;
+    data->src = src;
+    data->dst = dst;
+    data->stage = stage;
+    data->ppl = ppl;
+    data->mbpost_flimit = mbpost_flimit;
+    data->index = i;
+    data->num_workers = num_workers;
+    if (workers == NULL) {
+      postproc_worker_hook(data, NULL);
+    } else {
+      VPxWorker *const worker = &workers[i];
+      worker->hook = (VPxWorkerHook)postproc_worker_hook;
+      worker->data1 = data;
+      worker->data2 = NULL;
+      if (i == num_workers - 1) {
+        winterface->execute(worker);
+      } else {
+        winterface->launch(worker);
+      }
+    }
+  }
+
+  if (workers != NULL) {
+    for (i = 0; i < num_workers; ++i) winterface->sync(&workers[i]);
+  }
+}
+
+// Deblocks 'src' into 'dst'. A nonzero 'mbpost_flimit' also runs the across
+// and down macroblock filters on the luma plane of 'dst'.
+static void postproc_filter_frame(VP9_COMMON *cm, const YV12_BUFFER_CONFIG *src,
+                                  YV12_BUFFER_CONFIG *dst, int q,
+                                  int mbpost_flimit, VPxWorker *workers,
+                                  int num_workers) {
+  const int ppl = get_deblock_ppl(q);
+
+  memset(cm->postproc_state.limits, (unsigned char)ppl,
+         16 * (src->y_width / 16));
+  run_postproc_stage(cm, PP_STAGE_DEBLOCK, src, dst, ppl, mbpost_flimit,
+                     workers, num_workers);
+  if (!mbpost_flimit) return;
+#if CONFIG_VP9_HIGHBITDEPTH
+  // The high bitdepth filter draws its dither offset from rand() once per
+  // call, so it stays a single call to keep the output unchanged.
+  if (dst->flags & YV12_FLAG_HIGHBITDEPTH) {
+    vp9_highbd_mbpost_proc_down(CONVERT_TO_SHORTPTR(dst->y_buffer),
+                                dst->y_stride, dst->y_height, dst->y_width,
+                                mbpost_flimit);
+    return;
+  }
+#endif  // CONFIG_VP9_HIGHBITDEPTH
+  run_postproc_stage(cm, PP_STAGE_MBPOST_DOWN, src, dst, ppl, mbpost_flimit,
+                     workers, num_workers);
+}
+
 static void swap_mi_and_prev_mi(VP9_COMMON *cm) {
-  // Current mip will be the prev_mip for the next frame.
-  MODE_INFO *temp = cm->postproc_state.prev_mip;
-  cm->postproc_state.prev_mip = cm->mip;
+  struct postproc_state *const ppstate = &cm->postproc_state;
+  // Current mip and grid will be the previous ones for the next frame.
+  MODE_INFO *const temp = ppstate->prev_mip;
+  MODE_INFO **const temp_grid = ppstate->prev_mi_grid_base;
+  ppstate->prev_mip = cm->mip;
+  ppstate->prev_mi_grid_base = cm->mi_grid_base;
   cm->mip = temp;
+  cm->mi_grid_base = temp_grid;
 
   // Update the upper left visible macroblock ptrs.
   cm->mi = cm->mip + cm->mi_stride + 1;
-  cm->postproc_state.prev_mi = cm->postproc_state.prev_mip + cm->mi_stride + 1;
+  cm->mi_grid_visible = cm->mi_grid_base + cm->mi_stride + 1;
+  ppstate->prev_mi_grid_visible =
+      ppstate->prev_mi_grid_base + cm->mi_stride + 1;
 }
 
 int vp9_post_proc_frame(struct VP9Common *cm, YV12_BUFFER_CONFIG *dest,
                         vp9_ppflags_t *ppflags) {
+  return vp9_post_proc_frame_mt(cm, dest, ppflags, NULL, 0);
+}
+
+int vp9_post_proc_frame_mt(struct VP9Common *cm, YV12_BUFFER_CONFIG *dest,
+                           vp9_ppflags_t *ppflags, VPxWorker *workers,
+                           int num_workers) {
   const int q = VPXMIN(105, cm->lf.filter_level * 2);
+  const int demb_q = q + (ppflags->deblocking_level - 5) * 10;
   const int flags = ppflags->post_proc_flag;
   YV12_BUFFER_CONFIG *const ppbuf = &cm->post_proc_buffer;
   struct postproc_state *const ppstate = &cm->postproc_state;
@@ -316,10 +471,17 @@ int vp9_post_proc_frame(struct VP9Common *cm, YV12_BUFFER_CONFIG *dest,
 
   if ((flags & VP9D_MFQE) && ppstate->prev_mip == NULL) {
     ppstate->prev_mip = vpx_calloc(cm->mi_alloc_size, sizeof(*cm->mip));
-    if (!ppstate->prev_mip) {
+    ppstate->prev_mi_grid_base =
+        vpx_calloc(cm->mi_alloc_size, sizeof(*cm->mi_grid_base));
+    if (!ppstate->prev_mip || !ppstate->prev_mi_grid_base) {
+      vpx_free(ppstate->prev_mip);
+      ppstate->prev_mip = NULL;
+      vpx_free(ppstate->prev_mi_grid_base);
+      ppstate->prev_mi_grid_base = NULL;
       return 1;
     }
-    ppstate->prev_mi = ppstate->prev_mip + cm->mi_stride + 1;
+    ppstate->prev_mi_grid_visible =
+        ppstate->prev_mi_grid_base + cm->mi_stride + 1;
   }
 
   // Allocate post_proc_buffer_int if needed.
@@ -375,7 +537,8 @@ int vp9_post_proc_frame(struct VP9Common *cm, YV12_BUFFER_CONFIG *dest,
       ppstate->last_frame_valid && cm->bit_depth == 8 &&
       ppstate->last_base_qindex <= last_q_thresh &&
       cm->base_qindex - ppstate->last_base_qindex >= q_diff_thresh) {
-    vp9_mfqe(cm);
+    run_postproc_stage(cm, PP_STAGE_MFQE, cm->frame_to_show, ppbuf, 0, 0,
+                       workers, num_workers);
     // TODO(jackychen): Consider whether enable deblocking by default
     // if mfqe is enabled. Need to take both the quality and the speed
     // into consideration.
@@ -383,21 +546,20 @@ int vp9_post_proc_frame(struct VP9Common *cm, YV12_BUFFER_CONFIG *dest,
       vpx_yv12_copy_frame(ppbuf, &cm->post_proc_buffer_int);
     }
     if ((flags & VP9D_DEMACROBLOCK) && cm->post_proc_buffer_int.buffer_alloc) {
-      deblock_and_de_macro_block(&cm->post_proc_buffer_int, ppbuf,
-                                 q + (ppflags->deblocking_level - 5) * 10, 1, 0,
-                                 cm->postproc_state.limits);
+      postproc_filter_frame(cm, &cm->post_proc_buffer_int, ppbuf, demb_q,
+                            q2mbl(demb_q), workers, num_workers);
     } else if (flags & VP9D_DEBLOCK) {
-      vp9_deblock(&cm->post_proc_buffer_int, ppbuf, q,
-                  cm->postproc_state.limits);
+      postproc_filter_frame(cm, &cm->post_proc_buffer_int, ppbuf, q, 0,
+                            workers, num_workers);
     } else {
       vpx_yv12_copy_frame(&cm->post_proc_buffer_int, ppbuf);
     }
   } else if (flags & VP9D_DEMACROBLOCK) {
-    deblock_and_de_macro_block(cm->frame_to_show, ppbuf,
-                               q + (ppflags->deblocking_level - 5) * 10, 1, 0,
-                               cm->postproc_state.limits);
+    postproc_filter_frame(cm, cm->frame_to_show, ppbuf, demb_q, q2mbl(demb_q),
+                          workers, num_workers);
   } else if (flags & VP9D_DEBLOCK) {
-    vp9_deblock(cm->frame_to_show, ppbuf, q, cm->postproc_state.limits);
+    postproc_filter_frame(cm, cm->frame_to_show, ppbuf, q, 0, workers,
+                          num_workers);
   } else {
     vpx_yv12_copy_frame(cm->frame_to_show, ppbuf);
   }
@@ -13,6 +13,7 @@
 
 #include "vpx_ports/mem.h"
 #include "vpx_scale/yv12config.h"
+#include "vpx_util/vpx_thread.h"
 #include "vp9/common/vp9_blockd.h"
 #include "vp9/common/vp9_mfqe.h"
 #include "vp9/common/vp9_ppflags.h"
@@ -26,11 +27,16 @@ struct postproc_state {
   int last_noise;
   int last_base_qindex;
   int last_frame_valid;
+  // Mode info of the previous frame, used by MFQE.
   MODE_INFO *prev_mip;
-  MODE_INFO *prev_mi;
+  MODE_INFO **prev_mi_grid_base;
+  MODE_INFO **prev_mi_grid_visible;
   int clamp;
   uint8_t *limits;
   int8_t *generated_noise;
+  // Per worker state of vp9_post_proc_frame_mt().
+  struct PostProcWorkerData *worker_data;
+  int num_workers;
 };
 
 struct VP9Common;
@@ -40,6 +46,14 @@ struct VP9Common;
 int vp9_post_proc_frame(struct VP9Common *cm, YV12_BUFFER_CONFIG *dest,
                         vp9_ppflags_t *flags);
 
+// Same as vp9_post_proc_frame() with MFQE, deblocking and the macroblock
+// filters split by rows (or column strips) over 'num_workers' workers. The
+// last worker runs on the calling thread. The output matches
+// vp9_post_proc_frame().
+int vp9_post_proc_frame_mt(struct VP9Common *cm, YV12_BUFFER_CONFIG *dest,
+                           vp9_ppflags_t *flags, VPxWorker *workers,
+                           int num_workers);
+
 void vp9_denoise(const YV12_BUFFER_CONFIG *src, YV12_BUFFER_CONFIG *dst, int q,
                  uint8_t *limits);
 
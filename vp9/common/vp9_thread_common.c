@@ -8,10 +8,14 @@
  *  be found in the AUTHORS file in the root of the source tree.
  */
 
+#include <stddef.h>
+
 #include "./vpx_config.h"
 #include "vpx_dsp/vpx_dsp_common.h"
 #include "vpx_mem/vpx_mem.h"
+#include "vp9/common/vp9_entropy.h"
 #include "vp9/common/vp9_entropymode.h"
+#include "vp9/common/vp9_entropymv.h"
 #include "vp9/common/vp9_thread_common.h"
 #include "vp9/common/vp9_reconinter.h"
 #include "vp9/common/vp9_loopfilter.h"
@@ -103,7 +107,7 @@ static INLINE void thread_loop_filter_rows(
     path = LF_PATH_SLOW;
 
   for (mi_row = start; mi_row < stop;
-       mi_row += lf_sync->num_workers * MI_BLOCK_SIZE) {
+       mi_row += lf_sync->num_active_workers * MI_BLOCK_SIZE) {
     MODE_INFO **const mi = cm->mi_grid_visible + mi_row * cm->mi_stride;
     LOOP_FILTER_MASK *lfm = get_lfm(&cm->lf, mi_row, 0);
 
@@ -136,6 +140,9 @@ static INLINE void thread_loop_filter_rows(
 
       sync_write(lf_sync, r, c, sb_cols);
     }
+
+    if (cm->lf.row_filtered)
+      cm->lf.row_filtered(cm->lf.row_filtered_priv, mi_row);
   }
 }
 
@@ -148,6 +155,20 @@ static int loop_filter_row_worker(VP9LfSync *const lf_sync,
   return 1;
 }
 
+// Set up nsync by width.
+static INLINE int get_sync_range(int width) {
+  // nsync numbers are picked by testing. For example, for 4k
+  // video, using 4 gives best performance.
+  if (width < 640)
+    return 1;
+  else if (width <= 1280)
+    return 2;
+  else if (width <= 4096)
+    return 4;
+  else
+    return 8;
+}
+
 static void loop_filter_rows_mt(YV12_BUFFER_CONFIG *frame, VP9_COMMON *cm,
                                 struct macroblockd_plane planes[MAX_MB_PLANE],
                                 int start, int stop, int y_only,
@@ -162,11 +183,16 @@ static void loop_filter_rows_mt(YV12_BUFFER_CONFIG *frame, VP9_COMMON *cm,
   const int num_workers = VPXMIN(nworkers, tile_cols);
   int i;
 
-  if (!lf_sync->sync_range || sb_rows != lf_sync->rows ||
+  // The sync data is only reallocated when it grows, so that resizing down
+  // and back up does not allocate.
+  if (!lf_sync->sync_range || sb_rows > lf_sync->rows ||
       num_workers > lf_sync->num_workers) {
     vp9_loop_filter_dealloc(lf_sync);
     vp9_loop_filter_alloc(lf_sync, cm, sb_rows, cm->width, num_workers);
+  } else {
+    lf_sync->sync_range = get_sync_range(cm->width);
   }
+  lf_sync->num_active_workers = num_workers;
 
   // Initialize cur_sb_col to -1 for all SB rows.
   memset(lf_sync->cur_sb_col, -1, sizeof(*lf_sync->cur_sb_col) * sb_rows);
@@ -230,20 +256,6 @@ void vp9_loop_filter_frame_mt(YV12_BUFFER_CONFIG *frame, VP9_COMMON *cm,
                       workers, num_workers, lf_sync);
 }
 
-// Set up nsync by width.
-static INLINE int get_sync_range(int width) {
-  // nsync numbers are picked by testing. For example, for 4k
-  // video, using 4 gives best performance.
-  if (width < 640)
-    return 1;
-  else if (width <= 1280)
-    return 2;
-  else if (width <= 4096)
-    return 4;
-  else
-    return 8;
-}
-
 // Allocate memory for lf row synchronization
 void vp9_loop_filter_alloc(VP9LfSync *lf_sync, VP9_COMMON *cm, int rows,
                            int width, int num_workers) {
@@ -308,113 +320,91 @@ void vp9_loop_filter_dealloc(VP9LfSync *lf_sync) {
   }
 }
 
-// Accumulate frame counts.
-void vp9_accumulate_frame_counts(FRAME_COUNTS *accum,
-                                 const FRAME_COUNTS *counts, int is_dec) {
-  int i, j, k, l, m;
-
-  for (i = 0; i < BLOCK_SIZE_GROUPS; i++)
-    for (j = 0; j < INTRA_MODES; j++)
-      accum->y_mode[i][j] += counts->y_mode[i][j];
-
-  for (i = 0; i < INTRA_MODES; i++)
-    for (j = 0; j < INTRA_MODES; j++)
-      accum->uv_mode[i][j] += counts->uv_mode[i][j];
-
-  for (i = 0; i < PARTITION_CONTEXTS; i++)
-    for (j = 0; j < PARTITION_TYPES; j++)
-      accum->partition[i][j] += counts->partition[i][j];
-
-  if (is_dec) {
-    int n;
-    for (i = 0; i < TX_SIZES; i++)
-      for (j = 0; j < PLANE_TYPES; j++)
-        for (k = 0; k < REF_TYPES; k++)
-          for (l = 0; l < COEF_BANDS; l++)
-            for (m = 0; m < COEFF_CONTEXTS; m++) {
-              accum->eob_branch[i][j][k][l][m] +=
-                  counts->eob_branch[i][j][k][l][m];
-              for (n = 0; n < UNCONSTRAINED_NODES + 1; n++)
-                accum->coef[i][j][k][l][m][n] += counts->coef[i][j][k][l][m][n];
-            }
-  } else {
-    for (i = 0; i < TX_SIZES; i++)
-      for (j = 0; j < PLANE_TYPES; j++)
-        for (k = 0; k < REF_TYPES; k++)
-          for (l = 0; l < COEF_BANDS; l++)
-            for (m = 0; m < COEFF_CONTEXTS; m++)
-              accum->eob_branch[i][j][k][l][m] +=
-                  counts->eob_branch[i][j][k][l][m];
-    // In the encoder, coef is only updated at frame
-    // level, so not need to accumulate it here.
-    // for (n = 0; n < UNCONSTRAINED_NODES + 1; n++)
-    //   accum->coef[i][j][k][l][m][n] +=
-    //       counts->coef[i][j][k][l][m][n];
-  }
-
-  for (i = 0; i < SWITCHABLE_FILTER_CONTEXTS; i++)
-    for (j = 0; j < SWITCHABLE_FILTERS; j++)
-      accum->switchable_interp[i][j] += counts->switchable_interp[i][j];
-
-  for (i = 0; i < INTER_MODE_CONTEXTS; i++)
-    for (j = 0; j < INTER_MODES; j++)
-      accum->inter_mode[i][j] += counts->inter_mode[i][j];
-
-  for (i = 0; i < INTRA_INTER_CONTEXTS; i++)
-    for (j = 0; j < 2; j++)
-      accum->intra_inter[i][j] += counts->intra_inter[i][j];
-
-  for (i = 0; i < COMP_INTER_CONTEXTS; i++)
-    for (j = 0; j < 2; j++) accum->comp_inter[i][j] += counts->comp_inter[i][j];
-
-  for (i = 0; i < REF_CONTEXTS; i++)
-    for (j = 0; j < 2; j++)
-      for (k = 0; k < 2; k++)
-        accum->single_ref[i][j][k] += counts->single_ref[i][j][k];
-
-  for (i = 0; i < REF_CONTEXTS; i++)
-    for (j = 0; j < 2; j++) accum->comp_ref[i][j] += counts->comp_ref[i][j];
-
-  for (i = 0; i < TX_SIZE_CONTEXTS; i++) {
-    for (j = 0; j < TX_SIZES; j++)
-      accum->tx.p32x32[i][j] += counts->tx.p32x32[i][j];
-
-    for (j = 0; j < TX_SIZES - 1; j++)
-      accum->tx.p16x16[i][j] += counts->tx.p16x16[i][j];
-
-    for (j = 0; j < TX_SIZES - 2; j++)
-      accum->tx.p8x8[i][j] += counts->tx.p8x8[i][j];
+// Adaptation jobs: the coefficient probabilities of each transform size, then
+// the mode and the mv probabilities.
+#define ADAPT_JOB_MODE TX_SIZES
+#define ADAPT_JOB_MV (TX_SIZES + 1)
+#define ADAPT_JOBS (TX_SIZES + 2)
+
+typedef struct {
+  VP9_COMMON *cm;
+  int first_job;
+  int job_step;
+  int num_jobs;
+} AdaptProbsData;
+
+static int adapt_probs_worker(AdaptProbsData *const data, void *unused) {
+  VP9_COMMON *const cm = data->cm;
+  int job;
+  (void)unused;
+
+  for (job = data->first_job; job < data->num_jobs; job += data->job_step) {
+    if (job < TX_SIZES)
+      vp9_adapt_coef_probs_tx(cm, (TX_SIZE)job);
+    else if (job == ADAPT_JOB_MODE)
+      vp9_adapt_mode_probs(cm);
+    else
+      vp9_adapt_mv_probs(cm, cm->allow_high_precision_mv);
   }
+  return 1;
+}
 
-  for (i = 0; i < TX_SIZES; i++)
-    accum->tx.tx_totals[i] += counts->tx.tx_totals[i];
-
-  for (i = 0; i < SKIP_CONTEXTS; i++)
-    for (j = 0; j < 2; j++) accum->skip[i][j] += counts->skip[i][j];
+void vp9_adapt_probs_mt(VP9_COMMON *cm, int adapt_modes, VPxWorker *workers,
+                        int nworkers) {
+  const VPxWorkerInterface *const winterface = vpx_get_worker_interface();
+  const int num_jobs = adapt_modes ? ADAPT_JOBS : TX_SIZES;
+  const int num_workers = VPXMIN(nworkers, num_jobs);
+  AdaptProbsData data[ADAPT_JOBS];
+  int i;
 
-  for (i = 0; i < MV_JOINTS; i++) accum->mv.joints[i] += counts->mv.joints[i];
+  // The jobs write disjoint parts of cm->fc.
+  for (i = 0; i < num_workers; ++i) {
+    VPxWorker *const worker = &workers[i];
 
-  for (k = 0; k < 2; k++) {
-    nmv_component_counts *const comps = &accum->mv.comps[k];
-    const nmv_component_counts *const comps_t = &counts->mv.comps[k];
+    data[i].cm = cm;
+    data[i].first_job = i;
+    data[i].job_step = num_workers;
+    data[i].num_jobs = num_jobs;
+    worker->hook = (VPxWorkerHook)adapt_probs_worker;
+    worker->data1 = &data[i];
+    worker->data2 = NULL;
 
-    for (i = 0; i < 2; i++) {
-      comps->sign[i] += comps_t->sign[i];
-      comps->class0_hp[i] += comps_t->class0_hp[i];
-      comps->hp[i] += comps_t->hp[i];
+    if (i == num_workers - 1) {
+      winterface->execute(worker);
+    } else {
+      winterface->launch(worker);
     }
+  }
 
-    for (i = 0; i < MV_CLASSES; i++) comps->classes[i] += comps_t->classes[i];
+  for (i = 0; i < num_workers; ++i) {
+    winterface->sync(&workers[i]);
+  }
+}
 
-    for (i = 0; i < CLASS0_SIZE; i++) {
-      comps->class0[i] += comps_t->class0[i];
-      for (j = 0; j < MV_FP_SIZE; j++)
-        comps->class0_fp[i][j] += comps_t->class0_fp[i][j];
-    }
+static void accumulate_counts(unsigned int *accum, const unsigned int *counts,
+                              int start, int end) {
+  int i;
+  for (i = start; i < end; ++i) accum[i] += counts[i];
+}
 
-    for (i = 0; i < MV_OFFSET_BITS; i++)
-      for (j = 0; j < 2; j++) comps->bits[i][j] += comps_t->bits[i][j];
+// Accumulate frame counts. FRAME_COUNTS holds only unsigned int counters, so
+// it is summed as one array, in a loop the compiler vectorizes.
+void vp9_accumulate_frame_counts(FRAME_COUNTS *accum,
+                                 const FRAME_COUNTS *counts, int is_dec) {
+  unsigned int *const accum_ct = (unsigned int *)accum;
+  const unsigned int *const counts_ct = (const unsigned int *)counts;
+  const int num_counts = (int)(sizeof(*accum) / sizeof(*accum_ct));
 
-    for (i = 0; i < MV_FP_SIZE; i++) comps->fp[i] += comps_t->fp[i];
+  if (is_dec) {
+    accumulate_counts(accum_ct, counts_ct, 0, num_counts);
+  } else {
+    // In the encoder, coef is only updated at frame
+    // level, so not need to accumulate it here.
+    accumulate_counts(accum_ct, counts_ct, 0,
+                      (int)(offsetof(FRAME_COUNTS, coef) / sizeof(*accum_ct)));
+    accumulate_counts(
+        accum_ct, counts_ct,
+        (int)(offsetof(FRAME_COUNTS, eob_branch) / sizeof(*accum_ct)),
+        num_counts);
   }
 }
@@ -36,7 +36,8 @@ typedef struct VP9LfSyncData {
 
   // Row-based parallel loopfilter data
   LFWorkerData *lfdata;
-  int num_workers;
+  int num_workers;         // Number of entries in lfdata.
+  int num_active_workers;  // Number of workers filtering the current frame.
 } VP9LfSync;
 
 // Allocate memory for loopfilter row synchronization.
@@ -56,6 +57,13 @@ void vp9_loop_filter_frame_mt(YV12_BUFFER_CONFIG *frame, struct VP9Common *cm,
 void vp9_accumulate_frame_counts(struct FRAME_COUNTS *accum,
                                  const struct FRAME_COUNTS *counts, int is_dec);
 
+// Adapts the frame context to the frame counts as vp9_adapt_coef_probs(),
+// and vp9_adapt_mode_probs() and vp9_adapt_mv_probs() when adapt_modes is set,
+// would, with the transform sizes and the mode and mv probabilities split
+// across the workers.
+void vp9_adapt_probs_mt(struct VP9Common *cm, int adapt_modes,
+                        VPxWorker *workers, int num_workers);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
@@ -9,6 +9,7 @@
  */
 
 #include <assert.h>
+#include <stddef.h>  // offsetof()
 #include <stdlib.h>  // qsort()
 
 #include "./vp9_rtcd.h"
@@ -731,15 +732,31 @@ static void set_plane_n4(MACROBLOCKD *const xd, int bw, int bh, int bwl,
   }
 }
 
-static MODE_INFO *set_offsets(VP9_COMMON *const cm, MACROBLOCKD *const xd,
+// Mode info is packed in decode order into a region of cm->mip reserved for
+// each tile, large enough for every 8x8 block of the tile to be sub8x8. Blocks
+// of 8x8 and larger leave out the trailing bmi array.
+static void init_tile_mode_info(const VP9_COMMON *const cm,
+                                TileWorkerData *const twd) {
+  const TileInfo *const tile = &twd->xd.tile;
+  const int tile_mi_rows = tile->mi_row_end - tile->mi_row_start;
+  twd->mi_next = (uint8_t *)(cm->mip + tile->mi_row_start * cm->mi_cols +
+                             tile_mi_rows * tile->mi_col_start);
+}
+
+static MODE_INFO *set_offsets(VP9_COMMON *const cm, TileWorkerData *twd,
                               BLOCK_SIZE bsize, int mi_row, int mi_col, int bw,
                               int bh, int x_mis, int y_mis, int bwl, int bhl) {
+  MACROBLOCKD *const xd = &twd->xd;
   const int offset = mi_row * cm->mi_stride + mi_col;
+  const size_t mi_size =
+      bsize < BLOCK_8X8 ? sizeof(MODE_INFO) : offsetof(MODE_INFO, bmi);
   int x, y;
   const TileInfo *const tile = &xd->tile;
 
   xd->mi = cm->mi_grid_visible + offset;
-  xd->mi[0] = &cm->mi[offset];
+  xd->mi[0] = (MODE_INFO *)twd->mi_next;
+  twd->mi_next += mi_size;
+  memset(xd->mi[0], 0, mi_size);
   // TODO(slavarnway): Generate sb_type based on bwl and bhl, instead of
   // passing bsize from decode_partition().
   xd->mi[0]->sb_type = bsize;
@@ -771,7 +788,7 @@ static void decode_block(TileWorkerData *twd, VP9Decoder *const pbi, int mi_row,
   vpx_reader *r = &twd->bit_reader;
   MACROBLOCKD *const xd = &twd->xd;
 
-  MODE_INFO *mi = set_offsets(cm, xd, bsize, mi_row, mi_col, bw, bh, x_mis,
+  MODE_INFO *mi = set_offsets(cm, twd, bsize, mi_row, mi_col, bw, bh, x_mis,
                               y_mis, bwl, bhl);
 
   if (bsize >= BLOCK_8X8 && (cm->subsampling_x || cm->subsampling_y)) {
@@ -783,6 +800,7 @@ static void decode_block(TileWorkerData *twd, VP9Decoder *const pbi, int mi_row,
   }
 
   vp9_read_mode_info(twd, pbi, mi_row, mi_col, x_mis, y_mis);
+  vp9_dec_count_block(twd, bsize, mi->skip);
 
   if (mi->skip) {
     dec_reset_skip_context(xd);
@@ -860,6 +878,122 @@ static void decode_block(TileWorkerData *twd, VP9Decoder *const pbi, int mi_row,
   }
 }
 
+static INLINE PREDICTION_MODE get_intra_tx_block_mode(const MODE_INFO *mi,
+                                                      int plane, int row,
+                                                      int col) {
+  if (plane) return mi->uv_mode;
+  return mi->sb_type < BLOCK_8X8 ? mi->bmi[(row << 1) + col].as_mode
+                                 : mi->mode;
+}
+
+static INLINE void set_plane_max_blocks(MACROBLOCKD *const xd,
+                                        const struct macroblockd_plane *pd,
+                                        int *max_blocks_wide,
+                                        int *max_blocks_high) {
+  *max_blocks_wide =
+      pd->n4_w + (xd->mb_to_right_edge >= 0
+                      ? 0
+                      : xd->mb_to_right_edge >> (5 + pd->subsampling_x));
+  *max_blocks_high =
+      pd->n4_h + (xd->mb_to_bottom_edge >= 0
+                      ? 0
+                      : xd->mb_to_bottom_edge >> (5 + pd->subsampling_y));
+
+  xd->max_blocks_wide = xd->mb_to_right_edge >= 0 ? 0 : *max_blocks_wide;
+  xd->max_blocks_high = xd->mb_to_bottom_edge >= 0 ? 0 : *max_blocks_high;
+}
+
+// Parse stage of decode_block(): reads the mode info and the coefficient
+// tokens of the block into twd->parsed_sb without touching the frame buffer.
+static void parse_block(TileWorkerData *twd, VP9Decoder *const pbi, int mi_row,
+                        int mi_col, BLOCK_SIZE bsize, int bwl, int bhl) {
+  VP9_COMMON *const cm = &pbi->common;
+  const int less8x8 = bsize < BLOCK_8X8;
+  const int bw = 1 << (bwl - 1);
+  const int bh = 1 << (bhl - 1);
+  const int x_mis = VPXMIN(bw, cm->mi_cols - mi_col);
+  const int y_mis = VPXMIN(bh, cm->mi_rows - mi_row);
+  vpx_reader *r = &twd->bit_reader;
+  MACROBLOCKD *const xd = &twd->xd;
+  ParsedSuperblock *const sb = twd->parsed_sb;
+  ParsedBlock *const block = &sb->blocks[sb->num_blocks++];
+
+  MODE_INFO *mi = set_offsets(cm, twd, bsize, mi_row, mi_col, bw, bh, x_mis,
+                              y_mis, bwl, bhl);
+
+  if (bsize >= BLOCK_8X8 && (cm->subsampling_x || cm->subsampling_y)) {
+    const BLOCK_SIZE uv_subsize =
+        ss_size_lookup[bsize][cm->subsampling_x][cm->subsampling_y];
+    if (uv_subsize == BLOCK_INVALID)
+      vpx_internal_error(xd->error_info, VPX_CODEC_CORRUPT_FRAME,
+                         "Invalid block size.");
+  }
+
+  vp9_read_mode_info(twd, pbi, mi_row, mi_col, x_mis, y_mis);
+  vp9_dec_count_block(twd, bsize, mi->skip);
+
+  block->mi_row = mi_row;
+  block->mi_col = mi_col;
+  block->bwl = bwl;
+  block->bhl = bhl;
+
+  if (mi->skip) {
+    dec_reset_skip_context(xd);
+  } else {
+    const int is_inter = is_inter_block(mi);
+    const int eob_start = sb->num_eobs;
+    int eobtotal = 0;
+    int plane;
+
+    for (plane = 0; plane < MAX_MB_PLANE; ++plane) {
+      struct macroblockd_plane *const pd = &xd->plane[plane];
+      const TX_SIZE tx_size = plane ? get_uv_tx_size(mi, pd) : mi->tx_size;
+      const int step = (1 << tx_size);
+      int row, col, max_blocks_wide, max_blocks_high;
+
+      set_plane_max_blocks(xd, pd, &max_blocks_wide, &max_blocks_high);
+
+      for (row = 0; row < max_blocks_high; row += step) {
+        for (col = 0; col < max_blocks_wide; col += step) {
+          const scan_order *sc = &vp9_default_scan_orders[tx_size];
+          int eob;
+          if (!is_inter && !plane && !xd->lossless) {
+            const PREDICTION_MODE mode =
+                get_intra_tx_block_mode(mi, plane, row, col);
+            sc = &vp9_scan_orders[tx_size][intra_mode_to_tx_type_lookup[mode]];
+          }
+          pd->dqcoeff = sb->dqcoeff + sb->num_coeffs;
+          eob = vp9_decode_block_tokens(twd, plane, sc, col, row, tx_size,
+                                        mi->segment_id);
+          sb->eobs[sb->num_eobs++] = eob;
+          if (eob > 0) sb->num_coeffs += 16 << (tx_size << 1);
+          eobtotal += eob;
+        }
+      }
+    }
+
+    if (is_inter && !less8x8 && eobtotal == 0) {
+      mi->skip = 1;  // skip loopfilter
+      sb->num_eobs = eob_start;
+    }
+  }
+
+  xd->corrupted |= vpx_reader_has_error(r);
+
+  if (cm->lf.filter_level) {
+    vp9_build_mask(cm, mi, mi_row, mi_col, bw, bh);
+  }
+}
+
+static INLINE void process_block(TileWorkerData *twd, VP9Decoder *const pbi,
+                                 int mi_row, int mi_col, BLOCK_SIZE bsize,
+                                 int bwl, int bhl) {
+  if (twd->parsed_sb)
+    parse_block(twd, pbi, mi_row, mi_col, bsize, bwl, bhl);
+  else
+    decode_block(twd, pbi, mi_row, mi_col, bsize, bwl, bhl);
+}
+
 static INLINE int dec_partition_plane_context(TileWorkerData *twd, int mi_row,
                                               int mi_col, int bsl) {
   const PARTITION_CONTEXT *above_ctx = twd->xd.above_seg_context + mi_col;
@@ -931,23 +1065,23 @@ static void decode_partition(TileWorkerData *twd, VP9Decoder *const pbi,
     // calculate bmode block dimensions (log 2)
     xd->bmode_blocks_wl = 1 >> !!(partition & PARTITION_VERT);
     xd->bmode_blocks_hl = 1 >> !!(partition & PARTITION_HORZ);
-    decode_block(twd, pbi, mi_row, mi_col, subsize, 1, 1);
+    process_block(twd, pbi, mi_row, mi_col, subsize, 1, 1);
   } else {
     switch (partition) {
       case PARTITION_NONE:
-        decode_block(twd, pbi, mi_row, mi_col, subsize, n4x4_l2, n4x4_l2);
+        process_block(twd, pbi, mi_row, mi_col, subsize, n4x4_l2, n4x4_l2);
         break;
       case PARTITION_HORZ:
-        decode_block(twd, pbi, mi_row, mi_col, subsize, n4x4_l2, n8x8_l2);
+        process_block(twd, pbi, mi_row, mi_col, subsize, n4x4_l2, n8x8_l2);
         if (has_rows)
-          decode_block(twd, pbi, mi_row + hbs, mi_col, subsize, n4x4_l2,
-                       n8x8_l2);
+          process_block(twd, pbi, mi_row + hbs, mi_col, subsize, n4x4_l2,
+                        n8x8_l2);
         break;
       case PARTITION_VERT:
-        decode_block(twd, pbi, mi_row, mi_col, subsize, n8x8_l2, n4x4_l2);
+        process_block(twd, pbi, mi_row, mi_col, subsize, n8x8_l2, n4x4_l2);
         if (has_cols)
-          decode_block(twd, pbi, mi_row, mi_col + hbs, subsize, n8x8_l2,
-                       n4x4_l2);
+          process_block(twd, pbi, mi_row, mi_col + hbs, subsize, n8x8_l2,
+                        n4x4_l2);
         break;
       case PARTITION_SPLIT:
         decode_partition(twd, pbi, mi_row, mi_col, subsize, n8x8_l2);
@@ -1368,6 +1502,486 @@ static void get_tile_buffers(VP9Decoder *pbi, const uint8_t *data,
   }
 }
 
+void vp9_create_tile_workers(VP9Decoder *pbi) {
+  VP9_COMMON *const cm = &pbi->common;
+  const VPxWorkerInterface *const winterface = vpx_get_worker_interface();
+  int n;
+
+  if (pbi->num_tile_workers == 0) {
+    const int num_threads = pbi->max_threads;
+    CHECK_MEM_ERROR(cm, pbi->tile_workers,
+                    vpx_malloc(num_threads * sizeof(*pbi->tile_workers)));
+    for (n = 0; n < num_threads; ++n) {
+      VPxWorker *const worker = &pbi->tile_workers[n];
+      ++pbi->num_tile_workers;
+
+      winterface->init(worker);
+      if (n < num_threads - 1 && !winterface->reset(worker)) {
+        vpx_internal_error(&cm->error, VPX_CODEC_ERROR,
+                           "Tile decoder thread creation failed");
+      }
+    }
+  }
+}
+
+// Clears the work counters of a tile worker.
+static INLINE void reset_block_stats(TileWorkerData *twd) {
+#if CONFIG_STAGE_TIMING
+  vp9_zero(twd->block_count);
+  twd->skip_count = 0;
+  twd->coeff_count = 0;
+#else
+  (void)twd;
+#endif
+}
+
+// Adds the work counters of 'num' tile worker data to pbi->frame_stats.
+static void accumulate_block_stats(VP9Decoder *pbi, const TileWorkerData *twd,
+                                   int num) {
+#if CONFIG_STAGE_TIMING
+  vpx_dec_frame_stats_t *const stats = &pbi->frame_stats;
+  int n, i;
+
+  for (n = 0; n < num; ++n) {
+    for (i = 0; i < BLOCK_SIZES; ++i) stats->blocks[i] += twd[n].block_count[i];
+    stats->skip_blocks += twd[n].skip_count;
+    stats->coeffs += twd[n].coeff_count;
+  }
+#else
+  (void)pbi;
+  (void)twd;
+  (void)num;
+#endif
+}
+
+// Adds the time elapsed since vp9_dec_timer_start() to the slot of the tile
+// worker owning 'twd'. Each worker only writes its own slot.
+static void worker_timer_end(VP9Decoder *pbi, const TileWorkerData *twd,
+                             struct vpx_usec_timer *timer) {
+#if CONFIG_STAGE_TIMING
+  const int n = (int)(twd - pbi->tile_worker_data) - pbi->total_tiles;
+  if (n < VPX_DEC_STATS_MAX_WORKERS)
+    vp9_dec_timer_end(timer, &pbi->frame_stats.worker_us[n]);
+#else
+  (void)pbi;
+  (void)twd;
+  (void)timer;
+#endif
+}
+
+#if CONFIG_STAGE_TIMING
+static int timed_loop_filter_worker(LFWorkerData *const lf_data,
+                                    VP9Decoder *const pbi) {
+  struct vpx_usec_timer timer;
+  vp9_dec_timer_start(&timer);
+  vp9_loop_filter_worker(lf_data, NULL);
+  vp9_dec_timer_end(&timer, &pbi->frame_stats.loop_filter_us);
+  return 1;
+}
+#endif  // CONFIG_STAGE_TIMING
+
+// Reconstruction stage of decode_block() for a block recorded by
+// parse_block(). 'eobs' and 'dqcoeff' are advanced past the block's data.
+static void recon_block(TileWorkerData *twd, VP9Decoder *const pbi,
+                        const ParsedBlock *const block, const uint16_t **eobs,
+                        tran_low_t **dqcoeff) {
+  VP9_COMMON *const cm = &pbi->common;
+  MACROBLOCKD *const xd = &twd->xd;
+  const int mi_row = block->mi_row;
+  const int mi_col = block->mi_col;
+  const int bw = 1 << (block->bwl - 1);
+  const int bh = 1 << (block->bhl - 1);
+  MODE_INFO *mi;
+  int plane;
+
+  xd->mi = cm->mi_grid_visible + mi_row * cm->mi_stride + mi_col;
+  mi = xd->mi[0];
+  set_plane_n4(xd, bw, bh, block->bwl, block->bhl);
+  set_mi_row_col(xd, &xd->tile, mi_row, bh, mi_col, bw, cm->mi_rows,
+                 cm->mi_cols);
+  vp9_setup_dst_planes(xd->plane, get_frame_new_buffer(cm), mi_row, mi_col);
+
+  if (!is_inter_block(mi)) {
+    for (plane = 0; plane < MAX_MB_PLANE; ++plane) {
+      struct macroblockd_plane *const pd = &xd->plane[plane];
+      const TX_SIZE tx_size = plane ? get_uv_tx_size(mi, pd) : mi->tx_size;
+      const int step = (1 << tx_size);
+      int row, col, max_blocks_wide, max_blocks_high;
+
+      set_plane_max_blocks(xd, pd, &max_blocks_wide, &max_blocks_high);
+
+      for (row = 0; row < max_blocks_high; row += step) {
+        for (col = 0; col < max_blocks_wide; col += step) {
+          const PREDICTION_MODE mode =
+              get_intra_tx_block_mode(mi, plane, row, col);
+          uint8_t *const dst =
+              &pd->dst.buf[4 * row * pd->dst.stride + 4 * col];
+
+          vp9_predict_intra_block(xd, pd->n4_wl, tx_size, mode, dst,
+                                  pd->dst.stride, dst, pd->dst.stride, col,
+                                  row, plane);
+
+          if (!mi->skip) {
+            const int eob = *(*eobs)++;
+            if (eob > 0) {
+              const TX_TYPE tx_type = (plane || xd->lossless)
+                                          ? DCT_DCT
+                                          : intra_mode_to_tx_type_lookup[mode];
+              pd->dqcoeff = *dqcoeff;
+              inverse_transform_block_intra(xd, plane, tx_type, tx_size, dst,
+                                            pd->dst.stride, eob);
+              *dqcoeff += 16 << (tx_size << 1);
+            }
+          }
+        }
+      }
+    }
+  } else {
+    dec_build_inter_predictors_sb(pbi, xd, mi_row, mi_col);
+
+    if (!mi->skip) {
+      for (plane = 0; plane < MAX_MB_PLANE; ++plane) {
+        struct macroblockd_plane *const pd = &xd->plane[plane];
+        const TX_SIZE tx_size = plane ? get_uv_tx_size(mi, pd) : mi->tx_size;
+        const int step = (1 << tx_size);
+        int row, col, max_blocks_wide, max_blocks_high;
+
+        set_plane_max_blocks(xd, pd, &max_blocks_wide, &max_blocks_high);
+
+        for (row = 0; row < max_blocks_high; row += step) {
+          for (col = 0; col < max_blocks_wide; col += step) {
+            const int eob = *(*eobs)++;
+            if (eob > 0) {
+              pd->dqcoeff = *dqcoeff;
+              inverse_transform_block_inter(
+                  xd, plane, tx_size,
+                  &pd->dst.buf[4 * row * pd->dst.stride + 4 * col],
+                  pd->dst.stride, eob);
+              *dqcoeff += 16 << (tx_size << 1);
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+static void recon_superblock(TileWorkerData *twd, VP9Decoder *const pbi,
+                             const ParsedSuperblock *const sb) {
+  const uint16_t *eobs = sb->eobs;
+  tran_low_t *dqcoeff = sb->dqcoeff;
+  int i;
+
+  twd->xd.tile = sb->tile;
+  for (i = 0; i < sb->num_blocks; ++i)
+    recon_block(twd, pbi, &sb->blocks[i], &eobs, &dqcoeff);
+}
+
+// Wakes up every thread of the parse/reconstruction pipeline after an error.
+static void recon_sync_abort(VP9ReconSync *const recon_sync) {
+#if CONFIG_MULTITHREAD
+  int i;
+
+  pthread_mutex_lock(&recon_sync->job_mutex_);
+  recon_sync->abort = 1;
+  pthread_cond_signal(&recon_sync->job_cond_);
+  pthread_mutex_unlock(&recon_sync->job_mutex_);
+
+  for (i = 0; i < recon_sync->rows; ++i) {
+    pthread_mutex_lock(&recon_sync->mutex_[i]);
+    pthread_cond_signal(&recon_sync->parse_cond_[i]);
+    pthread_cond_signal(&recon_sync->recon_cond_[i]);
+    pthread_mutex_unlock(&recon_sync->mutex_[i]);
+  }
+#else
+  recon_sync->abort = 1;
+#endif  // CONFIG_MULTITHREAD
+}
+
+// Waits until the ring slots for superblock row 'r' are no longer in use.
+static int parse_sync_wait_slots(VP9ReconSync *const recon_sync, int r) {
+#if CONFIG_MULTITHREAD
+  int abort;
+
+  pthread_mutex_lock(&recon_sync->job_mutex_);
+  while (!recon_sync->abort &&
+         r - recon_sync->rows_done >= recon_sync->slot_rows) {
+    pthread_cond_wait(&recon_sync->job_cond_, &recon_sync->job_mutex_);
+  }
+  abort = recon_sync->abort;
+  pthread_mutex_unlock(&recon_sync->job_mutex_);
+  return !abort;
+#else
+  (void)r;
+  return !recon_sync->abort;
+#endif  // CONFIG_MULTITHREAD
+}
+
+static void parse_sync_write(VP9ReconSync *const recon_sync, int r, int c) {
+#if CONFIG_MULTITHREAD
+  pthread_mutex_lock(&recon_sync->mutex_[r]);
+  recon_sync->parsed_sb_cols[r] = c + 1;
+  pthread_cond_signal(&recon_sync->parse_cond_[r]);
+  pthread_mutex_unlock(&recon_sync->mutex_[r]);
+#else
+  recon_sync->parsed_sb_cols[r] = c + 1;
+#endif  // CONFIG_MULTITHREAD
+}
+
+// Waits until superblock (r, c) has been parsed and the superblock above it
+// has been reconstructed. Intra prediction never reads above-right pixels
+// outside of the current block so the superblock above is sufficient.
+static int recon_sync_read(VP9ReconSync *const recon_sync, int r, int c) {
+#if CONFIG_MULTITHREAD
+  int abort;
+
+  pthread_mutex_lock(&recon_sync->mutex_[r]);
+  while (!recon_sync->abort && recon_sync->parsed_sb_cols[r] <= c) {
+    pthread_cond_wait(&recon_sync->parse_cond_[r], &recon_sync->mutex_[r]);
+  }
+  abort = recon_sync->abort;
+  pthread_mutex_unlock(&recon_sync->mutex_[r]);
+
+  if (r > 0 && !abort) {
+    pthread_mutex_lock(&recon_sync->mutex_[r - 1]);
+    while (!recon_sync->abort && recon_sync->recon_sb_cols[r - 1] <= c) {
+      pthread_cond_wait(&recon_sync->recon_cond_[r - 1],
+                        &recon_sync->mutex_[r - 1]);
+    }
+    abort = recon_sync->abort;
+    pthread_mutex_unlock(&recon_sync->mutex_[r - 1]);
+  }
+  return !abort;
+#else
+  (void)r;
+  (void)c;
+  return !recon_sync->abort;
+#endif  // CONFIG_MULTITHREAD
+}
+
+static void recon_sync_write(VP9ReconSync *const recon_sync, int r, int c) {
+#if CONFIG_MULTITHREAD
+  pthread_mutex_lock(&recon_sync->mutex_[r]);
+  recon_sync->recon_sb_cols[r] = c + 1;
+  pthread_cond_signal(&recon_sync->recon_cond_[r]);
+  pthread_mutex_unlock(&recon_sync->mutex_[r]);
+
+  if (c == recon_sync->cols - 1) {
+    pthread_mutex_lock(&recon_sync->job_mutex_);
+    recon_sync->rows_done = VPXMAX(recon_sync->rows_done, r + 1);
+    pthread_cond_signal(&recon_sync->job_cond_);
+    pthread_mutex_unlock(&recon_sync->job_mutex_);
+  }
+#else
+  recon_sync->recon_sb_cols[r] = c + 1;
+  if (c == recon_sync->cols - 1) recon_sync->rows_done = r + 1;
+#endif  // CONFIG_MULTITHREAD
+}
+
+static int recon_sync_get_row(VP9ReconSync *const recon_sync) {
+  int r;
+#if CONFIG_MULTITHREAD
+  pthread_mutex_lock(&recon_sync->job_mutex_);
+#endif
+  r = recon_sync->abort ? recon_sync->rows : recon_sync->next_row++;
+#if CONFIG_MULTITHREAD
+  pthread_mutex_unlock(&recon_sync->job_mutex_);
+#endif
+  return r;
+}
+
+// Reconstructs superblock rows handed out by recon_sync_get_row() until the
+// frame is complete. The worker finishing a superblock row also schedules the
+// loop filter of the row above it, before signalling the row's last
+// superblock, which keeps the loop filter rows in order.
+static int recon_worker_hook(TileWorkerData *const twd, VP9Decoder *const pbi) {
+  VP9_COMMON *const cm = &pbi->common;
+  VP9ReconSync *const recon_sync = &pbi->recon_sync;
+  const VPxWorkerInterface *const winterface = vpx_get_worker_interface();
+  const int sb_rows = recon_sync->rows;
+  const int sb_cols = recon_sync->cols;
+  int sb_row;
+  struct vpx_usec_timer timer;
+
+  vp9_dec_timer_start(&timer);
+  twd->error_info.setjmp = 1;
+  if (setjmp(twd->error_info.jmp)) {
+    twd->error_info.setjmp = 0;
+    twd->xd.corrupted = 1;
+    recon_sync_abort(recon_sync);
+    return 0;
+  }
+
+  twd->xd.corrupted = 0;
+
+  while ((sb_row = recon_sync_get_row(recon_sync)) < sb_rows) {
+    ParsedSuperblock *const sbs =
+        recon_sync->sbs + (sb_row % recon_sync->slot_rows) * sb_cols;
+    int sb_col;
+
+    for (sb_col = 0; sb_col < sb_cols; ++sb_col) {
+      if (!recon_sync_read(recon_sync, sb_row, sb_col)) {
+        twd->error_info.setjmp = 0;
+        return 0;
+      }
+
+      recon_superblock(twd, pbi, &sbs[sb_col]);
+
+      // Loopfilter the row above, delayed by 1 superblock row as in
+      // decode_tiles(). The last rows are filtered by the parse thread.
+      if (sb_col == sb_cols - 1 && cm->lf.filter_level &&
+          !cm->skip_loop_filter && sb_row > 0 && sb_row < sb_rows - 1) {
+        LFWorkerData *const lf_data = (LFWorkerData *)pbi->lf_worker.data1;
+        winterface->sync(&pbi->lf_worker);
+        lf_data->start = (sb_row - 1) << MI_BLOCK_SIZE_LOG2;
+        lf_data->stop = sb_row << MI_BLOCK_SIZE_LOG2;
+        winterface->launch(&pbi->lf_worker);
+      }
+
+      recon_sync_write(recon_sync, sb_row, sb_col);
+    }
+  }
+
+  twd->error_info.setjmp = 0;
+  worker_timer_end(pbi, twd, &timer);
+  return 1;
+}
+
+// The parse/reconstruction pipeline is used when the tiles can not be decoded
+// in parallel, which includes all single tile column streams.
+static int use_parse_recon_mt(const VP9Decoder *pbi) {
+#if CONFIG_MULTITHREAD
+  return pbi->max_threads > 1 && !pbi->frame_parallel_decode &&
+         !pbi->inv_tile_order;
+#else
+  (void)pbi;
+  return 0;
+#endif  // CONFIG_MULTITHREAD
+}
+
+// Parses all tiles on the calling thread while pbi->max_threads - 1 tile
+// workers reconstruct the parsed superblocks.
+static void parse_and_reconstruct_tiles(VP9Decoder *pbi) {
+  VP9_COMMON *const cm = &pbi->common;
+  const VPxWorkerInterface *const winterface = vpx_get_worker_interface();
+  VP9ReconSync *const recon_sync = &pbi->recon_sync;
+  const int tile_cols = 1 << cm->log2_tile_cols;
+  const int tile_rows = 1 << cm->log2_tile_rows;
+  const int sb_rows = mi_cols_aligned_to_sb(cm->mi_rows) >> MI_BLOCK_SIZE_LOG2;
+  const int sb_cols = mi_cols_aligned_to_sb(cm->mi_cols) >> MI_BLOCK_SIZE_LOG2;
+  const int num_workers = pbi->max_threads - 1;
+  // Let the parse stage run one superblock row ahead of the wavefront.
+  const int slot_rows = VPXMIN(sb_rows, num_workers + 1);
+  const int sb_coeffs =
+      64 * 64 + 2 * ((64 * 64) >> (cm->subsampling_x + cm->subsampling_y));
+  int tile_row, tile_col;
+  int mi_row, mi_col;
+  int n;
+
+#if CONFIG_STAGE_TIMING
+  pbi->frame_stats.num_workers = VPXMIN(num_workers, VPX_DEC_STATS_MAX_WORKERS);
+#endif
+
+  if (recon_sync->rows != sb_rows || recon_sync->cols != sb_cols ||
+      recon_sync->slot_rows != slot_rows ||
+      recon_sync->sb_coeffs != sb_coeffs) {
+    vp9_recon_sync_dealloc(recon_sync);
+    vp9_recon_sync_alloc(recon_sync, cm, sb_rows, sb_cols, slot_rows,
+                         sb_coeffs);
+  }
+
+  memset(recon_sync->parsed_sb_cols, 0,
+         sizeof(*recon_sync->parsed_sb_cols) * sb_rows);
+  memset(recon_sync->recon_sb_cols, 0,
+         sizeof(*recon_sync->recon_sb_cols) * sb_rows);
+  recon_sync->next_row = 0;
+  recon_sync->rows_done = 0;
+  recon_sync->abort = 0;
+
+  if (setjmp(recon_sync->error_info.jmp)) {
+    recon_sync->error_info.setjmp = 0;
+    recon_sync_abort(recon_sync);
+    for (n = 0; n < num_workers; ++n) winterface->sync(&pbi->tile_workers[n]);
+    // Unconsumed superblocks may have left coefficients in the ring.
+    memset(recon_sync->dqcoeff, 0, slot_rows * sb_cols * sb_coeffs *
+                                       sizeof(*recon_sync->dqcoeff));
+    vpx_internal_error(&cm->error, recon_sync->error_info.error_code, "%s",
+                       recon_sync->error_info.has_detail
+                           ? recon_sync->error_info.detail
+                           : "Failed to decode tile data");
+  }
+  recon_sync->error_info.setjmp = 1;
+
+  for (n = 0; n < tile_rows * tile_cols; ++n)
+    pbi->tile_worker_data[n].xd.error_info = &recon_sync->error_info;
+
+  for (n = 0; n < num_workers; ++n) {
+    VPxWorker *const worker = &pbi->tile_workers[n];
+    TileWorkerData *const twd = &pbi->tile_worker_data[pbi->total_tiles + n];
+
+    twd->xd = pbi->mb;
+    twd->parsed_sb = NULL;
+    vp9_init_macroblockd(cm, &twd->xd, twd->dqcoeff);
+    twd->xd.error_info = &twd->error_info;
+    worker->hook = (VPxWorkerHook)recon_worker_hook;
+    worker->data1 = twd;
+    worker->data2 = pbi;
+    worker->had_error = 0;
+    winterface->launch(worker);
+  }
+
+  for (tile_row = 0; tile_row < tile_rows; ++tile_row) {
+    TileInfo tile;
+    vp9_tile_set_row(&tile, cm, tile_row);
+    for (mi_row = tile.mi_row_start; mi_row < tile.mi_row_end;
+         mi_row += MI_BLOCK_SIZE) {
+      const int sb_row = mi_row >> MI_BLOCK_SIZE_LOG2;
+      ParsedSuperblock *const sbs =
+          recon_sync->sbs + (sb_row % slot_rows) * sb_cols;
+
+      if (!parse_sync_wait_slots(recon_sync, sb_row))
+        vpx_internal_error(&recon_sync->error_info, VPX_CODEC_CORRUPT_FRAME,
+                           "Failed to reconstruct tile data");
+
+      for (tile_col = 0; tile_col < tile_cols; ++tile_col) {
+        TileWorkerData *const tile_data =
+            pbi->tile_worker_data + tile_cols * tile_row + tile_col;
+        struct vpx_usec_timer timer;
+        vp9_dec_timer_start(&timer);
+        vp9_tile_set_col(&tile, cm, tile_col);
+        vp9_zero(tile_data->xd.left_context);
+        vp9_zero(tile_data->xd.left_seg_context);
+        for (mi_col = tile.mi_col_start; mi_col < tile.mi_col_end;
+             mi_col += MI_BLOCK_SIZE) {
+          const int sb_col = mi_col >> MI_BLOCK_SIZE_LOG2;
+          ParsedSuperblock *const sb = &sbs[sb_col];
+          sb->tile = tile_data->xd.tile;
+          sb->num_blocks = 0;
+          sb->num_eobs = 0;
+          sb->num_coeffs = 0;
+          tile_data->parsed_sb = sb;
+          decode_partition(tile_data, pbi, mi_row, mi_col, BLOCK_64X64, 4);
+          parse_sync_write(recon_sync, sb_row, sb_col);
+        }
+        vp9_dec_timer_end(
+            &timer, &pbi->frame_stats.tile_us[tile_cols * tile_row + tile_col]);
+        tile_data->parsed_sb = NULL;
+        pbi->mb.corrupted |= tile_data->xd.corrupted;
+        if (pbi->mb.corrupted)
+          vpx_internal_error(&recon_sync->error_info, VPX_CODEC_CORRUPT_FRAME,
+                             "Failed to decode tile data");
+      }
+    }
+  }
+
+  for (n = 0; n < num_workers; ++n)
+    pbi->mb.corrupted |= !winterface->sync(&pbi->tile_workers[n]);
+  if (pbi->mb.corrupted)
+    vpx_internal_error(&recon_sync->error_info, VPX_CODEC_CORRUPT_FRAME,
+                       "Failed to reconstruct tile data");
+  recon_sync->error_info.setjmp = 0;
+}
+
 static const uint8_t *decode_tiles(VP9Decoder *pbi, const uint8_t *data,
                                    const uint8_t *data_end) {
   VP9_COMMON *const cm = &pbi->common;
@@ -1379,12 +1993,20 @@ static const uint8_t *decode_tiles(VP9Decoder *pbi, const uint8_t *data,
   int tile_row, tile_col;
   int mi_row, mi_col;
   TileWorkerData *tile_data = NULL;
+  const int parse_recon_mt = use_parse_recon_mt(pbi);
+
+  if (parse_recon_mt) vp9_create_tile_workers(pbi);
 
   if (cm->lf.filter_level && !cm->skip_loop_filter &&
       pbi->lf_worker.data1 == NULL) {
     CHECK_MEM_ERROR(cm, pbi->lf_worker.data1,
                     vpx_memalign(32, sizeof(LFWorkerData)));
+#if CONFIG_STAGE_TIMING
+    pbi->lf_worker.hook = (VPxWorkerHook)timed_loop_filter_worker;
+    pbi->lf_worker.data2 = pbi;
+#else
     pbi->lf_worker.hook = (VPxWorkerHook)vp9_loop_filter_worker;
+#endif
     if (pbi->max_threads > 1 && !winterface->reset(&pbi->lf_worker)) {
       vpx_internal_error(&cm->error, VPX_CODEC_ERROR,
                          "Loop filter thread creation failed");
@@ -1423,8 +2045,11 @@ static const uint8_t *decode_tiles(VP9Decoder *pbi, const uint8_t *data,
       tile_data->xd.corrupted = 0;
       tile_data->xd.counts =
           cm->frame_parallel_decoding_mode ? NULL : &cm->counts;
+      tile_data->parsed_sb = NULL;
+      reset_block_stats(tile_data);
       vp9_zero(tile_data->dqcoeff);
       vp9_tile_init(&tile_data->xd.tile, cm, tile_row, tile_col);
+      init_tile_mode_info(cm, tile_data);
       setup_token_decoder(buf->data, data_end, buf->size, &cm->error,
                           &tile_data->bit_reader, pbi->decrypt_cb,
                           pbi->decrypt_state);
@@ -1432,52 +2057,64 @@ static const uint8_t *decode_tiles(VP9Decoder *pbi, const uint8_t *data,
     }
   }
 
-  for (tile_row = 0; tile_row < tile_rows; ++tile_row) {
-    TileInfo tile;
-    vp9_tile_set_row(&tile, cm, tile_row);
-    for (mi_row = tile.mi_row_start; mi_row < tile.mi_row_end;
-         mi_row += MI_BLOCK_SIZE) {
-      for (tile_col = 0; tile_col < tile_cols; ++tile_col) {
-        const int col =
-            pbi->inv_tile_order ? tile_cols - tile_col - 1 : tile_col;
-        tile_data = pbi->tile_worker_data + tile_cols * tile_row + col;
-        vp9_tile_set_col(&tile, cm, col);
-        vp9_zero(tile_data->xd.left_context);
-        vp9_zero(tile_data->xd.left_seg_context);
-        for (mi_col = tile.mi_col_start; mi_col < tile.mi_col_end;
-             mi_col += MI_BLOCK_SIZE) {
-          decode_partition(tile_data, pbi, mi_row, mi_col, BLOCK_64X64, 4);
+  if (parse_recon_mt) {
+    parse_and_reconstruct_tiles(pbi);
+  } else {
+    for (tile_row = 0; tile_row < tile_rows; ++tile_row) {
+      TileInfo tile;
+      vp9_tile_set_row(&tile, cm, tile_row);
+      for (mi_row = tile.mi_row_start; mi_row < tile.mi_row_end;
+           mi_row += MI_BLOCK_SIZE) {
+        for (tile_col = 0; tile_col < tile_cols; ++tile_col) {
+          const int col =
+              pbi->inv_tile_order ? tile_cols - tile_col - 1 : tile_col;
+          struct vpx_usec_timer timer;
+          vp9_dec_timer_start(&timer);
+          tile_data = pbi->tile_worker_data + tile_cols * tile_row + col;
+          vp9_tile_set_col(&tile, cm, col);
+          vp9_zero(tile_data->xd.left_context);
+          vp9_zero(tile_data->xd.left_seg_context);
+          for (mi_col = tile.mi_col_start; mi_col < tile.mi_col_end;
+               mi_col += MI_BLOCK_SIZE) {
+            decode_partition(tile_data, pbi, mi_row, mi_col, BLOCK_64X64,
+                             4);
+          }
+          vp9_dec_timer_end(
+              &timer, &pbi->frame_stats.tile_us[tile_cols * tile_row + col]);
+          pbi->mb.corrupted |= tile_data->xd.corrupted;
+          if (pbi->mb.corrupted)
+            vpx_internal_error(&cm->error, VPX_CODEC_CORRUPT_FRAME,
+                               "Failed to decode tile data");
         }
-        pbi->mb.corrupted |= tile_data->xd.corrupted;
-        if (pbi->mb.corrupted)
-          vpx_internal_error(&cm->error, VPX_CODEC_CORRUPT_FRAME,
-                             "Failed to decode tile data");
-      }
-      // Loopfilter one row.
-      if (cm->lf.filter_level && !cm->skip_loop_filter) {
-        const int lf_start = mi_row - MI_BLOCK_SIZE;
-        LFWorkerData *const lf_data = (LFWorkerData *)pbi->lf_worker.data1;
-
-        // delay the loopfilter by 1 macroblock row.
-        if (lf_start < 0) continue;
-
-        // decoding has completed: finish up the loop filter in this thread.
-        if (mi_row + MI_BLOCK_SIZE >= cm->mi_rows) continue;
-
-        winterface->sync(&pbi->lf_worker);
-        lf_data->start = lf_start;
-        lf_data->stop = mi_row;
-        if (pbi->max_threads > 1) {
-          winterface->launch(&pbi->lf_worker);
-        } else {
-          winterface->execute(&pbi->lf_worker);
+        // Loopfilter one row.
+        if (cm->lf.filter_level && !cm->skip_loop_filter) {
+          const int lf_start = mi_row - MI_BLOCK_SIZE;
+          LFWorkerData *const lf_data =
+              (LFWorkerData *)pbi->lf_worker.data1;
+
+          // delay the loopfilter by 1 macroblock row.
+          if (lf_start < 0) continue;
+
+          // decoding has completed: finish up the loop filter in this
+          // thread.
+          if (mi_row + MI_BLOCK_SIZE >= cm->mi_rows) continue;
+
+          winterface->sync(&pbi->lf_worker);
+          lf_data->start = lf_start;
+          lf_data->stop = mi_row;
+          if (pbi->max_threads > 1) {
+            winterface->launch(&pbi->lf_worker);
+          } else {
+            winterface->execute(&pbi->lf_worker);
+          }
         }
+        // After loopfiltering, the last 7 row pixels in each superblock row
+        // may still be changed by the longest loopfilter of the next
+        // superblock row.
+        if (pbi->frame_parallel_decode)
+          vp9_frameworker_broadcast(pbi->cur_buf,
+                                    mi_row << MI_BLOCK_SIZE_LOG2);
       }
-      // After loopfiltering, the last 7 row pixels in each superblock row may
-      // still be changed by the longest loopfilter of the next superblock
-      // row.
-      if (pbi->frame_parallel_decode)
-        vp9_frameworker_broadcast(pbi->cur_buf, mi_row << MI_BLOCK_SIZE_LOG2);
     }
   }
 
@@ -1490,6 +2127,8 @@ static const uint8_t *decode_tiles(VP9Decoder *pbi, const uint8_t *data,
     winterface->execute(&pbi->lf_worker);
   }
 
+  accumulate_block_stats(pbi, pbi->tile_worker_data, tile_cols * tile_rows);
+
   // Get last tile data.
   tile_data = pbi->tile_worker_data + tile_cols * tile_rows - 1;
 
@@ -1507,6 +2146,8 @@ static int tile_worker_hook(TileWorkerData *const tile_data,
   const int final_col = (1 << pbi->common.log2_tile_cols) - 1;
   const uint8_t *volatile bit_reader_end = NULL;
   volatile int n = tile_data->buf_start;
+  struct vpx_usec_timer worker_timer;
+  vp9_dec_timer_start(&worker_timer);
   tile_data->error_info.setjmp = 1;
 
   if (setjmp(tile_data->error_info.jmp)) {
@@ -1521,8 +2162,11 @@ static int tile_worker_hook(TileWorkerData *const tile_data,
   do {
     int mi_row, mi_col;
     const TileBuffer *const buf = pbi->tile_buffers + n;
+    struct vpx_usec_timer timer;
+    vp9_dec_timer_start(&timer);
     vp9_zero(tile_data->dqcoeff);
     vp9_tile_init(tile, &pbi->common, 0, buf->col);
+    init_tile_mode_info(&pbi->common, tile_data);
     setup_token_decoder(buf->data, tile_data->data_end, buf->size,
                         &tile_data->error_info, &tile_data->bit_reader,
                         pbi->decrypt_cb, pbi->decrypt_state);
@@ -1543,9 +2187,11 @@ static int tile_worker_hook(TileWorkerData *const tile_data,
     if (buf->col == final_col) {
       bit_reader_end = vpx_reader_find_end(&tile_data->bit_reader);
     }
+    vp9_dec_timer_end(&timer, &pbi->frame_stats.tile_us[buf->col]);
   } while (!tile_data->xd.corrupted && ++n <= tile_data->buf_end);
 
   tile_data->data_end = bit_reader_end;
+  worker_timer_end(pbi, tile_data, &worker_timer);
   return !tile_data->xd.corrupted;
 }
 
@@ -1571,21 +2217,10 @@ static const uint8_t *decode_tiles_mt(VP9Decoder *pbi, const uint8_t *data,
   assert(tile_rows == 1);
   (void)tile_rows;
 
-  if (pbi->num_tile_workers == 0) {
-    const int num_threads = pbi->max_threads;
-    CHECK_MEM_ERROR(cm, pbi->tile_workers,
-                    vpx_malloc(num_threads * sizeof(*pbi->tile_workers)));
-    for (n = 0; n < num_threads; ++n) {
-      VPxWorker *const worker = &pbi->tile_workers[n];
-      ++pbi->num_tile_workers;
-
-      winterface->init(worker);
-      if (n < num_threads - 1 && !winterface->reset(worker)) {
-        vpx_internal_error(&cm->error, VPX_CODEC_ERROR,
-                           "Tile decoder thread creation failed");
-      }
-    }
-  }
+  vp9_create_tile_workers(pbi);
+#if CONFIG_STAGE_TIMING
+  pbi->frame_stats.num_workers = VPXMIN(num_workers, VPX_DEC_STATS_MAX_WORKERS);
+#endif
 
   // Reset tile decoding hook
   for (n = 0; n < num_workers; ++n) {
@@ -1596,6 +2231,8 @@ static const uint8_t *decode_tiles_mt(VP9Decoder *pbi, const uint8_t *data,
     tile_data->xd = pbi->mb;
     tile_data->xd.counts =
         cm->frame_parallel_decoding_mode ? NULL : &tile_data->counts;
+    tile_data->parsed_sb = NULL;
+    reset_block_stats(tile_data);
     worker->hook = (VPxWorkerHook)tile_worker_hook;
     worker->data1 = tile_data;
     worker->data2 = pbi;
@@ -1696,6 +2333,9 @@ static const uint8_t *decode_tiles_mt(VP9Decoder *pbi, const uint8_t *data,
     }
   }
 
+  accumulate_block_stats(pbi, pbi->tile_worker_data + pbi->total_tiles,
+                         num_workers);
+
   assert(bit_reader_end || pbi->mb.corrupted);
   return bit_reader_end;
 }
@@ -2050,16 +2690,23 @@ void vp9_decode_frame(VP9Decoder *pbi, const uint8_t *data,
   struct vpx_read_bit_buffer rb;
   int context_updated = 0;
   uint8_t clear_data[MAX_VP9_HEADER_SIZE];
-  const size_t first_partition_size = read_uncompressed_header(
+  struct vpx_usec_timer timer;
+  size_t first_partition_size;
+  int tile_rows, tile_cols;
+  YV12_BUFFER_CONFIG *new_fb;
+
+  vp9_dec_timer_start(&timer);
+  first_partition_size = read_uncompressed_header(
       pbi, init_read_bit_buffer(pbi, &rb, data, data_end, clear_data));
-  const int tile_rows = 1 << cm->log2_tile_rows;
-  const int tile_cols = 1 << cm->log2_tile_cols;
-  YV12_BUFFER_CONFIG *const new_fb = get_frame_new_buffer(cm);
+  tile_rows = 1 << cm->log2_tile_rows;
+  tile_cols = 1 << cm->log2_tile_cols;
+  new_fb = get_frame_new_buffer(cm);
   xd->cur_buf = new_fb;
 
   if (!first_partition_size) {
     // showing a frame directly
     *p_data_end = data + (cm->profile <= PROFILE_2 ? 1 : 2);
+    vp9_dec_timer_end(&timer, &pbi->frame_stats.header_us);
     return;
   }
 
@@ -2085,6 +2732,7 @@ void vp9_decode_frame(VP9Decoder *pbi, const uint8_t *data,
   if (new_fb->corrupted)
     vpx_internal_error(&cm->error, VPX_CODEC_CORRUPT_FRAME,
                        "Decode failed. Frame data header is corrupted.");
+  vp9_dec_timer_end(&timer, &pbi->frame_stats.header_us);
 
   if (cm->lf.filter_level && !cm->skip_loop_filter) {
     vp9_loop_filter_frame_init(cm, cm->lf.filter_level);
@@ -2121,32 +2769,48 @@ void vp9_decode_frame(VP9Decoder *pbi, const uint8_t *data,
     pbi->total_tiles = tile_rows * tile_cols;
   }
 
+#if CONFIG_STAGE_TIMING
+  pbi->frame_stats.num_tiles = tile_rows * tile_cols;
+#endif
+
   if (pbi->max_threads > 1 && tile_rows == 1 && tile_cols > 1) {
     // Multi-threaded tile decoder
+    vp9_dec_timer_start(&timer);
     *p_data_end = decode_tiles_mt(pbi, data + first_partition_size, data_end);
+    vp9_dec_timer_end(&timer, &pbi->frame_stats.tile_decode_us);
     if (!xd->corrupted) {
       if (!cm->skip_loop_filter) {
         // If multiple threads are used to decode tiles, then we use those
         // threads to do parallel loopfiltering.
+        vp9_dec_timer_start(&timer);
         vp9_loop_filter_frame_mt(new_fb, cm, pbi->mb.plane, cm->lf.filter_level,
                                  0, 0, pbi->tile_workers, pbi->num_tile_workers,
                                  &pbi->lf_row_sync);
+        vp9_dec_timer_end(&timer, &pbi->frame_stats.loop_filter_us);
       }
     } else {
       vpx_internal_error(&cm->error, VPX_CODEC_CORRUPT_FRAME,
                          "Decode failed. Frame data is corrupted.");
     }
   } else {
+    vp9_dec_timer_start(&timer);
     *p_data_end = decode_tiles(pbi, data + first_partition_size, data_end);
+    vp9_dec_timer_end(&timer, &pbi->frame_stats.tile_decode_us);
   }
 
   if (!xd->corrupted) {
     if (!cm->error_resilient_mode && !cm->frame_parallel_decoding_mode) {
-      vp9_adapt_coef_probs(cm);
+      if (pbi->num_tile_workers > 1) {
+        // Use the tile threads, idle by now, as for the loopfilter.
+        vp9_adapt_probs_mt(cm, !frame_is_intra_only(cm), pbi->tile_workers,
+                           pbi->num_tile_workers);
+      } else {
+        vp9_adapt_coef_probs(cm);
 
-      if (!frame_is_intra_only(cm)) {
-        vp9_adapt_mode_probs(cm);
-        vp9_adapt_mv_probs(cm, cm->allow_high_precision_mv);
+        if (!frame_is_intra_only(cm)) {
+          vp9_adapt_mode_probs(cm);
+          vp9_adapt_mv_probs(cm, cm->allow_high_precision_mv);
+        }
       }
     }
   } else {
@@ -28,6 +28,11 @@ BITSTREAM_PROFILE vp9_read_profile(struct vpx_read_bit_buffer *rb);
 void vp9_decode_frame(struct VP9Decoder *pbi, const uint8_t *data,
                       const uint8_t *data_end, const uint8_t **p_data_end);
 
+// Creates pbi->max_threads tile workers, all but the last of which own a
+// thread. The last worker is executed on the calling thread. Does nothing if
+// the workers already exist.
+void vp9_create_tile_workers(struct VP9Decoder *pbi);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
@@ -51,12 +51,15 @@ static void initialize_dec(void) {
 static void vp9_dec_setup_mi(VP9_COMMON *cm) {
   cm->mi = cm->mip + cm->mi_stride + 1;
   cm->mi_grid_visible = cm->mi_grid_base + cm->mi_stride + 1;
-  memset(cm->mi_grid_base, 0,
-         cm->mi_stride * (cm->mi_rows + 1) * sizeof(*cm->mi_grid_base));
+  // Clear the whole grid: entries outside the frame must not keep pointers
+  // into mode info storage that is repacked every frame.
+  memset(cm->mi_grid_base, 0, cm->mi_alloc_size * sizeof(*cm->mi_grid_base));
 }
 
 static int vp9_dec_alloc_mi(VP9_COMMON *cm, int mi_size) {
-  cm->mip = vpx_calloc(mi_size, sizeof(*cm->mip));
+  // Mode info is packed in decode order (see set_offsets()), so the tail of
+  // the allocation is usually never touched.
+  cm->mip = vpx_malloc(mi_size * sizeof(*cm->mip));
   if (!cm->mip) return 1;
   cm->mi_alloc_size = mi_size;
   cm->mi_grid_base = (MODE_INFO **)vpx_calloc(mi_size, sizeof(MODE_INFO *));
@@ -69,6 +72,14 @@ static void vp9_dec_free_mi(VP9_COMMON *cm) {
   cm->mip = NULL;
   vpx_free(cm->mi_grid_base);
   cm->mi_grid_base = NULL;
+#if CONFIG_VP9_POSTPROC
+  // The MFQE copies are swapped with the buffers above every frame, so they
+  // must be reallocated at the new size as well.
+  vpx_free(cm->postproc_state.prev_mip);
+  cm->postproc_state.prev_mip = NULL;
+  vpx_free(cm->postproc_state.prev_mi_grid_base);
+  cm->postproc_state.prev_mi_grid_base = NULL;
+#endif
 }
 
 VP9Decoder *vp9_decoder_create(BufferPool *const pool) {
@@ -137,6 +148,7 @@ void vp9_decoder_remove(VP9Decoder *pbi) {
 
   if (pbi->num_tile_workers > 0) {
     vp9_loop_filter_dealloc(&pbi->lf_row_sync);
+    vp9_recon_sync_dealloc(&pbi->recon_sync);
   }
 
   vpx_free(pbi);
@@ -290,6 +302,7 @@ int vp9_receive_compressed_data(VP9Decoder *pbi, size_t size,
   }
 
   pbi->ready_for_new_data = 0;
+  vp9_zero(pbi->frame_stats);
 
   // Check if the previous frame was a frame without any references to it.
   // Release frame buffer if not decoding in frame parallel mode.
@@ -336,6 +349,10 @@ int vp9_receive_compressed_data(VP9Decoder *pbi, size_t size,
       winterface->sync(&pbi->tile_workers[i]);
     }
 
+    // Blocks the failed frame did not decode would otherwise keep pointers
+    // into mode info storage that has since been repacked.
+    if (cm->mi_grid_base) vp9_dec_setup_mi(cm);
+
     lock_buffer_pool(pool);
     // Release all the reference buffers if worker thread is holding them.
     if (pbi->hold_ref_buf == 1) {
@@ -408,6 +425,33 @@ int vp9_receive_compressed_data(VP9Decoder *pbi, size_t size,
   return retcode;
 }
 
+#if CONFIG_VP9_POSTPROC
+// Post-processes the frame to show, spreading the filters over the tile
+// workers when the decoder has more than one thread.
+static int post_proc_frame(VP9Decoder *pbi, YV12_BUFFER_CONFIG *sd,
+                           vp9_ppflags_t *flags) {
+  VP9_COMMON *const cm = &pbi->common;
+  int ret;
+
+  if (pbi->max_threads <= 1 || pbi->frame_parallel_decode ||
+      !flags->post_proc_flag) {
+    return vp9_post_proc_frame(cm, sd, flags);
+  }
+
+  if (setjmp(cm->error.jmp)) {
+    cm->error.setjmp = 0;
+    vpx_clear_system_state();
+    return -1;
+  }
+  cm->error.setjmp = 1;
+  vp9_create_tile_workers(pbi);
+  ret = vp9_post_proc_frame_mt(cm, sd, flags, pbi->tile_workers,
+                               pbi->num_tile_workers);
+  cm->error.setjmp = 0;
+  return ret;
+}
+#endif  // CONFIG_VP9_POSTPROC
+
 int vp9_get_raw_frame(VP9Decoder *pbi, YV12_BUFFER_CONFIG *sd,
                       vp9_ppflags_t *flags) {
   VP9_COMMON *const cm = &pbi->common;
@@ -427,7 +471,10 @@ int vp9_get_raw_frame(VP9Decoder *pbi, YV12_BUFFER_CONFIG *sd,
 
 #if CONFIG_VP9_POSTPROC
   if (!cm->show_existing_frame) {
-    ret = vp9_post_proc_frame(cm, sd, flags);
+    struct vpx_usec_timer timer;
+    vp9_dec_timer_start(&timer);
+    ret = post_proc_frame(pbi, sd, flags);
+    vp9_dec_timer_end(&timer, &pbi->frame_stats.postproc_us);
   } else {
     *sd = *cm->frame_to_show;
     ret = 0;
@@ -13,8 +13,10 @@
 
 #include "./vpx_config.h"
 
+#include "vpx/vp8dx.h"
 #include "vpx/vpx_codec.h"
 #include "vpx_dsp/bitreader.h"
+#include "vpx_ports/vpx_timer.h"
 #include "vpx_scale/yv12config.h"
 #include "vpx_util/vpx_thread.h"
 
@@ -37,11 +39,19 @@ typedef struct TileWorkerData {
   const uint8_t *data_end;
   int buf_start, buf_end;  // pbi->tile_buffers to decode, inclusive
   vpx_reader bit_reader;
+  ParsedSuperblock *parsed_sb;  // Output slot of the parse stage.
+  uint8_t *mi_next;  // Next free mode info in the tile's region of cm->mip.
   FRAME_COUNTS counts;
   DECLARE_ALIGNED(16, MACROBLOCKD, xd);
   /* dqcoeff are shared by all the planes. So planes must be decoded serially */
   DECLARE_ALIGNED(16, tran_low_t, dqcoeff[32 * 32]);
   struct vpx_internal_error_info error_info;
+#if CONFIG_STAGE_TIMING
+  // Work counters, folded into VP9Decoder.frame_stats after the tiles.
+  unsigned int block_count[BLOCK_SIZES];
+  unsigned int skip_count;
+  uint64_t coeff_count;
+#endif
 } TileWorkerData;
 
 typedef struct VP9Decoder {
@@ -68,6 +78,7 @@ typedef struct VP9Decoder {
   int total_tiles;
 
   VP9LfSync lf_row_sync;
+  VP9ReconSync recon_sync;  // Parse/reconstruction pipeline.
 
   vpx_decrypt_cb decrypt_cb;
   void *decrypt_state;
@@ -76,6 +87,10 @@ typedef struct VP9Decoder {
   int inv_tile_order;
   int need_resync;   // wait for key/intra-only frame.
   int hold_ref_buf;  // hold the reference buffer.
+
+  // Timing and work counters of the last frame, see VP9D_GET_FRAME_STATS.
+  // Only filled in when CONFIG_STAGE_TIMING is enabled.
+  vpx_dec_frame_stats_t frame_stats;
 } VP9Decoder;
 
 int vp9_receive_compressed_data(struct VP9Decoder *pbi, size_t size,
@@ -111,6 +126,38 @@ vpx_codec_err_t vp9_parse_superframe_index(const uint8_t *data, size_t data_sz,
 
 struct VP9Decoder *vp9_decoder_create(BufferPool *const pool);
 
+static INLINE void vp9_dec_timer_start(struct vpx_usec_timer *timer) {
+#if CONFIG_STAGE_TIMING
+  vpx_usec_timer_start(timer);
+#else
+  (void)timer;
+#endif
+}
+
+// Adds the time elapsed since vp9_dec_timer_start() to '*total'.
+static INLINE void vp9_dec_timer_end(struct vpx_usec_timer *timer,
+                                     int64_t *total) {
+#if CONFIG_STAGE_TIMING
+  vpx_usec_timer_mark(timer);
+  *total += vpx_usec_timer_elapsed(timer);
+#else
+  (void)timer;
+  (void)total;
+#endif
+}
+
+static INLINE void vp9_dec_count_block(TileWorkerData *twd, BLOCK_SIZE bsize,
+                                       int skip) {
+#if CONFIG_STAGE_TIMING
+  ++twd->block_count[bsize];
+  twd->skip_count += skip;
+#else
+  (void)twd;
+  (void)bsize;
+  (void)skip;
+#endif
+}
+
 void vp9_decoder_remove(struct VP9Decoder *pbi);
 
 static INLINE void decrease_ref_count(int idx, RefCntBuffer *const frame_bufs,
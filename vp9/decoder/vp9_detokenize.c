@@ -29,19 +29,25 @@
     if (counts) ++coef_counts[band][ctx][token]; \
   } while (0)
 
-static INLINE int read_bool(vpx_reader *r, int prob, BD_VALUE *value,
-                            int *count, unsigned int *range) {
+// A bool never consumes more than 7 bits of the window: the range is at least
+// 1 after a split, which vpx_norm renormalizes by 7.
+#define BOOL_MAX_BITS 7
+
+#if SIZE_MAX == 0xffffffffffffffffULL
+// A refill leaves at least BD_VALUE_SIZE - 15 bits in a 64-bit window, enough
+// for the EOB, ZERO and ONE nodes, the pareto tree of a TWO..FOUR token and
+// the sign (7 bools) to be decoded without checking the window in between.
+#define TOKEN_WINDOW_BITS (6 * BOOL_MAX_BITS)
+#else
+// A 32-bit window cannot hold a whole token; check before every bool.
+#define TOKEN_WINDOW_BITS 0
+#endif
+
+static INLINE int read_bool_window(int prob, BD_VALUE *value, int *count,
+                                   unsigned int *range) {
   const unsigned int split = (*range * prob + (256 - prob)) >> CHAR_BIT;
   const BD_VALUE bigsplit = (BD_VALUE)split << (BD_VALUE_SIZE - CHAR_BIT);
 
-  if (*count < 0) {
-    r->value = *value;
-    r->count = *count;
-    vpx_reader_fill(r);
-    *value = r->value;
-    *count = r->count;
-  }
-
   if (*value >= bigsplit) {
     *range = *range - split;
     *value = *value - bigsplit;
@@ -63,6 +69,43 @@ static INLINE int read_bool(vpx_reader *r, int prob, BD_VALUE *value,
   return 0;
 }
 
+static INLINE void fill_window(vpx_reader *r, BD_VALUE *value, int *count) {
+  r->value = *value;
+  r->count = *count;
+  vpx_reader_fill(r);
+  *value = r->value;
+  *count = r->count;
+}
+
+static INLINE int read_bool(vpx_reader *r, int prob, BD_VALUE *value,
+                            int *count, unsigned int *range) {
+  if (*count < 0) fill_window(r, value, count);
+  return read_bool_window(prob, value, count, range);
+}
+
+// Makes sure the bools up to the sign of the next token can be read with
+// read_token_bool().
+static INLINE void fill_token_window(vpx_reader *r, BD_VALUE *value,
+                                     int *count) {
+#if TOKEN_WINDOW_BITS
+  if (*count < TOKEN_WINDOW_BITS) fill_window(r, value, count);
+#else
+  (void)r;
+  (void)value;
+  (void)count;
+#endif
+}
+
+static INLINE int read_token_bool(vpx_reader *r, int prob, BD_VALUE *value,
+                                  int *count, unsigned int *range) {
+#if TOKEN_WINDOW_BITS
+  (void)r;
+  return read_bool_window(prob, value, count, range);
+#else
+  return read_bool(r, prob, value, count, range);
+#endif
+}
+
 static INLINE int read_coeff(vpx_reader *r, const vpx_prob *probs, int n,
                              BD_VALUE *value, int *count, unsigned int *range) {
   int i, val = 0;
@@ -71,6 +114,20 @@ static INLINE int read_coeff(vpx_reader *r, const vpx_prob *probs, int n,
   return val;
 }
 
+typedef struct {
+  int min_val;
+  const vpx_prob *probs;
+  int bits;
+} TokenCategory;
+
+// Extra bits of the CAT1..CAT5 tokens, indexed by category - 1. CAT6 depends
+// on the bit depth.
+static const TokenCategory token_cats[5] = {
+  { CAT1_MIN_VAL, vp9_cat1_prob, 1 }, { CAT2_MIN_VAL, vp9_cat2_prob, 2 },
+  { CAT3_MIN_VAL, vp9_cat3_prob, 3 }, { CAT4_MIN_VAL, vp9_cat4_prob, 4 },
+  { CAT5_MIN_VAL, vp9_cat5_prob, 5 },
+};
+
 static int decode_coefs(const MACROBLOCKD *xd, PLANE_TYPE type,
                         tran_low_t *dqcoeff, TX_SIZE tx_size, const int16_t *dq,
                         int ctx, const int16_t *scan, const int16_t *nb,
@@ -119,12 +176,14 @@ static int decode_coefs(const MACROBLOCKD *xd, PLANE_TYPE type,
     band = *band_translate++;
     prob = coef_probs[band][ctx];
     if (counts) ++eob_branch_count[band][ctx];
-    if (!read_bool(r, prob[EOB_CONTEXT_NODE], &value, &count, &range)) {
+    fill_token_window(r, &value, &count);
+    if (!read_token_bool(r, prob[EOB_CONTEXT_NODE], &value, &count, &range)) {
       INCREMENT_COUNT(EOB_MODEL_TOKEN);
       break;
     }
 
-    while (!read_bool(r, prob[ZERO_CONTEXT_NODE], &value, &count, &range)) {
+    while (!read_token_bool(r, prob[ZERO_CONTEXT_NODE], &value, &count,
+                            &range)) {
       INCREMENT_COUNT(ZERO_TOKEN);
       dqv = dq[1];
       token_cache[scan[c]] = 0;
@@ -138,39 +197,35 @@ static int decode_coefs(const MACROBLOCKD *xd, PLANE_TYPE type,
       ctx = get_coef_context(nb, token_cache, c);
       band = *band_translate++;
       prob = coef_probs[band][ctx];
+      fill_token_window(r, &value, &count);
     }
 
-    if (read_bool(r, prob[ONE_CONTEXT_NODE], &value, &count, &range)) {
+    if (read_token_bool(r, prob[ONE_CONTEXT_NODE], &value, &count, &range)) {
       const vpx_prob *p = vp9_pareto8_full[prob[PIVOT_NODE] - 1];
       INCREMENT_COUNT(TWO_TOKEN);
-      if (read_bool(r, p[0], &value, &count, &range)) {
-        if (read_bool(r, p[3], &value, &count, &range)) {
+      if (read_token_bool(r, p[0], &value, &count, &range)) {
+        // Walk the category tree, then read the extra bits of the category
+        // with a checked read as they may not fit in the window.
+        int cat;
+        if (read_token_bool(r, p[3], &value, &count, &range)) {
           token_cache[scan[c]] = 5;
-          if (read_bool(r, p[5], &value, &count, &range)) {
-            if (read_bool(r, p[7], &value, &count, &range)) {
-              val = CAT6_MIN_VAL +
-                    read_coeff(r, cat6_prob, cat6_bits, &value, &count, &range);
-            } else {
-              val = CAT5_MIN_VAL +
-                    read_coeff(r, vp9_cat5_prob, 5, &value, &count, &range);
-            }
-          } else if (read_bool(r, p[6], &value, &count, &range)) {
-            val = CAT4_MIN_VAL +
-                  read_coeff(r, vp9_cat4_prob, 4, &value, &count, &range);
-          } else {
-            val = CAT3_MIN_VAL +
-                  read_coeff(r, vp9_cat3_prob, 3, &value, &count, &range);
-          }
+          if (read_token_bool(r, p[5], &value, &count, &range))
+            cat = read_token_bool(r, p[7], &value, &count, &range) ? 6 : 5;
+          else
+            cat = read_token_bool(r, p[6], &value, &count, &range) ? 4 : 3;
         } else {
           token_cache[scan[c]] = 4;
-          if (read_bool(r, p[4], &value, &count, &range)) {
-            val = CAT2_MIN_VAL +
-                  read_coeff(r, vp9_cat2_prob, 2, &value, &count, &range);
-          } else {
-            val = CAT1_MIN_VAL +
-                  read_coeff(r, vp9_cat1_prob, 1, &value, &count, &range);
-          }
+          cat = read_token_bool(r, p[4], &value, &count, &range) ? 2 : 1;
         }
+        if (cat == 6) {
+          val = CAT6_MIN_VAL +
+                read_coeff(r, cat6_prob, cat6_bits, &value, &count, &range);
+        } else {
+          const TokenCategory *const tc = &token_cats[cat - 1];
+          val = tc->min_val +
+                read_coeff(r, tc->probs, tc->bits, &value, &count, &range);
+        }
+        fill_token_window(r, &value, &count);
 #if CONFIG_VP9_HIGHBITDEPTH
         // val may use 18-bits
         v = (int)(((int64_t)val * dqv) >> dq_shift);
@@ -178,9 +233,9 @@ static int decode_coefs(const MACROBLOCKD *xd, PLANE_TYPE type,
         v = (val * dqv) >> dq_shift;
 #endif
       } else {
-        if (read_bool(r, p[1], &value, &count, &range)) {
+        if (read_token_bool(r, p[1], &value, &count, &range)) {
           token_cache[scan[c]] = 3;
-          v = ((3 + read_bool(r, p[2], &value, &count, &range)) * dqv) >>
+          v = ((3 + read_token_bool(r, p[2], &value, &count, &range)) * dqv) >>
               dq_shift;
         } else {
           token_cache[scan[c]] = 2;
@@ -195,13 +250,13 @@ static int decode_coefs(const MACROBLOCKD *xd, PLANE_TYPE type,
 #if CONFIG_COEFFICIENT_RANGE_CHECKING
 #if CONFIG_VP9_HIGHBITDEPTH
     dqcoeff[scan[c]] = highbd_check_range(
-        read_bool(r, 128, &value, &count, &range) ? -v : v, xd->bd);
+        read_token_bool(r, 128, &value, &count, &range) ? -v : v, xd->bd);
 #else
     dqcoeff[scan[c]] =
-        check_range(read_bool(r, 128, &value, &count, &range) ? -v : v);
+        check_range(read_token_bool(r, 128, &value, &count, &range) ? -v : v);
 #endif  // CONFIG_VP9_HIGHBITDEPTH
 #else
-    if (read_bool(r, 128, &value, &count, &range)) {
+    if (read_token_bool(r, 128, &value, &count, &range)) {
       dqcoeff[scan[c]] = -v;
     } else {
       dqcoeff[scan[c]] = v;
@@ -288,5 +343,8 @@ int vp9_decode_block_tokens(TileWorkerData *twd, int plane,
       break;
   }
 
+#if CONFIG_STAGE_TIMING
+  twd->coeff_count += eob;
+#endif
   return eob;
 }
@@ -188,3 +188,96 @@ void vp9_frameworker_copy_context(VPxWorker *const dst_worker,
   (void)src_worker;
 #endif  // CONFIG_MULTITHREAD
 }
+
+void vp9_recon_sync_alloc(VP9ReconSync *recon_sync, VP9_COMMON *cm, int rows,
+                          int cols, int slot_rows, int sb_coeffs) {
+  int i;
+
+  recon_sync->rows = rows;
+  recon_sync->cols = cols;
+  recon_sync->slot_rows = slot_rows;
+  recon_sync->sb_coeffs = sb_coeffs;
+#if CONFIG_MULTITHREAD
+  pthread_mutex_init(&recon_sync->job_mutex_, NULL);
+  pthread_cond_init(&recon_sync->job_cond_, NULL);
+
+  CHECK_MEM_ERROR(cm, recon_sync->mutex_,
+                  vpx_malloc(sizeof(*recon_sync->mutex_) * rows));
+  if (recon_sync->mutex_) {
+    for (i = 0; i < rows; ++i) {
+      pthread_mutex_init(&recon_sync->mutex_[i], NULL);
+    }
+  }
+
+  CHECK_MEM_ERROR(cm, recon_sync->parse_cond_,
+                  vpx_malloc(sizeof(*recon_sync->parse_cond_) * rows));
+  if (recon_sync->parse_cond_) {
+    for (i = 0; i < rows; ++i) {
+      pthread_cond_init(&recon_sync->parse_cond_[i], NULL);
+    }
+  }
+
+  CHECK_MEM_ERROR(cm, recon_sync->recon_cond_,
+                  vpx_malloc(sizeof(*recon_sync->recon_cond_) * rows));
+  if (recon_sync->recon_cond_) {
+    for (i = 0; i < rows; ++i) {
+      pthread_cond_init(&recon_sync->recon_cond_[i], NULL);
+    }
+  }
+#endif  // CONFIG_MULTITHREAD
+
+  CHECK_MEM_ERROR(cm, recon_sync->parsed_sb_cols,
+                  vpx_calloc(rows, sizeof(*recon_sync->parsed_sb_cols)));
+  CHECK_MEM_ERROR(cm, recon_sync->recon_sb_cols,
+                  vpx_calloc(rows, sizeof(*recon_sync->recon_sb_cols)));
+
+  CHECK_MEM_ERROR(
+      cm, recon_sync->sbs,
+      vpx_memalign(32, slot_rows * cols * sizeof(*recon_sync->sbs)));
+  // The coefficient ring must start out zeroed, see ParsedSuperblock.
+  CHECK_MEM_ERROR(cm, recon_sync->dqcoeff,
+                  vpx_memalign(32, slot_rows * cols * sb_coeffs *
+                                       sizeof(*recon_sync->dqcoeff)));
+  memset(recon_sync->dqcoeff, 0,
+         slot_rows * cols * sb_coeffs * sizeof(*recon_sync->dqcoeff));
+  for (i = 0; i < slot_rows * cols; ++i)
+    recon_sync->sbs[i].dqcoeff = recon_sync->dqcoeff + i * sb_coeffs;
+}
+
+void vp9_recon_sync_dealloc(VP9ReconSync *recon_sync) {
+  if (recon_sync != NULL) {
+#if CONFIG_MULTITHREAD
+    int i;
+
+    if (recon_sync->mutex_ != NULL) {
+      for (i = 0; i < recon_sync->rows; ++i) {
+        pthread_mutex_destroy(&recon_sync->mutex_[i]);
+      }
+      vpx_free(recon_sync->mutex_);
+    }
+    if (recon_sync->parse_cond_ != NULL) {
+      for (i = 0; i < recon_sync->rows; ++i) {
+        pthread_cond_destroy(&recon_sync->parse_cond_[i]);
+      }
+      vpx_free(recon_sync->parse_cond_);
+    }
+    if (recon_sync->recon_cond_ != NULL) {
+      for (i = 0; i < recon_sync->rows; ++i) {
+        pthread_cond_destroy(&recon_sync->recon_cond_[i]);
+      }
+      vpx_free(recon_sync->recon_cond_);
+    }
+    if (recon_sync->rows > 0) {
+      pthread_mutex_destroy(&recon_sync->job_mutex_);
+      pthread_cond_destroy(&recon_sync->job_cond_);
+    }
+#endif  // CONFIG_MULTITHREAD
+    vpx_free(recon_sync->parsed_sb_cols);
+    vpx_free(recon_sync->recon_sb_cols);
+    vpx_free(recon_sync->sbs);
+    vpx_free(recon_sync->dqcoeff);
+    // Clear the structure as the source of this call may be a resize in which
+    // case this call will be followed by an _alloc() which may fail.
+    vp9_zero(*recon_sync);
+  }
+}
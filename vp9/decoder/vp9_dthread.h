@@ -14,6 +14,8 @@
 #include "./vpx_config.h"
 #include "vpx_util/vpx_thread.h"
 #include "vpx/internal/vpx_codec_internal.h"
+#include "vp9/common/vp9_blockd.h"
+#include "vp9/common/vp9_tile_common.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -48,6 +50,71 @@ typedef struct FrameWorkerData {
   int frame_decoded;        // Finished decoding current frame.
 } FrameWorkerData;
 
+// A coding block recorded by the parse stage of the parse/reconstruction
+// pipeline. Sub8x8 partitions are stored as a single 8x8 block.
+typedef struct ParsedBlock {
+  int mi_row;
+  int mi_col;
+  int bwl, bhl;
+} ParsedBlock;
+
+// Output of the parse stage for one superblock: the coding blocks in decode
+// order, the eob of every transform block of the non-skipped blocks and the
+// dequantized coefficients of the transform blocks with a non-zero eob,
+// packed back to back. The reconstruction stage clears the coefficients as it
+// consumes them so the buffer is all zero again when the slot is reused.
+typedef struct ParsedSuperblock {
+  TileInfo tile;
+  int num_blocks;
+  ParsedBlock blocks[64];
+  int num_eobs;
+  uint16_t eobs[256 * MAX_MB_PLANE];
+  int num_coeffs;
+  tran_low_t *dqcoeff;
+} ParsedSuperblock;
+
+// Parse/reconstruction pipeline synchronization. The calling thread parses
+// superblocks in raster order into a ring of 'slot_rows' superblock rows and
+// the reconstruction workers each take a whole superblock row, running as a
+// wavefront behind the row above. Every condition variable has a single
+// waiter so no broadcast is required.
+typedef struct VP9ReconSync {
+#if CONFIG_MULTITHREAD
+  pthread_mutex_t *mutex_;
+  pthread_cond_t *parse_cond_;  // Waited on by the worker of the row.
+  pthread_cond_t *recon_cond_;  // Waited on by the worker of the row below.
+  pthread_mutex_t job_mutex_;
+  pthread_cond_t job_cond_;  // Waited on by the parse thread.
+#endif
+  // Number of parsed and reconstructed superblocks in each row.
+  int *parsed_sb_cols;
+  int *recon_sb_cols;
+  int rows;
+  int cols;
+
+  ParsedSuperblock *sbs;
+  tran_low_t *dqcoeff;
+  int sb_coeffs;  // Coefficient capacity of a superblock slot.
+  int slot_rows;
+
+  int next_row;   // Next superblock row to hand to a worker.
+  int rows_done;  // Number of fully reconstructed superblock rows.
+  int abort;
+
+  // Errors raised by the parse stage, which must stop the workers before
+  // being forwarded to the frame's error handler.
+  struct vpx_internal_error_info error_info;
+} VP9ReconSync;
+
+// Allocate the parse/reconstruction synchronization data for a frame of
+// 'rows' x 'cols' superblocks, with a ring of 'slot_rows' superblock rows
+// holding up to 'sb_coeffs' coefficients per superblock.
+void vp9_recon_sync_alloc(VP9ReconSync *recon_sync, struct VP9Common *cm,
+                          int rows, int cols, int slot_rows, int sb_coeffs);
+
+// Deallocate the parse/reconstruction synchronization mutexes and data.
+void vp9_recon_sync_dealloc(VP9ReconSync *recon_sync);
+
 void vp9_frameworker_lock_stats(VPxWorker *const worker);
 void vp9_frameworker_unlock_stats(VPxWorker *const worker);
 void vp9_frameworker_signal_stats(VPxWorker *const worker);
@@ -123,9 +123,14 @@ static void update_switchable_interp_probs(VP9_COMMON *cm, vpx_writer *w,
                      counts->switchable_interp[j], SWITCHABLE_FILTERS, w);
 }
 
-static void pack_mb_tokens(vpx_writer *w, TOKENEXTRA **tp,
+static void pack_mb_tokens(vpx_writer *bc, TOKENEXTRA **tp,
                            const TOKENEXTRA *const stop,
+                           const vpx_prob *const coef_probs,
                            vpx_bit_depth_t bit_depth) {
+  // Write through a local copy of the writer so its state can be kept in
+  // registers rather than reloaded around every byte stored to the buffer.
+  vpx_writer writer = *bc;
+  vpx_writer *const w = &writer;
   const TOKENEXTRA *p;
   const vp9_extra_bit *const extra_bits =
 #if CONFIG_VP9_HIGHBITDEPTH
@@ -139,22 +144,24 @@ static void pack_mb_tokens(vpx_writer *w, TOKENEXTRA **tp,
 
   for (p = *tp; p < stop && p->token != EOSB_TOKEN; ++p) {
     if (p->token == EOB_TOKEN) {
-      vpx_write(w, 0, p->context_tree[0]);
+      vpx_write(w, 0, coef_probs[p->context * UNCONSTRAINED_NODES]);
       continue;
     }
-    vpx_write(w, 1, p->context_tree[0]);
+    vpx_write(w, 1, coef_probs[p->context * UNCONSTRAINED_NODES]);
     while (p->token == ZERO_TOKEN) {
-      vpx_write(w, 0, p->context_tree[1]);
+      vpx_write(w, 0, coef_probs[p->context * UNCONSTRAINED_NODES + 1]);
       ++p;
       if (p == stop || p->token == EOSB_TOKEN) {
         *tp = (TOKENEXTRA *)(uintptr_t)p + (p->token == EOSB_TOKEN);
+        *bc = writer;
         return;
       }
     }
 
     {
       const int t = p->token;
-      const vpx_prob *const context_tree = p->context_tree;
+      const vpx_prob *const context_tree =
+          coef_probs + p->context * UNCONSTRAINED_NODES;
       assert(t != ZERO_TOKEN);
       assert(t != EOB_TOKEN);
       assert(t != EOSB_TOKEN);
@@ -186,6 +193,7 @@ static void pack_mb_tokens(vpx_writer *w, TOKENEXTRA **tp,
     }
   }
   *tp = (TOKENEXTRA *)(uintptr_t)p + (p->token == EOSB_TOKEN);
+  *bc = writer;
 }
 
 static void write_segment_id(vpx_writer *w, const struct segmentation *seg,
@@ -391,7 +399,8 @@ static void write_modes_b(
   }
 
   assert(*tok < tok_end);
-  pack_mb_tokens(w, tok, tok_end, cm->bit_depth);
+  pack_mb_tokens(w, tok, tok_end, cm->fc->coef_probs[0][0][0][0][0],
+                 cm->bit_depth);
 }
 
 static void write_partition(const VP9_COMMON *const cm,
@@ -508,11 +517,11 @@ static void write_modes(
   }
 }
 
-static void build_tree_distribution(VP9_COMP *cpi, TX_SIZE tx_size,
+static void build_tree_distribution(const VP9_COMP *cpi, TX_SIZE tx_size,
                                     vp9_coeff_stats *coef_branch_ct,
                                     vp9_coeff_probs_model *coef_probs) {
-  vp9_coeff_count *coef_counts = cpi->td.rd_counts.coef_counts[tx_size];
-  unsigned int(*eob_branch_ct)[REF_TYPES][COEF_BANDS][COEFF_CONTEXTS] =
+  const vp9_coeff_count *coef_counts = cpi->td.rd_counts.coef_counts[tx_size];
+  const unsigned int(*eob_branch_ct)[REF_TYPES][COEF_BANDS][COEFF_CONTEXTS] =
       cpi->common.counts.eob_branch[tx_size];
   int i, j, k, l, m;
 
@@ -535,159 +544,184 @@ static void build_tree_distribution(VP9_COMP *cpi, TX_SIZE tx_size,
   }
 }
 
-static void update_coef_probs_common(vpx_writer *const bc, VP9_COMP *cpi,
-                                     TX_SIZE tx_size,
-                                     vp9_coeff_stats *frame_branch_ct,
-                                     vp9_coeff_probs_model *new_coef_probs) {
-  vp9_coeff_probs_model *old_coef_probs = cpi->common.fc->coef_probs[tx_size];
+// Coefficient probability updates chosen for one transform size.
+typedef struct CoefUpdateSearch {
+  // The probability each node is updated to, or 0 to keep the old one.
+  vp9_coeff_probs_model new_probs[PLANE_TYPES];
+  // Net savings of the updates, including the cost of the update flags.
+  int savings;
+  int num_updates;
+  // Set when there are too few counts to search: no update is sent.
+  int skip;
+} CoefUpdateSearch;
+
+// Searches the best update of every coefficient probability of tx_size. It
+// only reads the encoder state, so the transform sizes can be searched in
+// parallel.
+static void search_coef_updates(const VP9_COMP *cpi, TX_SIZE tx_size,
+                                CoefUpdateSearch *search) {
+  const vp9_coeff_probs_model *old_coef_probs =
+      cpi->common.fc->coef_probs[tx_size];
   const vpx_prob upd = DIFF_UPDATE_PROB;
-  const int entropy_nodes_update = UNCONSTRAINED_NODES;
+  const int stepsize = cpi->sf.coeff_prob_appx_step;
+  vp9_coeff_stats frame_branch_ct[PLANE_TYPES];
   int i, j, k, l, t;
-  int stepsize = cpi->sf.coeff_prob_appx_step;
 
-  switch (cpi->sf.use_fast_coef_updates) {
-    case TWO_LOOP: {
-      /* dry run to see if there is any update at all needed */
-      int savings = 0;
-      int update[2] = { 0, 0 };
-      for (i = 0; i < PLANE_TYPES; ++i) {
-        for (j = 0; j < REF_TYPES; ++j) {
-          for (k = 0; k < COEF_BANDS; ++k) {
-            for (l = 0; l < BAND_COEFF_CONTEXTS(k); ++l) {
-              for (t = 0; t < entropy_nodes_update; ++t) {
-                vpx_prob newp = new_coef_probs[i][j][k][l][t];
-                const vpx_prob oldp = old_coef_probs[i][j][k][l][t];
-                int s;
-                int u = 0;
-                if (t == PIVOT_NODE)
-                  s = vp9_prob_diff_update_savings_search_model(
-                      frame_branch_ct[i][j][k][l][0], oldp, &newp, upd,
-                      stepsize);
-                else
-                  s = vp9_prob_diff_update_savings_search(
-                      frame_branch_ct[i][j][k][l][t], oldp, &newp, upd);
-                if (s > 0 && newp != oldp) u = 1;
-                if (u)
-                  savings += s - (int)(vp9_cost_zero(upd));
-                else
-                  savings -= (int)(vp9_cost_zero(upd));
-                update[u]++;
-              }
+  build_tree_distribution(cpi, tx_size, frame_branch_ct,
+                          search->new_probs);
+  search->savings = 0;
+  search->num_updates = 0;
+  for (i = 0; i < PLANE_TYPES; ++i) {
+    for (j = 0; j < REF_TYPES; ++j) {
+      for (k = 0; k < COEF_BANDS; ++k) {
+        for (l = 0; l < BAND_COEFF_CONTEXTS(k); ++l) {
+          for (t = 0; t < UNCONSTRAINED_NODES; ++t) {
+            vpx_prob *const newp = &search->new_probs[i][j][k][l][t];
+            const vpx_prob oldp = old_coef_probs[i][j][k][l][t];
+            int s;
+            if (t == PIVOT_NODE)
+              s = vp9_prob_diff_update_savings_search_model(
+                  frame_branch_ct[i][j][k][l][0], oldp, newp, upd, stepsize);
+            else
+              s = vp9_prob_diff_update_savings_search(
+                  frame_branch_ct[i][j][k][l][t], oldp, newp, upd);
+            if (s > 0 && *newp != oldp) {
+              search->savings += s - (int)(vp9_cost_zero(upd));
+              ++search->num_updates;
+            } else {
+              search->savings -= (int)(vp9_cost_zero(upd));
+              *newp = 0;
             }
           }
         }
       }
+    }
+  }
+}
+
+static void update_coef_probs_common(vpx_writer *const bc, VP9_COMP *cpi,
+                                     TX_SIZE tx_size,
+                                     const CoefUpdateSearch *search) {
+  vp9_coeff_probs_model *old_coef_probs = cpi->common.fc->coef_probs[tx_size];
+  const vpx_prob upd = DIFF_UPDATE_PROB;
+  int i, j, k, l, t;
 
-      // printf("Update %d %d, savings %d\n", update[0], update[1], savings);
-      /* Is coef updated at all */
-      if (update[1] == 0 || savings < 0) {
+  // Both strategies make the same per-node decisions. ONE_LOOP_REDUCED
+  // sends them as soon as there is any update, TWO_LOOP only when the
+  // updates pay for all the update flags.
+  switch (cpi->sf.use_fast_coef_updates) {
+    case TWO_LOOP:
+      if (search->num_updates == 0 || search->savings < 0) {
         vpx_write_bit(bc, 0);
         return;
       }
-      vpx_write_bit(bc, 1);
-      for (i = 0; i < PLANE_TYPES; ++i) {
-        for (j = 0; j < REF_TYPES; ++j) {
-          for (k = 0; k < COEF_BANDS; ++k) {
-            for (l = 0; l < BAND_COEFF_CONTEXTS(k); ++l) {
-              // calc probs and branch cts for this frame only
-              for (t = 0; t < entropy_nodes_update; ++t) {
-                vpx_prob newp = new_coef_probs[i][j][k][l][t];
-                vpx_prob *oldp = old_coef_probs[i][j][k][l] + t;
-                const vpx_prob upd = DIFF_UPDATE_PROB;
-                int s;
-                int u = 0;
-                if (t == PIVOT_NODE)
-                  s = vp9_prob_diff_update_savings_search_model(
-                      frame_branch_ct[i][j][k][l][0], *oldp, &newp, upd,
-                      stepsize);
-                else
-                  s = vp9_prob_diff_update_savings_search(
-                      frame_branch_ct[i][j][k][l][t], *oldp, &newp, upd);
-                if (s > 0 && newp != *oldp) u = 1;
-                vpx_write(bc, u, upd);
-                if (u) {
-                  /* send/use new probability */
-                  vp9_write_prob_diff_update(bc, newp, *oldp);
-                  *oldp = newp;
-                }
-              }
-            }
-          }
-        }
+      break;
+    case ONE_LOOP_REDUCED:
+      if (search->num_updates == 0) {
+        vpx_write_bit(bc, 0);
+        return;
       }
-      return;
-    }
+      break;
+    default: assert(0);
+  }
 
-    case ONE_LOOP_REDUCED: {
-      int updates = 0;
-      int noupdates_before_first = 0;
-      for (i = 0; i < PLANE_TYPES; ++i) {
-        for (j = 0; j < REF_TYPES; ++j) {
-          for (k = 0; k < COEF_BANDS; ++k) {
-            for (l = 0; l < BAND_COEFF_CONTEXTS(k); ++l) {
-              // calc probs and branch cts for this frame only
-              for (t = 0; t < entropy_nodes_update; ++t) {
-                vpx_prob newp = new_coef_probs[i][j][k][l][t];
-                vpx_prob *oldp = old_coef_probs[i][j][k][l] + t;
-                int s;
-                int u = 0;
-
-                if (t == PIVOT_NODE) {
-                  s = vp9_prob_diff_update_savings_search_model(
-                      frame_branch_ct[i][j][k][l][0], *oldp, &newp, upd,
-                      stepsize);
-                } else {
-                  s = vp9_prob_diff_update_savings_search(
-                      frame_branch_ct[i][j][k][l][t], *oldp, &newp, upd);
-                }
-
-                if (s > 0 && newp != *oldp) u = 1;
-                updates += u;
-                if (u == 0 && updates == 0) {
-                  noupdates_before_first++;
-                  continue;
-                }
-                if (u == 1 && updates == 1) {
-                  int v;
-                  // first update
-                  vpx_write_bit(bc, 1);
-                  for (v = 0; v < noupdates_before_first; ++v)
-                    vpx_write(bc, 0, upd);
-                }
-                vpx_write(bc, u, upd);
-                if (u) {
-                  /* send/use new probability */
-                  vp9_write_prob_diff_update(bc, newp, *oldp);
-                  *oldp = newp;
-                }
-              }
+  vpx_write_bit(bc, 1);
+  for (i = 0; i < PLANE_TYPES; ++i) {
+    for (j = 0; j < REF_TYPES; ++j) {
+      for (k = 0; k < COEF_BANDS; ++k) {
+        for (l = 0; l < BAND_COEFF_CONTEXTS(k); ++l) {
+          for (t = 0; t < UNCONSTRAINED_NODES; ++t) {
+            const vpx_prob newp = search->new_probs[i][j][k][l][t];
+            vpx_prob *oldp = old_coef_probs[i][j][k][l] + t;
+            vpx_write(bc, newp != 0, upd);
+            if (newp != 0) {
+              /* send/use new probability */
+              vp9_write_prob_diff_update(bc, newp, *oldp);
+              *oldp = newp;
             }
           }
         }
       }
-      if (updates == 0) {
-        vpx_write_bit(bc, 0);  // no updates
-      }
-      return;
     }
-    default: assert(0);
+  }
+}
+
+typedef struct CoefUpdateWorkerData {
+  const VP9_COMP *cpi;
+  CoefUpdateSearch *searches;
+  int first_tx_size;
+  int tx_size_step;
+  int num_tx_sizes;
+} CoefUpdateWorkerData;
+
+static int coef_update_worker(CoefUpdateWorkerData *data, void *unused) {
+  int tx_size;
+  (void)unused;
+
+  for (tx_size = data->first_tx_size; tx_size < data->num_tx_sizes;
+       tx_size += data->tx_size_step)
+    if (!data->searches[tx_size].skip)
+      search_coef_updates(data->cpi, tx_size, &data->searches[tx_size]);
+  return 1;
+}
+
+static void search_coef_updates_mt(VP9_COMP *cpi, CoefUpdateSearch *searches,
+                                   int num_tx_sizes) {
+  const VPxWorkerInterface *const winterface = vpx_get_worker_interface();
+  const int num_workers = VPXMIN(cpi->num_workers, num_tx_sizes);
+  CoefUpdateWorkerData data[TX_SIZES];
+  int i;
+
+  for (i = 0; i < num_workers; ++i) {
+    VPxWorker *const worker = &cpi->workers[i];
+
+    data[i].cpi = cpi;
+    data[i].searches = searches;
+    data[i].first_tx_size = i;
+    data[i].tx_size_step = num_workers;
+    data[i].num_tx_sizes = num_tx_sizes;
+    worker->hook = (VPxWorkerHook)coef_update_worker;
+    worker->data1 = &data[i];
+    worker->data2 = NULL;
+
+    if (i == num_workers - 1) {
+      winterface->execute(worker);
+    } else {
+      winterface->launch(worker);
+    }
+  }
+
+  for (i = 0; i < num_workers; ++i) {
+    winterface->sync(&cpi->workers[i]);
   }
 }
 
 static void update_coef_probs(VP9_COMP *cpi, vpx_writer *w) {
   const TX_MODE tx_mode = cpi->common.tx_mode;
   const TX_SIZE max_tx_size = tx_mode_to_biggest_tx_size[tx_mode];
-  TX_SIZE tx_size;
+  const int num_tx_sizes = max_tx_size + 1;
+  CoefUpdateSearch searches[TX_SIZES];
+  int tx_size;
+
+  for (tx_size = TX_4X4; tx_size <= max_tx_size; ++tx_size) {
+    searches[tx_size].skip =
+        cpi->td.counts->tx.tx_totals[tx_size] <= 20 ||
+        (tx_size >= TX_16X16 && cpi->sf.tx_size_search_method == USE_TX_8X8);
+  }
+
+  if (cpi->num_workers > 1) {
+    search_coef_updates_mt(cpi, searches, num_tx_sizes);
+  } else {
+    for (tx_size = TX_4X4; tx_size <= max_tx_size; ++tx_size)
+      if (!searches[tx_size].skip)
+        search_coef_updates(cpi, tx_size, &searches[tx_size]);
+  }
+
   for (tx_size = TX_4X4; tx_size <= max_tx_size; ++tx_size) {
-    vp9_coeff_stats frame_branch_ct[PLANE_TYPES];
-    vp9_coeff_probs_model frame_coef_probs[PLANE_TYPES];
-    if (cpi->td.counts->tx.tx_totals[tx_size] <= 20 ||
-        (tx_size >= TX_16X16 && cpi->sf.tx_size_search_method == USE_TX_8X8)) {
+    if (searches[tx_size].skip) {
       vpx_write_bit(w, 0);
     } else {
-      build_tree_distribution(cpi, tx_size, frame_branch_ct, frame_coef_probs);
-      update_coef_probs_common(w, cpi, tx_size, frame_branch_ct,
-                               frame_coef_probs);
+      update_coef_probs_common(w, cpi, tx_size, &searches[tx_size]);
     }
   }
 }
@@ -1337,7 +1371,9 @@ void vp9_pack_bitstream(VP9_COMP *cpi, uint8_t *dest, size_t *size) {
   size_t first_part_size, uncompressed_hdr_size;
   struct vpx_write_bit_buffer wb = { data, 0 };
   struct vpx_write_bit_buffer saved_wb;
+  struct vpx_usec_timer timer;
 
+  vp9_stage_timer_start(&timer);
   write_uncompressed_header(cpi, &wb);
   saved_wb = wb;
   vpx_wb_write_literal(&wb, 0, 16);  // don't know in advance first part. size
@@ -1355,4 +1391,5 @@ void vp9_pack_bitstream(VP9_COMP *cpi, uint8_t *dest, size_t *size) {
   data += encode_tiles(cpi, data);
 
   *size = data - dest;
+  vp9_stage_timer_end(cpi, &timer, VPX_ENC_STAGE_PACK_BITSTREAM);
 }
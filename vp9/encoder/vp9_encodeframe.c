@@ -3354,6 +3354,12 @@ static void encode_rd_sb_row(VP9_COMP *cpi, ThreadData *td,
     (*(cpi->row_mt_sync_read_ptr))(&tile_data->row_mt_sync, sb_row,
                                    sb_col_in_tile);
 
+    if (!frame_is_intra_only(cm))
+      vp9_setup_mv_ref_cache(cm, xd, tile_info, &td->mv_ref_cache, mi_row,
+                             mi_col);
+    else
+      xd->mv_ref_cache = NULL;
+
     if (sf->adaptive_pred_interp_filter) {
       for (i = 0; i < 64; ++i) td->leaf_tree[i].pred_interp_filter = SWITCHABLE;
 
@@ -4132,6 +4138,12 @@ static void encode_nonrd_sb_row(VP9_COMP *cpi, ThreadData *td,
     (*(cpi->row_mt_sync_read_ptr))(&tile_data->row_mt_sync, sb_row,
                                    sb_col_in_tile);
 
+    if (!frame_is_intra_only(cm))
+      vp9_setup_mv_ref_cache(cm, xd, tile_info, &td->mv_ref_cache, mi_row,
+                             mi_col);
+    else
+      xd->mv_ref_cache = NULL;
+
     x->source_variance = UINT_MAX;
     vp9_zero(x->pred_mv);
     vp9_rd_cost_init(&dummy_rdc);
@@ -4618,6 +4630,9 @@ static int compute_frame_aq_offset(struct VP9_COMP *cpi) {
 
 void vp9_encode_frame(VP9_COMP *cpi) {
   VP9_COMMON *const cm = &cpi->common;
+  struct vpx_usec_timer timer;
+
+  vp9_stage_timer_start(&timer);
 
   // In the longer term the encoder should be generalized to match the
   // decoder such that we allow compound where one of the 3 buffers has a
@@ -4742,6 +4757,8 @@ void vp9_encode_frame(VP9_COMP *cpi) {
       (cm->seg.update_map || cm->seg.update_data)) {
     cm->seg.aq_av_offset = compute_frame_aq_offset(cpi);
   }
+
+  vp9_stage_timer_end(cpi, &timer, VPX_ENC_STAGE_ENCODE_FRAME);
 }
 
 static void sum_intra_stats(FRAME_COUNTS *counts, const MODE_INFO *mi) {
@@ -59,6 +59,7 @@
 #include "vp9/encoder/vp9_segmentation.h"
 #include "vp9/encoder/vp9_skin_detection.h"
 #include "vp9/encoder/vp9_speed_features.h"
+#include "vp9/encoder/vp9_subexp.h"
 #include "vp9/encoder/vp9_svc_layercontext.h"
 #include "vp9/encoder/vp9_temporal_filter.h"
 
@@ -728,22 +729,6 @@ static void vp9_swap_mi_and_prev_mi(VP9_COMMON *cm) {
   cm->prev_mi_grid_visible = cm->prev_mi_grid_base + cm->mi_stride + 1;
 }
 
-void vp9_initialize_enc(void) {
-  static volatile int init_done = 0;
-
-  if (!init_done) {
-    vp9_rtcd();
-    vpx_dsp_rtcd();
-    vpx_scale_rtcd();
-    vp9_init_intra_predictors();
-    vp9_init_me_luts();
-    vp9_rc_init_minq_luts();
-    vp9_entropy_mv_init();
-    vp9_temporal_filter_init();
-    init_done = 1;
-  }
-}
-
 static void dealloc_compressor_data(VP9_COMP *cpi) {
   VP9_COMMON *const cm = &cpi->common;
   int i;
@@ -769,16 +754,6 @@ static void dealloc_compressor_data(VP9_COMP *cpi) {
   cpi->nmvcosts_hp[0] = NULL;
   cpi->nmvcosts_hp[1] = NULL;
 
-  vpx_free(cpi->nmvsadcosts[0]);
-  vpx_free(cpi->nmvsadcosts[1]);
-  cpi->nmvsadcosts[0] = NULL;
-  cpi->nmvsadcosts[1] = NULL;
-
-  vpx_free(cpi->nmvsadcosts_hp[0]);
-  vpx_free(cpi->nmvsadcosts_hp[1]);
-  cpi->nmvsadcosts_hp[0] = NULL;
-  cpi->nmvsadcosts_hp[1] = NULL;
-
   vpx_free(cpi->prev_partition);
   cpi->prev_partition = NULL;
 
@@ -829,11 +804,13 @@ static void dealloc_compressor_data(VP9_COMP *cpi) {
   vp9_free_pc_tree(&cpi->td);
 
   for (i = 0; i < cpi->svc.number_spatial_layers; ++i) {
-    LAYER_CONTEXT *const lc = &cpi->svc.layer_context[i];
-    vpx_free(lc->rc_twopass_stats_in.buf);
-    lc->rc_twopass_stats_in.buf = NULL;
-    lc->rc_twopass_stats_in.sz = 0;
+    TWO_PASS *const twopass = &cpi->svc.layer_context[i].twopass;
+    // cpi->twopass may be a copy of a layer's.
+    if (twopass->stats_window == cpi->twopass.stats_window)
+      cpi->twopass.stats_window = NULL;
+    vp9_twopass_free_stats_window(twopass);
   }
+  vp9_twopass_free_stats_window(&cpi->twopass);
 
   if (cpi->source_diff_var != NULL) {
     vpx_free(cpi->source_diff_var);
@@ -1061,12 +1038,17 @@ static void alloc_raw_frame_buffers(VP9_COMP *cpi) {
 #if CONFIG_VP9_HIGHBITDEPTH
                                         cm->use_highbitdepth,
 #endif
-                                        oxcf->lag_in_frames);
+                                        oxcf->lag_in_frames +
+                                            oxcf->lookahead_pass_frames);
   if (!cpi->lookahead)
     vpx_internal_error(&cm->error, VPX_CODEC_MEM_ERROR,
                        "Failed to allocate lag buffers");
 
+  // The low memory profile forbids lag, so there are no alt ref frames to
+  // filter.
   // TODO(agrange) Check if ARF is enabled and skip allocation if not.
+  if (oxcf->memory_profile == VP9E_MEMORY_PROFILE_LOW) return;
+
   if (vpx_realloc_frame_buffer(&cpi->alt_ref_buffer, oxcf->width, oxcf->height,
                                cm->subsampling_x, cm->subsampling_y,
 #if CONFIG_VP9_HIGHBITDEPTH
@@ -1080,26 +1062,19 @@ static void alloc_raw_frame_buffers(VP9_COMP *cpi) {
 
 static void alloc_util_frame_buffers(VP9_COMP *cpi) {
   VP9_COMMON *const cm = &cpi->common;
+  const int low_memory = cpi->oxcf.memory_profile == VP9E_MEMORY_PROFILE_LOW;
+  // Only the visible luma plane of last_frame_uf is saved and restored by the
+  // loop filter search, so it does not need a border.
   if (vpx_realloc_frame_buffer(&cpi->last_frame_uf, cm->width, cm->height,
                                cm->subsampling_x, cm->subsampling_y,
 #if CONFIG_VP9_HIGHBITDEPTH
                                cm->use_highbitdepth,
 #endif
-                               VP9_ENC_BORDER_IN_PIXELS, cm->byte_alignment,
-                               NULL, NULL, NULL))
+                               low_memory ? 0 : VP9_ENC_BORDER_IN_PIXELS,
+                               cm->byte_alignment, NULL, NULL, NULL))
     vpx_internal_error(&cm->error, VPX_CODEC_MEM_ERROR,
                        "Failed to allocate last frame buffer");
 
-  if (vpx_realloc_frame_buffer(&cpi->scaled_source, cm->width, cm->height,
-                               cm->subsampling_x, cm->subsampling_y,
-#if CONFIG_VP9_HIGHBITDEPTH
-                               cm->use_highbitdepth,
-#endif
-                               VP9_ENC_BORDER_IN_PIXELS, cm->byte_alignment,
-                               NULL, NULL, NULL))
-    vpx_internal_error(&cm->error, VPX_CODEC_MEM_ERROR,
-                       "Failed to allocate scaled source buffer");
-
   // For 1 pass cbr: allocate scaled_frame that may be used as an intermediate
   // buffer for a 2 stage down-sampling: two stages of 1:2 down-sampling for a
   // target of 1/4x1/4.
@@ -1116,6 +1091,22 @@ static void alloc_util_frame_buffers(VP9_COMP *cpi) {
                          "Failed to allocate scaled_frame for svc ");
   }
 
+  // The scaled sources are only written when the coded size differs from the
+  // input size, as with dynamic resize or spatial layers.
+  if (low_memory && cm->width == cpi->oxcf.width &&
+      cm->height == cpi->oxcf.height)
+    return;
+
+  if (vpx_realloc_frame_buffer(&cpi->scaled_source, cm->width, cm->height,
+                               cm->subsampling_x, cm->subsampling_y,
+#if CONFIG_VP9_HIGHBITDEPTH
+                               cm->use_highbitdepth,
+#endif
+                               VP9_ENC_BORDER_IN_PIXELS, cm->byte_alignment,
+                               NULL, NULL, NULL))
+    vpx_internal_error(&cm->error, VPX_CODEC_MEM_ERROR,
+                       "Failed to allocate scaled source buffer");
+
   if (vpx_realloc_frame_buffer(&cpi->scaled_last_source, cm->width, cm->height,
                                cm->subsampling_x, cm->subsampling_y,
 #if CONFIG_VP9_HIGHBITDEPTH
@@ -1169,9 +1160,13 @@ static void alloc_compressor_data(VP9_COMP *cpi) {
   vpx_free(cpi->tile_tok[0][0]);
 
   {
+    // The buffer is sized for the worst case but tokens are always written
+    // before they are read, so it is not cleared and untouched pages stay
+    // unmapped.
     unsigned int tokens = get_token_alloc(cm->mb_rows, cm->mb_cols);
     CHECK_MEM_ERROR(cm, cpi->tile_tok[0][0],
-                    vpx_calloc(tokens, sizeof(*cpi->tile_tok[0][0])));
+                    vpx_malloc(tokens * sizeof(*cpi->tile_tok[0][0])));
+    cpi->tile_tok_alloc = tokens;
   }
 
   sb_rows = mi_cols_aligned_to_sb(cm->mi_rows) >> MI_BLOCK_SIZE_LOG2;
@@ -1950,7 +1945,7 @@ void vp9_change_config(struct VP9_COMP *cpi, const VP9EncoderConfig *oxcf) {
  *   - mvjointsadcost[1] == mvjointsadcost[2] == mvjointsadcost[3]     *
  * For cal_nmvsadcosts:                                                *
  *   - For all i: mvsadcost[0][i] == mvsadcost[1][i]                   *
- *         (Equal costs for both components)                           *
+ *         (Equal costs for both components, which share one table)    *
  *   - For all i: mvsadcost[0][i] == mvsadcost[0][-i]                  *
  *         (Cost function is even)                                     *
  * If these do not hold, then the AVX optimised version of the         *
@@ -1968,37 +1963,48 @@ static void cal_nmvjointsadcost(int *mvjointsadcost) {
   mvjointsadcost[3] = 300;
 }
 
-static void cal_nmvsadcosts(int *mvsadcost[2]) {
+static void cal_nmvsadcosts(int *mvsadcost) {
   /*********************************************************************
    * Warning: Read the comments above before modifying this function   *
    *********************************************************************/
   int i = 1;
 
-  mvsadcost[0][0] = 0;
-  mvsadcost[1][0] = 0;
+  mvsadcost[0] = 0;
 
   do {
     double z = 256 * (2 * (log2f(8 * i) + .6));
-    mvsadcost[0][i] = (int)z;
-    mvsadcost[1][i] = (int)z;
-    mvsadcost[0][-i] = (int)z;
-    mvsadcost[1][-i] = (int)z;
+    mvsadcost[i] = (int)z;
+    mvsadcost[-i] = (int)z;
   } while (++i <= MV_MAX);
 }
 
-static void cal_nmvsadcosts_hp(int *mvsadcost[2]) {
-  int i = 1;
+// The SAD based MV costs do not adapt, so they are computed once by
+// vp9_initialize_enc() and shared by all encoder instances, for both MV
+// components and precisions.
+static int nmvsadcosts[MV_VALS];
 
-  mvsadcost[0][0] = 0;
-  mvsadcost[1][0] = 0;
+void vp9_initialize_enc(void) {
+  static volatile int init_done = 0;
 
-  do {
-    double z = 256 * (2 * (log2f(8 * i) + .6));
-    mvsadcost[0][i] = (int)z;
-    mvsadcost[1][i] = (int)z;
-    mvsadcost[0][-i] = (int)z;
-    mvsadcost[1][-i] = (int)z;
-  } while (++i <= MV_MAX);
+  if (!init_done) {
+    vp9_rtcd();
+    vpx_dsp_rtcd();
+    vpx_scale_rtcd();
+    vp9_init_intra_predictors();
+    vp9_init_me_luts();
+    vp9_rc_init_minq_luts();
+    vp9_entropy_mv_init();
+    vp9_temporal_filter_init();
+    vp9_subexp_init();
+    cal_nmvsadcosts(&nmvsadcosts[MV_MAX]);
+    init_done = 1;
+  }
+}
+
+static size_t read_stats_buffer(void *priv, uint64_t offset, void *buf,
+                                size_t size) {
+  memcpy(buf, (const uint8_t *)priv + offset, size);
+  return size;
 }
 
 VP9_COMP *vp9_create_compressor(VP9EncoderConfig *oxcf,
@@ -2060,20 +2066,17 @@ VP9_COMP *vp9_create_compressor(VP9EncoderConfig *oxcf,
                   vpx_calloc(MV_VALS, sizeof(*cpi->nmvcosts_hp[0])));
   CHECK_MEM_ERROR(cm, cpi->nmvcosts_hp[1],
                   vpx_calloc(MV_VALS, sizeof(*cpi->nmvcosts_hp[1])));
-  CHECK_MEM_ERROR(cm, cpi->nmvsadcosts[0],
-                  vpx_calloc(MV_VALS, sizeof(*cpi->nmvsadcosts[0])));
-  CHECK_MEM_ERROR(cm, cpi->nmvsadcosts[1],
-                  vpx_calloc(MV_VALS, sizeof(*cpi->nmvsadcosts[1])));
-  CHECK_MEM_ERROR(cm, cpi->nmvsadcosts_hp[0],
-                  vpx_calloc(MV_VALS, sizeof(*cpi->nmvsadcosts_hp[0])));
-  CHECK_MEM_ERROR(cm, cpi->nmvsadcosts_hp[1],
-                  vpx_calloc(MV_VALS, sizeof(*cpi->nmvsadcosts_hp[1])));
-
-  for (i = 0; i < (sizeof(cpi->mbgraph_stats) / sizeof(cpi->mbgraph_stats[0]));
-       i++) {
-    CHECK_MEM_ERROR(
-        cm, cpi->mbgraph_stats[i].mb_stats,
-        vpx_calloc(cm->MBs * sizeof(*cpi->mbgraph_stats[i].mb_stats), 1));
+
+  // The macroblock graph only drives the static segmentation of the second
+  // pass.
+  if (oxcf->pass == 2) {
+    for (i = 0;
+         i < (sizeof(cpi->mbgraph_stats) / sizeof(cpi->mbgraph_stats[0]));
+         i++) {
+      CHECK_MEM_ERROR(
+          cm, cpi->mbgraph_stats[i].mb_stats,
+          vpx_calloc(cm->MBs * sizeof(*cpi->mbgraph_stats[i].mb_stats), 1));
+    }
   }
 
 #if CONFIG_FP_MB_STATS
@@ -2146,15 +2149,13 @@ VP9_COMP *vp9_create_compressor(VP9EncoderConfig *oxcf,
   cal_nmvjointsadcost(cpi->td.mb.nmvjointsadcost);
   cpi->td.mb.nmvcost[0] = &cpi->nmvcosts[0][MV_MAX];
   cpi->td.mb.nmvcost[1] = &cpi->nmvcosts[1][MV_MAX];
-  cpi->td.mb.nmvsadcost[0] = &cpi->nmvsadcosts[0][MV_MAX];
-  cpi->td.mb.nmvsadcost[1] = &cpi->nmvsadcosts[1][MV_MAX];
-  cal_nmvsadcosts(cpi->td.mb.nmvsadcost);
+  cpi->td.mb.nmvsadcost[0] = &nmvsadcosts[MV_MAX];
+  cpi->td.mb.nmvsadcost[1] = &nmvsadcosts[MV_MAX];
 
   cpi->td.mb.nmvcost_hp[0] = &cpi->nmvcosts_hp[0][MV_MAX];
   cpi->td.mb.nmvcost_hp[1] = &cpi->nmvcosts_hp[1][MV_MAX];
-  cpi->td.mb.nmvsadcost_hp[0] = &cpi->nmvsadcosts_hp[0][MV_MAX];
-  cpi->td.mb.nmvsadcost_hp[1] = &cpi->nmvsadcosts_hp[1][MV_MAX];
-  cal_nmvsadcosts_hp(cpi->td.mb.nmvsadcost_hp);
+  cpi->td.mb.nmvsadcost_hp[0] = &nmvsadcosts[MV_MAX];
+  cpi->td.mb.nmvsadcost_hp[1] = &nmvsadcosts[MV_MAX];
 
 #if CONFIG_VP9_TEMPORAL_DENOISING
 #ifdef OUTPUT_YUV_DENOISED
@@ -2177,47 +2178,18 @@ VP9_COMP *vp9_create_compressor(VP9EncoderConfig *oxcf,
 
   if (oxcf->pass == 1) {
     vp9_init_first_pass(cpi);
-  } else if (oxcf->pass == 2) {
+  } else if (oxcf->pass == 2 && oxcf->two_pass_stats_in.buf != NULL) {
     const size_t packet_sz = sizeof(FIRSTPASS_STATS);
     const int packets = (int)(oxcf->two_pass_stats_in.sz / packet_sz);
 
     if (cpi->svc.number_spatial_layers > 1 ||
         cpi->svc.number_temporal_layers > 1) {
-      FIRSTPASS_STATS *const stats = oxcf->two_pass_stats_in.buf;
-      FIRSTPASS_STATS *stats_copy[VPX_SS_MAX_LAYERS] = { 0 };
-      int i;
-
-      for (i = 0; i < oxcf->ss_number_layers; ++i) {
-        FIRSTPASS_STATS *const last_packet_for_layer =
-            &stats[packets - oxcf->ss_number_layers + i];
-        const int layer_id = (int)last_packet_for_layer->spatial_layer_id;
-        const int packets_in_layer = (int)last_packet_for_layer->count + 1;
-        if (layer_id >= 0 && layer_id < oxcf->ss_number_layers) {
-          LAYER_CONTEXT *const lc = &cpi->svc.layer_context[layer_id];
-
-          vpx_free(lc->rc_twopass_stats_in.buf);
-
-          lc->rc_twopass_stats_in.sz = packets_in_layer * packet_sz;
-          CHECK_MEM_ERROR(cm, lc->rc_twopass_stats_in.buf,
-                          vpx_malloc(lc->rc_twopass_stats_in.sz));
-          lc->twopass.stats_in_start = lc->rc_twopass_stats_in.buf;
-          lc->twopass.stats_in = lc->twopass.stats_in_start;
-          lc->twopass.stats_in_end =
-              lc->twopass.stats_in_start + packets_in_layer - 1;
-          stats_copy[layer_id] = lc->rc_twopass_stats_in.buf;
-        }
-      }
-
-      for (i = 0; i < packets; ++i) {
-        const int layer_id = (int)stats[i].spatial_layer_id;
-        if (layer_id >= 0 && layer_id < oxcf->ss_number_layers &&
-            stats_copy[layer_id] != NULL) {
-          *stats_copy[layer_id] = stats[i];
-          ++stats_copy[layer_id];
-        }
-      }
-
-      vp9_init_second_pass_spatial_svc(cpi);
+      // Read the packets of each layer in place rather than copying them out.
+      vpx_twopass_stats_source_t source;
+      source.read = read_stats_buffer;
+      source.sz = oxcf->two_pass_stats_in.sz;
+      source.priv = oxcf->two_pass_stats_in.buf;
+      vp9_set_twopass_stats_source(cpi, &source);
     } else {
 #if CONFIG_FP_MB_STATS
       if (cpi->use_fp_mb_stats) {
@@ -2445,6 +2417,9 @@ void vp9_remove_compressor(VP9_COMP *cpi) {
   vpx_free(cpi->tile_thr_data);
   vpx_free(cpi->workers);
   vp9_row_mt_mem_dealloc(cpi);
+  vpx_arena_free(&cpi->multi_thread_ctxt.arena);
+
+  vpx_free(cpi->lf_row_sse);
 
   if (cpi->num_workers > 1) {
     vp9_loop_filter_dealloc(&cpi->lf_row_sync);
@@ -2504,12 +2479,31 @@ static void generate_psnr_packet(VP9_COMP *cpi) {
   struct vpx_codec_cx_pkt pkt;
   int i;
   PSNR_STATS psnr;
+
+  if (cpi->lf_row_sse_valid) {
+    // The loop filter already measured the reconstruction row by row.
+    const int sb_rows = mi_cols_aligned_to_sb(cpi->common.mi_rows) >>
+                        MI_BLOCK_SIZE_LOG2;
 #if CONFIG_VP9_HIGHBITDEPTH
-  vpx_calc_highbd_psnr(cpi->raw_source_frame, cpi->common.frame_to_show, &psnr,
-                       cpi->td.mb.e_mbd.bd, cpi->oxcf.input_bit_depth);
+    const double peak = (double)((1 << cpi->oxcf.input_bit_depth) - 1);
 #else
-  vpx_calc_psnr(cpi->raw_source_frame, cpi->common.frame_to_show, &psnr);
+    const double peak = 255.0;
+#endif  // CONFIG_VP9_HIGHBITDEPTH
+    uint64_t sse[MAX_MB_PLANE] = { 0, 0, 0 };
+    int row, plane;
+    for (row = 0; row < sb_rows; ++row)
+      for (plane = 0; plane < MAX_MB_PLANE; ++plane)
+        sse[plane] += cpi->lf_row_sse[row * MAX_MB_PLANE + plane];
+    vpx_sse_to_psnr_stats(cpi->raw_source_frame, sse, peak, &psnr);
+    cpi->lf_row_sse_valid = 0;
+  } else {
+#if CONFIG_VP9_HIGHBITDEPTH
+    vpx_calc_highbd_psnr(cpi->raw_source_frame, cpi->common.frame_to_show,
+                         &psnr, cpi->td.mb.e_mbd.bd, cpi->oxcf.input_bit_depth);
+#else
+    vpx_calc_psnr(cpi->raw_source_frame, cpi->common.frame_to_show, &psnr);
 #endif
+  }
 
   for (i = 0; i < 4; ++i) {
     pkt.data.psnr.samples[i] = psnr.samples[i];
@@ -2913,6 +2907,71 @@ void vp9_update_reference_frames(VP9_COMP *cpi) {
   }
 }
 
+// Number of pixel rows at the bottom of a superblock row that the loop filter
+// may still modify while filtering the superblock row below it.
+#define LF_ROW_MARGIN 8
+
+// Loop filter row hook. Once superblock row mi_row is filtered the rows of each
+// plane above the next row's filter margin are final, so their inner borders
+// are extended and, when the PSNR packet is fused with the loop filter, their
+// SSE is accumulated while they are still warm in the cache.
+static void lf_row_filtered(void *priv, int mi_row) {
+  VP9_COMP *const cpi = (VP9_COMP *)priv;
+  const VP9_COMMON *const cm = &cpi->common;
+  YV12_BUFFER_CONFIG *const recon = cm->frame_to_show;
+  const int sb_row = mi_row >> MI_BLOCK_SIZE_LOG2;
+  const int last_row = mi_row + MI_BLOCK_SIZE >= cm->mi_rows;
+  int plane;
+
+  for (plane = 0; plane < MAX_MB_PLANE; ++plane) {
+    const int ss_y = plane ? cm->subsampling_y : 0;
+    const int sb_height = (MI_BLOCK_SIZE * MI_SIZE) >> ss_y;
+    const int height = plane ? recon->uv_crop_height : recon->y_crop_height;
+    const int start =
+        sb_row ? VPXMIN(sb_row * sb_height - LF_ROW_MARGIN, height) : 0;
+    const int end =
+        last_row ? height
+                 : VPXMIN((sb_row + 1) * sb_height - LF_ROW_MARGIN, height);
+    if (cpi->lf_row_sse_valid) {
+      uint64_t *const row_sse = &cpi->lf_row_sse[sb_row * MAX_MB_PLANE];
+#if CONFIG_VP9_HIGHBITDEPTH
+      row_sse[plane] =
+          vpx_get_plane_sse(cpi->raw_source_frame, recon, plane, start, end,
+                            cpi->td.mb.e_mbd.bd, cpi->oxcf.input_bit_depth);
+#else
+      row_sse[plane] = vpx_get_plane_sse(cpi->raw_source_frame, recon, plane,
+                                         start, end, 8, 8);
+#endif  // CONFIG_VP9_HIGHBITDEPTH
+    }
+    vpx_extend_frame_inner_borders_rows(recon, plane, start, end);
+  }
+}
+
+// Returns whether the PSNR packet of this frame can be measured by the loop
+// filter, and makes room for the per row results.
+static int setup_lf_row_sse(VP9_COMP *cpi) {
+  VP9_COMMON *const cm = &cpi->common;
+  const YV12_BUFFER_CONFIG *const src = cpi->raw_source_frame;
+  const YV12_BUFFER_CONFIG *const recon = cm->frame_to_show;
+  const int sb_rows = mi_cols_aligned_to_sb(cm->mi_rows) >> MI_BLOCK_SIZE_LOG2;
+
+  if (!is_psnr_calc_enabled(cpi) || src == NULL ||
+      src->y_crop_width != recon->y_crop_width ||
+      src->y_crop_height != recon->y_crop_height ||
+      src->uv_crop_height != recon->uv_crop_height)
+    return 0;
+
+  if (cpi->lf_row_sse_rows < sb_rows) {
+    vpx_free(cpi->lf_row_sse);
+    cpi->lf_row_sse_rows = 0;
+    CHECK_MEM_ERROR(cm, cpi->lf_row_sse,
+                    vpx_calloc(sb_rows * MAX_MB_PLANE,
+                               sizeof(*cpi->lf_row_sse)));
+    cpi->lf_row_sse_rows = sb_rows;
+  }
+  return 1;
+}
+
 static void loopfilter_frame(VP9_COMP *cpi, VP9_COMMON *cm) {
   MACROBLOCKD *xd = &cpi->td.mb.e_mbd;
   struct loopfilter *lf = &cm->lf;
@@ -2944,20 +3003,36 @@ static void loopfilter_frame(VP9_COMP *cpi, VP9_COMMON *cm) {
 
     vpx_usec_timer_mark(&timer);
     cpi->time_pick_lpf += vpx_usec_timer_elapsed(&timer);
+#if CONFIG_STAGE_TIMING
+    cpi->stage_timing.stage_us[VPX_ENC_STAGE_PICK_LOOP_FILTER] +=
+        vpx_usec_timer_elapsed(&timer);
+#endif
   }
 
+  cpi->lf_row_sse_valid = 0;
+
   if (lf->filter_level > 0 && is_reference_frame) {
+    struct vpx_usec_timer timer;
+
+    vp9_stage_timer_start(&timer);
     vp9_build_mask_frame(cm, lf->filter_level, 0);
 
+    // The borders are extended by the loop filter workers as rows complete.
+    cpi->lf_row_sse_valid = setup_lf_row_sse(cpi);
+    lf->row_filtered = lf_row_filtered;
+    lf->row_filtered_priv = cpi;
     if (cpi->num_workers > 1)
       vp9_loop_filter_frame_mt(cm->frame_to_show, cm, xd->plane,
                                lf->filter_level, 0, 0, cpi->workers,
                                cpi->num_workers, &cpi->lf_row_sync);
     else
       vp9_loop_filter_frame(cm->frame_to_show, cm, xd, lf->filter_level, 0, 0);
+    lf->row_filtered = NULL;
+    lf->row_filtered_priv = NULL;
+    vp9_stage_timer_end(cpi, &timer, VPX_ENC_STAGE_LOOP_FILTER);
+  } else {
+    vpx_extend_frame_inner_borders(cm->frame_to_show);
   }
-
-  vpx_extend_frame_inner_borders(cm->frame_to_show);
 }
 
 static INLINE void alloc_frame_mvs(VP9_COMMON *const cm, int buffer_idx) {
@@ -3317,7 +3392,8 @@ static void setup_denoiser_buffer(VP9_COMP *cpi) {
 #endif
 
 static void init_motion_estimation(VP9_COMP *cpi) {
-  int y_stride = cpi->scaled_source.y_stride;
+  // All frame buffers share the stride of the frame being coded.
+  int y_stride = get_frame_new_buffer(&cpi->common)->y_stride;
 
   if (cpi->sf.mv.search_method == NSTEP) {
     vp9_init3smotion_compensation(&cpi->ss_cfg, y_stride);
@@ -4470,13 +4546,17 @@ static void encode_frame_to_data_rate(VP9_COMP *cpi, size_t *size,
     full_to_model_counts(cpi->td.counts->coef[t],
                          cpi->td.rd_counts.coef_counts[t]);
 
-  if (!cm->error_resilient_mode && !cm->frame_parallel_decoding_mode)
-    vp9_adapt_coef_probs(cm);
+  if (!cm->error_resilient_mode && !cm->frame_parallel_decoding_mode) {
+    if (cpi->num_workers > 1) {
+      vp9_adapt_probs_mt(cm, !frame_is_intra_only(cm), cpi->workers,
+                         cpi->num_workers);
+    } else {
+      vp9_adapt_coef_probs(cm);
 
-  if (!frame_is_intra_only(cm)) {
-    if (!cm->error_resilient_mode && !cm->frame_parallel_decoding_mode) {
-      vp9_adapt_mode_probs(cm);
-      vp9_adapt_mv_probs(cm, cm->allow_high_precision_mv);
+      if (!frame_is_intra_only(cm)) {
+        vp9_adapt_mode_probs(cm);
+        vp9_adapt_mv_probs(cm, cm->allow_high_precision_mv);
+      }
     }
   }
 
@@ -4603,8 +4683,6 @@ static void check_initial_width(VP9_COMP *cpi,
     init_ref_frame_bufs(cm);
     alloc_util_frame_buffers(cpi);
 
-    init_motion_estimation(cpi);  // TODO(agrange) This can be removed.
-
     cpi->initial_width = cm->width;
     cpi->initial_height = cm->height;
     cpi->initial_mbs = cm->MBs;
@@ -4642,6 +4720,10 @@ int vp9_receive_raw_frame(VP9_COMP *cpi, vpx_enc_frame_flags_t frame_flags,
     res = -1;
   vpx_usec_timer_mark(&timer);
   cpi->time_receive_data += vpx_usec_timer_elapsed(&timer);
+#if CONFIG_STAGE_TIMING
+  cpi->stage_timing.stage_us[VPX_ENC_STAGE_LOOKAHEAD] +=
+      vpx_usec_timer_elapsed(&timer);
+#endif
 
   if ((cm->profile == PROFILE_0 || cm->profile == PROFILE_2) &&
       (subsampling_x != 1 || subsampling_y != 1)) {
@@ -5070,11 +5152,14 @@ int vp9_get_compressed_data(VP9_COMP *cpi, unsigned int *frame_flags,
         int not_low_bitrate = bitrate > ALT_REF_AQ_LOW_BITRATE_BOUNDARY;
 
         int not_last_frame = (cpi->lookahead->sz - arf_src_index > 1);
+        struct vpx_usec_timer timer;
         not_last_frame |= ALT_REF_AQ_APPLY_TO_LAST_FRAME;
 
         // Produce the filtered ARF frame.
+        vp9_stage_timer_start(&timer);
         vp9_temporal_filter(cpi, arf_src_index);
         vpx_extend_frame_borders(&cpi->alt_ref_buffer);
+        vp9_stage_timer_end(cpi, &timer, VPX_ENC_STAGE_TEMPORAL_FILTER);
 
         // for small bitrates segmentation overhead usually
         // eats all bitrate gain from enabling delta quantizers
@@ -5256,6 +5341,9 @@ int vp9_get_compressed_data(VP9_COMP *cpi, unsigned int *frame_flags,
 
   vpx_usec_timer_mark(&cmptimer);
   cpi->time_compress_data += vpx_usec_timer_elapsed(&cmptimer);
+#if CONFIG_STAGE_TIMING
+  cpi->stage_timing.total_us += vpx_usec_timer_elapsed(&cmptimer);
+#endif
 
   // Should we calculate metrics for the frame.
   if (is_psnr_calc_enabled(cpi)) generate_psnr_packet(cpi);
@@ -5272,6 +5360,8 @@ int vp9_get_compressed_data(VP9_COMP *cpi, unsigned int *frame_flags,
     if (cm->show_frame) {
       uint32_t bit_depth = 8;
       uint32_t in_bit_depth = 8;
+      FRAME_METRICS metrics;
+      int fused_metrics;
       cpi->count++;
 #if CONFIG_VP9_HIGHBITDEPTH
       if (cm->use_highbitdepth) {
@@ -5280,27 +5370,35 @@ int vp9_get_compressed_data(VP9_COMP *cpi, unsigned int *frame_flags,
       }
 #endif
 
+      // FastSSIM and PSNR-HVS are measured against cpi->Source. When that is
+      // also the PSNR source, all the metrics are computed in a single pass.
+      fused_metrics =
+          cpi->b_calculate_psnr && cpi->Source == cpi->raw_source_frame;
+
       if (cpi->b_calculate_psnr) {
         YV12_BUFFER_CONFIG *orig = cpi->raw_source_frame;
         YV12_BUFFER_CONFIG *recon = cpi->common.frame_to_show;
         YV12_BUFFER_CONFIG *pp = &cm->post_proc_buffer;
-        PSNR_STATS psnr;
-#if CONFIG_VP9_HIGHBITDEPTH
-        vpx_calc_highbd_psnr(orig, recon, &psnr, cpi->td.mb.e_mbd.bd,
-                             in_bit_depth);
-#else
-        vpx_calc_psnr(orig, recon, &psnr);
-#endif  // CONFIG_VP9_HIGHBITDEPTH
+        const PSNR_STATS *const psnr = &metrics.psnr;
+
+        vp9_calc_frame_metrics_mt(
+            cpi, orig, recon,
+            VPX_METRIC_PSNR | VPX_METRIC_SSIM |
+                (fused_metrics ? VPX_METRIC_FASTSSIM | VPX_METRIC_PSNRHVS : 0),
+            bit_depth, in_bit_depth, &metrics);
+
+        adjust_image_stat(psnr->psnr[1], psnr->psnr[2], psnr->psnr[3],
+                          psnr->psnr[0], &cpi->psnr);
+        cpi->total_sq_error += psnr->sse[0];
+        cpi->total_samples += psnr->samples[0];
+        samples = psnr->samples[0];
 
-        adjust_image_stat(psnr.psnr[1], psnr.psnr[2], psnr.psnr[3],
-                          psnr.psnr[0], &cpi->psnr);
-        cpi->total_sq_error += psnr.sse[0];
-        cpi->total_samples += psnr.samples[0];
-        samples = psnr.samples[0];
+        cpi->worst_ssim = VPXMIN(cpi->worst_ssim, metrics.ssim);
+        cpi->summed_quality += metrics.ssim;
+        cpi->summed_weights += 1;
 
         {
-          PSNR_STATS psnr2;
-          double frame_ssim2 = 0, weight = 0;
+          FRAME_METRICS pp_metrics;
 #if CONFIG_VP9_POSTPROC
           if (vpx_alloc_frame_buffer(
                   pp, recon->y_crop_width, recon->y_crop_height,
@@ -5322,46 +5420,18 @@ int vp9_get_compressed_data(VP9_COMP *cpi, unsigned int *frame_flags,
 #endif
           vpx_clear_system_state();
 
-#if CONFIG_VP9_HIGHBITDEPTH
-          vpx_calc_highbd_psnr(orig, pp, &psnr2, cpi->td.mb.e_mbd.bd,
-                               cpi->oxcf.input_bit_depth);
-#else
-          vpx_calc_psnr(orig, pp, &psnr2);
-#endif  // CONFIG_VP9_HIGHBITDEPTH
+          vp9_calc_frame_metrics_mt(cpi, orig, pp,
+                                    VPX_METRIC_PSNR | VPX_METRIC_SSIM,
+                                    bit_depth, in_bit_depth, &pp_metrics);
 
-          cpi->totalp_sq_error += psnr2.sse[0];
-          cpi->totalp_samples += psnr2.samples[0];
-          adjust_image_stat(psnr2.psnr[1], psnr2.psnr[2], psnr2.psnr[3],
-                            psnr2.psnr[0], &cpi->psnrp);
+          cpi->totalp_sq_error += pp_metrics.psnr.sse[0];
+          cpi->totalp_samples += pp_metrics.psnr.samples[0];
+          adjust_image_stat(pp_metrics.psnr.psnr[1], pp_metrics.psnr.psnr[2],
+                            pp_metrics.psnr.psnr[3], pp_metrics.psnr.psnr[0],
+                            &cpi->psnrp);
 
-#if CONFIG_VP9_HIGHBITDEPTH
-          if (cm->use_highbitdepth) {
-            frame_ssim2 = vpx_highbd_calc_ssim(orig, recon, &weight, bit_depth,
-                                               in_bit_depth);
-          } else {
-            frame_ssim2 = vpx_calc_ssim(orig, recon, &weight);
-          }
-#else
-          frame_ssim2 = vpx_calc_ssim(orig, recon, &weight);
-#endif  // CONFIG_VP9_HIGHBITDEPTH
-
-          cpi->worst_ssim = VPXMIN(cpi->worst_ssim, frame_ssim2);
-          cpi->summed_quality += frame_ssim2 * weight;
-          cpi->summed_weights += weight;
-
-#if CONFIG_VP9_HIGHBITDEPTH
-          if (cm->use_highbitdepth) {
-            frame_ssim2 = vpx_highbd_calc_ssim(orig, pp, &weight, bit_depth,
-                                               in_bit_depth);
-          } else {
-            frame_ssim2 = vpx_calc_ssim(orig, pp, &weight);
-          }
-#else
-          frame_ssim2 = vpx_calc_ssim(orig, pp, &weight);
-#endif  // CONFIG_VP9_HIGHBITDEPTH
-
-          cpi->summedp_quality += frame_ssim2 * weight;
-          cpi->summedp_weights += weight;
+          cpi->summedp_quality += pp_metrics.ssim;
+          cpi->summedp_weights += 1;
 #if 0
           {
             FILE *f = fopen("q_used.stt", "a");
@@ -5409,18 +5479,16 @@ int vp9_get_compressed_data(VP9_COMP *cpi, unsigned int *frame_flags,
         }
       }
 
-      {
-        double y, u, v, frame_all;
-        frame_all = vpx_calc_fastssim(cpi->Source, cm->frame_to_show, &y, &u,
-                                      &v, bit_depth, in_bit_depth);
-        adjust_image_stat(y, u, v, frame_all, &cpi->fastssim);
-      }
-      {
-        double y, u, v, frame_all;
-        frame_all = vpx_psnrhvs(cpi->Source, cm->frame_to_show, &y, &u, &v,
-                                bit_depth, in_bit_depth);
-        adjust_image_stat(y, u, v, frame_all, &cpi->psnrhvs);
+      if (!fused_metrics) {
+        vp9_calc_frame_metrics_mt(cpi, cpi->Source, cm->frame_to_show,
+                                  VPX_METRIC_FASTSSIM | VPX_METRIC_PSNRHVS,
+                                  bit_depth, in_bit_depth, &metrics);
       }
+      adjust_image_stat(metrics.fastssim[1], metrics.fastssim[2],
+                        metrics.fastssim[3], metrics.fastssim[0],
+                        &cpi->fastssim);
+      adjust_image_stat(metrics.psnrhvs[1], metrics.psnrhvs[2],
+                        metrics.psnrhvs[3], metrics.psnrhvs[0], &cpi->psnrhvs);
     }
   }
 
@@ -5582,16 +5650,17 @@ void vp9_apply_encoding_flags(VP9_COMP *cpi, vpx_enc_frame_flags_t flags) {
 }
 
 void vp9_set_row_mt(VP9_COMP *cpi) {
-  // Enable row based multi-threading for supported modes of encoding
+  // Enable row based multi-threading for supported modes of encoding. Spatial
+  // layers are encoded one after another, each with the row workers; the
+  // row-mt buffers grow to the largest layer.
   cpi->row_mt = 0;
   if (((cpi->oxcf.mode == GOOD || cpi->oxcf.mode == BEST) &&
        cpi->oxcf.speed < 5 && cpi->oxcf.pass == 1) &&
-      cpi->oxcf.row_mt && !cpi->use_svc)
+      cpi->oxcf.row_mt)
     cpi->row_mt = 1;
 
   if (cpi->oxcf.mode == GOOD && cpi->oxcf.speed < 5 &&
-      (cpi->oxcf.pass == 0 || cpi->oxcf.pass == 2) && cpi->oxcf.row_mt &&
-      !cpi->use_svc)
+      (cpi->oxcf.pass == 0 || cpi->oxcf.pass == 2) && cpi->oxcf.row_mt)
     cpi->row_mt = 1;
 
   // In realtime mode, enable row based multi-threading for all the speed levels
@@ -5605,3 +5674,137 @@ void vp9_set_row_mt(VP9_COMP *cpi) {
   else
     cpi->row_mt_bit_exact = 0;
 }
+
+size_t vp9_get_memory_footprint(const VP9_COMP *cpi) {
+  const VP9_COMMON *const cm = &cpi->common;
+  const BufferPool *const pool = cm->buffer_pool;
+  const size_t mi_size = cm->mi_rows * cm->mi_cols;
+  size_t size = sizeof(*cpi);
+  int i;
+
+  for (i = 0; i < FRAME_BUFFERS; ++i) {
+    const RefCntBuffer *const buf = &pool->frame_bufs[i];
+    size += buf->buf.buffer_alloc_sz;
+    if (buf->mvs != NULL)
+      size += buf->mi_rows * buf->mi_cols * sizeof(*buf->mvs);
+  }
+
+  if (cpi->lookahead != NULL) {
+    for (i = 0; i < cpi->lookahead->max_sz; ++i)
+      size += cpi->lookahead->buf[i].img.buffer_alloc_sz;
+  }
+
+  size += cpi->alt_ref_buffer.buffer_alloc_sz;
+  size += cpi->last_frame_uf.buffer_alloc_sz;
+  size += cpi->scaled_source.buffer_alloc_sz;
+  size += cpi->scaled_last_source.buffer_alloc_sz;
+  size += cpi->svc.scaled_temp.buffer_alloc_sz;
+
+  // Mode info for the current and previous frames, and their grids.
+  size +=
+      cm->mi_alloc_size * 2 * (sizeof(*cm->mip) + sizeof(*cm->mi_grid_base));
+  size += mi_size * sizeof(*cpi->mbmi_ext_base);
+  size += cpi->tile_tok_alloc * sizeof(*cpi->tile_tok[0][0]);
+
+  if (cpi->mbgraph_stats[0].mb_stats != NULL) {
+    size += sizeof(cpi->mbgraph_stats) / sizeof(cpi->mbgraph_stats[0]) *
+            cm->MBs * sizeof(*cpi->mbgraph_stats[0].mb_stats);
+  }
+
+  return size;
+}
+
+void vp9_set_memory_allocator(VP9_COMP *cpi,
+                              const vpx_memory_allocator_t *allocator) {
+  VP9_COMMON *const cm = &cpi->common;
+  int i;
+
+  if (allocator != NULL)
+    cpi->allocator = *allocator;
+  else
+    vp9_zero(cpi->allocator);
+
+  vp9_row_mt_mem_dealloc(cpi);
+  vpx_arena_set_allocator(&cpi->multi_thread_ctxt.arena, &cpi->allocator);
+
+  vpx_arena_set_allocator(&cpi->td.pc_arena, &cpi->allocator);
+  if (cpi->td.pc_tree != NULL) vp9_setup_pc_tree(cm, &cpi->td);
+  for (i = 0; i < cpi->num_workers - 1; ++i) {
+    ThreadData *const td = cpi->tile_thr_data[i].td;
+    vpx_arena_set_allocator(&td->pc_arena, &cpi->allocator);
+    vp9_setup_pc_tree(cm, td);
+  }
+}
+
+void vp9_get_memory_allocator_stats(const VP9_COMP *cpi,
+                                    vpx_memory_allocator_stats_t *stats) {
+  int i;
+
+  memset(stats, 0, sizeof(*stats));
+  vpx_arena_add_stats(&cpi->td.pc_arena, stats);
+  for (i = 0; i < cpi->num_workers - 1; ++i)
+    vpx_arena_add_stats(&cpi->tile_thr_data[i].td->pc_arena, stats);
+  vpx_arena_add_stats(&cpi->multi_thread_ctxt.arena, stats);
+}
+
+static int read_stats_at(const vpx_twopass_stats_source_t *source,
+                         int64_t index, FIRSTPASS_STATS *stats) {
+  return source->read(source->priv, (uint64_t)index * sizeof(*stats), stats,
+                      sizeof(*stats)) == sizeof(*stats);
+}
+
+int vp9_set_twopass_stats_source(VP9_COMP *cpi,
+                                 const vpx_twopass_stats_source_t *source) {
+  const int64_t packets = (int64_t)(source->sz / sizeof(FIRSTPASS_STATS));
+  FIRSTPASS_STATS totals;
+
+  if (source->read == NULL || source->sz % sizeof(FIRSTPASS_STATS)) return -1;
+
+  if (cpi->svc.number_spatial_layers > 1 ||
+      cpi->svc.number_temporal_layers > 1) {
+    const int num_layers = cpi->oxcf.ss_number_layers;
+    int64_t packets_in_layer[VPX_SS_MAX_LAYERS] = { 0 };
+    int64_t i;
+
+    // The packets of the layers are interleaved, followed by the totals
+    // packet of each layer.
+    for (i = 0; i < packets; ++i) {
+      int layer_id;
+      if (!read_stats_at(source, i, &totals)) return -1;
+      layer_id = (int)totals.spatial_layer_id;
+      if (layer_id >= 0 && layer_id < num_layers) ++packets_in_layer[layer_id];
+    }
+
+    for (i = 0; i < num_layers; ++i) {
+      int layer_id;
+      if (packets_in_layer[i] < 2 ||
+          !read_stats_at(source, packets - num_layers + i, &totals))
+        return -1;
+      layer_id = (int)totals.spatial_layer_id;
+      if (layer_id < 0 || layer_id >= num_layers ||
+          (int64_t)(totals.count + 0.5) != packets_in_layer[layer_id] - 1)
+        return -1;
+    }
+
+    for (i = 0; i < num_layers; ++i) {
+      int layer_id;
+      read_stats_at(source, packets - num_layers + i, &totals);
+      layer_id = (int)totals.spatial_layer_id;
+      vp9_twopass_stream_stats(cpi, &cpi->svc.layer_context[layer_id].twopass,
+                               source, layer_id, packets_in_layer[layer_id] - 1,
+                               &totals);
+    }
+
+    vp9_init_second_pass_spatial_svc(cpi);
+  } else {
+    if (packets < 2 || !read_stats_at(source, packets - 1, &totals) ||
+        (int64_t)(totals.count + 0.5) != packets - 1)
+      return -1;
+
+    vp9_twopass_stream_stats(cpi, &cpi->twopass, source, -1, packets - 1,
+                             &totals);
+    vp9_init_second_pass(cpi);
+  }
+
+  return 0;
+}
@@ -20,12 +20,15 @@
 #include "vpx_dsp/ssim.h"
 #endif
 #include "vpx_dsp/variance.h"
+#include "vpx_mem/vpx_arena.h"
 #include "vpx_ports/system_state.h"
+#include "vpx_ports/vpx_timer.h"
 #include "vpx_util/vpx_thread.h"
 
 #include "vp9/common/vp9_alloccommon.h"
 #include "vp9/common/vp9_ppflags.h"
 #include "vp9/common/vp9_entropymode.h"
+#include "vp9/common/vp9_mvref_common.h"
 #include "vp9/common/vp9_thread_common.h"
 #include "vp9/common/vp9_onyxc_int.h"
 
@@ -167,6 +170,8 @@ typedef struct VP9EncoderConfig {
   int key_freq;  // maximum distance to key frame.
 
   int lag_in_frames;  // how many frames lag before we start encoding
+  // Frames the lookahead pass analyses ahead of the lag, 0 if it is off.
+  int lookahead_pass_frames;
 
   // ----------------------------------------------------------------
   // DATARATE CONTROL OPTIONS
@@ -259,6 +264,7 @@ typedef struct VP9EncoderConfig {
 
   vp8e_tuning tuning;
   vp9e_tune_content content;
+  vp9e_memory_profile memory_profile;
 #if CONFIG_VP9_HIGHBITDEPTH
   int use_highbitdepth;
 #endif
@@ -316,6 +322,9 @@ typedef struct MultiThreadHandle {
 
   RowMTInfo row_mt_info[MAX_NUM_TILE_COLS];
   int thread_id_to_tile_id[MAX_NUM_THREADS];  // Mapping of threads to tiles
+
+  // Backs the job queue and the per tile row synchronization buffers.
+  vpx_arena arena;
 } MultiThreadHandle;
 
 typedef struct RD_COUNTS {
@@ -332,6 +341,9 @@ typedef struct ThreadData {
   PICK_MODE_CONTEXT *leaf_tree;
   PC_TREE *pc_tree;
   PC_TREE *pc_root;
+  vpx_arena pc_arena;  // Backs leaf_tree and pc_tree.
+
+  MV_REF_CACHE mv_ref_cache;  // Of the superblock being encoded.
 } ThreadData;
 
 struct EncWorkerData;
@@ -494,6 +506,7 @@ typedef struct VP9_COMP {
   YV12_BUFFER_CONFIG last_frame_uf;
 
   TOKENEXTRA *tile_tok[4][1 << 6];
+  unsigned int tile_tok_alloc;  // Number of tokens allocated in tile_tok.
   uint32_t tok_count[4][1 << 6];
   TOKENLIST *tplist[4][1 << 6];
 
@@ -506,8 +519,6 @@ typedef struct VP9_COMP {
 
   int *nmvcosts[2];
   int *nmvcosts_hp[2];
-  int *nmvsadcosts[2];
-  int *nmvsadcosts_hp[2];
 
   int64_t last_time_stamp_seen;
   int64_t last_end_time_stamp_seen;
@@ -555,6 +566,10 @@ typedef struct VP9_COMP {
   uint64_t time_compress_data;
   uint64_t time_pick_lpf;
   uint64_t time_encode_sb_row;
+#if CONFIG_STAGE_TIMING
+  // Stage timing of the current vpx_codec_encode() call.
+  vpx_stage_timing_t stage_timing;
+#endif
 
 #if CONFIG_FP_MB_STATS
   int use_fp_mb_stats;
@@ -610,6 +625,12 @@ typedef struct VP9_COMP {
 #endif
   int b_calculate_psnr;
 
+  // SSE of the reconstruction against raw_source_frame, gathered per
+  // superblock row and plane by the loop filter for the PSNR packet.
+  uint64_t *lf_row_sse;
+  int lf_row_sse_rows;
+  int lf_row_sse_valid;
+
   int droppable;
 
   int initial_width;
@@ -686,6 +707,8 @@ typedef struct VP9_COMP {
   int keep_level_stats;
   Vp9LevelInfo level_info;
   MultiThreadHandle multi_thread_ctxt;
+  // Allocator of the scratch arenas. A NULL alloc selects vpx_memalign().
+  vpx_memory_allocator_t allocator;
   void (*row_mt_sync_read_ptr)(VP9RowMTSync *const, int, int);
   void (*row_mt_sync_write_ptr)(VP9RowMTSync *const, int, int, const int);
   ARNRFilterData arnr_filter_data;
@@ -865,6 +888,28 @@ static INLINE int denoise_svc(const struct VP9_COMP *const cpi) {
 }
 #endif
 
+static INLINE void vp9_stage_timer_start(struct vpx_usec_timer *timer) {
+#if CONFIG_STAGE_TIMING
+  vpx_usec_timer_start(timer);
+#else
+  (void)timer;
+#endif
+}
+
+// Adds the time elapsed since vp9_stage_timer_start() to 'stage'.
+static INLINE void vp9_stage_timer_end(VP9_COMP *cpi,
+                                       struct vpx_usec_timer *timer,
+                                       vpx_enc_stage_t stage) {
+#if CONFIG_STAGE_TIMING
+  vpx_usec_timer_mark(timer);
+  cpi->stage_timing.stage_us[stage] += vpx_usec_timer_elapsed(timer);
+#else
+  (void)cpi;
+  (void)timer;
+  (void)stage;
+#endif
+}
+
 static INLINE int is_altref_enabled(const VP9_COMP *const cpi) {
   return !(cpi->oxcf.mode == REALTIME && cpi->oxcf.rc_mode == VPX_CBR) &&
          cpi->oxcf.lag_in_frames > 0 &&
@@ -916,6 +961,23 @@ void vp9_new_framerate(VP9_COMP *cpi, double framerate);
 
 void vp9_set_row_mt(VP9_COMP *cpi);
 
+// Returns the approximate number of bytes allocated for frame buffers and
+// frame sized work buffers, excluding per-thread data.
+size_t vp9_get_memory_footprint(const VP9_COMP *cpi);
+
+// Moves the scratch arenas to |allocator|, or to vpx_memalign() when it is
+// NULL. The partition search contexts are set up again.
+void vp9_set_memory_allocator(VP9_COMP *cpi,
+                              const vpx_memory_allocator_t *allocator);
+
+void vp9_get_memory_allocator_stats(const VP9_COMP *cpi,
+                                    vpx_memory_allocator_stats_t *stats);
+
+// Makes the second pass read the first pass stats from |source|, keeping only
+// a window of them in memory. Returns -1 if the stats are not valid.
+int vp9_set_twopass_stats_source(VP9_COMP *cpi,
+                                 const vpx_twopass_stats_source_t *source);
+
 #define LAYER_IDS_TO_IDX(sl, tl, num_tl) ((sl) * (num_tl) + (tl))
 
 #ifdef __cplusplus
@@ -108,6 +108,7 @@ static void create_enc_workers(VP9_COMP *cpi, int num_workers) {
         // Set up pc_tree.
         thread_data->td->leaf_tree = NULL;
         thread_data->td->pc_tree = NULL;
+        vpx_arena_set_allocator(&thread_data->td->pc_arena, &cpi->allocator);
         vp9_setup_pc_tree(cm, thread_data->td);
 
         // Allocate frame counters in thread data.
@@ -128,6 +129,24 @@ static void create_enc_workers(VP9_COMP *cpi, int num_workers) {
   }
 }
 
+#if CONFIG_STAGE_TIMING
+// Runs the worker's real job and charges its wall time to the worker's slot
+// in cpi->stage_timing.thread_us. Each worker only writes its own slot.
+static int timed_worker_hook(EncWorkerData *const thread_data, void *data2) {
+  VP9_COMP *const cpi = thread_data->cpi;
+  const int idx = (int)(thread_data - cpi->tile_thr_data);
+  struct vpx_usec_timer timer;
+  int ret;
+
+  vpx_usec_timer_start(&timer);
+  ret = thread_data->hook(thread_data, data2);
+  vpx_usec_timer_mark(&timer);
+  if (idx < VPX_ENC_STAGE_MAX_THREADS)
+    cpi->stage_timing.thread_us[idx] += vpx_usec_timer_elapsed(&timer);
+  return ret;
+}
+#endif  // CONFIG_STAGE_TIMING
+
 static void launch_enc_workers(VP9_COMP *cpi, VPxWorkerHook hook, void *data2,
                                int num_workers) {
   const VPxWorkerInterface *const winterface = vpx_get_worker_interface();
@@ -135,11 +154,22 @@ static void launch_enc_workers(VP9_COMP *cpi, VPxWorkerHook hook, void *data2,
 
   for (i = 0; i < num_workers; i++) {
     VPxWorker *const worker = &cpi->workers[i];
-    worker->hook = (VPxWorkerHook)hook;
     worker->data1 = &cpi->tile_thr_data[i];
     worker->data2 = data2;
+#if CONFIG_STAGE_TIMING
+    cpi->tile_thr_data[i].hook = hook;
+    worker->hook = (VPxWorkerHook)timed_worker_hook;
+#else
+    worker->hook = (VPxWorkerHook)hook;
+#endif
   }
 
+#if CONFIG_STAGE_TIMING
+  cpi->stage_timing.num_threads =
+      VPXMAX(cpi->stage_timing.num_threads,
+             VPXMIN(num_workers, VPX_ENC_STAGE_MAX_THREADS));
+#endif
+
   // Encode a frame
   for (i = 0; i < num_workers; i++) {
     VPxWorker *const worker = &cpi->workers[i];
@@ -254,22 +284,26 @@ static void accumulate_fp_tile_stat(TileDataEnc *tile_data,
 
 // Allocate memory for row synchronization
 void vp9_row_mt_sync_mem_alloc(VP9RowMTSync *row_mt_sync, VP9_COMMON *cm,
-                               int rows) {
+                               vpx_arena *arena, int rows) {
   row_mt_sync->rows = rows;
 #if CONFIG_MULTITHREAD
   {
     int i;
 
-    CHECK_MEM_ERROR(cm, row_mt_sync->mutex_,
-                    vpx_malloc(sizeof(*row_mt_sync->mutex_) * rows));
+    CHECK_MEM_ERROR(
+        cm, row_mt_sync->mutex_,
+        vpx_arena_alloc(arena, sizeof(*row_mt_sync->mutex_) * rows,
+                        sizeof(void *)));
     if (row_mt_sync->mutex_) {
       for (i = 0; i < rows; ++i) {
         pthread_mutex_init(&row_mt_sync->mutex_[i], NULL);
       }
     }
 
-    CHECK_MEM_ERROR(cm, row_mt_sync->cond_,
-                    vpx_malloc(sizeof(*row_mt_sync->cond_) * rows));
+    CHECK_MEM_ERROR(
+        cm, row_mt_sync->cond_,
+        vpx_arena_alloc(arena, sizeof(*row_mt_sync->cond_) * rows,
+                        sizeof(void *)));
     if (row_mt_sync->cond_) {
       for (i = 0; i < rows; ++i) {
         pthread_cond_init(&row_mt_sync->cond_[i], NULL);
@@ -279,13 +313,15 @@ void vp9_row_mt_sync_mem_alloc(VP9RowMTSync *row_mt_sync, VP9_COMMON *cm,
 #endif  // CONFIG_MULTITHREAD
 
   CHECK_MEM_ERROR(cm, row_mt_sync->cur_col,
-                  vpx_malloc(sizeof(*row_mt_sync->cur_col) * rows));
+                  vpx_arena_alloc(arena, sizeof(*row_mt_sync->cur_col) * rows,
+                                  sizeof(int)));
 
   // Set up nsync.
   row_mt_sync->sync_range = 1;
 }
 
-// Deallocate row based multi-threading synchronization related mutex and data
+// Destroy row based multi-threading synchronization related mutex and data.
+// The memory belongs to the arena it was allocated from.
 void vp9_row_mt_sync_mem_dealloc(VP9RowMTSync *row_mt_sync) {
   if (row_mt_sync != NULL) {
 #if CONFIG_MULTITHREAD
@@ -295,16 +331,13 @@ void vp9_row_mt_sync_mem_dealloc(VP9RowMTSync *row_mt_sync) {
       for (i = 0; i < row_mt_sync->rows; ++i) {
         pthread_mutex_destroy(&row_mt_sync->mutex_[i]);
       }
-      vpx_free(row_mt_sync->mutex_);
     }
     if (row_mt_sync->cond_ != NULL) {
       for (i = 0; i < row_mt_sync->rows; ++i) {
         pthread_cond_destroy(&row_mt_sync->cond_[i]);
       }
-      vpx_free(row_mt_sync->cond_);
     }
 #endif  // CONFIG_MULTITHREAD
-    vpx_free(row_mt_sync->cur_col);
     // clear the structure as the source of this call may be dynamic change
     // in tiles in which case this call will be followed by an _alloc()
     // which may fail.
@@ -650,3 +683,36 @@ void vp9_encode_tiles_row_mt(VP9_COMP *cpi) {
     }
   }
 }
+
+#if CONFIG_INTERNAL_STATS
+static int frame_metrics_worker_hook(EncWorkerData *const thread_data,
+                                     FRAME_METRICS_CTX *ctx) {
+  const int num_jobs = vpx_frame_metrics_num_jobs(ctx);
+  int job;
+
+  for (job = thread_data->start; job < num_jobs;
+       job += thread_data->cpi->num_workers)
+    vpx_frame_metrics_job(ctx, job);
+
+  return 0;
+}
+
+void vp9_calc_frame_metrics_mt(VP9_COMP *cpi, const YV12_BUFFER_CONFIG *source,
+                               const YV12_BUFFER_CONFIG *dest, int flags,
+                               uint32_t bd, uint32_t in_bd,
+                               FRAME_METRICS *metrics) {
+  FRAME_METRICS_CTX ctx;
+
+  // Only reuse workers that the encoder already created; the metrics are not
+  // worth spawning threads for.
+  if (cpi->num_workers <= 1) {
+    vpx_frame_metrics_calc(source, dest, flags, bd, in_bd, metrics);
+    return;
+  }
+
+  vpx_frame_metrics_init(&ctx, source, dest, flags, bd, in_bd);
+  launch_enc_workers(cpi, (VPxWorkerHook)frame_metrics_worker_hook, &ctx,
+                     cpi->num_workers);
+  vpx_frame_metrics_finish(&ctx, metrics);
+}
+#endif  // CONFIG_INTERNAL_STATS
@@ -11,6 +11,12 @@
 #ifndef VP9_ENCODER_VP9_ETHREAD_H_
 #define VP9_ENCODER_VP9_ETHREAD_H_
 
+#include "./vpx_config.h"
+#if CONFIG_INTERNAL_STATS
+#include "vpx_dsp/frame_metrics.h"
+#endif
+#include "vpx_util/vpx_thread.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -21,6 +27,7 @@ extern "C" {
 
 struct VP9_COMP;
 struct ThreadData;
+struct vpx_arena;
 
 typedef struct EncWorkerData {
   struct VP9_COMP *cpi;
@@ -28,6 +35,9 @@ typedef struct EncWorkerData {
   int start;
   int thread_id;
   int tile_completion_status[MAX_NUM_TILE_COLS];
+#if CONFIG_STAGE_TIMING
+  VPxWorkerHook hook;  // Job run by timed_worker_hook().
+#endif
 } EncWorkerData;
 
 // Encoder row synchronization
@@ -56,15 +66,26 @@ void vp9_row_mt_sync_read_dummy(VP9RowMTSync *const row_mt_sync, int r, int c);
 void vp9_row_mt_sync_write_dummy(VP9RowMTSync *const row_mt_sync, int r, int c,
                                  const int cols);
 
-// Allocate memory for row based multi-threading synchronization.
+// Allocate memory for row based multi-threading synchronization from |arena|.
 void vp9_row_mt_sync_mem_alloc(VP9RowMTSync *row_mt_sync, struct VP9Common *cm,
-                               int rows);
+                               struct vpx_arena *arena, int rows);
 
-// Deallocate row based multi-threading synchronization related mutex and data.
+// Destroy row based multi-threading synchronization related mutex and data.
 void vp9_row_mt_sync_mem_dealloc(VP9RowMTSync *row_mt_sync);
 
 void vp9_temporal_filter_row_mt(struct VP9_COMP *cpi);
 
+#if CONFIG_INTERNAL_STATS
+// Computes the quality metrics selected by flags (VPX_METRIC_*) between
+// source and dest, spreading the work over the encoder's worker threads when
+// they exist.
+void vp9_calc_frame_metrics_mt(struct VP9_COMP *cpi,
+                               const YV12_BUFFER_CONFIG *source,
+                               const YV12_BUFFER_CONFIG *dest, int flags,
+                               uint32_t bd, uint32_t in_bd,
+                               FRAME_METRICS *metrics);
+#endif  // CONFIG_INTERNAL_STATS
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
@@ -88,6 +88,122 @@ static int input_stats(TWO_PASS *p, FIRSTPASS_STATS *fps) {
   return 1;
 }
 
+// Frame packets of a streamed stats window kept behind stats_in, for the
+// backward looks of the gf group setup, and read beyond the key frame
+// interval, for the forward looks past the end of a group.
+#define STATS_WINDOW_HISTORY (MAX_LAG_BUFFERS * 4)
+#define STATS_WINDOW_LOOKAHEAD (MAX_LAG_BUFFERS * 8)
+
+// Reads the next frame packet of the reader's layer. Returns 0 once all of
+// them have been read or the source comes up short.
+static int read_stats_packet(STATS_READER *reader, FIRSTPASS_STATS *fps) {
+  const size_t packet_sz = sizeof(*fps);
+
+  while (reader->frames_left > 0 &&
+         reader->pos + packet_sz <= reader->source.sz) {
+    if (reader->source.read(reader->source.priv, reader->pos, fps,
+                            packet_sz) != packet_sz)
+      break;
+    reader->pos += packet_sz;
+    if (reader->layer_id < 0 ||
+        (int)fps->spatial_layer_id == reader->layer_id) {
+      --reader->frames_left;
+      return 1;
+    }
+  }
+  reader->frames_left = 0;
+  return 0;
+}
+
+// Drops the packets of the stats window more than STATS_WINDOW_HISTORY behind
+// stats_in.
+static void trim_stats_window(TWO_PASS *twopass) {
+  STATS_WINDOW *const window = twopass->stats_window;
+  const int shift = (int)(twopass->stats_in - twopass->stats_in_start) -
+                    STATS_WINDOW_HISTORY;
+
+  if (shift > 0) {
+    // The totals packet moves along with the frame packets.
+    const int count =
+        (int)(twopass->stats_in_end - twopass->stats_in_start) - shift + 1;
+    memmove(window->buf, window->buf + shift, count * sizeof(*window->buf));
+    twopass->stats_in -= shift;
+    twopass->stats_in_end -= shift;
+  }
+}
+
+// Grows the stats window to hold size frame packets.
+static void grow_stats_window(VP9_COMP *cpi, TWO_PASS *twopass, int size) {
+  STATS_WINDOW *const window = twopass->stats_window;
+
+  if (size > window->buf_size) {
+    const int pos = (int)(twopass->stats_in - twopass->stats_in_start);
+    const int count = (int)(twopass->stats_in_end - twopass->stats_in_start);
+    FIRSTPASS_STATS *buf;
+
+    CHECK_MEM_ERROR(&cpi->common, buf, vpx_malloc((size + 1) * sizeof(*buf)));
+    memcpy(buf, window->buf, (count + 1) * sizeof(*buf));
+    vpx_free(window->buf);
+    window->buf = buf;
+    window->buf_size = size;
+
+    twopass->stats_in_start = buf;
+    twopass->stats_in = buf + pos;
+    twopass->stats_in_end = buf + count;
+  }
+}
+
+// Slides the stats window so that it holds the packets the second pass may
+// look at for the next frame.
+static void refill_stats_window(VP9_COMP *cpi, TWO_PASS *twopass) {
+  STATS_WINDOW *const window = twopass->stats_window;
+  FIRSTPASS_STATS totals;
+  int count;
+
+  trim_stats_window(twopass);
+  count = (int)(twopass->stats_in_end - twopass->stats_in_start);
+  grow_stats_window(
+      cpi, twopass,
+      (int)VPXMIN((int64_t)(twopass->stats_in - twopass->stats_in_start) +
+                      cpi->oxcf.key_freq + STATS_WINDOW_LOOKAHEAD,
+                  count + window->reader.frames_left));
+
+  totals = *twopass->stats_in_end;
+  while (count < window->buf_size &&
+         read_stats_packet(&window->reader, &window->buf[count]))
+    ++count;
+  window->buf[count] = totals;
+  twopass->stats_in_end = window->buf + count;
+}
+
+void vp9_twopass_stream_stats(VP9_COMP *cpi, TWO_PASS *twopass,
+                              const vpx_twopass_stats_source_t *source,
+                              int layer_id, int64_t frame_count,
+                              const FIRSTPASS_STATS *totals) {
+  STATS_WINDOW *window;
+
+  vp9_twopass_free_stats_window(twopass);
+  CHECK_MEM_ERROR(&cpi->common, window, vpx_calloc(1, sizeof(*window)));
+  twopass->stats_window = window;
+  CHECK_MEM_ERROR(&cpi->common, window->buf, vpx_malloc(sizeof(*window->buf)));
+  if (source != NULL) window->reader.source = *source;
+  window->reader.frames_left = frame_count;
+  window->reader.layer_id = layer_id;
+  window->buf[0] = *totals;
+
+  twopass->stats_in_start = window->buf;
+  twopass->stats_in = window->buf;
+  twopass->stats_in_end = window->buf;
+}
+
+void vp9_twopass_free_stats_window(TWO_PASS *twopass) {
+  if (twopass->stats_window != NULL) {
+    vpx_free(twopass->stats_window->buf);
+    vpx_free(twopass->stats_window);
+    twopass->stats_window = NULL;
+  }
+}
+
 static void output_stats(FIRSTPASS_STATS *stats,
                          struct vpx_codec_pkt_list *pktlist) {
   struct vpx_codec_cx_pkt pkt;
@@ -320,6 +436,7 @@ void vp9_end_first_pass(VP9_COMP *cpi) {
 
   vpx_free(cpi->twopass.fp_mb_float_stats);
   cpi->twopass.fp_mb_float_stats = NULL;
+  cpi->twopass.fp_mb_float_stats_mbs = 0;
 }
 
 static vpx_variance_fn_t get_block_variance_fn(BLOCK_SIZE bsize) {
@@ -1453,10 +1570,14 @@ void vp9_first_pass(VP9_COMP *cpi, const struct lookahead_entry *source) {
 
   cm->log2_tile_rows = 0;
 
-  if (cpi->row_mt_bit_exact && cpi->twopass.fp_mb_float_stats == NULL)
+  // Spatial layers share the stats buffer, so it grows to the largest layer.
+  if (cpi->row_mt_bit_exact && cpi->twopass.fp_mb_float_stats_mbs < cm->MBs) {
+    vpx_free(cpi->twopass.fp_mb_float_stats);
     CHECK_MEM_ERROR(
         cm, cpi->twopass.fp_mb_float_stats,
         vpx_calloc(cm->MBs * sizeof(*cpi->twopass.fp_mb_float_stats), 1));
+    cpi->twopass.fp_mb_float_stats_mbs = cm->MBs;
+  }
 
   {
     FIRSTPASS_STATS fps;
@@ -1664,23 +1785,39 @@ void calculate_coded_size(VP9_COMP *cpi, int *scaled_frame_width,
   *scaled_frame_height = rc->frame_height[rc->frame_size_selector];
 }
 
-void vp9_init_second_pass(VP9_COMP *cpi) {
+// Sums frame_score over the frames of the first pass stats. Streamed stats
+// are read through a copy of the window's reader, before the window is
+// first filled.
+static double sum_frame_scores(
+    const VP9_COMP *cpi, const TWO_PASS *twopass,
+    double (*frame_score)(const VP9_COMP *cpi, const TWO_PASS *twopass,
+                          const VP9EncoderConfig *oxcf,
+                          const FIRSTPASS_STATS *this_frame)) {
+  double score_total = 0.0;
+
+  if (twopass->stats_window != NULL) {
+    STATS_READER reader = twopass->stats_window->reader;
+    FIRSTPASS_STATS this_frame;
+    while (read_stats_packet(&reader, &this_frame))
+      score_total += frame_score(cpi, twopass, &cpi->oxcf, &this_frame);
+  } else {
+    const FIRSTPASS_STATS *s;
+    for (s = twopass->stats_in; s < twopass->stats_in_end; ++s)
+      score_total += frame_score(cpi, twopass, &cpi->oxcf, s);
+  }
+  return score_total;
+}
+
+// Sets the bit budget and the frame scores of the second pass from the stats
+// of the whole sequence.
+static void init_second_pass_budget(VP9_COMP *cpi, TWO_PASS *twopass) {
   SVC *const svc = &cpi->svc;
   const VP9EncoderConfig *const oxcf = &cpi->oxcf;
   const int is_two_pass_svc =
       (svc->number_spatial_layers > 1) || (svc->number_temporal_layers > 1);
-  RATE_CONTROL *const rc = &cpi->rc;
-  TWO_PASS *const twopass =
-      is_two_pass_svc ? &svc->layer_context[svc->spatial_layer_id].twopass
-                      : &cpi->twopass;
   double frame_rate;
   FIRSTPASS_STATS *stats;
 
-  zero_stats(&twopass->total_stats);
-  zero_stats(&twopass->total_left_stats);
-
-  if (!twopass->stats_in_end) return;
-
   stats = &twopass->total_stats;
 
   *stats = *twopass->stats_in_end;
@@ -1705,22 +1842,14 @@ void vp9_init_second_pass(VP9_COMP *cpi) {
         (int64_t)(stats->duration * oxcf->target_bandwidth / 10000000.0);
   }
 
-  // This variable monitors how far behind the second ref update is lagging.
-  twopass->sr_update_lag = 1;
-
   // Scan the first pass file and calculate a modified score for each
   // frame that is used to distribute bits. The modified score is assumed
   // to provide a linear basis for bit allocation. I.e a frame A with a score
   // that is double that of frame B will be allocated 2x as many bits.
   {
-    const FIRSTPASS_STATS *s = twopass->stats_in;
-    double modified_score_total = 0.0;
-
     // The first scan is unclamped and gives a raw average.
-    while (s < twopass->stats_in_end) {
-      modified_score_total += calculate_mod_frame_score(cpi, twopass, oxcf, s);
-      ++s;
-    }
+    const double modified_score_total =
+        sum_frame_scores(cpi, twopass, calculate_mod_frame_score);
 
     // The average error from this first scan is used to define the midpoint
     // error for the rate distribution function.
@@ -1730,15 +1859,38 @@ void vp9_init_second_pass(VP9_COMP *cpi) {
     // Second scan using clamps based on the previous cycle average.
     // This may modify the total and average somewhat but we dont bother with
     // further itterations.
-    s = twopass->stats_in;
-    modified_score_total = 0.0;
-    while (s < twopass->stats_in_end) {
-      modified_score_total += calculate_norm_frame_score(cpi, twopass, oxcf, s);
-      ++s;
-    }
-    twopass->normalized_score_left = modified_score_total;
+    twopass->normalized_score_left =
+        sum_frame_scores(cpi, twopass, calculate_norm_frame_score);
+  }
+}
+
+void vp9_init_second_pass(VP9_COMP *cpi) {
+  SVC *const svc = &cpi->svc;
+  const VP9EncoderConfig *const oxcf = &cpi->oxcf;
+  const int is_two_pass_svc =
+      (svc->number_spatial_layers > 1) || (svc->number_temporal_layers > 1);
+  RATE_CONTROL *const rc = &cpi->rc;
+  TWO_PASS *const twopass =
+      is_two_pass_svc ? &svc->layer_context[svc->spatial_layer_id].twopass
+                      : &cpi->twopass;
+
+  zero_stats(&twopass->total_stats);
+  zero_stats(&twopass->total_left_stats);
+
+  if (!twopass->stats_in_end) return;
+
+  if (twopass->stats_window != NULL && twopass->stats_window->live) {
+    // The budget grows as the lookahead pass adds frames.
+    twopass->bits_left = 0;
+    twopass->mean_mod_score = 1.0;
+    twopass->normalized_score_left = 0.0;
+  } else {
+    init_second_pass_budget(cpi, twopass);
   }
 
+  // This variable monitors how far behind the second ref update is lagging.
+  twopass->sr_update_lag = 1;
+
   // Reset the vbr bits off target counters
   rc->vbr_bits_off_target = 0;
   rc->vbr_bits_off_target_fast = 0;
@@ -1763,6 +1915,41 @@ void vp9_init_second_pass(VP9_COMP *cpi) {
   twopass->arnr_strength_adjustment = 0;
 }
 
+void vp9_twopass_live_stats(VP9_COMP *cpi) {
+  FIRSTPASS_STATS totals;
+
+  zero_stats(&totals);
+  vp9_twopass_stream_stats(cpi, &cpi->twopass, NULL, -1, 0, &totals);
+  cpi->twopass.stats_window->live = 1;
+}
+
+void vp9_twopass_add_stats(VP9_COMP *cpi, const FIRSTPASS_STATS *stats) {
+  TWO_PASS *const twopass = &cpi->twopass;
+  STATS_WINDOW *const window = twopass->stats_window;
+  int count;
+
+  trim_stats_window(twopass);
+  count = (int)(twopass->stats_in_end - twopass->stats_in_start);
+  grow_stats_window(cpi, twopass, count + 1);
+
+  accumulate_stats(&twopass->total_stats, stats);
+  accumulate_stats(&twopass->total_left_stats, stats);
+  window->buf[count] = *stats;
+  window->buf[count + 1] = twopass->total_stats;
+  twopass->stats_in_end = window->buf + count + 1;
+
+  // The frame adds its share of the target rate to the budget. Its score is
+  // normalized by the average of the frames analysed so far.
+  twopass->bits_left +=
+      (int64_t)(stats->duration * cpi->oxcf.target_bandwidth / 10000000.0);
+  window->mod_score_total +=
+      calculate_mod_frame_score(cpi, twopass, &cpi->oxcf, stats);
+  twopass->mean_mod_score =
+      window->mod_score_total / twopass->total_stats.count;
+  twopass->normalized_score_left +=
+      calculate_norm_frame_score(cpi, twopass, &cpi->oxcf, stats);
+}
+
 #define SR_DIFF_PART 0.0015
 #define INTRA_PART 0.005
 #define DEFAULT_DECAY_LIMIT 0.75
@@ -3071,6 +3258,8 @@ void vp9_rc_get_second_pass_params(VP9_COMP *cpi) {
 
   if (!twopass->stats_in) return;
 
+  if (twopass->stats_window != NULL) refill_stats_window(cpi, twopass);
+
   // If this is an arf frame then we dont want to read the stats file or
   // advance the input pointer as we already have what we need.
   if (gf_group->update_type[gf_group->index] == ARF_UPDATE) {
@@ -11,6 +11,7 @@
 #ifndef VP9_ENCODER_VP9_FIRSTPASS_H_
 #define VP9_ENCODER_VP9_FIRSTPASS_H_
 
+#include "vpx/vp8cx.h"
 #include "vp9/encoder/vp9_lookahead.h"
 #include "vp9/encoder/vp9_ratectrl.h"
 
@@ -128,6 +129,26 @@ typedef struct {
   int bit_allocation[(MAX_LAG_BUFFERS * 2) + 1];
 } GF_GROUP;
 
+// Sequential reader of the stats packets of a vpx_twopass_stats_source_t.
+typedef struct {
+  vpx_twopass_stats_source_t source;
+  uint64_t pos;        // Byte offset of the next packet.
+  int64_t frames_left; // Frame packets of the layer not read yet.
+  int layer_id;        // Spatial layer of the packets read, -1 for all.
+} STATS_READER;
+
+// Window of streamed stats around stats_in. buf holds the frame packets from
+// stats_in_start to stats_in_end, followed by a copy of the totals packet.
+typedef struct {
+  STATS_READER reader;
+  FIRSTPASS_STATS *buf;
+  int buf_size;  // Frame packets buf can hold.
+  // Set when the packets are added by the lookahead pass as it analyses the
+  // frames, rather than read.
+  int live;
+  double mod_score_total;
+} STATS_WINDOW;
+
 typedef struct {
   unsigned int section_intra_rating;
   FIRSTPASS_STATS total_stats;
@@ -135,6 +156,8 @@ typedef struct {
   const FIRSTPASS_STATS *stats_in;
   const FIRSTPASS_STATS *stats_in_start;
   const FIRSTPASS_STATS *stats_in_end;
+  // Set when the stats are streamed from a source rather than held in full.
+  STATS_WINDOW *stats_window;
   FIRSTPASS_STATS total_left_stats;
   int first_pass_done;
   int64_t bits_left;
@@ -150,6 +173,7 @@ typedef struct {
 #endif
 
   FP_MB_FLOAT_STATS *fp_mb_float_stats;
+  int fp_mb_float_stats_mbs;
 
   // An indication of the content type of the current frame
   FRAME_CONTENT_TYPE fr_content_type;
@@ -192,6 +216,23 @@ void vp9_first_pass_encode_tile_mb_row(struct VP9_COMP *cpi,
                                        struct TileDataEnc *tile_data,
                                        MV *best_ref_mv, int mb_row);
 
+// Points the second pass of twopass at the frame_count frame packets of
+// spatial layer layer_id (-1 for all packets) in source, described by the
+// totals packet. source may be NULL when frame_count is 0.
+// vp9_init_second_pass() must be called afterwards.
+void vp9_twopass_stream_stats(struct VP9_COMP *cpi, TWO_PASS *twopass,
+                              const vpx_twopass_stats_source_t *source,
+                              int layer_id, int64_t frame_count,
+                              const FIRSTPASS_STATS *totals);
+void vp9_twopass_free_stats_window(TWO_PASS *twopass);
+
+// Points the second pass at the stats added by vp9_twopass_add_stats() as the
+// lookahead pass analyses the frames. The bit budget and the frame scores
+// grow with each frame added. vp9_init_second_pass() must be called
+// afterwards.
+void vp9_twopass_live_stats(struct VP9_COMP *cpi);
+void vp9_twopass_add_stats(struct VP9_COMP *cpi, const FIRSTPASS_STATS *stats);
+
 void vp9_init_second_pass(struct VP9_COMP *cpi);
 void vp9_rc_get_second_pass_params(struct VP9_COMP *cpi);
 void vp9_twopass_postencode_update(struct VP9_COMP *cpi);
@@ -52,7 +52,7 @@ struct lookahead_ctx *vp9_lookahead_init(unsigned int width,
   struct lookahead_ctx *ctx = NULL;
 
   // Clamp the lookahead queue depth
-  depth = clamp(depth, 1, MAX_LAG_BUFFERS);
+  depth = clamp(depth, 1, MAX_LAG_BUFFERS + MAX_LOOKAHEAD_PASS_FRAMES);
 
   // Allocate memory to keep previous source frames available.
   depth += MAX_PRE_FRAMES;
@@ -25,6 +25,11 @@ extern "C" {
 
 #define MAX_LAG_BUFFERS 25
 
+// The range of frames the lookahead pass analyses ahead of the lag. The key
+// frame search looks up to 16 frames past a group.
+#define MIN_LOOKAHEAD_PASS_FRAMES 32
+#define MAX_LOOKAHEAD_PASS_FRAMES 600
+
 struct lookahead_entry {
   YV12_BUFFER_CONFIG img;
   int64_t ts_start;
@@ -53,6 +53,7 @@ void *vp9_enc_grp_get_next_job(MultiThreadHandle *multi_thread_ctxt,
 void vp9_row_mt_mem_alloc(VP9_COMP *cpi) {
   struct VP9Common *cm = &cpi->common;
   MultiThreadHandle *multi_thread_ctxt = &cpi->multi_thread_ctxt;
+  vpx_arena *const arena = &multi_thread_ctxt->arena;
   int tile_row, tile_col;
   const int tile_cols = 1 << cm->log2_tile_cols;
   const int tile_rows = 1 << cm->log2_tile_rows;
@@ -67,8 +68,9 @@ void vp9_row_mt_mem_alloc(VP9_COMP *cpi) {
   multi_thread_ctxt->allocated_tile_rows = tile_rows;
   multi_thread_ctxt->allocated_vert_unit_rows = jobs_per_tile_col;
 
-  multi_thread_ctxt->job_queue =
-      (JobQueue *)vpx_memalign(32, total_jobs * sizeof(JobQueue));
+  CHECK_MEM_ERROR(
+      cm, multi_thread_ctxt->job_queue,
+      (JobQueue *)vpx_arena_alloc(arena, total_jobs * sizeof(JobQueue), 32));
 
 #if CONFIG_MULTITHREAD
   // Create mutex for each tile
@@ -81,14 +83,19 @@ void vp9_row_mt_mem_alloc(VP9_COMP *cpi) {
   // Allocate memory for row based multi-threading
   for (tile_col = 0; tile_col < tile_cols; tile_col++) {
     TileDataEnc *this_tile = &cpi->tile_data[tile_col];
-    vp9_row_mt_sync_mem_alloc(&this_tile->row_mt_sync, cm, jobs_per_tile_col);
+    vp9_row_mt_sync_mem_alloc(&this_tile->row_mt_sync, cm, arena,
+                              jobs_per_tile_col);
     if (cpi->sf.adaptive_rd_thresh_row_mt) {
       const int sb_rows =
           (mi_cols_aligned_to_sb(cm->mi_rows) >> MI_BLOCK_SIZE_LOG2) + 1;
       int i;
-      this_tile->row_base_thresh_freq_fact =
-          (int *)vpx_calloc(sb_rows * BLOCK_SIZES * MAX_MODES,
-                            sizeof(*(this_tile->row_base_thresh_freq_fact)));
+      CHECK_MEM_ERROR(
+          cm, this_tile->row_base_thresh_freq_fact,
+          (int *)vpx_arena_alloc(
+              arena,
+              sb_rows * BLOCK_SIZES * MAX_MODES *
+                  sizeof(*(this_tile->row_base_thresh_freq_fact)),
+              sizeof(int)));
       for (i = 0; i < sb_rows * BLOCK_SIZES * MAX_MODES; i++)
         this_tile->row_base_thresh_freq_fact[i] = RD_THRESH_INIT_FACT;
     }
@@ -102,25 +109,17 @@ void vp9_row_mt_mem_alloc(VP9_COMP *cpi) {
       this_tile->row_mt_sync = this_col_tile->row_mt_sync;
     }
   }
-
-  // Calculate the number of vertical units in the given tile row
-  for (tile_row = 0; tile_row < tile_rows; tile_row++) {
-    TileDataEnc *this_tile = &cpi->tile_data[tile_row * tile_cols];
-    TileInfo *tile_info = &this_tile->tile_info;
-    multi_thread_ctxt->num_tile_vert_sbs[tile_row] =
-        get_num_vert_units(*tile_info, MI_BLOCK_SIZE_LOG2);
-  }
 }
 
+// The buffers live in multi_thread_ctxt->arena. It is reset rather than
+// freed, so reallocating for the same or a smaller frame size, or for the
+// first pass and temporal filter jobs, does not call the allocator again.
 void vp9_row_mt_mem_dealloc(VP9_COMP *cpi) {
   MultiThreadHandle *multi_thread_ctxt = &cpi->multi_thread_ctxt;
   int tile_col;
-#if CONFIG_MULTITHREAD
   int tile_row;
-#endif
 
-  // Deallocate memory for job queue
-  if (multi_thread_ctxt->job_queue) vpx_free(multi_thread_ctxt->job_queue);
+  multi_thread_ctxt->job_queue = NULL;
 
 #if CONFIG_MULTITHREAD
   // Destroy mutex for each tile
@@ -131,14 +130,13 @@ void vp9_row_mt_mem_dealloc(VP9_COMP *cpi) {
   }
 #endif
 
-  // Free row based multi-threading sync memory
+  // Release row based multi-threading sync objects
   for (tile_col = 0; tile_col < multi_thread_ctxt->allocated_tile_cols;
        tile_col++) {
     TileDataEnc *this_tile = &cpi->tile_data[tile_col];
     vp9_row_mt_sync_mem_dealloc(&this_tile->row_mt_sync);
   }
 
-#if CONFIG_MULTITHREAD
   for (tile_row = 0; tile_row < multi_thread_ctxt->allocated_tile_rows;
        tile_row++) {
     for (tile_col = 0; tile_col < multi_thread_ctxt->allocated_tile_cols;
@@ -146,15 +144,14 @@ void vp9_row_mt_mem_dealloc(VP9_COMP *cpi) {
       TileDataEnc *this_tile =
           &cpi->tile_data[tile_row * multi_thread_ctxt->allocated_tile_cols +
                           tile_col];
-      if (cpi->sf.adaptive_rd_thresh_row_mt) {
-        if (this_tile->row_base_thresh_freq_fact != NULL) {
-          vpx_free(this_tile->row_base_thresh_freq_fact);
-          this_tile->row_base_thresh_freq_fact = NULL;
-        }
-      }
+      this_tile->row_base_thresh_freq_fact = NULL;
     }
   }
-#endif
+
+  multi_thread_ctxt->allocated_tile_cols = 0;
+  multi_thread_ctxt->allocated_tile_rows = 0;
+  multi_thread_ctxt->allocated_vert_unit_rows = 0;
+  vpx_arena_reset(&multi_thread_ctxt->arena);
 }
 
 void vp9_multi_thread_tile_init(VP9_COMP *cpi) {
@@ -219,11 +216,22 @@ void vp9_prepare_job_queue(VP9_COMP *cpi, JOB_TYPE job_type) {
   MultiThreadHandle *multi_thread_ctxt = &cpi->multi_thread_ctxt;
   JobQueue *job_queue = multi_thread_ctxt->job_queue;
   const int tile_cols = 1 << cm->log2_tile_cols;
+  const int tile_rows = 1 << cm->log2_tile_rows;
   int job_row_num, jobs_per_tile, jobs_per_tile_col, total_jobs;
   const int sb_rows = mi_cols_aligned_to_sb(cm->mi_rows) >> MI_BLOCK_SIZE_LOG2;
-  int tile_col, i;
+  int tile_col, tile_row, i;
 
   jobs_per_tile_col = (job_type != ENCODE_JOB) ? cm->mb_rows : sb_rows;
+
+  // Calculate the number of vertical units in the given tile row. The frame
+  // size can change between calls, e.g. across spatial layers.
+  for (tile_row = 0; tile_row < tile_rows; tile_row++) {
+    TileDataEnc *this_tile = &cpi->tile_data[tile_row * tile_cols];
+    TileInfo *tile_info = &this_tile->tile_info;
+    multi_thread_ctxt->num_tile_vert_sbs[tile_row] =
+        get_num_vert_units(*tile_info, MI_BLOCK_SIZE_LOG2);
+  }
+
   total_jobs = jobs_per_tile_col * tile_cols;
 
   multi_thread_ctxt->jobs_per_tile_col = jobs_per_tile_col;
@@ -234,7 +242,8 @@ void vp9_prepare_job_queue(VP9_COMP *cpi, JOB_TYPE job_type) {
   for (tile_col = 0; tile_col < tile_cols; tile_col++) {
     RowMTInfo *tile_ctxt = &multi_thread_ctxt->row_mt_info[tile_col];
     JobQueue *job_queue_curr, *job_queue_temp;
-    int tile_row = 0;
+
+    tile_row = 0;
 
     tile_ctxt->job_queue_hdl.next = (void *)job_queue;
     tile_ctxt->job_queue_hdl.num_jobs_acquired = 0;
@@ -58,6 +58,7 @@ static int mv_refs_rt(VP9_COMP *cpi, const VP9_COMMON *cm, const MACROBLOCK *x,
   int different_ref_found = 0;
   int context_counter = 0;
   int const_motion = 0;
+  MV_REF_CANDIDATE tmp;
 
   // Blank the reference vector list
   memset(mv_ref_list, 0, sizeof(*mv_ref_list) * MAX_MV_REF_CANDIDATES);
@@ -68,15 +69,14 @@ static int mv_refs_rt(VP9_COMP *cpi, const VP9_COMMON *cm, const MACROBLOCK *x,
   for (i = 0; i < 2; ++i) {
     const POSITION *const mv_ref = &mv_ref_search[i];
     if (is_inside(tile, mi_col, mi_row, cm->mi_rows, mv_ref)) {
-      const MODE_INFO *const candidate_mi =
-          xd->mi[mv_ref->col + mv_ref->row * xd->mi_stride];
+      const MV_REF_CANDIDATE *const candidate =
+          get_mv_ref_candidate(xd, mi_row, mi_col, mv_ref, &tmp);
       // Keep counts for entropy encoding.
-      context_counter += mode_2_counter[candidate_mi->mode];
+      context_counter += mode_2_counter[candidate->mode];
       different_ref_found = 1;
 
-      if (candidate_mi->ref_frame[0] == ref_frame)
-        ADD_MV_REF_LIST(get_sub_block_mv(candidate_mi, 0, mv_ref->col, -1),
-                        refmv_count, mv_ref_list, Done);
+      if (candidate->ref_frame[0] == ref_frame)
+        ADD_MV_REF_LIST(candidate->mv[0], refmv_count, mv_ref_list, Done);
     }
   }
 
@@ -88,12 +88,12 @@ static int mv_refs_rt(VP9_COMP *cpi, const VP9_COMMON *cm, const MACROBLOCK *x,
   for (; i < MVREF_NEIGHBOURS && !refmv_count; ++i) {
     const POSITION *const mv_ref = &mv_ref_search[i];
     if (is_inside(tile, mi_col, mi_row, cm->mi_rows, mv_ref)) {
-      const MODE_INFO *const candidate_mi =
-          xd->mi[mv_ref->col + mv_ref->row * xd->mi_stride];
+      const MV_REF_CANDIDATE *const candidate =
+          get_mv_ref_candidate(xd, mi_row, mi_col, mv_ref, &tmp);
       different_ref_found = 1;
 
-      if (candidate_mi->ref_frame[0] == ref_frame)
-        ADD_MV_REF_LIST(candidate_mi->mv[0], refmv_count, mv_ref_list, Done);
+      if (candidate->ref_frame[0] == ref_frame)
+        ADD_MV_REF_LIST(candidate->mv[0], refmv_count, mv_ref_list, Done);
     }
   }
 
@@ -104,11 +104,11 @@ static int mv_refs_rt(VP9_COMP *cpi, const VP9_COMMON *cm, const MACROBLOCK *x,
     for (i = 0; i < MVREF_NEIGHBOURS; ++i) {
       const POSITION *mv_ref = &mv_ref_search[i];
       if (is_inside(tile, mi_col, mi_row, cm->mi_rows, mv_ref)) {
-        const MODE_INFO *const candidate_mi =
-            xd->mi[mv_ref->col + mv_ref->row * xd->mi_stride];
+        const MV_REF_CANDIDATE *const candidate =
+            get_mv_ref_candidate(xd, mi_row, mi_col, mv_ref, &tmp);
 
         // If the candidate is INTRA we don't want to consider its mv.
-        IF_DIFF_REF_FRAME_ADD_MV(candidate_mi, ref_frame, ref_sign_bias,
+        IF_DIFF_REF_FRAME_ADD_MV(candidate, ref_frame, ref_sign_bias,
                                  refmv_count, mv_ref_list, Done);
       }
     }
@@ -32,6 +32,35 @@ static const uint8_t update_bits[255] = {
 };
 #define MIN_DELP_BITS 5
 
+// Costs of coding a zero and a one with each model node probability of each
+// pareto row, interleaved like the branch counts they are multiplied with.
+// Built by vp9_subexp_init().
+static uint16_t pareto_costs[COEFF_PROB_MODELS][2 * MODEL_NODES];
+
+void vp9_subexp_init(void) {
+  int i, j;
+
+  for (i = 0; i < COEFF_PROB_MODELS; ++i) {
+    for (j = 0; j < MODEL_NODES; ++j) {
+      pareto_costs[i][2 * j] = vp9_cost_zero(vp9_pareto8_full[i][j]);
+      pareto_costs[i][2 * j + 1] = vp9_cost_one(vp9_pareto8_full[i][j]);
+    }
+  }
+}
+
+// Cost of the model nodes for pivot probability p, given the branch counts
+// of those nodes. A plain dot product, so it vectorizes; the sum wraps like
+// the cost_branch256() sums it replaces.
+static INLINE unsigned int model_nodes_cost(const unsigned int *ct,
+                                            vpx_prob p) {
+  const uint16_t *const costs = pareto_costs[p - 1];
+  unsigned int cost = 0;
+  int i;
+
+  for (i = 0; i < 2 * MODEL_NODES; ++i) cost += ct[i] * costs[i];
+  return cost;
+}
+
 static int recenter_nonneg(int v, int m) {
   if (v > (m << 1))
     return v;
@@ -140,17 +169,15 @@ int vp9_prob_diff_update_savings_search_model(const unsigned int *ct,
                                               const vpx_prob oldp,
                                               vpx_prob *bestp, vpx_prob upd,
                                               int stepsize) {
-  int i, old_b, new_b, update_b, savings, bestsavings;
+  int old_b, new_b, update_b, savings, bestsavings;
   int newp;
   const int step_sign = *bestp > oldp ? -1 : 1;
   const int step = stepsize * step_sign;
   const int upd_cost = vp9_cost_one(upd) - vp9_cost_zero(upd);
-  const vpx_prob *newplist, *oldplist;
+  const unsigned int *const model_ct = ct + 2 * UNCONSTRAINED_NODES;
   vpx_prob bestnewp;
-  oldplist = vp9_pareto8_full[oldp - 1];
-  old_b = cost_branch256(ct + 2 * PIVOT_NODE, oldp);
-  for (i = UNCONSTRAINED_NODES; i < ENTROPY_NODES; ++i)
-    old_b += cost_branch256(ct + 2 * i, oldplist[i - UNCONSTRAINED_NODES]);
+  old_b = cost_branch256(ct + 2 * PIVOT_NODE, oldp) +
+          model_nodes_cost(model_ct, oldp);
 
   bestsavings = 0;
   bestnewp = oldp;
@@ -160,10 +187,8 @@ int vp9_prob_diff_update_savings_search_model(const unsigned int *ct,
   if (old_b > upd_cost + (MIN_DELP_BITS << VP9_PROB_COST_SHIFT)) {
     for (newp = *bestp; (newp - oldp) * step_sign < 0; newp += step) {
       if (newp < 1 || newp > 255) continue;
-      newplist = vp9_pareto8_full[newp - 1];
-      new_b = cost_branch256(ct + 2 * PIVOT_NODE, newp);
-      for (i = UNCONSTRAINED_NODES; i < ENTROPY_NODES; ++i)
-        new_b += cost_branch256(ct + 2 * i, newplist[i - UNCONSTRAINED_NODES]);
+      new_b = cost_branch256(ct + 2 * PIVOT_NODE, newp) +
+              model_nodes_cost(model_ct, newp);
       update_b = prob_diff_update_cost(newp, oldp) + upd_cost;
       savings = old_b - new_b - update_b;
       if (savings > bestsavings) {
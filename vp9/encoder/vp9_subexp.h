@@ -19,6 +19,8 @@ extern "C" {
 
 struct vpx_writer;
 
+void vp9_subexp_init(void);
+
 void vp9_write_prob_diff_update(struct vpx_writer *w, vpx_prob newp,
                                 vpx_prob oldp);
 
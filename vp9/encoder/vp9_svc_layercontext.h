@@ -30,7 +30,6 @@ typedef struct {
   int scaling_factor_num;
   int scaling_factor_den;
   TWO_PASS twopass;
-  vpx_fixed_buf_t rc_twopass_stats_in;
   unsigned int current_video_frame_in_layer;
   int is_key_frame;
   int frames_from_key_frame;
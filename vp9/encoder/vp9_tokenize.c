@@ -326,20 +326,18 @@ static void set_entropy_context_b(int plane, int block, int row, int col,
   vp9_set_contexts(xd, pd, plane_bsize, tx_size, p->eobs[block] > 0, col, row);
 }
 
-static INLINE void add_token(TOKENEXTRA **t, const vpx_prob *context_tree,
-                             int16_t token, EXTRABIT extra,
-                             unsigned int *counts) {
-  (*t)->context_tree = context_tree;
+static INLINE void add_token(TOKENEXTRA **t, int context, int16_t token,
+                             EXTRABIT extra, unsigned int *counts) {
+  (*t)->context = context;
   (*t)->token = token;
   (*t)->extra = extra;
   (*t)++;
   ++counts[token];
 }
 
-static INLINE void add_token_no_extra(TOKENEXTRA **t,
-                                      const vpx_prob *context_tree,
+static INLINE void add_token_no_extra(TOKENEXTRA **t, int context,
                                       int16_t token, unsigned int *counts) {
-  (*t)->context_tree = context_tree;
+  (*t)->context = context;
   (*t)->token = token;
   (*t)++;
   ++counts[token];
@@ -348,7 +346,6 @@ static INLINE void add_token_no_extra(TOKENEXTRA **t,
 static void tokenize_b(int plane, int block, int row, int col,
                        BLOCK_SIZE plane_bsize, TX_SIZE tx_size, void *arg) {
   struct tokenize_b_args *const args = arg;
-  VP9_COMP *cpi = args->cpi;
   ThreadData *const td = args->td;
   MACROBLOCK *const x = &td->mb;
   MACROBLOCKD *const xd = &x->e_mbd;
@@ -368,8 +365,10 @@ static void tokenize_b(int plane, int block, int row, int col,
   const int ref = is_inter_block(mi);
   unsigned int(*const counts)[COEFF_CONTEXTS][ENTROPY_TOKENS] =
       td->rd_counts.coef_counts[tx_size][type][ref];
-  vpx_prob(*const coef_probs)[COEFF_CONTEXTS][UNCONSTRAINED_NODES] =
-      cpi->common.fc->coef_probs[tx_size][type][ref];
+  // Context index of the first band of fc->coef_probs[tx_size][type][ref].
+  const int context_base =
+      ((tx_size * PLANE_TYPES + type) * REF_TYPES + ref) * COEF_BANDS *
+      COEFF_CONTEXTS;
   unsigned int(*const eob_branch)[COEFF_CONTEXTS] =
       td->counts->eob_branch[tx_size][type][ref];
   const uint8_t *const band = get_band_translate(tx_size);
@@ -389,8 +388,8 @@ static void tokenize_b(int plane, int block, int row, int col,
     ++eob_branch[band[c]][pt];
 
     while (!v) {
-      add_token_no_extra(&t, coef_probs[band[c]][pt], ZERO_TOKEN,
-                         counts[band[c]][pt]);
+      add_token_no_extra(&t, context_base + band[c] * COEFF_CONTEXTS + pt,
+                         ZERO_TOKEN, counts[band[c]][pt]);
 
       token_cache[scan[c]] = 0;
       ++c;
@@ -400,7 +399,8 @@ static void tokenize_b(int plane, int block, int row, int col,
 
     vp9_get_token_extra(v, &token, &extra);
 
-    add_token(&t, coef_probs[band[c]][pt], token, extra, counts[band[c]][pt]);
+    add_token(&t, context_base + band[c] * COEFF_CONTEXTS + pt, token, extra,
+              counts[band[c]][pt]);
 
     token_cache[scan[c]] = vp9_pt_energy_class[token];
     ++c;
@@ -408,8 +408,8 @@ static void tokenize_b(int plane, int block, int row, int col,
   }
   if (c < tx_eob) {
     ++eob_branch[band[c]][pt];
-    add_token_no_extra(&t, coef_probs[band[c]][pt], EOB_TOKEN,
-                       counts[band[c]][pt]);
+    add_token_no_extra(&t, context_base + band[c] * COEFF_CONTEXTS + pt,
+                       EOB_TOKEN, counts[band[c]][pt]);
   }
 
   *tp = t;
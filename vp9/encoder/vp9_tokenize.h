@@ -34,7 +34,10 @@ typedef struct {
 } TOKENVALUE;
 
 typedef struct {
-  const vpx_prob *context_tree;
+  // Index of the token's probabilities in the flattened frame context
+  // coef_probs, in units of UNCONSTRAINED_NODES. An index rather than a
+  // pointer keeps the worst-case sized token buffers small.
+  uint16_t context;
   int16_t token;
   EXTRABIT extra;
 } TOKENEXTRA;
@@ -10,9 +10,14 @@
 
 #include <tmmintrin.h>  // SSSE3
 
+#include <assert.h>
+#include <string.h>
+
 #include "./vp9_rtcd.h"
 #include "./vpx_dsp_rtcd.h"
 #include "./vpx_scale_rtcd.h"
+#include "vp9/common/vp9_filter.h"
+#include "vpx_mem/vpx_mem.h"
 #include "vpx_scale/yv12config.h"
 
 extern void vp9_scale_and_extend_frame_c(const YV12_BUFFER_CONFIG *src,
@@ -168,6 +173,271 @@ static void upsample_1_to_2_ssse3(const uint8_t *src, ptrdiff_t src_stride,
   }
 }
 
+// The 8-tap paths below add the products of the tap pairs in the same order
+// as vpx_scaled_2d_ssse3(), so the results match vp9_scale_and_extend_frame_c().
+// A kernel with a 128 tap does not fit _mm_maddubs_epi16(); the callers copy
+// the pixel instead of filtering with the full-pixel kernel.
+static INLINE void load_kernel_pairs(const int16_t *kernel, __m128i *f) {
+  const __m128i f_values = _mm_load_si128((const __m128i *)kernel);
+  f[0] = _mm_shuffle_epi8(f_values, _mm_set1_epi16(0x0200u));
+  f[1] = _mm_shuffle_epi8(f_values, _mm_set1_epi16(0x0604u));
+  f[2] = _mm_shuffle_epi8(f_values, _mm_set1_epi16(0x0a08u));
+  f[3] = _mm_shuffle_epi8(f_values, _mm_set1_epi16(0x0e0cu));
+}
+
+static INLINE __m128i sum_tap_pairs(__m128i x0, __m128i x1, __m128i x2,
+                                    __m128i x3) {
+  __m128i temp = _mm_adds_epi16(x0, x3);
+  temp = _mm_adds_epi16(temp, _mm_min_epi16(x1, x2));
+  temp = _mm_adds_epi16(temp, _mm_max_epi16(x1, x2));
+  return _mm_mulhrs_epi16(temp, _mm_set1_epi16(1 << 8));
+}
+
+// Filters w columns vertically with one kernel. src points to the first of
+// the 8 source rows and w is a multiple of 8.
+static void filter_vert_row(const uint8_t *src, ptrdiff_t src_stride,
+                            uint8_t *dst, const __m128i *f, int w) {
+  int x;
+  for (x = 0; x + 16 <= w; x += 16) {
+    __m128i r[8], lo[4], hi[4];
+    int i;
+    for (i = 0; i < 8; ++i)
+      r[i] = _mm_loadu_si128((const __m128i *)(src + i * src_stride + x));
+    for (i = 0; i < 4; ++i) {
+      lo[i] = _mm_maddubs_epi16(_mm_unpacklo_epi8(r[2 * i], r[2 * i + 1]),
+                                f[i]);
+      hi[i] = _mm_maddubs_epi16(_mm_unpackhi_epi8(r[2 * i], r[2 * i + 1]),
+                                f[i]);
+    }
+    _mm_storeu_si128(
+        (__m128i *)(dst + x),
+        _mm_packus_epi16(sum_tap_pairs(lo[0], lo[1], lo[2], lo[3]),
+                         sum_tap_pairs(hi[0], hi[1], hi[2], hi[3])));
+  }
+  if (x < w) {
+    __m128i lo[4], res;
+    int i;
+    for (i = 0; i < 4; ++i) {
+      const __m128i a =
+          _mm_loadl_epi64((const __m128i *)(src + 2 * i * src_stride + x));
+      const __m128i b = _mm_loadl_epi64(
+          (const __m128i *)(src + (2 * i + 1) * src_stride + x));
+      lo[i] = _mm_maddubs_epi16(_mm_unpacklo_epi8(a, b), f[i]);
+    }
+    res = sum_tap_pairs(lo[0], lo[1], lo[2], lo[3]);
+    _mm_storel_epi64((__m128i *)(dst + x), _mm_packus_epi16(res, res));
+  }
+}
+
+// Filters a row down by 2:1 with one kernel. Output pixel x uses the source
+// pixels 2 * x - 3 to 2 * x + 4 and src points to pixel -3. w is a multiple of
+// 16.
+static void filter_row_2_to_1(const uint8_t *src, uint8_t *dst,
+                              const __m128i *f, int w) {
+  int x;
+  for (x = 0; x < w; x += 16) {
+    __m128i res[2];
+    int i;
+    for (i = 0; i < 2; ++i) {
+      const uint8_t *const s = src + 2 * x + 16 * i;
+      // Loading at s + 2 * j lines the pairs of taps 2 * j and 2 * j + 1 up
+      // with _mm_maddubs_epi16().
+      const __m128i x0 =
+          _mm_maddubs_epi16(_mm_loadu_si128((const __m128i *)s), f[0]);
+      const __m128i x1 =
+          _mm_maddubs_epi16(_mm_loadu_si128((const __m128i *)(s + 2)), f[1]);
+      const __m128i x2 =
+          _mm_maddubs_epi16(_mm_loadu_si128((const __m128i *)(s + 4)), f[2]);
+      const __m128i x3 =
+          _mm_maddubs_epi16(_mm_loadu_si128((const __m128i *)(s + 6)), f[3]);
+      res[i] = sum_tap_pairs(x0, x1, x2, x3);
+    }
+    _mm_storeu_si128((__m128i *)(dst + x), _mm_packus_epi16(res[0], res[1]));
+  }
+}
+
+// 2:1 downscaling where every output pixel uses the same sub-pixel kernel,
+// which is the case for all phases other than 0. Returns 0 if the
+// intermediate buffer cannot be allocated.
+static int scale_plane_2_to_1_phase(const uint8_t *src, int src_stride,
+                                    uint8_t *dst, int dst_stride, int w, int h,
+                                    const int16_t *kernel) {
+  const int w16 = (w + 15) & ~15;
+  const int temp_h = 2 * h + SUBPEL_TAPS - 2;
+  uint8_t *const temp = (uint8_t *)vpx_malloc(w16 * temp_h);
+  __m128i f[4];
+  int y;
+
+  if (temp == NULL) return 0;
+  load_kernel_pairs(kernel, f);
+
+  src -= (SUBPEL_TAPS / 2 - 1) * src_stride + SUBPEL_TAPS / 2 - 1;
+  for (y = 0; y < temp_h; ++y)
+    filter_row_2_to_1(src + y * src_stride, temp + y * w16, f, w16);
+  for (y = 0; y < h; ++y)
+    filter_vert_row(temp + 2 * y * w16, w16, dst + y * dst_stride, f, w16);
+
+  vpx_free(temp);
+  return 1;
+}
+
+// Positions and sub-pixel phases of the first n pixels of a row or column as
+// computed by vp9_scale_and_extend_frame_c(), which scales blocks of 16x16
+// luma pixels (8x8 for subsampled chroma) with vpx_scaled_2d().
+static void get_scale_positions(int n, int factor, int src_len, int dst_len,
+                                int phase_scaler, int *pos, int *phase) {
+  const int block = 16 / factor;
+  const int step = 16 * src_len / dst_len;
+  int i;
+  for (i = 0; i < n; ++i) {
+    const int x = i / block * 16;
+    const int x_q4 = x * block * src_len / dst_len + phase_scaler;
+    const int q4 = (x_q4 & SUBPEL_MASK) + i % block * step;
+    pos[i] = (x / factor) * src_len / dst_len + (q4 >> SUBPEL_BITS);
+    phase[i] = q4 & SUBPEL_MASK;
+  }
+}
+
+// Horizontal filter setup for a group of 8 output pixels. With steps of up to
+// 2 pixels the 8 source windows of a group start at most 14 pixels apart, so
+// for each pair of taps one load from src + offset + 2 * pair and a byte
+// shuffle line up the pixels of all 8 windows.
+typedef struct {
+  uint8_t shuffle[16];
+  // Same as shuffle for the pair of taps 2 and 3, but full-pixel outputs use
+  // tap 3 twice: their kernel has a single 128 tap, which is split in two 64
+  // taps as it does not fit a signed byte.
+  uint8_t shuffle_23[16];
+  int8_t taps[4][16];
+  int offset;
+} ScaleColumnGroup;
+
+static void setup_column_groups(ScaleColumnGroup *groups, int num_groups,
+                                const int *x_pos, const int *x_phase,
+                                const InterpKernel *kernel) {
+  int g, i;
+  for (g = 0; g < num_groups; ++g) {
+    ScaleColumnGroup *const group = &groups[g];
+    const int *const pos = &x_pos[g * 8];
+    const int *const phase = &x_phase[g * 8];
+    group->offset = pos[0] - (SUBPEL_TAPS / 2 - 1);
+    for (i = 0; i < 8; ++i) {
+      const int d = pos[i] - pos[0];
+      int j;
+      assert(d + 1 < 16);
+      group->shuffle[2 * i] = d;
+      group->shuffle[2 * i + 1] = d + 1;
+      group->shuffle_23[2 * i] = phase[i] ? d : d + 1;
+      group->shuffle_23[2 * i + 1] = d + 1;
+      for (j = 0; j < 4; ++j) {
+        group->taps[j][2 * i] =
+            phase[i] ? (int8_t)kernel[phase[i]][2 * j] : (j == 1 ? 64 : 0);
+        group->taps[j][2 * i + 1] =
+            phase[i] ? (int8_t)kernel[phase[i]][2 * j + 1] : (j == 1 ? 64 : 0);
+      }
+    }
+  }
+}
+
+static INLINE __m128i filter_column_group(const uint8_t *src,
+                                          const ScaleColumnGroup *group) {
+  const uint8_t *const s = src + group->offset;
+  const __m128i shuffle = _mm_loadu_si128((const __m128i *)group->shuffle);
+  const __m128i shuffle_23 =
+      _mm_loadu_si128((const __m128i *)group->shuffle_23);
+  const __m128i x0 = _mm_maddubs_epi16(
+      _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)s), shuffle),
+      _mm_loadu_si128((const __m128i *)group->taps[0]));
+  const __m128i x1 = _mm_maddubs_epi16(
+      _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(s + 2)), shuffle_23),
+      _mm_loadu_si128((const __m128i *)group->taps[1]));
+  const __m128i x2 = _mm_maddubs_epi16(
+      _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(s + 4)), shuffle),
+      _mm_loadu_si128((const __m128i *)group->taps[2]));
+  const __m128i x3 = _mm_maddubs_epi16(
+      _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(s + 6)), shuffle),
+      _mm_loadu_si128((const __m128i *)group->taps[3]));
+  return sum_tap_pairs(x0, x1, x2, x3);
+}
+
+static void filter_row_general(const uint8_t *src, uint8_t *dst,
+                               const ScaleColumnGroup *groups,
+                               int num_groups) {
+  int g;
+  for (g = 0; g + 2 <= num_groups; g += 2) {
+    _mm_storeu_si128((__m128i *)(dst + g * 8),
+                     _mm_packus_epi16(filter_column_group(src, &groups[g]),
+                                      filter_column_group(src, &groups[g + 1])));
+  }
+  if (g < num_groups) {
+    const __m128i res = filter_column_group(src, &groups[g]);
+    _mm_storel_epi64((__m128i *)(dst + g * 8), _mm_packus_epi16(res, res));
+  }
+}
+
+// Scales a plane with any ratio supported by vp9_scale_and_extend_frame_c(),
+// reproducing the positions and kernels of its blocks. Returns 0 if the
+// buffers cannot be allocated.
+static int scale_plane_general(const uint8_t *src, int src_stride,
+                               uint8_t *dst, int dst_stride, int w, int h,
+                               int factor, int src_w, int src_h, int dst_w,
+                               int dst_h, const InterpKernel *kernel,
+                               int phase_scaler) {
+  const int w8 = (w + 7) & ~7;
+  const int num_groups = w8 / 8;
+  int *const x_pos = (int *)vpx_malloc(w8 * 2 * sizeof(*x_pos));
+  int *const y_pos = (int *)vpx_malloc(h * 2 * sizeof(*y_pos));
+  ScaleColumnGroup *const groups =
+      (ScaleColumnGroup *)vpx_malloc(num_groups * sizeof(*groups));
+  uint8_t *temp = NULL;
+  int ok = 0;
+
+  if (x_pos != NULL && y_pos != NULL && groups != NULL) {
+    int *const x_phase = x_pos + w8;
+    int *const y_phase = y_pos + h;
+    int top, bottom, y;
+
+    get_scale_positions(w8, factor, src_w, dst_w, phase_scaler, x_pos,
+                        x_phase);
+    get_scale_positions(h, factor, src_h, dst_h, phase_scaler, y_pos, y_phase);
+    setup_column_groups(groups, num_groups, x_pos, x_phase, kernel);
+
+    top = bottom = y_pos[0];
+    for (y = 1; y < h; ++y) {
+      top = VPXMIN(top, y_pos[y]);
+      bottom = VPXMAX(bottom, y_pos[y]);
+    }
+    top -= SUBPEL_TAPS / 2 - 1;
+    bottom += SUBPEL_TAPS / 2;
+
+    temp = (uint8_t *)vpx_malloc(w8 * (bottom - top + 1));
+    if (temp != NULL) {
+      for (y = top; y <= bottom; ++y) {
+        filter_row_general(src + y * src_stride, temp + (y - top) * w8, groups,
+                           num_groups);
+      }
+      for (y = 0; y < h; ++y) {
+        const uint8_t *const t = temp + (y_pos[y] - top) * w8;
+        if (y_phase[y]) {
+          __m128i f[4];
+          load_kernel_pairs(kernel[y_phase[y]], f);
+          filter_vert_row(t - (SUBPEL_TAPS / 2 - 1) * w8, w8,
+                          dst + y * dst_stride, f, w8);
+        } else {
+          memcpy(dst + y * dst_stride, t, w8);
+        }
+      }
+      ok = 1;
+    }
+  }
+
+  vpx_free(temp);
+  vpx_free(groups);
+  vpx_free(y_pos);
+  vpx_free(x_pos);
+  return ok;
+}
+
 void vp9_scale_and_extend_frame_ssse3(const YV12_BUFFER_CONFIG *src,
                                       YV12_BUFFER_CONFIG *dst,
                                       uint8_t filter_type, int phase_scaler) {
@@ -175,8 +445,9 @@ void vp9_scale_and_extend_frame_ssse3(const YV12_BUFFER_CONFIG *src,
   const int src_h = src->y_crop_height;
   const int dst_w = dst->y_crop_width;
   const int dst_h = dst->y_crop_height;
-  const int dst_uv_w = dst_w / 2;
-  const int dst_uv_h = dst_h / 2;
+  const int dst_uv_w = dst->uv_crop_width;
+  const int dst_uv_h = dst->uv_crop_height;
+  const InterpKernel *const kernel = vp9_filter_kernels[filter_type];
 
   if (dst_w * 2 == src_w && dst_h * 2 == src_h && phase_scaler == 0) {
     downsample_2_to_1_ssse3(src->y_buffer, src->y_stride, dst->y_buffer,
@@ -186,21 +457,48 @@ void vp9_scale_and_extend_frame_ssse3(const YV12_BUFFER_CONFIG *src,
     downsample_2_to_1_ssse3(src->v_buffer, src->uv_stride, dst->v_buffer,
                             dst->uv_stride, dst_uv_w, dst_uv_h);
     vpx_extend_frame_borders(dst);
-  } else if (dst_w == src_w * 2 && dst_h == src_h * 2 && phase_scaler == 0) {
-    // The upsample() supports widths up to 1920 * 2.  If greater, fall back
-    // to vp9_scale_and_extend_frame_c().
-    if (dst_w / 2 <= 1920) {
-      upsample_1_to_2_ssse3(src->y_buffer, src->y_stride, dst->y_buffer,
-                            dst->y_stride, dst_w, dst_h);
-      upsample_1_to_2_ssse3(src->u_buffer, src->uv_stride, dst->u_buffer,
-                            dst->uv_stride, dst_uv_w, dst_uv_h);
-      upsample_1_to_2_ssse3(src->v_buffer, src->uv_stride, dst->v_buffer,
-                            dst->uv_stride, dst_uv_w, dst_uv_h);
+    return;
+  }
+
+  if (dst_w * 2 == src_w && dst_h * 2 == src_h && phase_scaler > 0 &&
+      phase_scaler < 16) {
+    const int16_t *const k = kernel[phase_scaler];
+    if (scale_plane_2_to_1_phase(src->y_buffer, src->y_stride, dst->y_buffer,
+                                 dst->y_stride, dst_w, dst_h, k) &&
+        scale_plane_2_to_1_phase(src->u_buffer, src->uv_stride, dst->u_buffer,
+                                 dst->uv_stride, dst_uv_w, dst_uv_h, k) &&
+        scale_plane_2_to_1_phase(src->v_buffer, src->uv_stride, dst->v_buffer,
+                                 dst->uv_stride, dst_uv_w, dst_uv_h, k)) {
       vpx_extend_frame_borders(dst);
-    } else {
-      vp9_scale_and_extend_frame_c(src, dst, filter_type, phase_scaler);
+      return;
+    }
+  } else if (dst_w == src_w * 2 && dst_h == src_h * 2 && phase_scaler == 0 &&
+             filter_type == EIGHTTAP && (src_w & 15) == 0 && dst_w / 2 <= 1920) {
+    // upsample_1_to_2_ssse3() has the regular 8-tap kernel built in, supports
+    // widths up to 1920 * 2 and fills whole groups of 8 chroma pixels only.
+    upsample_1_to_2_ssse3(src->y_buffer, src->y_stride, dst->y_buffer,
+                          dst->y_stride, dst_w, dst_h);
+    upsample_1_to_2_ssse3(src->u_buffer, src->uv_stride, dst->u_buffer,
+                          dst->uv_stride, dst_uv_w, dst_uv_h);
+    upsample_1_to_2_ssse3(src->v_buffer, src->uv_stride, dst->v_buffer,
+                          dst->uv_stride, dst_uv_w, dst_uv_h);
+    vpx_extend_frame_borders(dst);
+    return;
+  } else if (16 * src_w / dst_w <= 32 && 16 * src_h / dst_h <= 32) {
+    // Any other ratio, e.g. 4:3 or 3:2 downscaling.
+    if (scale_plane_general(src->y_buffer, src->y_stride, dst->y_buffer,
+                            dst->y_stride, dst_w, dst_h, 1, src_w, src_h,
+                            dst_w, dst_h, kernel, phase_scaler) &&
+        scale_plane_general(src->u_buffer, src->uv_stride, dst->u_buffer,
+                            dst->uv_stride, dst_uv_w, dst_uv_h, 2, src_w,
+                            src_h, dst_w, dst_h, kernel, phase_scaler) &&
+        scale_plane_general(src->v_buffer, src->uv_stride, dst->v_buffer,
+                            dst->uv_stride, dst_uv_w, dst_uv_h, 2, src_w,
+                            src_h, dst_w, dst_h, kernel, phase_scaler)) {
+      vpx_extend_frame_borders(dst);
+      return;
     }
-  } else {
-    vp9_scale_and_extend_frame_c(src, dst, filter_type, phase_scaler);
   }
+
+  vp9_scale_and_extend_frame_c(src, dst, filter_type, phase_scaler);
 }
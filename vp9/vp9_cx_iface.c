@@ -53,6 +53,8 @@ struct vp9_extracfg {
   int render_height;
   unsigned int row_mt;
   unsigned int motion_vector_unit_test;
+  vp9e_memory_profile memory_profile;
+  unsigned int lookahead_pass_frames;
 };
 
 static struct vp9_extracfg default_extra_cfg = {
@@ -86,6 +88,8 @@ static struct vp9_extracfg default_extra_cfg = {
   0,                     // render height
   0,                     // row_mt
   0,                     // motion_vector_unit_test
+  0,                     // memory_profile
+  0,                     // lookahead_pass_frames
 };
 
 struct vpx_codec_alg_priv {
@@ -106,9 +110,19 @@ struct vpx_codec_alg_priv {
   vp8_postproc_cfg_t preview_ppcfg;
   vpx_codec_pkt_list_decl(256) pkt_list;
   unsigned int fixed_kf_cntr;
+  int twopass_stats_source_set;
   vpx_codec_priv_output_cx_pkt_cb_pair_t output_cx_pkt_cb;
   // BufferPool that holds all reference frames.
   BufferPool *buffer_pool;
+  // First pass encoder of the lookahead pass, run on fp_worker while cpi
+  // encodes, and the frame it analyses.
+  VP9_COMP *fp_cpi;
+  BufferPool *fp_buffer_pool;
+  VPxWorker fp_worker;
+  vpx_codec_pkt_list_decl(4) fp_pkt_list;
+  YV12_BUFFER_CONFIG fp_sd;
+  int64_t fp_time_stamp;
+  int64_t fp_end_time_stamp;
 };
 
 static vpx_codec_err_t update_error_state(
@@ -264,12 +278,28 @@ static vpx_codec_err_t validate_config(vpx_codec_alg_priv_t *ctx,
   RANGE_CHECK(cfg, g_input_bit_depth, 8, 12);
   RANGE_CHECK(extra_cfg, content, VP9E_CONTENT_DEFAULT,
               VP9E_CONTENT_INVALID - 1);
+  RANGE_CHECK(extra_cfg, memory_profile, VP9E_MEMORY_PROFILE_DEFAULT,
+              VP9E_MEMORY_PROFILE_INVALID - 1);
+  if (extra_cfg->memory_profile == VP9E_MEMORY_PROFILE_LOW &&
+      (cfg->g_pass != VPX_RC_ONE_PASS || cfg->g_lag_in_frames != 0))
+    ERROR("Low memory profile requires one pass encoding without lag");
+  if (extra_cfg->lookahead_pass_frames != 0) {
+    RANGE_CHECK(extra_cfg, lookahead_pass_frames, MIN_LOOKAHEAD_PASS_FRAMES,
+                MAX_LOOKAHEAD_PASS_FRAMES);
+    if (cfg->g_pass != VPX_RC_LAST_PASS)
+      ERROR("Lookahead pass requires g_pass VPX_RC_LAST_PASS.");
+    if (cfg->ss_number_layers > 1 || cfg->ts_number_layers > 1)
+      ERROR("Lookahead pass does not support spatial or temporal layers.");
+  }
 
   // TODO(yaowu): remove this when ssim tuning is implemented for vp9
   if (extra_cfg->tuning == VP8_TUNE_SSIM)
     ERROR("Option --tune=ssim is not currently supported in VP9.");
 
-  if (cfg->g_pass == VPX_RC_LAST_PASS) {
+  // The stats may instead come from VP9E_SET_TWOPASS_STATS_SOURCE.
+  if (cfg->g_pass == VPX_RC_LAST_PASS &&
+      (cfg->rc_twopass_stats_in.buf != NULL ||
+       cfg->rc_twopass_stats_in.sz != 0)) {
     const size_t packet_sz = sizeof(FIRSTPASS_STATS);
     const int n_packets = (int)(cfg->rc_twopass_stats_in.sz / packet_sz);
     const FIRSTPASS_STATS *stats;
@@ -509,6 +539,13 @@ static vpx_codec_err_t set_encoder_config(
 
   oxcf->key_freq = cfg->kf_max_dist;
 
+  oxcf->lookahead_pass_frames =
+      cfg->g_pass == VPX_RC_LAST_PASS ? extra_cfg->lookahead_pass_frames : 0;
+  // Keep the key frame search, which looks up to 16 frames past the group,
+  // within the frames the lookahead pass has analysed.
+  if (oxcf->lookahead_pass_frames > 0)
+    oxcf->key_freq = VPXMIN(oxcf->key_freq, oxcf->lookahead_pass_frames - 16);
+
   oxcf->speed = abs(extra_cfg->cpu_used);
   oxcf->encode_breakout = extra_cfg->static_thresh;
   oxcf->enable_auto_arf = extra_cfg->enable_auto_alt_ref;
@@ -532,6 +569,7 @@ static vpx_codec_err_t set_encoder_config(
 
   oxcf->tuning = extra_cfg->tuning;
   oxcf->content = extra_cfg->content;
+  oxcf->memory_profile = extra_cfg->memory_profile;
 
   oxcf->tile_columns = extra_cfg->tile_columns;
 
@@ -624,6 +662,30 @@ static vpx_codec_err_t set_encoder_config(
   return VPX_CODEC_OK;
 }
 
+// Sets the config of the lookahead pass: a first pass over the same frames.
+static void set_lookahead_pass_config(const vpx_codec_alg_priv_t *ctx,
+                                      VP9EncoderConfig *oxcf) {
+  vpx_codec_enc_cfg_t cfg = ctx->cfg;
+
+  cfg.g_pass = VPX_RC_FIRST_PASS;
+  cfg.rc_twopass_stats_in.buf = NULL;
+  cfg.rc_twopass_stats_in.sz = 0;
+  vp9_zero(*oxcf);
+  set_encoder_config(oxcf, &cfg, &ctx->extra_cfg);
+  oxcf->mode = BEST;
+#if CONFIG_VP9_HIGHBITDEPTH
+  oxcf->use_highbitdepth = ctx->oxcf.use_highbitdepth;
+#endif
+}
+
+static void update_lookahead_pass_config(vpx_codec_alg_priv_t *ctx) {
+  if (ctx->fp_cpi != NULL) {
+    VP9EncoderConfig oxcf;
+    set_lookahead_pass_config(ctx, &oxcf);
+    vp9_change_config(ctx->fp_cpi, &oxcf);
+  }
+}
+
 static vpx_codec_err_t encoder_set_config(vpx_codec_alg_priv_t *ctx,
                                           const vpx_codec_enc_cfg_t *cfg) {
   vpx_codec_err_t res;
@@ -653,6 +715,7 @@ static vpx_codec_err_t encoder_set_config(vpx_codec_alg_priv_t *ctx,
     // On profile change, request a key frame
     force_key |= ctx->cpi->common.profile != ctx->oxcf.profile;
     vp9_change_config(ctx->cpi, &ctx->oxcf);
+    update_lookahead_pass_config(ctx);
   }
 
   if (force_key) ctx->next_frame_flags |= VPX_EFLAG_FORCE_KF;
@@ -683,6 +746,7 @@ static vpx_codec_err_t update_extra_cfg(vpx_codec_alg_priv_t *ctx,
     ctx->extra_cfg = *extra_cfg;
     set_encoder_config(&ctx->oxcf, &ctx->cfg, &ctx->extra_cfg);
     vp9_change_config(ctx->cpi, &ctx->oxcf);
+    update_lookahead_pass_config(ctx);
   }
   return res;
 }
@@ -873,6 +937,178 @@ static vpx_codec_err_t ctrl_get_level(vpx_codec_alg_priv_t *ctx, va_list args) {
   return VPX_CODEC_OK;
 }
 
+static vpx_codec_err_t ctrl_get_stage_timing(vpx_codec_alg_priv_t *ctx,
+                                             va_list args) {
+#if CONFIG_STAGE_TIMING
+  vpx_stage_timing_t *const arg = va_arg(args, vpx_stage_timing_t *);
+  if (arg == NULL) return VPX_CODEC_INVALID_PARAM;
+  *arg = ctx->cpi->stage_timing;
+  return VPX_CODEC_OK;
+#else
+  (void)ctx;
+  (void)args;
+  return VPX_CODEC_INCAPABLE;
+#endif
+}
+
+static vpx_codec_err_t ctrl_get_memory_footprint(vpx_codec_alg_priv_t *ctx,
+                                                 va_list args) {
+  size_t *const arg = va_arg(args, size_t *);
+  if (arg == NULL) return VPX_CODEC_INVALID_PARAM;
+  *arg = vp9_get_memory_footprint(ctx->cpi) + ctx->cx_data_sz;
+  if (ctx->fp_cpi != NULL) *arg += vp9_get_memory_footprint(ctx->fp_cpi);
+  return VPX_CODEC_OK;
+}
+
+static vpx_codec_err_t ctrl_set_memory_allocator(vpx_codec_alg_priv_t *ctx,
+                                                 va_list args) {
+  const vpx_memory_allocator_t *const allocator =
+      va_arg(args, vpx_memory_allocator_t *);
+  VP9_COMP *const cpi = ctx->cpi;
+
+  if (allocator != NULL &&
+      (allocator->alloc == NULL || allocator->free == NULL))
+    return VPX_CODEC_INVALID_PARAM;
+
+  if (setjmp(cpi->common.error.jmp)) {
+    cpi->common.error.setjmp = 0;
+    return update_error_state(ctx, &cpi->common.error);
+  }
+  cpi->common.error.setjmp = 1;
+  vp9_set_memory_allocator(cpi, allocator);
+  cpi->common.error.setjmp = 0;
+  return VPX_CODEC_OK;
+}
+
+static vpx_codec_err_t ctrl_get_memory_allocator_stats(
+    vpx_codec_alg_priv_t *ctx, va_list args) {
+  vpx_memory_allocator_stats_t *const arg =
+      va_arg(args, vpx_memory_allocator_stats_t *);
+  if (arg == NULL) return VPX_CODEC_INVALID_PARAM;
+  vp9_get_memory_allocator_stats(ctx->cpi, arg);
+  return VPX_CODEC_OK;
+}
+
+static vpx_codec_err_t ctrl_set_twopass_stats_source(
+    vpx_codec_alg_priv_t *ctx, va_list args) {
+  const vpx_twopass_stats_source_t *const source =
+      va_arg(args, vpx_twopass_stats_source_t *);
+  VP9_COMP *const cpi = ctx->cpi;
+  int res;
+
+  if (source == NULL) return VPX_CODEC_INVALID_PARAM;
+  if (cpi->oxcf.pass != 2)
+    ERROR("Two pass stats source requires g_pass VPX_RC_LAST_PASS.");
+  if (cpi->common.current_video_frame > 0 ||
+      (cpi->lookahead != NULL && vp9_lookahead_depth(cpi->lookahead) > 0))
+    ERROR("Two pass stats source must be set before the first frame.");
+  if (ctx->fp_cpi != NULL)
+    ERROR("Two pass stats source cannot be combined with the lookahead pass.");
+
+  if (setjmp(cpi->common.error.jmp)) {
+    cpi->common.error.setjmp = 0;
+    return update_error_state(ctx, &cpi->common.error);
+  }
+  cpi->common.error.setjmp = 1;
+  res = vp9_set_twopass_stats_source(cpi, source);
+  cpi->common.error.setjmp = 0;
+
+  if (res) ERROR("Two pass stats source missing or truncated EOS packets.");
+  ctx->twopass_stats_source_set = 1;
+  return VPX_CODEC_OK;
+}
+
+// Runs the lookahead pass over ctx->fp_sd, leaving its stats packet in
+// ctx->fp_pkt_list.
+static int lookahead_pass_hook(void *arg1, void *arg2) {
+  vpx_codec_alg_priv_t *const ctx = (vpx_codec_alg_priv_t *)arg1;
+  VP9_COMP *const cpi = ctx->fp_cpi;
+  unsigned int lib_flags = 0;
+  size_t size;
+  int64_t time_stamp, end_time_stamp;
+  (void)arg2;
+
+  if (setjmp(cpi->common.error.jmp)) {
+    cpi->common.error.setjmp = 0;
+    vpx_clear_system_state();
+    return 0;
+  }
+  cpi->common.error.setjmp = 1;
+
+  vpx_codec_pkt_list_init(&ctx->fp_pkt_list);
+  if (vp9_receive_raw_frame(cpi, 0, &ctx->fp_sd, ctx->fp_time_stamp,
+                            ctx->fp_end_time_stamp)) {
+    cpi->common.error.setjmp = 0;
+    return 0;
+  }
+  while (vp9_get_compressed_data(cpi, &lib_flags, &size, NULL, &time_stamp,
+                                 &end_time_stamp, 0) != -1) {
+  }
+
+  cpi->common.error.setjmp = 0;
+  return 1;
+}
+
+static vpx_codec_err_t init_lookahead_pass(vpx_codec_alg_priv_t *ctx) {
+  const VPxWorkerInterface *const winterface = vpx_get_worker_interface();
+  VP9EncoderConfig oxcf;
+
+  ctx->fp_buffer_pool = (BufferPool *)vpx_calloc(1, sizeof(BufferPool));
+  if (ctx->fp_buffer_pool == NULL) return VPX_CODEC_MEM_ERROR;
+#if CONFIG_MULTITHREAD
+  if (pthread_mutex_init(&ctx->fp_buffer_pool->pool_mutex, NULL)) {
+    vpx_free(ctx->fp_buffer_pool);
+    ctx->fp_buffer_pool = NULL;
+    return VPX_CODEC_MEM_ERROR;
+  }
+#endif
+
+  set_lookahead_pass_config(ctx, &oxcf);
+  ctx->fp_cpi = vp9_create_compressor(&oxcf, ctx->fp_buffer_pool);
+  if (ctx->fp_cpi == NULL) return VPX_CODEC_MEM_ERROR;
+  ctx->fp_cpi->output_pkt_list = &ctx->fp_pkt_list.head;
+
+  winterface->init(&ctx->fp_worker);
+  ctx->fp_worker.hook = lookahead_pass_hook;
+  ctx->fp_worker.data1 = ctx;
+  if (!winterface->reset(&ctx->fp_worker)) {
+    ctx->base.err_detail = "Lookahead pass thread creation failed";
+    return VPX_CODEC_ERROR;
+  }
+  return VPX_CODEC_OK;
+}
+
+static vpx_codec_err_t ctrl_set_lookahead_pass(vpx_codec_alg_priv_t *ctx,
+                                               va_list args) {
+  struct vp9_extracfg extra_cfg = ctx->extra_cfg;
+  VP9_COMP *const cpi = ctx->cpi;
+  vpx_codec_err_t res;
+
+  extra_cfg.lookahead_pass_frames = CAST(VP9E_SET_LOOKAHEAD_PASS, args);
+  if (extra_cfg.lookahead_pass_frames == ctx->extra_cfg.lookahead_pass_frames)
+    return VPX_CODEC_OK;
+  if (ctx->fp_cpi != NULL || cpi->lookahead != NULL)
+    ERROR("Lookahead pass must be set before the first frame.");
+  if (ctx->twopass_stats_source_set || ctx->cfg.rc_twopass_stats_in.buf != NULL)
+    ERROR("Lookahead pass cannot be combined with first pass statistics.");
+
+  res = update_extra_cfg(ctx, &extra_cfg);
+  if (res != VPX_CODEC_OK) return res;
+
+  res = init_lookahead_pass(ctx);
+  if (res != VPX_CODEC_OK) return res;
+
+  if (setjmp(cpi->common.error.jmp)) {
+    cpi->common.error.setjmp = 0;
+    return update_error_state(ctx, &cpi->common.error);
+  }
+  cpi->common.error.setjmp = 1;
+  vp9_twopass_live_stats(cpi);
+  vp9_init_second_pass(cpi);
+  cpi->common.error.setjmp = 0;
+  return VPX_CODEC_OK;
+}
+
 static vpx_codec_err_t encoder_init(vpx_codec_ctx_t *ctx,
                                     vpx_codec_priv_enc_mr_cfg_t *data) {
   vpx_codec_err_t res = VPX_CODEC_OK;
@@ -924,6 +1160,16 @@ static vpx_codec_err_t encoder_init(vpx_codec_ctx_t *ctx,
 
 static vpx_codec_err_t encoder_destroy(vpx_codec_alg_priv_t *ctx) {
   free(ctx->cx_data);
+  if (ctx->fp_cpi != NULL) {
+    vpx_get_worker_interface()->end(&ctx->fp_worker);
+    vp9_remove_compressor(ctx->fp_cpi);
+  }
+  if (ctx->fp_buffer_pool != NULL) {
+#if CONFIG_MULTITHREAD
+    pthread_mutex_destroy(&ctx->fp_buffer_pool->pool_mutex);
+#endif
+    vpx_free(ctx->fp_buffer_pool);
+  }
   vp9_remove_compressor(ctx->cpi);
 #if CONFIG_MULTITHREAD
   pthread_mutex_destroy(&ctx->buffer_pool->pool_mutex);
@@ -1067,12 +1313,24 @@ static vpx_codec_err_t encoder_encode(vpx_codec_alg_priv_t *ctx,
                                       unsigned long deadline) {
   volatile vpx_codec_err_t res = VPX_CODEC_OK;
   volatile vpx_enc_frame_flags_t flags = enc_flags;
+  // Set once fp_worker reads the caller's image, which it must finish doing
+  // before this returns.
+  volatile int fp_launched = 0;
   VP9_COMP *const cpi = ctx->cpi;
   const vpx_rational_t *const timebase = &ctx->cfg.g_timebase;
   size_t data_sz;
 
   if (cpi == NULL) return VPX_CODEC_INVALID_PARAM;
 
+  if (cpi->oxcf.pass == 2 && ctx->cfg.rc_twopass_stats_in.buf == NULL &&
+      !ctx->twopass_stats_source_set && ctx->fp_cpi == NULL)
+    ERROR("rc_twopass_stats_in.buf not set.");
+
+#if CONFIG_STAGE_TIMING
+  // Stage timing covers a single vpx_codec_encode() call.
+  vp9_zero(cpi->stage_timing);
+#endif
+
   if (cpi->oxcf.pass == 2 && cpi->level_constraint.level_index >= 0 &&
       !cpi->level_constraint.rc_config_updated) {
     SVC *const svc = &cpi->svc;
@@ -1126,6 +1384,7 @@ static vpx_codec_err_t encoder_encode(vpx_codec_alg_priv_t *ctx,
 
   if (setjmp(cpi->common.error.jmp)) {
     cpi->common.error.setjmp = 0;
+    if (fp_launched) vpx_get_worker_interface()->sync(&ctx->fp_worker);
     res = update_error_state(ctx, &cpi->common.error);
     vpx_clear_system_state();
     return res;
@@ -1163,6 +1422,13 @@ static vpx_codec_err_t encoder_encode(vpx_codec_alg_priv_t *ctx,
       if (vp9_receive_raw_frame(cpi, flags | ctx->next_frame_flags, &sd,
                                 dst_time_stamp, dst_end_time_stamp)) {
         res = update_error_state(ctx, &cpi->common.error);
+      } else if (ctx->fp_cpi != NULL) {
+        // Analyse the frame while cpi encodes the frames before it.
+        ctx->fp_sd = sd;
+        ctx->fp_time_stamp = dst_time_stamp;
+        ctx->fp_end_time_stamp = dst_end_time_stamp;
+        vpx_get_worker_interface()->launch(&ctx->fp_worker);
+        fp_launched = 1;
       }
       ctx->next_frame_flags = 0;
     }
@@ -1296,6 +1562,22 @@ static vpx_codec_err_t encoder_encode(vpx_codec_alg_priv_t *ctx,
         }
       }
     }
+
+    if (fp_launched) {
+      const vpx_codec_cx_pkt_t *pkt;
+      vpx_codec_iter_t iter = NULL;
+
+      if (!vpx_get_worker_interface()->sync(&ctx->fp_worker)) {
+        res = update_error_state(ctx, &ctx->fp_cpi->common.error);
+      } else {
+        while ((pkt = vpx_codec_pkt_list_get(&ctx->fp_pkt_list.head,
+                                             &iter)) != NULL) {
+          if (pkt->kind == VPX_CODEC_STATS_PKT)
+            vp9_twopass_add_stats(cpi, (const FIRSTPASS_STATS *)
+                                           pkt->data.twopass_stats.buf);
+        }
+      }
+    }
   }
 
   cpi->common.error.setjmp = 0;
@@ -1557,6 +1839,13 @@ static vpx_codec_err_t ctrl_set_tune_content(vpx_codec_alg_priv_t *ctx,
   return update_extra_cfg(ctx, &extra_cfg);
 }
 
+static vpx_codec_err_t ctrl_set_memory_profile(vpx_codec_alg_priv_t *ctx,
+                                              va_list args) {
+  struct vp9_extracfg extra_cfg = ctx->extra_cfg;
+  extra_cfg.memory_profile = CAST(VP9E_SET_MEMORY_PROFILE, args);
+  return update_extra_cfg(ctx, &extra_cfg);
+}
+
 static vpx_codec_err_t ctrl_set_color_space(vpx_codec_alg_priv_t *ctx,
                                             va_list args) {
   struct vp9_extracfg extra_cfg = ctx->extra_cfg;
@@ -1613,6 +1902,10 @@ static vpx_codec_ctrl_fn_map_t encoder_ctrl_maps[] = {
   { VP9E_REGISTER_CX_CALLBACK, ctrl_register_cx_callback },
   { VP9E_SET_SVC_LAYER_ID, ctrl_set_svc_layer_id },
   { VP9E_SET_TUNE_CONTENT, ctrl_set_tune_content },
+  { VP9E_SET_MEMORY_PROFILE, ctrl_set_memory_profile },
+  { VP9E_SET_MEMORY_ALLOCATOR, ctrl_set_memory_allocator },
+  { VP9E_SET_TWOPASS_STATS_SOURCE, ctrl_set_twopass_stats_source },
+  { VP9E_SET_LOOKAHEAD_PASS, ctrl_set_lookahead_pass },
   { VP9E_SET_COLOR_SPACE, ctrl_set_color_space },
   { VP9E_SET_COLOR_RANGE, ctrl_set_color_range },
   { VP9E_SET_NOISE_SENSITIVITY, ctrl_set_noise_sensitivity },
@@ -1631,6 +1924,9 @@ static vpx_codec_ctrl_fn_map_t encoder_ctrl_maps[] = {
   { VP9E_GET_SVC_LAYER_ID, ctrl_get_svc_layer_id },
   { VP9E_GET_ACTIVEMAP, ctrl_get_active_map },
   { VP9E_GET_LEVEL, ctrl_get_level },
+  { VP9E_GET_STAGE_TIMING, ctrl_get_stage_timing },
+  { VP9E_GET_MEMORY_FOOTPRINT, ctrl_get_memory_footprint },
+  { VP9E_GET_MEMORY_ALLOCATOR_STATS, ctrl_get_memory_allocator_stats },
 
   { -1, NULL },
 };
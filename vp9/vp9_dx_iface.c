@@ -838,6 +838,28 @@ static vpx_codec_err_t ctrl_get_quantizer(vpx_codec_alg_priv_t *ctx,
   return VPX_CODEC_OK;
 }
 
+static vpx_codec_err_t ctrl_get_frame_stats(vpx_codec_alg_priv_t *ctx,
+                                            va_list args) {
+#if CONFIG_STAGE_TIMING
+  vpx_dec_frame_stats_t *const stats = va_arg(args, vpx_dec_frame_stats_t *);
+  if (stats == NULL) return VPX_CODEC_INVALID_PARAM;
+
+  // Only support this function in serial decode.
+  if (ctx->frame_parallel_decode) {
+    set_error_detail(ctx, "Not supported in frame parallel decode");
+    return VPX_CODEC_INCAPABLE;
+  }
+
+  if (ctx->frame_workers == NULL) return VPX_CODEC_ERROR;
+  *stats = ((FrameWorkerData *)ctx->frame_workers[0].data1)->pbi->frame_stats;
+  return VPX_CODEC_OK;
+#else
+  (void)ctx;
+  (void)args;
+  return VPX_CODEC_INCAPABLE;
+#endif
+}
+
 static vpx_codec_err_t ctrl_get_last_ref_updates(vpx_codec_alg_priv_t *ctx,
                                                  va_list args) {
   int *const update_info = va_arg(args, int *);
@@ -1040,6 +1062,7 @@ static vpx_codec_ctrl_fn_map_t decoder_ctrl_maps[] = {
   { VP9D_GET_DISPLAY_SIZE, ctrl_get_render_size },
   { VP9D_GET_BIT_DEPTH, ctrl_get_bit_depth },
   { VP9D_GET_FRAME_SIZE, ctrl_get_frame_size },
+  { VP9D_GET_FRAME_STATS, ctrl_get_frame_stats },
 
   { -1, NULL },
 };
@@ -17,6 +17,7 @@
  */
 #include "./vp8.h"
 #include "./vpx_encoder.h"
+#include "./vpx_memory_allocator.h"
 
 /*!\file
  * \brief Provides definitions for using VP8 or VP9 encoder algorithm within the
@@ -594,6 +595,93 @@ enum vp8e_enc_control_id {
    * Supported in codecs: VP9
    */
   VP9E_ENABLE_MOTION_VECTOR_UNIT_TEST,
+
+  /*!\brief Codec control function to get the time spent in each encoding
+   * stage by the last call to vpx_codec_encode().
+   *
+   * The timing is filled in a #vpx_stage_timing_t. Returns
+   * #VPX_CODEC_INCAPABLE when the library was configured without
+   * --enable-stage-timing.
+   *
+   * Supported in codecs: VP9
+   */
+  VP9E_GET_STAGE_TIMING,
+
+  /*!\brief Codec control function to set the memory profile of the encoder.
+   *
+   * VP9E_MEMORY_PROFILE_LOW skips the buffers that only two-pass encoding and
+   * alt reference frames use, and allocates the frame scaling buffers only
+   * when the coded size differs from the input size. It is intended for
+   * realtime encoding and requires g_pass to be VPX_RC_ONE_PASS and
+   * g_lag_in_frames to be 0. The bitstream is the same for either profile.
+   *
+   *              VP9E_MEMORY_PROFILE_DEFAULT = Regular allocation (Default)
+   *              VP9E_MEMORY_PROFILE_LOW     = Low memory realtime encoding
+   *
+   * Supported in codecs: VP9
+   */
+  VP9E_SET_MEMORY_PROFILE,
+
+  /*!\brief Codec control function to get the approximate number of bytes
+   * the encoder has allocated for frame buffers and frame sized work buffers.
+   *
+   * Per-thread data is not included.
+   *
+   * Supported in codecs: VP9
+   */
+  VP9E_GET_MEMORY_FOOTPRINT,
+
+  /*!\brief Codec control function to set the allocator of the encoder's
+   * scratch memory.
+   *
+   * The partition search contexts of each thread and the row based
+   * multithreading buffers are carved out of blocks requested from the
+   * allocator. The blocks are kept across frames and resizes, so after the
+   * first frames at the largest size no further requests are made. Passing
+   * NULL restores the default allocator. The allocator must remain valid
+   * until it is replaced or the encoder is destroyed.
+   *
+   * Supported in codecs: VP9
+   */
+  VP9E_SET_MEMORY_ALLOCATOR,
+
+  /*!\brief Codec control function to get the statistics of the encoder's
+   * scratch memory, filled in a #vpx_memory_allocator_stats_t.
+   *
+   * Supported in codecs: VP9
+   */
+  VP9E_GET_MEMORY_ALLOCATOR_STATS,
+
+  /*!\brief Codec control function to read the first pass statistics from a
+   * #vpx_twopass_stats_source_t instead of rc_twopass_stats_in.
+   *
+   * The second pass then keeps only a window of statistics packets around
+   * the frame being encoded, sized from the key frame interval, rather than
+   * the statistics of the whole sequence. It must be set with g_pass set to
+   * VPX_RC_LAST_PASS before the first frame is passed to the encoder, in
+   * which case rc_twopass_stats_in may be left empty. The source must remain
+   * valid until the encoder is destroyed.
+   *
+   * Supported in codecs: VP9
+   */
+  VP9E_SET_TWOPASS_STATS_SOURCE,
+
+  /*!\brief Codec control function to encode in a single call sequence with
+   * the first pass run alongside the second, N frames ahead of it.
+   *
+   * A first pass encoder analyses each frame on its own thread as it is
+   * passed in, and the second pass places key frames and golden frame groups
+   * from the statistics gathered so far. The encoder then holds N frames
+   * beyond g_lag_in_frames and the key frame interval is limited to N - 16
+   * frames. It must be set with g_pass set to VPX_RC_LAST_PASS before the
+   * first frame is passed to the encoder, in which case rc_twopass_stats_in
+   * is left empty. Spatial and temporal layers are not supported.
+   *
+   * Valid values are 0 (off, the default) and 32..600.
+   *
+   * Supported in codecs: VP9
+   */
+  VP9E_SET_LOOKAHEAD_PASS,
 };
 
 /*!\brief vpx 1-D scaling mode
@@ -698,6 +786,13 @@ typedef enum {
   VP9E_CONTENT_INVALID
 } vp9e_tune_content;
 
+/*!brief VP9 encoder memory profile */
+typedef enum {
+  VP9E_MEMORY_PROFILE_DEFAULT,
+  VP9E_MEMORY_PROFILE_LOW,
+  VP9E_MEMORY_PROFILE_INVALID
+} vp9e_memory_profile;
+
 /*!\brief VP8 model tuning parameters
  *
  * Changes the encoder to tune for certain types of input material.
@@ -732,6 +827,49 @@ typedef struct vpx_svc_ref_frame_config {
   int alt_fb_idx[VPX_TS_MAX_LAYERS];  /**< Altref buffer index. */
 } vpx_svc_ref_frame_config_t;
 
+/*!\brief Encoding stages timed by #VP9E_GET_STAGE_TIMING
+ *
+ */
+typedef enum vpx_enc_stage {
+  VPX_ENC_STAGE_LOOKAHEAD,        /**< Copy of the source to the lookahead */
+  VPX_ENC_STAGE_TEMPORAL_FILTER,  /**< ARNR filtering of alt-ref frames */
+  VPX_ENC_STAGE_ENCODE_FRAME,     /**< Motion search, mode decision, coding */
+  VPX_ENC_STAGE_PICK_LOOP_FILTER, /**< Loop filter level search */
+  VPX_ENC_STAGE_LOOP_FILTER,      /**< Loop filtering of the reconstruction */
+  VPX_ENC_STAGE_PACK_BITSTREAM,   /**< Bitstream packing */
+  VPX_ENC_STAGE_COUNT             /**< Number of stages */
+} vpx_enc_stage_t;
+
+/*!\brief Maximum number of encoder threads timed by #VP9E_GET_STAGE_TIMING */
+#define VPX_ENC_STAGE_MAX_THREADS 64
+
+/*!\brief vpx encoder stage timing
+ *
+ * Time in microseconds spent by the last call to vpx_codec_encode() in each
+ * encoding stage, and by each encoder worker thread.
+ */
+typedef struct vpx_stage_timing {
+  int64_t stage_us[VPX_ENC_STAGE_COUNT]; /**< Time spent in each stage. */
+  int64_t total_us; /**< Total encoding time, lookahead copy excluded. */
+  int num_threads;  /**< Number of worker threads that were run. */
+  /*! Time each worker thread spent running encoder jobs. */
+  int64_t thread_us[VPX_ENC_STAGE_MAX_THREADS];
+} vpx_stage_timing_t;
+
+/*!\brief First pass statistics source set by #VP9E_SET_TWOPASS_STATS_SOURCE
+ *
+ * The statistics are the concatenated payloads of the VPX_CODEC_STATS_PKT
+ * packets of the first pass, as would otherwise be passed in
+ * rc_twopass_stats_in.
+ */
+typedef struct vpx_twopass_stats_source {
+  /*! Copies \p size bytes starting at byte \p offset of the statistics to
+   *  \p buf and returns the number of bytes copied. */
+  size_t (*read)(void *priv, uint64_t offset, void *buf, size_t size);
+  uint64_t sz; /**< Size of the statistics in bytes. */
+  void *priv;  /**< Private data passed to read. */
+} vpx_twopass_stats_source_t;
+
 /*!\cond */
 /*!\brief VP8 encoder control function parameter type
  *
@@ -864,6 +1002,29 @@ VPX_CTRL_USE_TYPE(VP9E_GET_LEVEL, int *)
 VPX_CTRL_USE_TYPE(VP9E_ENABLE_MOTION_VECTOR_UNIT_TEST, unsigned int)
 #define VPX_CTRL_VP9E_ENABLE_MOTION_VECTOR_UNIT_TEST
 
+VPX_CTRL_USE_TYPE(VP9E_GET_STAGE_TIMING, vpx_stage_timing_t *)
+#define VPX_CTRL_VP9E_GET_STAGE_TIMING
+
+VPX_CTRL_USE_TYPE(VP9E_SET_MEMORY_PROFILE, int) /* vp9e_memory_profile */
+#define VPX_CTRL_VP9E_SET_MEMORY_PROFILE
+
+VPX_CTRL_USE_TYPE(VP9E_GET_MEMORY_FOOTPRINT, size_t *)
+#define VPX_CTRL_VP9E_GET_MEMORY_FOOTPRINT
+
+VPX_CTRL_USE_TYPE(VP9E_SET_MEMORY_ALLOCATOR, vpx_memory_allocator_t *)
+#define VPX_CTRL_VP9E_SET_MEMORY_ALLOCATOR
+
+VPX_CTRL_USE_TYPE(VP9E_GET_MEMORY_ALLOCATOR_STATS,
+                  vpx_memory_allocator_stats_t *)
+#define VPX_CTRL_VP9E_GET_MEMORY_ALLOCATOR_STATS
+
+VPX_CTRL_USE_TYPE(VP9E_SET_TWOPASS_STATS_SOURCE,
+                  vpx_twopass_stats_source_t *)
+#define VPX_CTRL_VP9E_SET_TWOPASS_STATS_SOURCE
+
+VPX_CTRL_USE_TYPE(VP9E_SET_LOOKAHEAD_PASS, unsigned int)
+#define VPX_CTRL_VP9E_SET_LOOKAHEAD_PASS
+
 /*!\endcond */
 /*! @} - end defgroup vp8_encoder */
 #ifdef __cplusplus
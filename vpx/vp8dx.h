@@ -124,6 +124,19 @@ enum vp8_dec_control_id {
    */
   VPXD_GET_LAST_QUANTIZER,
 
+  /*!\brief Codec control function to get the timing and work counters of the
+   * last decoded frame.
+   *
+   * The statistics are filled in a #vpx_dec_frame_stats_t. They cover the
+   * last call to vpx_codec_decode() and, once it has been called, the
+   * post-processing done by vpx_codec_get_frame(). Returns
+   * #VPX_CODEC_INCAPABLE when the library was configured without
+   * --enable-stage-timing or when frame parallel decoding is used.
+   *
+   * Supported in codecs: VP9
+   */
+  VP9D_GET_FRAME_STATS,
+
   VP8_DECODER_CTRL_ID_MAX
 };
 
@@ -149,6 +162,40 @@ typedef struct vpx_decrypt_init {
  */
 typedef vpx_decrypt_init vp8_decrypt_init;
 
+/*!\brief Maximum number of tiles reported by #VP9D_GET_FRAME_STATS */
+#define VPX_DEC_STATS_MAX_TILES (4 * 64)
+
+/*!\brief Maximum number of tile workers reported by #VP9D_GET_FRAME_STATS */
+#define VPX_DEC_STATS_MAX_WORKERS 64
+
+/*!\brief Number of block sizes counted by #VP9D_GET_FRAME_STATS, from 4x4 to
+ * 64x64 in the order of the VP9 BLOCK_SIZE enumeration.
+ */
+#define VPX_DEC_STATS_BLOCK_SIZES 13
+
+/*!\brief vpx decoder frame statistics
+ *
+ * Times are wall times in microseconds.
+ */
+typedef struct vpx_dec_frame_stats {
+  int64_t header_us;      /**< Uncompressed and compressed header parsing. */
+  int64_t tile_decode_us; /**< Tile decoding, including the loop filter rows
+                               run while decoding on a single thread. */
+  int64_t loop_filter_us; /**< Loop filtering. */
+  int64_t postproc_us;    /**< Post-processing of the output frame. */
+  int num_tiles;          /**< Number of tiles in the frame. */
+  /*! Time spent decoding each tile, in raster order. When the parse and
+   * reconstruction stages are split, this is the parse time. */
+  int64_t tile_us[VPX_DEC_STATS_MAX_TILES];
+  int num_workers; /**< Number of tile worker threads that were run. */
+  /*! Time each tile worker thread spent decoding. */
+  int64_t worker_us[VPX_DEC_STATS_MAX_WORKERS];
+  /*! Number of coded blocks of each size. */
+  uint32_t blocks[VPX_DEC_STATS_BLOCK_SIZES];
+  uint32_t skip_blocks; /**< Number of blocks coded without residual. */
+  uint64_t coeffs;      /**< Number of coefficient tokens decoded. */
+} vpx_dec_frame_stats_t;
+
 /*!\cond */
 /*!\brief VP8 decoder control function parameter type
  *
@@ -175,6 +222,8 @@ VPX_CTRL_USE_TYPE(VP9D_GET_BIT_DEPTH, unsigned int *)
 #define VPX_CTRL_VP9D_GET_BIT_DEPTH
 VPX_CTRL_USE_TYPE(VP9D_GET_FRAME_SIZE, int *)
 #define VPX_CTRL_VP9D_GET_FRAME_SIZE
+VPX_CTRL_USE_TYPE(VP9D_GET_FRAME_STATS, vpx_dec_frame_stats_t *)
+#define VPX_CTRL_VP9D_GET_FRAME_STATS
 VPX_CTRL_USE_TYPE(VP9_INVERT_TILE_DECODE_ORDER, int)
 #define VPX_CTRL_VP9_INVERT_TILE_DECODE_ORDER
 #define VPX_CTRL_VP9_DECODE_SVC_SPATIAL_LAYER
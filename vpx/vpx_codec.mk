@@ -25,11 +25,15 @@ API_SRCS-$(CONFIG_VP8_DECODER) += vp8dx.h
 API_DOC_SRCS-$(CONFIG_VP8_DECODER) += vp8.h
 API_DOC_SRCS-$(CONFIG_VP8_DECODER) += vp8dx.h
 
+API_SRCS-$(CONFIG_ENCODERS) += vpx_frame_metrics.h
+API_DOC_SRCS-$(CONFIG_ENCODERS) += vpx_frame_metrics.h
+
 API_DOC_SRCS-yes += vpx_codec.h
 API_DOC_SRCS-yes += vpx_decoder.h
 API_DOC_SRCS-yes += vpx_encoder.h
 API_DOC_SRCS-yes += vpx_frame_buffer.h
 API_DOC_SRCS-yes += vpx_image.h
+API_DOC_SRCS-yes += vpx_memory_allocator.h
 
 API_SRCS-yes += src/vpx_decoder.c
 API_SRCS-yes += vpx_decoder.h
@@ -43,3 +47,4 @@ API_SRCS-yes += vpx_codec.mk
 API_SRCS-yes += vpx_frame_buffer.h
 API_SRCS-yes += vpx_image.h
 API_SRCS-yes += vpx_integer.h
+API_SRCS-yes += vpx_memory_allocator.h
@@ -0,0 +1,92 @@
+/*
+ *  Copyright (c) 2017 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef VPX_VPX_FRAME_METRICS_H_
+#define VPX_VPX_FRAME_METRICS_H_
+
+/*!\file
+ * \brief Describes the frame quality metrics interface.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "./vpx_codec.h"
+#include "./vpx_image.h"
+
+/*!\brief Metric selection flags
+ *
+ * Select the metrics computed by vpx_calc_frame_metrics().
+ */
+#define VPX_METRIC_PSNR (1 << 0)     /**< PSNR */
+#define VPX_METRIC_SSIM (1 << 1)     /**< SSIM */
+#define VPX_METRIC_FASTSSIM (1 << 2) /**< FastSSIM */
+#define VPX_METRIC_PSNRHVS (1 << 3)  /**< PSNR-HVS */
+/*!\brief All of the metrics above */
+#define VPX_METRIC_ALL                                        \
+  (VPX_METRIC_PSNR | VPX_METRIC_SSIM | VPX_METRIC_FASTSSIM | \
+   VPX_METRIC_PSNRHVS)
+
+/*!\brief Frame quality metrics
+ *
+ * Index 0 of the arrays holds the value for the whole frame and indices 1 to
+ * 3 the values for the Y, U and V planes. Metrics that were not requested are
+ * left at zero.
+ */
+typedef struct vpx_frame_metrics {
+  unsigned int samples[4]; /**< Number of samples */
+  uint64_t sse[4];         /**< Sum of squared errors */
+  double psnr[4];          /**< PSNR, in dB */
+  double ssim;             /**< SSIM of the whole frame */
+  double fastssim[4];      /**< FastSSIM, in dB for the whole frame */
+  double psnrhvs[4];       /**< PSNR-HVS, in dB for the whole frame */
+} vpx_frame_metrics_t;
+
+/*!\brief Computes the quality of a reconstructed frame
+ *
+ * Compares \p recon against \p source and fills in the metrics selected by
+ * \p flags. Both images must be planar and have the same format and display
+ * size. For high bit depth images the bit depth is taken from \p recon, as
+ * set by the decoder.
+ *
+ * The frame is split into bands of rows that are spread over \p threads
+ * threads. The results do not depend on the number of threads.
+ *
+ * \param[in]  source          Source image
+ * \param[in]  recon           Reconstructed image
+ * \param[in]  input_bit_depth Bit depth to measure at, lower than the bit
+ *                             depth of the images when the source was
+ *                             upshifted before encoding; 0 to use the bit
+ *                             depth of the images
+ * \param[in]  flags           Bitfield of VPX_METRIC_* flags
+ * \param[in]  threads         Number of threads to use, at least 1
+ * \param[out] metrics         Computed metrics
+ *
+ * \retval #VPX_CODEC_OK
+ *     The metrics were computed.
+ * \retval #VPX_CODEC_INVALID_PARAM
+ *     The images do not match or a parameter is out of range.
+ * \retval #VPX_CODEC_INCAPABLE
+ *     High bit depth images are not supported in this build.
+ * \retval #VPX_CODEC_MEM_ERROR
+ *     The worker threads could not be created.
+ */
+vpx_codec_err_t vpx_calc_frame_metrics(const vpx_image_t *source,
+                                       const vpx_image_t *recon,
+                                       unsigned int input_bit_depth, int flags,
+                                       int threads,
+                                       vpx_frame_metrics_t *metrics);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // VPX_VPX_FRAME_METRICS_H_
@@ -0,0 +1,68 @@
+/*
+ *  Copyright (c) 2017 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef VPX_VPX_MEMORY_ALLOCATOR_H_
+#define VPX_VPX_MEMORY_ALLOCATOR_H_
+
+/*!\file
+ * \brief Describes the external memory allocator interface.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "./vpx_integer.h"
+
+/*!\brief alloc callback prototype
+ *
+ * Returns \p size bytes aligned to \p align, a power of two, or NULL on
+ * failure.
+ *
+ * \param[in] priv     Callback's private data
+ * \param[in] size     Size in bytes of the block
+ * \param[in] align    Required alignment in bytes
+ */
+typedef void *(*vpx_alloc_cb_fn_t)(void *priv, size_t size, size_t align);
+
+/*!\brief free callback prototype
+ *
+ * Releases a block returned by the alloc callback of the same allocator.
+ *
+ * \param[in] priv     Callback's private data
+ * \param[in] mem      Block to release
+ */
+typedef void (*vpx_free_cb_fn_t)(void *priv, void *mem);
+
+/*!\brief External memory allocator
+ *
+ * The codec requests a few large blocks through this interface and carves
+ * its buffers out of them. The callbacks are only called from the thread
+ * calling into the codec.
+ */
+typedef struct vpx_memory_allocator {
+  vpx_alloc_cb_fn_t alloc; /**< Allocates a block */
+  vpx_free_cb_fn_t free;   /**< Releases a block */
+  void *priv;              /**< Private data passed to the callbacks */
+} vpx_memory_allocator_t;
+
+/*!\brief External memory allocator statistics */
+typedef struct vpx_memory_allocator_stats {
+  size_t bytes_reserved;   /**< Size of the blocks currently held */
+  size_t bytes_in_use;     /**< Part of bytes_reserved given to buffers */
+  unsigned int num_allocs; /**< Number of blocks allocated so far */
+  unsigned int num_frees;  /**< Number of blocks released so far */
+} vpx_memory_allocator_stats_t;
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // VPX_VPX_MEMORY_ALLOCATOR_H_
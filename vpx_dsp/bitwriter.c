@@ -26,6 +26,14 @@ void vpx_stop_encode(vpx_writer *br) {
 
   for (i = 0; i < 32; i++) vpx_write_bit(br, 0);
 
+  // Write the completed bytes that have not reached a four byte flush.
+  while (br->count >= 0) {
+    if ((br->lowvalue >> (br->count + 32)) & 1) vpx_writer_carry(br);
+    br->buffer[br->pos++] = (uint8_t)(br->lowvalue >> (br->count + 24));
+    br->lowvalue &= ((uint64_t)1 << (br->count + 24)) - 1;
+    br->count -= 8;
+  }
+
   // Ensure there's no ambigous collision with any index marker bytes
   if ((br->buffer[br->pos - 1] & 0xe0) == 0xc0) br->buffer[br->pos++] = 0;
 }
@@ -19,8 +19,12 @@
 extern "C" {
 #endif
 
+// 'lowvalue' holds the low end of the coding interval along with the
+// 'count' + 32 bits that have not been written to 'buffer' yet. Completed
+// bytes are written out four at a time, so a carry walks back through the
+// buffer at most once per 32 bits.
 typedef struct vpx_writer {
-  unsigned int lowvalue;
+  uint64_t lowvalue;
   unsigned int range;
   int count;
   unsigned int pos;
@@ -30,12 +34,23 @@ typedef struct vpx_writer {
 void vpx_start_encode(vpx_writer *bc, uint8_t *buffer);
 void vpx_stop_encode(vpx_writer *bc);
 
+static INLINE void vpx_writer_carry(vpx_writer *br) {
+  int x = br->pos - 1;
+
+  while (x >= 0 && br->buffer[x] == 0xff) {
+    br->buffer[x] = 0;
+    x--;
+  }
+
+  br->buffer[x] += 1;
+}
+
 static INLINE void vpx_write(vpx_writer *br, int bit, int probability) {
   unsigned int split;
   int count = br->count;
   unsigned int range = br->range;
-  unsigned int lowvalue = br->lowvalue;
-  register int shift;
+  uint64_t lowvalue = br->lowvalue;
+  int shift;
 
   split = 1 + (((range - 1) * probability) >> 8);
 
@@ -49,30 +64,23 @@ static INLINE void vpx_write(vpx_writer *br, int bit, int probability) {
   shift = vpx_norm[range];
 
   range <<= shift;
+  lowvalue <<= shift;
   count += shift;
 
-  if (count >= 0) {
-    int offset = shift - count;
-
-    if ((lowvalue << (offset - 1)) & 0x80000000) {
-      int x = br->pos - 1;
+  if (count >= 24) {
+    uint8_t *const dst = br->buffer + br->pos;
 
-      while (x >= 0 && br->buffer[x] == 0xff) {
-        br->buffer[x] = 0;
-        x--;
-      }
+    if ((lowvalue >> (count + 32)) & 1) vpx_writer_carry(br);
 
-      br->buffer[x] += 1;
-    }
-
-    br->buffer[br->pos++] = (lowvalue >> (24 - offset));
-    lowvalue <<= offset;
-    shift = count;
-    lowvalue &= 0xffffff;
-    count -= 8;
+    dst[0] = (uint8_t)(lowvalue >> (count + 24));
+    dst[1] = (uint8_t)(lowvalue >> (count + 16));
+    dst[2] = (uint8_t)(lowvalue >> (count + 8));
+    dst[3] = (uint8_t)(lowvalue >> count);
+    br->pos += 4;
+    lowvalue &= ((uint64_t)1 << count) - 1;
+    count -= 32;
   }
 
-  lowvalue <<= shift;
   br->count = count;
   br->lowvalue = lowvalue;
   br->range = range;
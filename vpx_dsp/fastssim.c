@@ -467,26 +467,34 @@ static double calc_ssim(const uint8_t *_src, int _systride, const uint8_t *_dst,
   return ret;
 }
 
+double vpx_calc_fastssim_plane(const YV12_BUFFER_CONFIG *source,
+                               const YV12_BUFFER_CONFIG *dest, int plane,
+                               uint32_t bd, uint32_t in_bd) {
+  assert(bd >= in_bd);
+  vpx_clear_system_state();
+  if (plane == 0) {
+    return calc_ssim(source->y_buffer, source->y_stride, dest->y_buffer,
+                     dest->y_stride, source->y_crop_width,
+                     source->y_crop_height, in_bd, bd - in_bd);
+  }
+  return calc_ssim(plane == 1 ? source->u_buffer : source->v_buffer,
+                   source->uv_stride,
+                   plane == 1 ? dest->u_buffer : dest->v_buffer,
+                   dest->uv_stride, source->uv_crop_width,
+                   source->uv_crop_height, in_bd, bd - in_bd);
+}
+
+double vpx_fastssim_to_db(double ssim_y, double ssim_u, double ssim_v) {
+  const double ssimv = ssim_y * .8 + .1 * (ssim_u + ssim_v);
+  return convert_ssim_db(ssimv, 1.0);
+}
+
 double vpx_calc_fastssim(const YV12_BUFFER_CONFIG *source,
                          const YV12_BUFFER_CONFIG *dest, double *ssim_y,
                          double *ssim_u, double *ssim_v, uint32_t bd,
                          uint32_t in_bd) {
-  double ssimv;
-  uint32_t bd_shift = 0;
-  vpx_clear_system_state();
-  assert(bd >= in_bd);
-  bd_shift = bd - in_bd;
-
-  *ssim_y = calc_ssim(source->y_buffer, source->y_stride, dest->y_buffer,
-                      dest->y_stride, source->y_crop_width,
-                      source->y_crop_height, in_bd, bd_shift);
-  *ssim_u = calc_ssim(source->u_buffer, source->uv_stride, dest->u_buffer,
-                      dest->uv_stride, source->uv_crop_width,
-                      source->uv_crop_height, in_bd, bd_shift);
-  *ssim_v = calc_ssim(source->v_buffer, source->uv_stride, dest->v_buffer,
-                      dest->uv_stride, source->uv_crop_width,
-                      source->uv_crop_height, in_bd, bd_shift);
-
-  ssimv = (*ssim_y) * .8 + .1 * ((*ssim_u) + (*ssim_v));
-  return convert_ssim_db(ssimv, 1.0);
+  *ssim_y = vpx_calc_fastssim_plane(source, dest, 0, bd, in_bd);
+  *ssim_u = vpx_calc_fastssim_plane(source, dest, 1, bd, in_bd);
+  *ssim_v = vpx_calc_fastssim_plane(source, dest, 2, bd, in_bd);
+  return vpx_fastssim_to_db(*ssim_y, *ssim_u, *ssim_v);
 }
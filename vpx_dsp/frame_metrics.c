@@ -0,0 +1,279 @@
+/*
+ *  Copyright (c) 2017 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <assert.h>
+#include <string.h>
+
+#include "./vpx_dsp_rtcd.h"
+#include "vpx_dsp/frame_metrics.h"
+#include "vpx_dsp/ssim.h"
+#include "vpx_ports/mem.h"
+#include "vpx_ports/system_state.h"
+#include "vpx_util/vpx_thread.h"
+
+void vpx_frame_metrics_init(FRAME_METRICS_CTX *ctx,
+                            const YV12_BUFFER_CONFIG *source,
+                            const YV12_BUFFER_CONFIG *dest, int flags,
+                            uint32_t bd, uint32_t in_bd) {
+  const int height = source->y_crop_height;
+  int band_rows = VPX_METRICS_MIN_BAND_ROWS;
+
+  while (band_rows * VPX_METRICS_MAX_BANDS < height) band_rows += 8;
+
+  memset(ctx, 0, sizeof(*ctx));
+  ctx->source = source;
+  ctx->dest = dest;
+  ctx->flags = flags;
+  ctx->bd = bd;
+  ctx->in_bd = in_bd;
+  ctx->band_rows = band_rows;
+  if (flags & (VPX_METRIC_PSNR | VPX_METRIC_SSIM | VPX_METRIC_PSNRHVS))
+    ctx->num_bands = (height + band_rows - 1) / band_rows;
+  ctx->num_plane_jobs = (flags & VPX_METRIC_FASTSSIM) ? 3 : 0;
+}
+
+int vpx_frame_metrics_num_jobs(const FRAME_METRICS_CTX *ctx) {
+  return ctx->num_plane_jobs + ctx->num_bands;
+}
+
+// Maps the luma row range of a band to the rows of the given plane. The last
+// band always ends at the bottom of the plane.
+static void get_band_rows(const FRAME_METRICS_CTX *ctx, int band, int plane,
+                          int *row_start, int *row_end) {
+  const YV12_BUFFER_CONFIG *const src = ctx->source;
+  const int ss_y = plane ? src->subsampling_y : 0;
+  const int start = band * ctx->band_rows;
+
+  *row_start = start >> ss_y;
+  if (band == ctx->num_bands - 1)
+    *row_end = plane ? src->uv_crop_height : src->y_crop_height;
+  else
+    *row_end = (start + ctx->band_rows) >> ss_y;
+}
+
+static void calc_band(const FRAME_METRICS_CTX *ctx, int band,
+                      FRAME_METRICS_SUMS *sums) {
+  int plane;
+
+  for (plane = 0; plane < 3; ++plane) {
+    int row_start, row_end;
+    get_band_rows(ctx, band, plane, &row_start, &row_end);
+
+    if (ctx->flags & VPX_METRIC_PSNR)
+      sums->sse[plane] =
+          vpx_get_plane_sse(ctx->source, ctx->dest, plane, row_start, row_end,
+                            ctx->bd, ctx->in_bd);
+    if (ctx->flags & VPX_METRIC_SSIM)
+      sums->ssim[plane] = vpx_ssim_plane_rows(
+          ctx->source, ctx->dest, plane, row_start, row_end, ctx->bd,
+          ctx->in_bd, &sums->ssim_samples[plane]);
+    if (ctx->flags & VPX_METRIC_PSNRHVS)
+      sums->psnrhvs[plane] = vpx_psnrhvs_rows(
+          ctx->source, ctx->dest, plane, ctx->bd, ctx->in_bd, row_start,
+          row_end, &sums->psnrhvs_pixels[plane]);
+  }
+}
+
+void vpx_frame_metrics_job(FRAME_METRICS_CTX *ctx, int job) {
+  FRAME_METRICS_SUMS *const sums = &ctx->sums[job];
+
+  assert(job >= 0 && job < vpx_frame_metrics_num_jobs(ctx));
+  if (job < ctx->num_plane_jobs) {
+    sums->fastssim = vpx_calc_fastssim_plane(ctx->source, ctx->dest, job,
+                                             ctx->bd, ctx->in_bd);
+  } else {
+    calc_band(ctx, job - ctx->num_plane_jobs, sums);
+  }
+}
+
+void vpx_frame_metrics_finish(const FRAME_METRICS_CTX *ctx,
+                              FRAME_METRICS *metrics) {
+  const FRAME_METRICS_SUMS *const bands = ctx->sums + ctx->num_plane_jobs;
+  uint64_t sse[3] = { 0, 0, 0 };
+  double ssim[3] = { 0, 0, 0 };
+  int ssim_samples[3] = { 0, 0, 0 };
+  double hvs[3] = { 0, 0, 0 };
+  int hvs_pixels[3] = { 0, 0, 0 };
+  int band, plane;
+
+  vpx_clear_system_state();
+  memset(metrics, 0, sizeof(*metrics));
+
+  // Bands are always summed in order so the result is reproducible.
+  for (band = 0; band < ctx->num_bands; ++band) {
+    for (plane = 0; plane < 3; ++plane) {
+      sse[plane] += bands[band].sse[plane];
+      ssim[plane] += bands[band].ssim[plane];
+      ssim_samples[plane] += bands[band].ssim_samples[plane];
+      hvs[plane] += bands[band].psnrhvs[plane];
+      hvs_pixels[plane] += bands[band].psnrhvs_pixels[plane];
+    }
+  }
+
+  if (ctx->flags & VPX_METRIC_PSNR) {
+    const double peak = (double)((1 << ctx->in_bd) - 1);
+    vpx_sse_to_psnr_stats(ctx->source, sse, peak, &metrics->psnr);
+  }
+
+  if (ctx->flags & VPX_METRIC_SSIM) {
+    for (plane = 0; plane < 3; ++plane) ssim[plane] /= ssim_samples[plane];
+    metrics->ssim = ssim[0] * .8 + .1 * (ssim[1] + ssim[2]);
+  }
+
+  if (ctx->flags & VPX_METRIC_FASTSSIM) {
+    for (plane = 0; plane < 3; ++plane)
+      metrics->fastssim[1 + plane] = ctx->sums[plane].fastssim;
+    metrics->fastssim[0] = vpx_fastssim_to_db(
+        metrics->fastssim[1], metrics->fastssim[2], metrics->fastssim[3]);
+  }
+
+  if (ctx->flags & VPX_METRIC_PSNRHVS) {
+    for (plane = 0; plane < 3; ++plane) {
+      metrics->psnrhvs[1 + plane] =
+          hvs_pixels[plane] > 0 ? hvs[plane] / hvs_pixels[plane] : 0;
+    }
+    metrics->psnrhvs[0] =
+        vpx_psnrhvs_to_db(metrics->psnrhvs[1], metrics->psnrhvs[2],
+                          metrics->psnrhvs[3], ctx->in_bd);
+  }
+}
+
+void vpx_frame_metrics_calc(const YV12_BUFFER_CONFIG *source,
+                            const YV12_BUFFER_CONFIG *dest, int flags,
+                            uint32_t bd, uint32_t in_bd,
+                            FRAME_METRICS *metrics) {
+  FRAME_METRICS_CTX ctx;
+  int i;
+
+  vpx_frame_metrics_init(&ctx, source, dest, flags, bd, in_bd);
+  for (i = 0; i < vpx_frame_metrics_num_jobs(&ctx); ++i)
+    vpx_frame_metrics_job(&ctx, i);
+  vpx_frame_metrics_finish(&ctx, metrics);
+}
+
+typedef struct {
+  FRAME_METRICS_CTX *ctx;
+  int first_job;
+  int job_step;
+} METRICS_WORKER_DATA;
+
+static int metrics_worker_hook(void *arg1, void *unused) {
+  METRICS_WORKER_DATA *const data = (METRICS_WORKER_DATA *)arg1;
+  const int num_jobs = vpx_frame_metrics_num_jobs(data->ctx);
+  int job;
+  (void)unused;
+
+  for (job = data->first_job; job < num_jobs; job += data->job_step)
+    vpx_frame_metrics_job(data->ctx, job);
+  return 1;
+}
+
+// Describes the display area of img without copying it.
+static void image_to_yv12(const vpx_image_t *img, YV12_BUFFER_CONFIG *yv12) {
+  memset(yv12, 0, sizeof(*yv12));
+  yv12->y_buffer = img->planes[VPX_PLANE_Y];
+  yv12->u_buffer = img->planes[VPX_PLANE_U];
+  yv12->v_buffer = img->planes[VPX_PLANE_V];
+  yv12->y_crop_width = yv12->y_width = img->d_w;
+  yv12->y_crop_height = yv12->y_height = img->d_h;
+  yv12->uv_crop_width = yv12->uv_width =
+      (img->d_w + img->x_chroma_shift) >> img->x_chroma_shift;
+  yv12->uv_crop_height = yv12->uv_height =
+      (img->d_h + img->y_chroma_shift) >> img->y_chroma_shift;
+  yv12->y_stride = img->stride[VPX_PLANE_Y];
+  yv12->uv_stride = img->stride[VPX_PLANE_U];
+  yv12->subsampling_x = img->x_chroma_shift;
+  yv12->subsampling_y = img->y_chroma_shift;
+#if CONFIG_VP9_HIGHBITDEPTH
+  if (img->fmt & VPX_IMG_FMT_HIGHBITDEPTH) {
+    yv12->y_buffer = CONVERT_TO_BYTEPTR(yv12->y_buffer);
+    yv12->u_buffer = CONVERT_TO_BYTEPTR(yv12->u_buffer);
+    yv12->v_buffer = CONVERT_TO_BYTEPTR(yv12->v_buffer);
+    yv12->y_stride >>= 1;
+    yv12->uv_stride >>= 1;
+    yv12->flags = YV12_FLAG_HIGHBITDEPTH;
+  }
+#endif
+}
+
+vpx_codec_err_t vpx_calc_frame_metrics(const vpx_image_t *source,
+                                       const vpx_image_t *recon,
+                                       unsigned int input_bit_depth, int flags,
+                                       int threads,
+                                       vpx_frame_metrics_t *metrics) {
+  const VPxWorkerInterface *const winterface = vpx_get_worker_interface();
+  VPxWorker workers[VPX_METRICS_MAX_JOBS];
+  METRICS_WORKER_DATA data[VPX_METRICS_MAX_JOBS];
+  YV12_BUFFER_CONFIG src, dst;
+  FRAME_METRICS_CTX ctx;
+  FRAME_METRICS result;
+  unsigned int bd = 8;
+  int num_workers, i;
+  int ok = 1;
+
+  if (!source || !recon || !metrics || threads < 1 ||
+      (flags & ~VPX_METRIC_ALL) || !(source->fmt & VPX_IMG_FMT_PLANAR) ||
+      source->fmt != recon->fmt || source->d_w != recon->d_w ||
+      source->d_h != recon->d_h || source->d_w == 0 || source->d_h == 0)
+    return VPX_CODEC_INVALID_PARAM;
+
+  if (recon->fmt & VPX_IMG_FMT_HIGHBITDEPTH) {
+#if CONFIG_VP9_HIGHBITDEPTH
+    bd = recon->bit_depth;
+    if (bd < 8 || bd > 16) return VPX_CODEC_INVALID_PARAM;
+#else
+    return VPX_CODEC_INCAPABLE;
+#endif
+  }
+  if (input_bit_depth == 0) input_bit_depth = bd;
+  if (input_bit_depth < 8 || input_bit_depth > bd)
+    return VPX_CODEC_INVALID_PARAM;
+
+  vpx_dsp_rtcd();
+  image_to_yv12(source, &src);
+  image_to_yv12(recon, &dst);
+  vpx_frame_metrics_init(&ctx, &src, &dst, flags, bd, input_bit_depth);
+
+  // The calling thread runs the last worker's jobs itself.
+  num_workers = VPXMIN(threads, vpx_frame_metrics_num_jobs(&ctx));
+  for (i = 0; i < num_workers; ++i) {
+    VPxWorker *const worker = &workers[i];
+    winterface->init(worker);
+    data[i].ctx = &ctx;
+    data[i].first_job = i;
+    data[i].job_step = num_workers;
+    worker->hook = metrics_worker_hook;
+    worker->data1 = &data[i];
+    worker->data2 = NULL;
+    if (i < num_workers - 1 && !winterface->reset(worker)) {
+      num_workers = i;
+      ok = 0;
+      break;
+    }
+  }
+  if (ok) {
+    for (i = 0; i < num_workers - 1; ++i) winterface->launch(&workers[i]);
+    winterface->execute(&workers[num_workers - 1]);
+  }
+  for (i = 0; i < num_workers; ++i) {
+    winterface->sync(&workers[i]);
+    winterface->end(&workers[i]);
+  }
+  if (!ok) return VPX_CODEC_MEM_ERROR;
+
+  vpx_frame_metrics_finish(&ctx, &result);
+  memcpy(metrics->samples, result.psnr.samples, sizeof(metrics->samples));
+  memcpy(metrics->sse, result.psnr.sse, sizeof(metrics->sse));
+  memcpy(metrics->psnr, result.psnr.psnr, sizeof(metrics->psnr));
+  metrics->ssim = result.ssim;
+  memcpy(metrics->fastssim, result.fastssim, sizeof(metrics->fastssim));
+  memcpy(metrics->psnrhvs, result.psnrhvs, sizeof(metrics->psnrhvs));
+  return VPX_CODEC_OK;
+}
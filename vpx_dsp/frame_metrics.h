@@ -0,0 +1,96 @@
+/*
+ *  Copyright (c) 2017 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef VPX_DSP_FRAME_METRICS_H_
+#define VPX_DSP_FRAME_METRICS_H_
+
+#include "./vpx_config.h"
+#include "vpx/vpx_frame_metrics.h"
+#include "vpx_dsp/psnr.h"
+#include "vpx_scale/yv12config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Computes several quality metrics between two frames in a single pass that
+// can be spread over worker threads. The frame is cut into bands of luma rows
+// and every metric is accumulated per band, except FastSSIM which works on
+// whole planes and gets one job per plane. The band layout only depends on
+// the frame size, so the results do not depend on how the jobs are scheduled.
+//
+// Usage:
+//   vpx_frame_metrics_init(&ctx, source, dest, flags, bd, in_bd);
+//   for (i = 0; i < vpx_frame_metrics_num_jobs(&ctx); ++i)  // any order
+//     vpx_frame_metrics_job(&ctx, i);
+//   vpx_frame_metrics_finish(&ctx, &metrics);
+
+#define VPX_METRICS_MIN_BAND_ROWS 64
+#define VPX_METRICS_MAX_BANDS 64
+#define VPX_METRICS_MAX_JOBS (VPX_METRICS_MAX_BANDS + 3)
+
+typedef struct {
+  PSNR_STATS psnr;     // Same as vpx_calc_psnr() / vpx_calc_highbd_psnr().
+  double ssim;         // Same as vpx_calc_ssim() / vpx_highbd_calc_ssim().
+  double fastssim[4];  // total/y/u/v, same as vpx_calc_fastssim().
+  double psnrhvs[4];   // total/y/u/v, same as vpx_psnrhvs().
+} FRAME_METRICS;
+
+// Partial sums produced by one job.
+typedef struct {
+  uint64_t sse[3];
+  double ssim[3];
+  int ssim_samples[3];
+  double psnrhvs[3];
+  int psnrhvs_pixels[3];
+  double fastssim;
+} FRAME_METRICS_SUMS;
+
+typedef struct {
+  const YV12_BUFFER_CONFIG *source;
+  const YV12_BUFFER_CONFIG *dest;
+  int flags;
+  uint32_t bd;
+  uint32_t in_bd;
+  int band_rows;  // Luma rows per band, a multiple of 8.
+  int num_bands;
+  int num_plane_jobs;
+  FRAME_METRICS_SUMS sums[VPX_METRICS_MAX_JOBS];
+} FRAME_METRICS_CTX;
+
+// bd and in_bd are the coded and input bit depths; both are 8 for 8-bit
+// frames.
+void vpx_frame_metrics_init(FRAME_METRICS_CTX *ctx,
+                            const YV12_BUFFER_CONFIG *source,
+                            const YV12_BUFFER_CONFIG *dest, int flags,
+                            uint32_t bd, uint32_t in_bd);
+
+int vpx_frame_metrics_num_jobs(const FRAME_METRICS_CTX *ctx);
+
+// Runs job number job. Different jobs may run concurrently.
+void vpx_frame_metrics_job(FRAME_METRICS_CTX *ctx, int job);
+
+// Combines the partial sums of all jobs, which must have completed.
+void vpx_frame_metrics_finish(const FRAME_METRICS_CTX *ctx,
+                              FRAME_METRICS *metrics);
+
+// Single threaded convenience wrapper around the functions above.
+// vpx_calc_frame_metrics() in vpx/vpx_frame_metrics.h is the threaded
+// equivalent for vpx_image_t frames.
+void vpx_frame_metrics_calc(const YV12_BUFFER_CONFIG *source,
+                            const YV12_BUFFER_CONFIG *dest, int flags,
+                            uint32_t bd, uint32_t in_bd,
+                            FRAME_METRICS *metrics);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // VPX_DSP_FRAME_METRICS_H_
@@ -48,7 +48,10 @@ typedef const vpx_tree_index vpx_tree[];
 static INLINE vpx_prob get_prob(unsigned int num, unsigned int den) {
   assert(den != 0);
   {
-    const int p = (int)(((uint64_t)num * 256 + (den >> 1)) / den);
+    // The 32-bit division is exact, and cheaper, while num * 256 fits.
+    const int p = ((num | den) < (1u << 23))
+                      ? (int)((num * 256 + (den >> 1)) / den)
+                      : (int)(((uint64_t)num * 256 + (den >> 1)) / den);
     // (p > 255) ? 255 : (p < 1) ? 1 : p;
     const int clipped_prob = p | ((255 - p) >> 23) | (p == 0);
     return (vpx_prob)clipped_prob;
@@ -197,45 +197,54 @@ int64_t vpx_highbd_get_y_sse(const YV12_BUFFER_CONFIG *a,
 }
 #endif  // CONFIG_VP9_HIGHBITDEPTH
 
+uint64_t vpx_get_plane_sse(const YV12_BUFFER_CONFIG *a,
+                           const YV12_BUFFER_CONFIG *b, int plane,
+                           int row_start, int row_end, uint32_t bit_depth,
+                           uint32_t in_bit_depth) {
+  const int w = plane ? a->uv_crop_width : a->y_crop_width;
+  const int h = row_end - row_start;
+  const int a_stride = plane ? a->uv_stride : a->y_stride;
+  const int b_stride = plane ? b->uv_stride : b->y_stride;
+  const uint8_t *const a_planes[3] = { a->y_buffer, a->u_buffer, a->v_buffer };
+  const uint8_t *const b_planes[3] = { b->y_buffer, b->u_buffer, b->v_buffer };
+  const uint8_t *const pa = a_planes[plane] + row_start * a_stride;
+  const uint8_t *const pb = b_planes[plane] + row_start * b_stride;
+
+  assert(row_start >= 0 && row_start <= row_end);
+  assert(row_end <= (plane ? a->uv_crop_height : a->y_crop_height));
 #if CONFIG_VP9_HIGHBITDEPTH
-void vpx_calc_highbd_psnr(const YV12_BUFFER_CONFIG *a,
-                          const YV12_BUFFER_CONFIG *b, PSNR_STATS *psnr,
-                          uint32_t bit_depth, uint32_t in_bit_depth) {
-  const int widths[3] = { a->y_crop_width, a->uv_crop_width, a->uv_crop_width };
-  const int heights[3] = { a->y_crop_height, a->uv_crop_height,
-                           a->uv_crop_height };
-  const uint8_t *a_planes[3] = { a->y_buffer, a->u_buffer, a->v_buffer };
-  const int a_strides[3] = { a->y_stride, a->uv_stride, a->uv_stride };
-  const uint8_t *b_planes[3] = { b->y_buffer, b->u_buffer, b->v_buffer };
-  const int b_strides[3] = { b->y_stride, b->uv_stride, b->uv_stride };
+  if (a->flags & YV12_FLAG_HIGHBITDEPTH) {
+    const unsigned int input_shift = bit_depth - in_bit_depth;
+    if (input_shift)
+      return highbd_get_sse_shift(pa, a_stride, pb, b_stride, w, h,
+                                  input_shift);
+    return highbd_get_sse(pa, a_stride, pb, b_stride, w, h);
+  }
+#else
+  (void)bit_depth;
+  (void)in_bit_depth;
+#endif  // CONFIG_VP9_HIGHBITDEPTH
+  return get_sse(pa, a_stride, pb, b_stride, w, h);
+}
+
+void vpx_sse_to_psnr_stats(const YV12_BUFFER_CONFIG *a, const uint64_t sse[3],
+                           double peak, PSNR_STATS *psnr) {
+  const uint32_t samples[3] = {
+    (uint32_t)(a->y_crop_width * a->y_crop_height),
+    (uint32_t)(a->uv_crop_width * a->uv_crop_height),
+    (uint32_t)(a->uv_crop_width * a->uv_crop_height)
+  };
   int i;
   uint64_t total_sse = 0;
   uint32_t total_samples = 0;
-  const double peak = (double)((1 << in_bit_depth) - 1);
-  const unsigned int input_shift = bit_depth - in_bit_depth;
 
   for (i = 0; i < 3; ++i) {
-    const int w = widths[i];
-    const int h = heights[i];
-    const uint32_t samples = w * h;
-    uint64_t sse;
-    if (a->flags & YV12_FLAG_HIGHBITDEPTH) {
-      if (input_shift) {
-        sse = highbd_get_sse_shift(a_planes[i], a_strides[i], b_planes[i],
-                                   b_strides[i], w, h, input_shift);
-      } else {
-        sse = highbd_get_sse(a_planes[i], a_strides[i], b_planes[i],
-                             b_strides[i], w, h);
-      }
-    } else {
-      sse = get_sse(a_planes[i], a_strides[i], b_planes[i], b_strides[i], w, h);
-    }
-    psnr->sse[1 + i] = sse;
-    psnr->samples[1 + i] = samples;
-    psnr->psnr[1 + i] = vpx_sse_to_psnr(samples, peak, (double)sse);
+    psnr->sse[1 + i] = sse[i];
+    psnr->samples[1 + i] = samples[i];
+    psnr->psnr[1 + i] = vpx_sse_to_psnr(samples[i], peak, (double)sse[i]);
 
-    total_sse += sse;
-    total_samples += samples;
+    total_sse += sse[i];
+    total_samples += samples[i];
   }
 
   psnr->sse[0] = total_sse;
@@ -244,38 +253,30 @@ void vpx_calc_highbd_psnr(const YV12_BUFFER_CONFIG *a,
       vpx_sse_to_psnr((double)total_samples, peak, (double)total_sse);
 }
 
-#endif  // !CONFIG_VP9_HIGHBITDEPTH
+#if CONFIG_VP9_HIGHBITDEPTH
+void vpx_calc_highbd_psnr(const YV12_BUFFER_CONFIG *a,
+                          const YV12_BUFFER_CONFIG *b, PSNR_STATS *psnr,
+                          uint32_t bit_depth, uint32_t in_bit_depth) {
+  uint64_t sse[3];
+  int i;
+
+  for (i = 0; i < 3; ++i) {
+    sse[i] = vpx_get_plane_sse(a, b, i, 0,
+                               i ? a->uv_crop_height : a->y_crop_height,
+                               bit_depth, in_bit_depth);
+  }
+  vpx_sse_to_psnr_stats(a, sse, (double)((1 << in_bit_depth) - 1), psnr);
+}
+#endif  // CONFIG_VP9_HIGHBITDEPTH
 
 void vpx_calc_psnr(const YV12_BUFFER_CONFIG *a, const YV12_BUFFER_CONFIG *b,
                    PSNR_STATS *psnr) {
-  static const double peak = 255.0;
-  const int widths[3] = { a->y_crop_width, a->uv_crop_width, a->uv_crop_width };
-  const int heights[3] = { a->y_crop_height, a->uv_crop_height,
-                           a->uv_crop_height };
-  const uint8_t *a_planes[3] = { a->y_buffer, a->u_buffer, a->v_buffer };
-  const int a_strides[3] = { a->y_stride, a->uv_stride, a->uv_stride };
-  const uint8_t *b_planes[3] = { b->y_buffer, b->u_buffer, b->v_buffer };
-  const int b_strides[3] = { b->y_stride, b->uv_stride, b->uv_stride };
+  uint64_t sse[3];
   int i;
-  uint64_t total_sse = 0;
-  uint32_t total_samples = 0;
 
   for (i = 0; i < 3; ++i) {
-    const int w = widths[i];
-    const int h = heights[i];
-    const uint32_t samples = w * h;
-    const uint64_t sse =
-        get_sse(a_planes[i], a_strides[i], b_planes[i], b_strides[i], w, h);
-    psnr->sse[1 + i] = sse;
-    psnr->samples[1 + i] = samples;
-    psnr->psnr[1 + i] = vpx_sse_to_psnr(samples, peak, (double)sse);
-
-    total_sse += sse;
-    total_samples += samples;
+    sse[i] = vpx_get_plane_sse(a, b, i, 0,
+                               i ? a->uv_crop_height : a->y_crop_height, 8, 8);
   }
-
-  psnr->sse[0] = total_sse;
-  psnr->samples[0] = total_samples;
-  psnr->psnr[0] =
-      vpx_sse_to_psnr((double)total_samples, peak, (double)total_sse);
+  vpx_sse_to_psnr_stats(a, sse, 255.0, psnr);
 }
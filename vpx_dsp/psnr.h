@@ -47,10 +47,32 @@ void vpx_calc_highbd_psnr(const YV12_BUFFER_CONFIG *a,
 void vpx_calc_psnr(const YV12_BUFFER_CONFIG *a, const YV12_BUFFER_CONFIG *b,
                    PSNR_STATS *psnr);
 
+// Returns the sum of squared errors of rows [row_start, row_end) of the
+// given plane (0: y, 1: u, 2: v). bit_depth and in_bit_depth are only used
+// for high bitdepth buffers.
+uint64_t vpx_get_plane_sse(const YV12_BUFFER_CONFIG *a,
+                           const YV12_BUFFER_CONFIG *b, int plane,
+                           int row_start, int row_end, uint32_t bit_depth,
+                           uint32_t in_bit_depth);
+// Fills psnr from the per-plane (y/u/v) SSE of the frame a.
+void vpx_sse_to_psnr_stats(const YV12_BUFFER_CONFIG *a, const uint64_t sse[3],
+                           double peak, PSNR_STATS *psnr);
+
 double vpx_psnrhvs(const YV12_BUFFER_CONFIG *source,
                    const YV12_BUFFER_CONFIG *dest, double *phvs_y,
                    double *phvs_u, double *phvs_v, uint32_t bd, uint32_t in_bd);
 
+// Returns the sum of the PSNR-HVS errors of the 8x8 blocks of the given plane
+// whose top row lies in [row_start, row_end), and adds the number of
+// coefficients visited to *pixels.
+double vpx_psnrhvs_rows(const YV12_BUFFER_CONFIG *src,
+                        const YV12_BUFFER_CONFIG *dest, int plane, uint32_t bd,
+                        uint32_t in_bd, int row_start, int row_end,
+                        int *pixels);
+// Combines the per-plane mean PSNR-HVS errors and converts the result to dB.
+double vpx_psnrhvs_to_db(double y_psnrhvs, double u_psnrhvs, double v_psnrhvs,
+                         uint32_t in_bd);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
@@ -117,10 +117,14 @@ static double convert_score_db(double _score, double _weight, int bit_depth) {
   return 10 * (log10(pix_max * pix_max) - log10(_weight * _score));
 }
 
+/* Returns the sum of the weighted squared errors of the blocks whose top row
+   lies in [row_start, row_end), and adds the number of coefficients visited
+   to *_pixels. */
 static double calc_psnrhvs(const unsigned char *src, int _systride,
                            const unsigned char *dst, int _dystride, double _par,
                            int _w, int _h, int _step, const double _csf[8][8],
-                           uint32_t bit_depth, uint32_t _shift) {
+                           uint32_t bit_depth, uint32_t _shift, int row_start,
+                           int row_end, int *_pixels) {
   double ret;
   const uint8_t *_src8 = src;
   const uint8_t *_dst8 = dst;
@@ -155,7 +159,8 @@ static double calc_psnrhvs(const unsigned char *src, int _systride,
     for (y = 0; y < 8; y++)
       mask[x][y] =
           (_csf[x][y] * 0.3885746225901003) * (_csf[x][y] * 0.3885746225901003);
-  for (y = 0; y < _h - 7; y += _step) {
+  for (y = (row_start + _step - 1) / _step * _step; y < _h - 7 && y < row_end;
+       y += _step) {
     for (x = 0; x < _w - 7; x += _step) {
       int i;
       int j;
@@ -241,35 +246,61 @@ static double calc_psnrhvs(const unsigned char *src, int _systride,
       }
     }
   }
-  if (pixels <= 0) return 0;
-  ret /= pixels;
+  *_pixels += pixels;
   return ret;
 }
 
-double vpx_psnrhvs(const YV12_BUFFER_CONFIG *src,
-                   const YV12_BUFFER_CONFIG *dest, double *y_psnrhvs,
-                   double *u_psnrhvs, double *v_psnrhvs, uint32_t bd,
-                   uint32_t in_bd) {
-  double psnrhvs;
+double vpx_psnrhvs_rows(const YV12_BUFFER_CONFIG *src,
+                        const YV12_BUFFER_CONFIG *dest, int plane, uint32_t bd,
+                        uint32_t in_bd, int row_start, int row_end,
+                        int *pixels) {
   const double par = 1.0;
   const int step = 7;
-  uint32_t bd_shift = 0;
-  vpx_clear_system_state();
-
   assert(bd == 8 || bd == 10 || bd == 12);
   assert(bd >= in_bd);
+  vpx_clear_system_state();
 
-  bd_shift = bd - in_bd;
+  if (plane == 0) {
+    return calc_psnrhvs(src->y_buffer, src->y_stride, dest->y_buffer,
+                        dest->y_stride, par, src->y_crop_width,
+                        src->y_crop_height, step, csf_y, bd, bd - in_bd,
+                        row_start, row_end, pixels);
+  }
+  if (plane == 1) {
+    return calc_psnrhvs(src->u_buffer, src->uv_stride, dest->u_buffer,
+                        dest->uv_stride, par, src->uv_crop_width,
+                        src->uv_crop_height, step, csf_cb420, bd, bd - in_bd,
+                        row_start, row_end, pixels);
+  }
+  return calc_psnrhvs(src->v_buffer, src->uv_stride, dest->v_buffer,
+                      dest->uv_stride, par, src->uv_crop_width,
+                      src->uv_crop_height, step, csf_cr420, bd, bd - in_bd,
+                      row_start, row_end, pixels);
+}
 
-  *y_psnrhvs = calc_psnrhvs(src->y_buffer, src->y_stride, dest->y_buffer,
-                            dest->y_stride, par, src->y_crop_width,
-                            src->y_crop_height, step, csf_y, bd, bd_shift);
-  *u_psnrhvs = calc_psnrhvs(src->u_buffer, src->uv_stride, dest->u_buffer,
-                            dest->uv_stride, par, src->uv_crop_width,
-                            src->uv_crop_height, step, csf_cb420, bd, bd_shift);
-  *v_psnrhvs = calc_psnrhvs(src->v_buffer, src->uv_stride, dest->v_buffer,
-                            dest->uv_stride, par, src->uv_crop_width,
-                            src->uv_crop_height, step, csf_cr420, bd, bd_shift);
-  psnrhvs = (*y_psnrhvs) * .8 + .1 * ((*u_psnrhvs) + (*v_psnrhvs));
+double vpx_psnrhvs_to_db(double y_psnrhvs, double u_psnrhvs, double v_psnrhvs,
+                         uint32_t in_bd) {
+  const double psnrhvs = y_psnrhvs * .8 + .1 * (u_psnrhvs + v_psnrhvs);
   return convert_score_db(psnrhvs, 1.0, in_bd);
 }
+
+static double plane_psnrhvs(const YV12_BUFFER_CONFIG *src,
+                            const YV12_BUFFER_CONFIG *dest, int plane,
+                            uint32_t bd, uint32_t in_bd) {
+  const int height = plane ? src->uv_crop_height : src->y_crop_height;
+  int pixels = 0;
+  const double ret =
+      vpx_psnrhvs_rows(src, dest, plane, bd, in_bd, 0, height, &pixels);
+  if (pixels <= 0) return 0;
+  return ret / pixels;
+}
+
+double vpx_psnrhvs(const YV12_BUFFER_CONFIG *src,
+                   const YV12_BUFFER_CONFIG *dest, double *y_psnrhvs,
+                   double *u_psnrhvs, double *v_psnrhvs, uint32_t bd,
+                   uint32_t in_bd) {
+  *y_psnrhvs = plane_psnrhvs(src, dest, 0, bd, in_bd);
+  *u_psnrhvs = plane_psnrhvs(src, dest, 1, bd, in_bd);
+  *v_psnrhvs = plane_psnrhvs(src, dest, 2, bd, in_bd);
+  return vpx_psnrhvs_to_db(*y_psnrhvs, *u_psnrhvs, *v_psnrhvs, in_bd);
+}
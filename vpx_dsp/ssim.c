@@ -121,50 +121,103 @@ static double highbd_ssim_8x8(const uint16_t *s, int sp, const uint16_t *r,
 // We are using a 8x8 moving window with starting location of each 8x8 window
 // on the 4x4 pixel grid. Such arrangement allows the windows to overlap
 // block boundaries to penalize blocking artifacts.
-static double vpx_ssim2(const uint8_t *img1, const uint8_t *img2,
-                        int stride_img1, int stride_img2, int width,
-                        int height) {
+//
+// Only the windows whose top row lies in [row_start, row_end) are visited, so
+// a plane can be split into row bands whose sums add up to the full result.
+static double ssim2_rows(const uint8_t *img1, const uint8_t *img2,
+                         int stride_img1, int stride_img2, int width,
+                         int height, int row_start, int row_end,
+                         int *samples) {
   int i, j;
-  int samples = 0;
   double ssim_total = 0;
+  const int first = (row_start + 3) & ~3;
 
+  img1 += stride_img1 * first;
+  img2 += stride_img2 * first;
   // sample point start with each 4x4 location
-  for (i = 0; i <= height - 8;
+  for (i = first; i <= height - 8 && i < row_end;
        i += 4, img1 += stride_img1 * 4, img2 += stride_img2 * 4) {
     for (j = 0; j <= width - 8; j += 4) {
       double v = ssim_8x8(img1 + j, stride_img1, img2 + j, stride_img2);
       ssim_total += v;
-      samples++;
+      (*samples)++;
     }
   }
-  ssim_total /= samples;
   return ssim_total;
 }
 
+static double vpx_ssim2(const uint8_t *img1, const uint8_t *img2,
+                        int stride_img1, int stride_img2, int width,
+                        int height) {
+  int samples = 0;
+  const double ssim_total = ssim2_rows(img1, img2, stride_img1, stride_img2,
+                                       width, height, 0, height, &samples);
+  return ssim_total / samples;
+}
+
 #if CONFIG_VP9_HIGHBITDEPTH
-static double vpx_highbd_ssim2(const uint8_t *img1, const uint8_t *img2,
-                               int stride_img1, int stride_img2, int width,
-                               int height, uint32_t bd, uint32_t shift) {
+static double highbd_ssim2_rows(const uint8_t *img1, const uint8_t *img2,
+                                int stride_img1, int stride_img2, int width,
+                                int height, int row_start, int row_end,
+                                uint32_t bd, uint32_t shift, int *samples) {
   int i, j;
-  int samples = 0;
   double ssim_total = 0;
+  const int first = (row_start + 3) & ~3;
 
+  img1 += stride_img1 * first;
+  img2 += stride_img2 * first;
   // sample point start with each 4x4 location
-  for (i = 0; i <= height - 8;
+  for (i = first; i <= height - 8 && i < row_end;
        i += 4, img1 += stride_img1 * 4, img2 += stride_img2 * 4) {
     for (j = 0; j <= width - 8; j += 4) {
       double v = highbd_ssim_8x8(CONVERT_TO_SHORTPTR(img1 + j), stride_img1,
                                  CONVERT_TO_SHORTPTR(img2 + j), stride_img2, bd,
                                  shift);
       ssim_total += v;
-      samples++;
+      (*samples)++;
     }
   }
-  ssim_total /= samples;
   return ssim_total;
 }
+
+static double vpx_highbd_ssim2(const uint8_t *img1, const uint8_t *img2,
+                               int stride_img1, int stride_img2, int width,
+                               int height, uint32_t bd, uint32_t shift) {
+  int samples = 0;
+  const double ssim_total =
+      highbd_ssim2_rows(img1, img2, stride_img1, stride_img2, width, height, 0,
+                        height, bd, shift, &samples);
+  return ssim_total / samples;
+}
 #endif  // CONFIG_VP9_HIGHBITDEPTH
 
+double vpx_ssim_plane_rows(const YV12_BUFFER_CONFIG *source,
+                           const YV12_BUFFER_CONFIG *dest, int plane,
+                           int row_start, int row_end, uint32_t bd,
+                           uint32_t in_bd, int *samples) {
+  const uint8_t *const src_planes[3] = { source->y_buffer, source->u_buffer,
+                                         source->v_buffer };
+  const uint8_t *const dst_planes[3] = { dest->y_buffer, dest->u_buffer,
+                                         dest->v_buffer };
+  const int src_stride = plane ? source->uv_stride : source->y_stride;
+  const int dst_stride = plane ? dest->uv_stride : dest->y_stride;
+  const int width = plane ? source->uv_crop_width : source->y_crop_width;
+  const int height = plane ? source->uv_crop_height : source->y_crop_height;
+
+#if CONFIG_VP9_HIGHBITDEPTH
+  if (source->flags & YV12_FLAG_HIGHBITDEPTH) {
+    assert(bd >= in_bd);
+    return highbd_ssim2_rows(src_planes[plane], dst_planes[plane], src_stride,
+                             dst_stride, width, height, row_start, row_end,
+                             in_bd, bd - in_bd, samples);
+  }
+#endif  // CONFIG_VP9_HIGHBITDEPTH
+  (void)bd;
+  (void)in_bd;
+  return ssim2_rows(src_planes[plane], dst_planes[plane], src_stride,
+                    dst_stride, width, height, row_start, row_end, samples);
+}
+
 double vpx_calc_ssim(const YV12_BUFFER_CONFIG *source,
                      const YV12_BUFFER_CONFIG *dest, double *weight) {
   double a, b, c;
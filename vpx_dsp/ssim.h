@@ -69,11 +69,27 @@ double vpx_get_ssim_metrics(uint8_t *img1, int img1_pitch, uint8_t *img2,
 double vpx_calc_ssim(const YV12_BUFFER_CONFIG *source,
                      const YV12_BUFFER_CONFIG *dest, double *weight);
 
+// Returns the sum of the SSIM of the 8x8 windows of the given plane (0: y,
+// 1: u, 2: v) whose top row lies in [row_start, row_end), and adds the number
+// of windows visited to *samples.
+double vpx_ssim_plane_rows(const YV12_BUFFER_CONFIG *source,
+                           const YV12_BUFFER_CONFIG *dest, int plane,
+                           int row_start, int row_end, uint32_t bd,
+                           uint32_t in_bd, int *samples);
+
 double vpx_calc_fastssim(const YV12_BUFFER_CONFIG *source,
                          const YV12_BUFFER_CONFIG *dest, double *ssim_y,
                          double *ssim_u, double *ssim_v, uint32_t bd,
                          uint32_t in_bd);
 
+// Returns the FastSSIM score of a single plane, before conversion to dB.
+double vpx_calc_fastssim_plane(const YV12_BUFFER_CONFIG *source,
+                               const YV12_BUFFER_CONFIG *dest, int plane,
+                               uint32_t bd, uint32_t in_bd);
+
+// Combines the per-plane FastSSIM scores and converts the result to dB.
+double vpx_fastssim_to_db(double ssim_y, double ssim_u, double ssim_v);
+
 #if CONFIG_VP9_HIGHBITDEPTH
 double vpx_highbd_calc_ssim(const YV12_BUFFER_CONFIG *source,
                             const YV12_BUFFER_CONFIG *dest, double *weight,
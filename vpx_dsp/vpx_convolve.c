@@ -538,6 +538,24 @@ void vpx_highbd_convolve8_avg_c(const uint16_t *src, ptrdiff_t src_stride,
                             bd);
 }
 
+void vpx_highbd_scaled_2d_c(const uint16_t *src, ptrdiff_t src_stride,
+                            uint16_t *dst, ptrdiff_t dst_stride,
+                            const int16_t *filter_x, int x_step_q4,
+                            const int16_t *filter_y, int y_step_q4, int w,
+                            int h, int bd) {
+  vpx_highbd_convolve8_c(src, src_stride, dst, dst_stride, filter_x, x_step_q4,
+                         filter_y, y_step_q4, w, h, bd);
+}
+
+void vpx_highbd_scaled_avg_2d_c(const uint16_t *src, ptrdiff_t src_stride,
+                                uint16_t *dst, ptrdiff_t dst_stride,
+                                const int16_t *filter_x, int x_step_q4,
+                                const int16_t *filter_y, int y_step_q4, int w,
+                                int h, int bd) {
+  vpx_highbd_convolve8_avg_c(src, src_stride, dst, dst_stride, filter_x,
+                             x_step_q4, filter_y, y_step_q4, w, h, bd);
+}
+
 void vpx_highbd_convolve_copy_c(const uint16_t *src, ptrdiff_t src_stride,
                                 uint16_t *dst, ptrdiff_t dst_stride,
                                 const int16_t *filter_x, int filter_x_stride,
@@ -186,9 +186,8 @@ typedef void highbd_filter8_1dfunction(const uint16_t *src_ptr,
                                                y_step_q4, w, h, bd);          \
       }                                                                       \
     } else {                                                                  \
-      vpx_highbd_convolve8_##avg##c(src, src_stride, dst, dst_stride,         \
-                                    filter_x, x_step_q4, filter_y, y_step_q4, \
-                                    w, h, bd);                                \
+      vpx_highbd_scaled_##avg##2d(src, src_stride, dst, dst_stride, filter_x, \
+                                  x_step_q4, filter_y, y_step_q4, w, h, bd);  \
     }                                                                         \
   }
 #endif  // CONFIG_VP9_HIGHBITDEPTH
@@ -9,8 +9,10 @@
  */
 
 #include <immintrin.h>
+#include <string.h>
 
 #include "./vpx_dsp_rtcd.h"
+#include "vpx_dsp/vpx_filter.h"
 #include "vpx_dsp/x86/convolve.h"
 
 // -----------------------------------------------------------------------------
@@ -1104,3 +1106,218 @@ HIGH_FUN_CONV_1D(avg_vert, y_step_q4, filter_y, v, src - src_stride * 3, avg_,
 HIGH_FUN_CONV_2D(avg_, avx2);
 
 #undef HIGHBD_FUNC
+
+// -----------------------------------------------------------------------------
+// Scaled 2D convolution. Every output pixel has its own source position and
+// kernel, so the kernels are applied with _mm256_madd_epi16() on unaligned
+// loads instead of the shuffles used above.
+
+static INLINE __m256i round_shift_scaled(__m256i sum) {
+  const __m256i round = _mm256_set1_epi32(1 << (FILTER_BITS - 1));
+  return _mm256_srai_epi32(_mm256_add_epi32(sum, round), FILTER_BITS);
+}
+
+static INLINE __m256i load_u16_8x2(const uint16_t *lo, const uint16_t *hi) {
+  return _mm256_inserti128_si256(
+      _mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)lo)),
+      _mm_loadu_si128((const __m128i *)hi), 1);
+}
+
+// Returns the rounded sums of 8 consecutive output pixels of a row: pixels 0-3
+// in the low lane and pixels 4-7 in the high lane.
+static INLINE __m256i filter_horiz_scaled_x8(const uint16_t *src,
+                                             const InterpKernel *x_filters,
+                                             int x_q4, int x_step_q4) {
+  __m256i sum[4];
+  int i;
+
+  for (i = 0; i < 4; ++i) {
+    const int q0 = x_q4 + i * x_step_q4;
+    const int q1 = q0 + 4 * x_step_q4;
+    const __m256i s =
+        load_u16_8x2(&src[q0 >> SUBPEL_BITS], &src[q1 >> SUBPEL_BITS]);
+    const __m256i f = _mm256_inserti128_si256(
+        _mm256_castsi128_si256(
+            _mm_load_si128((const __m128i *)x_filters[q0 & SUBPEL_MASK])),
+        _mm_load_si128((const __m128i *)x_filters[q1 & SUBPEL_MASK]), 1);
+    sum[i] = _mm256_madd_epi16(s, f);
+  }
+  return round_shift_scaled(
+      _mm256_hadd_epi32(_mm256_hadd_epi32(sum[0], sum[1]),
+                        _mm256_hadd_epi32(sum[2], sum[3])));
+}
+
+// Same as filter_horiz_scaled_x8() for 4 pixels.
+static INLINE __m128i filter_horiz_scaled_x4(const uint16_t *src,
+                                             const InterpKernel *x_filters,
+                                             int x_q4, int x_step_q4) {
+  __m128i sum[4];
+  int i;
+
+  for (i = 0; i < 4; ++i) {
+    const __m128i s =
+        _mm_loadu_si128((const __m128i *)&src[x_q4 >> SUBPEL_BITS]);
+    const __m128i f =
+        _mm_load_si128((const __m128i *)x_filters[x_q4 & SUBPEL_MASK]);
+    sum[i] = _mm_madd_epi16(s, f);
+    x_q4 += x_step_q4;
+  }
+  return _mm_srai_epi32(
+      _mm_add_epi32(_mm_hadd_epi32(_mm_hadd_epi32(sum[0], sum[1]),
+                                   _mm_hadd_epi32(sum[2], sum[3])),
+                    _mm_set1_epi32(1 << (FILTER_BITS - 1))),
+      FILTER_BITS);
+}
+
+static void highbd_scaledconvolve_horiz_avx2(
+    const uint16_t *src, ptrdiff_t src_stride, uint16_t *dst,
+    ptrdiff_t dst_stride, const InterpKernel *x_filters, int x0_q4,
+    int x_step_q4, int w, int h, int bd) {
+  const __m256i max = _mm256_set1_epi16((1 << bd) - 1);
+  int x, y;
+  src -= SUBPEL_TAPS / 2 - 1;
+
+  for (y = 0; y < h; ++y) {
+    int x_q4 = x0_q4;
+    for (x = 0; x + 16 <= w; x += 16) {
+      const __m256i a =
+          filter_horiz_scaled_x8(src, x_filters, x_q4, x_step_q4);
+      const __m256i b = filter_horiz_scaled_x8(
+          src, x_filters, x_q4 + 8 * x_step_q4, x_step_q4);
+      // The pack interleaves the lanes, 0-3 8-11 | 4-7 12-15.
+      const __m256i p =
+          _mm256_permute4x64_epi64(_mm256_packus_epi32(a, b), 0xd8);
+      _mm256_storeu_si256((__m256i *)&dst[x], _mm256_min_epu16(p, max));
+      x_q4 += 16 * x_step_q4;
+    }
+    if (w - x >= 8) {
+      const __m256i a =
+          filter_horiz_scaled_x8(src, x_filters, x_q4, x_step_q4);
+      const __m256i p =
+          _mm256_permute4x64_epi64(_mm256_packus_epi32(a, a), 0x08);
+      _mm_storeu_si128((__m128i *)&dst[x],
+                       _mm256_castsi256_si128(_mm256_min_epu16(p, max)));
+      x_q4 += 8 * x_step_q4;
+      x += 8;
+    }
+    if (x < w) {
+      const __m128i a =
+          filter_horiz_scaled_x4(src, x_filters, x_q4, x_step_q4);
+      _mm_storel_epi64((__m128i *)&dst[x],
+                       _mm_min_epu16(_mm_packus_epi32(a, a),
+                                     _mm256_castsi256_si128(max)));
+    }
+    src += src_stride;
+    dst += dst_stride;
+  }
+}
+
+static INLINE __m256i filter_vert_scaled(const __m256i *s, const __m256i *f) {
+  return _mm256_add_epi32(
+      _mm256_add_epi32(_mm256_madd_epi16(s[0], f[0]),
+                       _mm256_madd_epi16(s[1], f[1])),
+      _mm256_add_epi32(_mm256_madd_epi16(s[2], f[2]),
+                       _mm256_madd_epi16(s[3], f[3])));
+}
+
+static void highbd_filter_vert_scaled(const uint16_t *src,
+                                      ptrdiff_t src_pitch, uint16_t *dst,
+                                      const int16_t *filter, int w,
+                                      __m256i max) {
+  const __m128i f_values = _mm_load_si128((const __m128i *)filter);
+  const __m256i f_all = _mm256_broadcastsi128_si256(f_values);
+  __m256i f[4];
+  int x;
+
+  // pairs of filter taps
+  f[0] = _mm256_shuffle_epi32(f_all, 0x00);
+  f[1] = _mm256_shuffle_epi32(f_all, 0x55);
+  f[2] = _mm256_shuffle_epi32(f_all, 0xaa);
+  f[3] = _mm256_shuffle_epi32(f_all, 0xff);
+
+  for (x = 0; x + 16 <= w; x += 16) {
+    __m256i r[8], lo[4], hi[4];
+    int i;
+    for (i = 0; i < 8; ++i)
+      r[i] = _mm256_loadu_si256((const __m256i *)&src[i * src_pitch + x]);
+    for (i = 0; i < 4; ++i) {
+      lo[i] = _mm256_unpacklo_epi16(r[2 * i], r[2 * i + 1]);
+      hi[i] = _mm256_unpackhi_epi16(r[2 * i], r[2 * i + 1]);
+    }
+    // The unpacks and the pack both work within 128-bit lanes, so the pixels
+    // come out in order.
+    _mm256_storeu_si256(
+        (__m256i *)&dst[x],
+        _mm256_min_epu16(
+            _mm256_packus_epi32(round_shift_scaled(filter_vert_scaled(lo, f)),
+                                round_shift_scaled(filter_vert_scaled(hi, f))),
+            max));
+  }
+  for (; x < w; x += 4) {
+    // 4 columns of 8 rows, two rows per lane.
+    __m256i s[4];
+    __m256i sum;
+    int i;
+    for (i = 0; i < 4; ++i) {
+      const __m128i r0 =
+          _mm_loadl_epi64((const __m128i *)&src[2 * i * src_pitch + x]);
+      const __m128i r1 =
+          _mm_loadl_epi64((const __m128i *)&src[(2 * i + 1) * src_pitch + x]);
+      s[i] = _mm256_castsi128_si256(_mm_unpacklo_epi16(r0, r1));
+    }
+    sum = round_shift_scaled(filter_vert_scaled(s, f));
+    sum = _mm256_min_epu16(_mm256_packus_epi32(sum, sum), max);
+    _mm_storel_epi64((__m128i *)&dst[x], _mm256_castsi256_si128(sum));
+  }
+}
+
+static void highbd_scaledconvolve_vert_avx2(
+    const uint16_t *src, ptrdiff_t src_stride, uint16_t *dst,
+    ptrdiff_t dst_stride, const InterpKernel *y_filters, int y0_q4,
+    int y_step_q4, int w, int h, int bd) {
+  const __m256i max = _mm256_set1_epi16((1 << bd) - 1);
+  int y;
+  int y_q4 = y0_q4;
+
+  src -= src_stride * (SUBPEL_TAPS / 2 - 1);
+  for (y = 0; y < h; ++y) {
+    const uint16_t *src_y = &src[(y_q4 >> SUBPEL_BITS) * src_stride];
+    const int16_t *const y_filter = y_filters[y_q4 & SUBPEL_MASK];
+    if (y_q4 & SUBPEL_MASK) {
+      highbd_filter_vert_scaled(src_y, src_stride, &dst[y * dst_stride],
+                                y_filter, w, max);
+    } else {
+      memcpy(&dst[y * dst_stride], &src_y[3 * src_stride],
+             w * sizeof(*dst));
+    }
+    y_q4 += y_step_q4;
+  }
+}
+
+void vpx_highbd_scaled_2d_avx2(const uint16_t *src, ptrdiff_t src_stride,
+                               uint16_t *dst, ptrdiff_t dst_stride,
+                               const int16_t *filter_x, int x_step_q4,
+                               const int16_t *filter_y, int y_step_q4, int w,
+                               int h, int bd) {
+  const InterpKernel *const filters_x = get_filter_base(filter_x);
+  const int x0_q4 = get_filter_offset(filter_x, filters_x);
+  const InterpKernel *const filters_y = get_filter_base(filter_y);
+  const int y0_q4 = get_filter_offset(filter_y, filters_y);
+  // Same intermediate buffer as highbd_convolve() in vpx_convolve.c.
+  DECLARE_ALIGNED(32, uint16_t, temp[64 * 135]);
+  const int intermediate_height =
+      (((h - 1) * y_step_q4 + y0_q4) >> SUBPEL_BITS) + SUBPEL_TAPS;
+
+  assert(w <= 64);
+  assert(h <= 64);
+  assert((w & 3) == 0);
+  assert(y_step_q4 <= 32);
+  assert(x_step_q4 <= 32);
+
+  highbd_scaledconvolve_horiz_avx2(src - src_stride * (SUBPEL_TAPS / 2 - 1),
+                                   src_stride, temp, 64, filters_x, x0_q4,
+                                   x_step_q4, w, intermediate_height, bd);
+  highbd_scaledconvolve_vert_avx2(temp + 64 * (SUBPEL_TAPS / 2 - 1), 64, dst,
+                                  dst_stride, filters_y, y0_q4, y_step_q4, w,
+                                  h, bd);
+}
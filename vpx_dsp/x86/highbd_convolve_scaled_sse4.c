@@ -0,0 +1,169 @@
+/*
+ *  Copyright (c) 2017 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <assert.h>
+#include <string.h>
+#include <smmintrin.h>  // SSE4.1
+
+#include "./vpx_dsp_rtcd.h"
+#include "vpx_dsp/vpx_filter.h"
+#include "vpx_ports/mem.h"
+
+// Rounds two vectors of 32-bit filter sums and packs them to 8 pixels clamped
+// to [0, max].
+static INLINE __m128i round_pack_clip(__m128i sum_lo, __m128i sum_hi,
+                                      __m128i max) {
+  const __m128i round = _mm_set1_epi32(1 << (FILTER_BITS - 1));
+  sum_lo = _mm_srai_epi32(_mm_add_epi32(sum_lo, round), FILTER_BITS);
+  sum_hi = _mm_srai_epi32(_mm_add_epi32(sum_hi, round), FILTER_BITS);
+  return _mm_min_epu16(_mm_packus_epi32(sum_lo, sum_hi), max);
+}
+
+// Returns the 32-bit sums of 4 consecutive output pixels of a row, each with
+// its own source position and kernel.
+static INLINE __m128i filter_horiz_x4(const uint16_t *src,
+                                      const InterpKernel *x_filters, int x_q4,
+                                      int x_step_q4) {
+  __m128i sum[4];
+  int i;
+
+  for (i = 0; i < 4; ++i) {
+    const __m128i s =
+        _mm_loadu_si128((const __m128i *)&src[x_q4 >> SUBPEL_BITS]);
+    const __m128i f =
+        _mm_load_si128((const __m128i *)x_filters[x_q4 & SUBPEL_MASK]);
+    sum[i] = _mm_madd_epi16(s, f);
+    x_q4 += x_step_q4;
+  }
+  return _mm_hadd_epi32(_mm_hadd_epi32(sum[0], sum[1]),
+                        _mm_hadd_epi32(sum[2], sum[3]));
+}
+
+static void highbd_scaledconvolve_horiz(const uint16_t *src,
+                                        ptrdiff_t src_stride, uint16_t *dst,
+                                        ptrdiff_t dst_stride,
+                                        const InterpKernel *x_filters,
+                                        int x0_q4, int x_step_q4, int w, int h,
+                                        int bd) {
+  const __m128i max = _mm_set1_epi16((1 << bd) - 1);
+  int x, y;
+  src -= SUBPEL_TAPS / 2 - 1;
+
+  for (y = 0; y < h; ++y) {
+    int x_q4 = x0_q4;
+    for (x = 0; x + 8 <= w; x += 8) {
+      const __m128i lo = filter_horiz_x4(src, x_filters, x_q4, x_step_q4);
+      const __m128i hi =
+          filter_horiz_x4(src, x_filters, x_q4 + 4 * x_step_q4, x_step_q4);
+      _mm_storeu_si128((__m128i *)&dst[x], round_pack_clip(lo, hi, max));
+      x_q4 += 8 * x_step_q4;
+    }
+    if (x < w) {
+      const __m128i lo = filter_horiz_x4(src, x_filters, x_q4, x_step_q4);
+      _mm_storel_epi64((__m128i *)&dst[x], round_pack_clip(lo, lo, max));
+    }
+    src += src_stride;
+    dst += dst_stride;
+  }
+}
+
+static void highbd_filter_vert(const uint16_t *src, ptrdiff_t src_pitch,
+                               uint16_t *dst, const int16_t *filter, int w,
+                               __m128i max) {
+  const __m128i f_values = _mm_load_si128((const __m128i *)filter);
+  // pairs of filter taps
+  const __m128i f1f0 = _mm_shuffle_epi32(f_values, 0x00);
+  const __m128i f3f2 = _mm_shuffle_epi32(f_values, 0x55);
+  const __m128i f5f4 = _mm_shuffle_epi32(f_values, 0xaa);
+  const __m128i f7f6 = _mm_shuffle_epi32(f_values, 0xff);
+  int x;
+
+  for (x = 0; x < w; x += 8) {
+    __m128i s[8], sum_lo, sum_hi;
+    int i;
+    if (w - x >= 8) {
+      for (i = 0; i < 8; ++i)
+        s[i] = _mm_loadu_si128((const __m128i *)&src[i * src_pitch + x]);
+    } else {
+      for (i = 0; i < 8; ++i)
+        s[i] = _mm_loadl_epi64((const __m128i *)&src[i * src_pitch + x]);
+    }
+    sum_lo = _mm_add_epi32(
+        _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(s[0], s[1]), f1f0),
+                      _mm_madd_epi16(_mm_unpacklo_epi16(s[2], s[3]), f3f2)),
+        _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(s[4], s[5]), f5f4),
+                      _mm_madd_epi16(_mm_unpacklo_epi16(s[6], s[7]), f7f6)));
+    sum_hi = _mm_add_epi32(
+        _mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(s[0], s[1]), f1f0),
+                      _mm_madd_epi16(_mm_unpackhi_epi16(s[2], s[3]), f3f2)),
+        _mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(s[4], s[5]), f5f4),
+                      _mm_madd_epi16(_mm_unpackhi_epi16(s[6], s[7]), f7f6)));
+    if (w - x >= 8) {
+      _mm_storeu_si128((__m128i *)&dst[x],
+                       round_pack_clip(sum_lo, sum_hi, max));
+    } else {
+      _mm_storel_epi64((__m128i *)&dst[x],
+                       round_pack_clip(sum_lo, sum_lo, max));
+    }
+  }
+}
+
+static void highbd_scaledconvolve_vert(const uint16_t *src,
+                                       ptrdiff_t src_stride, uint16_t *dst,
+                                       ptrdiff_t dst_stride,
+                                       const InterpKernel *y_filters,
+                                       int y0_q4, int y_step_q4, int w, int h,
+                                       int bd) {
+  const __m128i max = _mm_set1_epi16((1 << bd) - 1);
+  int y;
+  int y_q4 = y0_q4;
+
+  src -= src_stride * (SUBPEL_TAPS / 2 - 1);
+  for (y = 0; y < h; ++y) {
+    const uint16_t *src_y = &src[(y_q4 >> SUBPEL_BITS) * src_stride];
+    const int16_t *const y_filter = y_filters[y_q4 & SUBPEL_MASK];
+    if (y_q4 & SUBPEL_MASK) {
+      highbd_filter_vert(src_y, src_stride, &dst[y * dst_stride], y_filter, w,
+                         max);
+    } else {
+      memcpy(&dst[y * dst_stride], &src_y[3 * src_stride],
+             w * sizeof(*dst));
+    }
+    y_q4 += y_step_q4;
+  }
+}
+
+void vpx_highbd_scaled_2d_sse4_1(const uint16_t *src, ptrdiff_t src_stride,
+                                 uint16_t *dst, ptrdiff_t dst_stride,
+                                 const int16_t *filter_x, int x_step_q4,
+                                 const int16_t *filter_y, int y_step_q4, int w,
+                                 int h, int bd) {
+  const InterpKernel *const filters_x = get_filter_base(filter_x);
+  const int x0_q4 = get_filter_offset(filter_x, filters_x);
+  const InterpKernel *const filters_y = get_filter_base(filter_y);
+  const int y0_q4 = get_filter_offset(filter_y, filters_y);
+  // Same intermediate buffer as highbd_convolve() in vpx_convolve.c.
+  DECLARE_ALIGNED(16, uint16_t, temp[64 * 135]);
+  const int intermediate_height =
+      (((h - 1) * y_step_q4 + y0_q4) >> SUBPEL_BITS) + SUBPEL_TAPS;
+
+  assert(w <= 64);
+  assert(h <= 64);
+  assert((w & 3) == 0);
+  assert(y_step_q4 <= 32);
+  assert(x_step_q4 <= 32);
+
+  highbd_scaledconvolve_horiz(src - src_stride * (SUBPEL_TAPS / 2 - 1),
+                              src_stride, temp, 64, filters_x, x0_q4,
+                              x_step_q4, w, intermediate_height, bd);
+  highbd_scaledconvolve_vert(temp + 64 * (SUBPEL_TAPS / 2 - 1), 64, dst,
+                             dst_stride, filters_y, y0_q4, y_step_q4, w, h,
+                             bd);
+}
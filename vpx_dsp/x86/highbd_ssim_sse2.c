@@ -0,0 +1,51 @@
+/*
+ *  Copyright (c) 2017 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <emmintrin.h>
+
+#include "./vpx_dsp_rtcd.h"
+#include "vpx_ports/mem.h"
+
+static INLINE uint32_t hsum_epi32(__m128i v) {
+  v = _mm_add_epi32(v, _mm_srli_si128(v, 8));
+  v = _mm_add_epi32(v, _mm_srli_si128(v, 4));
+  return (uint32_t)_mm_cvtsi128_si32(v);
+}
+
+// Pixels of up to 12 bits keep every pairwise product sum of _mm_madd_epi16()
+// and the per lane totals within 31 bits.
+void vpx_highbd_ssim_parms_8x8_sse2(const uint16_t *s, int sp,
+                                    const uint16_t *r, int rp, uint32_t *sum_s,
+                                    uint32_t *sum_r, uint32_t *sum_sq_s,
+                                    uint32_t *sum_sq_r, uint32_t *sum_sxr) {
+  const __m128i one = _mm_set1_epi16(1);
+  __m128i s_acc = _mm_setzero_si128();
+  __m128i r_acc = _mm_setzero_si128();
+  __m128i sq_s_acc = _mm_setzero_si128();
+  __m128i sq_r_acc = _mm_setzero_si128();
+  __m128i sxr_acc = _mm_setzero_si128();
+  int i;
+
+  for (i = 0; i < 8; i++, s += sp, r += rp) {
+    const __m128i s8 = _mm_loadu_si128((const __m128i *)s);
+    const __m128i r8 = _mm_loadu_si128((const __m128i *)r);
+    s_acc = _mm_add_epi32(s_acc, _mm_madd_epi16(s8, one));
+    r_acc = _mm_add_epi32(r_acc, _mm_madd_epi16(r8, one));
+    sq_s_acc = _mm_add_epi32(sq_s_acc, _mm_madd_epi16(s8, s8));
+    sq_r_acc = _mm_add_epi32(sq_r_acc, _mm_madd_epi16(r8, r8));
+    sxr_acc = _mm_add_epi32(sxr_acc, _mm_madd_epi16(s8, r8));
+  }
+
+  *sum_s += hsum_epi32(s_acc);
+  *sum_r += hsum_epi32(r_acc);
+  *sum_sq_s += hsum_epi32(sq_s_acc);
+  *sum_sq_r += hsum_epi32(sq_r_acc);
+  *sum_sxr += hsum_epi32(sxr_acc);
+}
@@ -0,0 +1,100 @@
+/*
+ *  Copyright (c) 2017 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <immintrin.h>
+
+#include "./vpx_config.h"
+#include "./vpx_dsp_rtcd.h"
+#include "vpx_ports/mem.h"
+
+static INLINE uint32_t hsum_epi32(__m256i v) {
+  __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(v),
+                              _mm256_extracti128_si256(v, 1));
+  sum = _mm_add_epi32(sum, _mm_srli_si128(sum, 8));
+  sum = _mm_add_epi32(sum, _mm_srli_si128(sum, 4));
+  return (uint32_t)_mm_cvtsi128_si32(sum);
+}
+
+// s and r hold two rows of 8 16-bit pixels each. Pixels of up to 12 bits keep
+// every pairwise product sum of _mm256_madd_epi16() within 31 bits.
+static INLINE void accumulate_rows(__m256i s, __m256i r, __m256i *sum_s,
+                                   __m256i *sum_r, __m256i *sum_sq_s,
+                                   __m256i *sum_sq_r, __m256i *sum_sxr) {
+  const __m256i one = _mm256_set1_epi16(1);
+  *sum_s = _mm256_add_epi32(*sum_s, _mm256_madd_epi16(s, one));
+  *sum_r = _mm256_add_epi32(*sum_r, _mm256_madd_epi16(r, one));
+  *sum_sq_s = _mm256_add_epi32(*sum_sq_s, _mm256_madd_epi16(s, s));
+  *sum_sq_r = _mm256_add_epi32(*sum_sq_r, _mm256_madd_epi16(r, r));
+  *sum_sxr = _mm256_add_epi32(*sum_sxr, _mm256_madd_epi16(s, r));
+}
+
+static INLINE void store_sums(__m256i s, __m256i r, __m256i sq_s, __m256i sq_r,
+                              __m256i sxr, uint32_t *sum_s, uint32_t *sum_r,
+                              uint32_t *sum_sq_s, uint32_t *sum_sq_r,
+                              uint32_t *sum_sxr) {
+  *sum_s += hsum_epi32(s);
+  *sum_r += hsum_epi32(r);
+  *sum_sq_s += hsum_epi32(sq_s);
+  *sum_sq_r += hsum_epi32(sq_r);
+  *sum_sxr += hsum_epi32(sxr);
+}
+
+static INLINE __m256i load_u8_rows(const uint8_t *p, int stride) {
+  const __m128i rows = _mm_unpacklo_epi64(
+      _mm_loadl_epi64((const __m128i *)p),
+      _mm_loadl_epi64((const __m128i *)(p + stride)));
+  return _mm256_cvtepu8_epi16(rows);
+}
+
+void vpx_ssim_parms_8x8_avx2(const uint8_t *s, int sp, const uint8_t *r,
+                             int rp, uint32_t *sum_s, uint32_t *sum_r,
+                             uint32_t *sum_sq_s, uint32_t *sum_sq_r,
+                             uint32_t *sum_sxr) {
+  __m256i s_acc = _mm256_setzero_si256();
+  __m256i r_acc = _mm256_setzero_si256();
+  __m256i sq_s_acc = _mm256_setzero_si256();
+  __m256i sq_r_acc = _mm256_setzero_si256();
+  __m256i sxr_acc = _mm256_setzero_si256();
+  int i;
+
+  for (i = 0; i < 8; i += 2, s += 2 * sp, r += 2 * rp) {
+    accumulate_rows(load_u8_rows(s, sp), load_u8_rows(r, rp), &s_acc, &r_acc,
+                    &sq_s_acc, &sq_r_acc, &sxr_acc);
+  }
+  store_sums(s_acc, r_acc, sq_s_acc, sq_r_acc, sxr_acc, sum_s, sum_r, sum_sq_s,
+             sum_sq_r, sum_sxr);
+}
+
+#if CONFIG_VP9_HIGHBITDEPTH
+static INLINE __m256i load_u16_rows(const uint16_t *p, int stride) {
+  return _mm256_inserti128_si256(
+      _mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)p)),
+      _mm_loadu_si128((const __m128i *)(p + stride)), 1);
+}
+
+void vpx_highbd_ssim_parms_8x8_avx2(const uint16_t *s, int sp,
+                                    const uint16_t *r, int rp, uint32_t *sum_s,
+                                    uint32_t *sum_r, uint32_t *sum_sq_s,
+                                    uint32_t *sum_sq_r, uint32_t *sum_sxr) {
+  __m256i s_acc = _mm256_setzero_si256();
+  __m256i r_acc = _mm256_setzero_si256();
+  __m256i sq_s_acc = _mm256_setzero_si256();
+  __m256i sq_r_acc = _mm256_setzero_si256();
+  __m256i sxr_acc = _mm256_setzero_si256();
+  int i;
+
+  for (i = 0; i < 8; i += 2, s += 2 * sp, r += 2 * rp) {
+    accumulate_rows(load_u16_rows(s, sp), load_u16_rows(r, rp), &s_acc, &r_acc,
+                    &sq_s_acc, &sq_r_acc, &sxr_acc);
+  }
+  store_sums(s_acc, r_acc, sq_s_acc, sq_r_acc, sxr_acc, sum_s, sum_r, sum_sq_s,
+             sum_sq_r, sum_sxr);
+}
+#endif  // CONFIG_VP9_HIGHBITDEPTH
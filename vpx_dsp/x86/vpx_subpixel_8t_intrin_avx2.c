@@ -10,7 +10,10 @@
 
 #include <immintrin.h>
 
+#include <string.h>
+
 #include "./vpx_dsp_rtcd.h"
+#include "vpx_dsp/vpx_filter.h"
 #include "vpx_dsp/x86/convolve.h"
 #include "vpx_ports/mem.h"
 
@@ -571,4 +574,262 @@ FUN_CONV_1D(vert, y_step_q4, filter_y, v, src - src_stride * 3, , avx2);
 //                          const int16_t *filter_y, int y_step_q4,
 //                          int w, int h);
 FUN_CONV_2D(, avx2);
+
+// Loads 8 pixels from src into the low lane and 8 pixels from
+// src + lane_offset into the high lane.
+static INLINE __m256i load_8x2(const uint8_t *src, ptrdiff_t lane_offset) {
+  return _mm256_inserti128_si256(
+      _mm256_castsi128_si256(_mm_loadl_epi64((const __m128i *)src)),
+      _mm_loadl_epi64((const __m128i *)(src + lane_offset)), 1);
+}
+
+// Same as filter_horiz_w8_ssse3() but filters 2 groups of 8 rows at once, the
+// second one starting lane_offset bytes after the first. The 16 results are
+// stored to dst.
+static void filter_horiz_w8x2_avx2(const uint8_t *src_x, ptrdiff_t src_pitch,
+                                   ptrdiff_t lane_offset, uint8_t *dst,
+                                   const int16_t *x_filter) {
+  const __m256i k_256 = _mm256_set1_epi16(1 << 8);
+  const __m128i f_values = _mm_load_si128((const __m128i *)x_filter);
+  const __m256i f = MM256_BROADCASTSI128_SI256(f_values);
+  // pack and duplicate the filter values
+  const __m256i f1f0 = _mm256_shuffle_epi8(f, _mm256_set1_epi16(0x0200u));
+  const __m256i f3f2 = _mm256_shuffle_epi8(f, _mm256_set1_epi16(0x0604u));
+  const __m256i f5f4 = _mm256_shuffle_epi8(f, _mm256_set1_epi16(0x0a08u));
+  const __m256i f7f6 = _mm256_shuffle_epi8(f, _mm256_set1_epi16(0x0e0cu));
+  const __m256i A = load_8x2(src_x, lane_offset);
+  const __m256i B = load_8x2(src_x + src_pitch, lane_offset);
+  const __m256i C = load_8x2(src_x + src_pitch * 2, lane_offset);
+  const __m256i D = load_8x2(src_x + src_pitch * 3, lane_offset);
+  const __m256i E = load_8x2(src_x + src_pitch * 4, lane_offset);
+  const __m256i F = load_8x2(src_x + src_pitch * 5, lane_offset);
+  const __m256i G = load_8x2(src_x + src_pitch * 6, lane_offset);
+  const __m256i H = load_8x2(src_x + src_pitch * 7, lane_offset);
+  // Transpose each lane as in filter_horiz_w8_ssse3().
+  const __m256i tr0_0 = _mm256_unpacklo_epi16(A, B);
+  const __m256i tr0_1 = _mm256_unpacklo_epi16(C, D);
+  const __m256i tr0_2 = _mm256_unpacklo_epi16(E, F);
+  const __m256i tr0_3 = _mm256_unpacklo_epi16(G, H);
+  const __m256i tr1_0 = _mm256_unpacklo_epi32(tr0_0, tr0_1);
+  const __m256i tr1_1 = _mm256_unpackhi_epi32(tr0_0, tr0_1);
+  const __m256i tr1_2 = _mm256_unpacklo_epi32(tr0_2, tr0_3);
+  const __m256i tr1_3 = _mm256_unpackhi_epi32(tr0_2, tr0_3);
+  const __m256i s1s0 = _mm256_unpacklo_epi64(tr1_0, tr1_2);
+  const __m256i s3s2 = _mm256_unpackhi_epi64(tr1_0, tr1_2);
+  const __m256i s5s4 = _mm256_unpacklo_epi64(tr1_1, tr1_3);
+  const __m256i s7s6 = _mm256_unpackhi_epi64(tr1_1, tr1_3);
+  // multiply 2 adjacent elements with the filter and add the result
+  const __m256i x0 = _mm256_maddubs_epi16(s1s0, f1f0);
+  const __m256i x1 = _mm256_maddubs_epi16(s3s2, f3f2);
+  const __m256i x2 = _mm256_maddubs_epi16(s5s4, f5f4);
+  const __m256i x3 = _mm256_maddubs_epi16(s7s6, f7f6);
+  // add and saturate the results together in the same order as the ssse3
+  // version so the results are identical
+  const __m256i min_x2x1 = _mm256_min_epi16(x2, x1);
+  const __m256i max_x2x1 = _mm256_max_epi16(x2, x1);
+  __m256i temp = _mm256_adds_epi16(x0, x3);
+  temp = _mm256_adds_epi16(temp, min_x2x1);
+  temp = _mm256_adds_epi16(temp, max_x2x1);
+  // round and shift by 7 bit each 16 bit
+  temp = _mm256_mulhrs_epi16(temp, k_256);
+  // shrink to 8 bit each 16 bits and gather the low 8 bytes of each lane
+  temp = _mm256_packus_epi16(temp, temp);
+  temp = _mm256_permute4x64_epi64(temp, 0x08);
+  _mm_storeu_si128((__m128i *)dst, _mm256_castsi256_si128(temp));
+}
+
+static void transpose8x8_to_dst(const uint8_t *src, ptrdiff_t src_stride,
+                                uint8_t *dst, ptrdiff_t dst_stride) {
+  const __m128i A = _mm_loadl_epi64((const __m128i *)src);
+  const __m128i B = _mm_loadl_epi64((const __m128i *)(src + src_stride));
+  const __m128i C = _mm_loadl_epi64((const __m128i *)(src + src_stride * 2));
+  const __m128i D = _mm_loadl_epi64((const __m128i *)(src + src_stride * 3));
+  const __m128i E = _mm_loadl_epi64((const __m128i *)(src + src_stride * 4));
+  const __m128i F = _mm_loadl_epi64((const __m128i *)(src + src_stride * 5));
+  const __m128i G = _mm_loadl_epi64((const __m128i *)(src + src_stride * 6));
+  const __m128i H = _mm_loadl_epi64((const __m128i *)(src + src_stride * 7));
+  const __m128i tr0_0 = _mm_unpacklo_epi8(A, B);
+  const __m128i tr0_1 = _mm_unpacklo_epi8(C, D);
+  const __m128i tr0_2 = _mm_unpacklo_epi8(E, F);
+  const __m128i tr0_3 = _mm_unpacklo_epi8(G, H);
+  const __m128i tr1_0 = _mm_unpacklo_epi16(tr0_0, tr0_1);
+  const __m128i tr1_1 = _mm_unpackhi_epi16(tr0_0, tr0_1);
+  const __m128i tr1_2 = _mm_unpacklo_epi16(tr0_2, tr0_3);
+  const __m128i tr1_3 = _mm_unpackhi_epi16(tr0_2, tr0_3);
+  const __m128i tr2_0 = _mm_unpacklo_epi32(tr1_0, tr1_2);
+  const __m128i tr2_1 = _mm_unpackhi_epi32(tr1_0, tr1_2);
+  const __m128i tr2_2 = _mm_unpacklo_epi32(tr1_1, tr1_3);
+  const __m128i tr2_3 = _mm_unpackhi_epi32(tr1_1, tr1_3);
+
+  _mm_storel_epi64((__m128i *)dst, tr2_0);
+  _mm_storel_epi64((__m128i *)(dst + dst_stride), _mm_srli_si128(tr2_0, 8));
+  _mm_storel_epi64((__m128i *)(dst + dst_stride * 2), tr2_1);
+  _mm_storel_epi64((__m128i *)(dst + dst_stride * 3), _mm_srli_si128(tr2_1, 8));
+  _mm_storel_epi64((__m128i *)(dst + dst_stride * 4), tr2_2);
+  _mm_storel_epi64((__m128i *)(dst + dst_stride * 5), _mm_srli_si128(tr2_2, 8));
+  _mm_storel_epi64((__m128i *)(dst + dst_stride * 6), tr2_3);
+  _mm_storel_epi64((__m128i *)(dst + dst_stride * 7), _mm_srli_si128(tr2_3, 8));
+}
+
+static void scaledconvolve_horiz_w8(const uint8_t *src, ptrdiff_t src_stride,
+                                    uint8_t *dst, ptrdiff_t dst_stride,
+                                    const InterpKernel *x_filters, int x0_q4,
+                                    int x_step_q4, int w, int h) {
+  DECLARE_ALIGNED(16, uint8_t, temp[8 * 16]);
+  int x, y, z, rows;
+  src -= SUBPEL_TAPS / 2 - 1;
+
+  // Same row count as the ssse3 version, which works on 8 rows at a time, so
+  // no rows beyond the ones it reads are touched. 16 rows are filtered per
+  // step while at least 16 remain.
+  y = h + (8 - (h & 0x7));
+
+  do {
+    const ptrdiff_t lane_offset = y >= 16 ? src_stride * 8 : 0;
+    int x_q4 = x0_q4;
+    rows = y >= 16 ? 16 : 8;
+    for (x = 0; x < w; x += 8) {
+      // process 8 src_x steps, each column of temp holds 16 rows
+      for (z = 0; z < 8; ++z) {
+        const uint8_t *const src_x = &src[x_q4 >> SUBPEL_BITS];
+        const int16_t *const x_filter = x_filters[x_q4 & SUBPEL_MASK];
+        if (x_q4 & SUBPEL_MASK) {
+          filter_horiz_w8x2_avx2(src_x, src_stride, lane_offset, temp + z * 16,
+                                 x_filter);
+        } else {
+          int i;
+          for (i = 0; i < rows; ++i) {
+            temp[z * 16 + i] = src_x[i * src_stride + 3];
+          }
+        }
+        x_q4 += x_step_q4;
+      }
+
+      // transpose the filtered values back to dst
+      transpose8x8_to_dst(temp, 16, dst + x, dst_stride);
+      if (rows == 16)
+        transpose8x8_to_dst(temp + 8, 16, dst + x + dst_stride * 8,
+                            dst_stride);
+    }
+
+    src += src_stride * rows;
+    dst += dst_stride * rows;
+  } while (y -= rows);
+}
+
+static void filter_vert_w32_avx2(const uint8_t *src_ptr, ptrdiff_t src_pitch,
+                                 uint8_t *dst, const int16_t *filter, int w) {
+  const __m256i k_256 = _mm256_set1_epi16(1 << 8);
+  const __m128i f_values = _mm_load_si128((const __m128i *)filter);
+  const __m256i f = MM256_BROADCASTSI128_SI256(f_values);
+  // pack and duplicate the filter values
+  const __m256i f1f0 = _mm256_shuffle_epi8(f, _mm256_set1_epi16(0x0200u));
+  const __m256i f3f2 = _mm256_shuffle_epi8(f, _mm256_set1_epi16(0x0604u));
+  const __m256i f5f4 = _mm256_shuffle_epi8(f, _mm256_set1_epi16(0x0a08u));
+  const __m256i f7f6 = _mm256_shuffle_epi8(f, _mm256_set1_epi16(0x0e0cu));
+  int i;
+
+  for (i = 0; i < w; i += 32) {
+    const __m256i A = _mm256_loadu_si256((const __m256i *)src_ptr);
+    const __m256i B =
+        _mm256_loadu_si256((const __m256i *)(src_ptr + src_pitch));
+    const __m256i C =
+        _mm256_loadu_si256((const __m256i *)(src_ptr + src_pitch * 2));
+    const __m256i D =
+        _mm256_loadu_si256((const __m256i *)(src_ptr + src_pitch * 3));
+    const __m256i E =
+        _mm256_loadu_si256((const __m256i *)(src_ptr + src_pitch * 4));
+    const __m256i F =
+        _mm256_loadu_si256((const __m256i *)(src_ptr + src_pitch * 5));
+    const __m256i G =
+        _mm256_loadu_si256((const __m256i *)(src_ptr + src_pitch * 6));
+    const __m256i H =
+        _mm256_loadu_si256((const __m256i *)(src_ptr + src_pitch * 7));
+    // The unpacks work within 128-bit lanes, which the final pack undoes.
+    const __m256i x0_lo =
+        _mm256_maddubs_epi16(_mm256_unpacklo_epi8(A, B), f1f0);
+    const __m256i x0_hi =
+        _mm256_maddubs_epi16(_mm256_unpackhi_epi8(A, B), f1f0);
+    const __m256i x1_lo =
+        _mm256_maddubs_epi16(_mm256_unpacklo_epi8(C, D), f3f2);
+    const __m256i x1_hi =
+        _mm256_maddubs_epi16(_mm256_unpackhi_epi8(C, D), f3f2);
+    const __m256i x2_lo =
+        _mm256_maddubs_epi16(_mm256_unpacklo_epi8(E, F), f5f4);
+    const __m256i x2_hi =
+        _mm256_maddubs_epi16(_mm256_unpackhi_epi8(E, F), f5f4);
+    const __m256i x3_lo =
+        _mm256_maddubs_epi16(_mm256_unpacklo_epi8(G, H), f7f6);
+    const __m256i x3_hi =
+        _mm256_maddubs_epi16(_mm256_unpackhi_epi8(G, H), f7f6);
+    // add and saturate the results together
+    __m256i temp_lo = _mm256_adds_epi16(x0_lo, x3_lo);
+    __m256i temp_hi = _mm256_adds_epi16(x0_hi, x3_hi);
+    temp_lo = _mm256_adds_epi16(temp_lo, _mm256_min_epi16(x1_lo, x2_lo));
+    temp_hi = _mm256_adds_epi16(temp_hi, _mm256_min_epi16(x1_hi, x2_hi));
+    temp_lo = _mm256_adds_epi16(temp_lo, _mm256_max_epi16(x1_lo, x2_lo));
+    temp_hi = _mm256_adds_epi16(temp_hi, _mm256_max_epi16(x1_hi, x2_hi));
+    // round and shift by 7 bit each 16 bit
+    temp_lo = _mm256_mulhrs_epi16(temp_lo, k_256);
+    temp_hi = _mm256_mulhrs_epi16(temp_hi, k_256);
+    src_ptr += 32;
+    _mm256_storeu_si256((__m256i *)&dst[i],
+                        _mm256_packus_epi16(temp_lo, temp_hi));
+  }
+}
+
+static void scaledconvolve_vert_w32(const uint8_t *src, ptrdiff_t src_stride,
+                                    uint8_t *dst, ptrdiff_t dst_stride,
+                                    const InterpKernel *y_filters, int y0_q4,
+                                    int y_step_q4, int w, int h) {
+  int y;
+  int y_q4 = y0_q4;
+
+  src -= src_stride * (SUBPEL_TAPS / 2 - 1);
+  for (y = 0; y < h; ++y) {
+    const unsigned char *src_y = &src[(y_q4 >> SUBPEL_BITS) * src_stride];
+    const int16_t *const y_filter = y_filters[y_q4 & SUBPEL_MASK];
+    if (y_q4 & SUBPEL_MASK) {
+      filter_vert_w32_avx2(src_y, src_stride, &dst[y * dst_stride], y_filter,
+                           w);
+    } else {
+      memcpy(&dst[y * dst_stride], &src_y[3 * src_stride], w);
+    }
+    y_q4 += y_step_q4;
+  }
+}
+
+// Bit exact with vpx_scaled_2d_ssse3(), which handles blocks narrower than 32.
+void vpx_scaled_2d_avx2(const uint8_t *src, ptrdiff_t src_stride, uint8_t *dst,
+                        ptrdiff_t dst_stride, const int16_t *filter_x,
+                        int x_step_q4, const int16_t *filter_y, int y_step_q4,
+                        int w, int h) {
+  const InterpKernel *const filters_x = get_filter_base(filter_x);
+  const int x0_q4 = get_filter_offset(filter_x, filters_x);
+  const InterpKernel *const filters_y = get_filter_base(filter_y);
+  const int y0_q4 = get_filter_offset(filter_y, filters_y);
+  // See scaledconvolve2d() in vpx_subpixel_8t_intrin_ssse3.c for the size of
+  // the intermediate buffer.
+  DECLARE_ALIGNED(32, uint8_t, temp[(135 + 8) * 64]);
+  int intermediate_height;
+
+  if (w < 32) {
+    vpx_scaled_2d_ssse3(src, src_stride, dst, dst_stride, filter_x, x_step_q4,
+                        filter_y, y_step_q4, w, h);
+    return;
+  }
+
+  assert(w <= 64);
+  assert(h <= 64);
+  assert(y_step_q4 <= 32);
+  assert(x_step_q4 <= 32);
+
+  intermediate_height =
+      (((h - 1) * y_step_q4 + y0_q4) >> SUBPEL_BITS) + SUBPEL_TAPS;
+  scaledconvolve_horiz_w8(src - src_stride * (SUBPEL_TAPS / 2 - 1), src_stride,
+                          temp, 64, filters_x, x0_q4, x_step_q4, w,
+                          intermediate_height);
+  scaledconvolve_vert_w32(temp + 64 * (SUBPEL_TAPS / 2 - 1), 64, dst,
+                          dst_stride, filters_y, y0_q4, y_step_q4, w, h);
+}
 #endif  // HAVE_AX2 && HAVE_SSSE3
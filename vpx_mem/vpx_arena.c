@@ -0,0 +1,134 @@
+/*
+ *  Copyright (c) 2017 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <assert.h>
+#include <string.h>
+
+#include "vpx_mem/vpx_arena.h"
+#include "vpx_mem/vpx_mem.h"
+
+// Smallest chunk taken from the allocator. Later chunks are at least as large
+// as all previous ones together, so an arena needs few of them to warm up.
+#define ARENA_MIN_CHUNK_SIZE (64 * 1024)
+
+struct vpx_arena_chunk {
+  struct vpx_arena_chunk *next;
+  size_t size;  // Usable bytes after the header.
+  size_t used;
+};
+
+// The header is padded so that the usable bytes have the maximum alignment.
+#define CHUNK_HEADER_SIZE                                       \
+  ((sizeof(struct vpx_arena_chunk) + VPX_ARENA_MAX_ALIGN - 1) & \
+   ~(size_t)(VPX_ARENA_MAX_ALIGN - 1))
+
+static uint8_t *chunk_data(struct vpx_arena_chunk *chunk) {
+  return (uint8_t *)chunk + CHUNK_HEADER_SIZE;
+}
+
+static struct vpx_arena_chunk *alloc_chunk(vpx_arena *arena, size_t size) {
+  struct vpx_arena_chunk *chunk;
+
+  if (size > (size_t)-1 - CHUNK_HEADER_SIZE) return NULL;
+  if (arena->allocator.alloc != NULL) {
+    chunk = (struct vpx_arena_chunk *)arena->allocator.alloc(
+        arena->allocator.priv, CHUNK_HEADER_SIZE + size, VPX_ARENA_MAX_ALIGN);
+  } else {
+    chunk = (struct vpx_arena_chunk *)vpx_memalign(VPX_ARENA_MAX_ALIGN,
+                                                   CHUNK_HEADER_SIZE + size);
+  }
+  if (chunk == NULL) return NULL;
+
+  chunk->next = NULL;
+  chunk->size = size;
+  chunk->used = 0;
+  arena->reserved += size;
+  ++arena->num_allocs;
+  return chunk;
+}
+
+static void release_chunks(vpx_arena *arena) {
+  while (arena->chunks != NULL) {
+    struct vpx_arena_chunk *const chunk = arena->chunks;
+    arena->chunks = chunk->next;
+    if (arena->allocator.alloc != NULL) {
+      arena->allocator.free(arena->allocator.priv, chunk);
+    } else {
+      vpx_free(chunk);
+    }
+    ++arena->num_frees;
+  }
+  arena->reserved = 0;
+  arena->used = 0;
+}
+
+void vpx_arena_set_allocator(vpx_arena *arena,
+                             const vpx_memory_allocator_t *allocator) {
+  release_chunks(arena);
+  if (allocator != NULL) {
+    arena->allocator = *allocator;
+  } else {
+    memset(&arena->allocator, 0, sizeof(arena->allocator));
+  }
+}
+
+void *vpx_arena_alloc(vpx_arena *arena, size_t size, size_t align) {
+  struct vpx_arena_chunk *chunk = arena->chunks;
+  size_t offset = 0;
+
+  assert(align > 0 && align <= VPX_ARENA_MAX_ALIGN);
+  assert((align & (align - 1)) == 0);
+
+  if (chunk != NULL) offset = (chunk->used + align - 1) & ~(align - 1);
+  if (chunk == NULL || offset > chunk->size || size > chunk->size - offset) {
+    size_t chunk_size = arena->reserved;
+    if (chunk_size < ARENA_MIN_CHUNK_SIZE) chunk_size = ARENA_MIN_CHUNK_SIZE;
+    if (chunk_size < size) chunk_size = size;
+    chunk = alloc_chunk(arena, chunk_size);
+    if (chunk == NULL) return NULL;
+    chunk->next = arena->chunks;
+    arena->chunks = chunk;
+    offset = 0;
+  }
+
+  arena->used += offset + size - chunk->used;
+  chunk->used = offset + size;
+  return chunk_data(chunk) + offset;
+}
+
+void *vpx_arena_calloc(vpx_arena *arena, size_t num, size_t size,
+                       size_t align) {
+  void *mem;
+  if (size != 0 && num > (size_t)-1 / size) return NULL;
+  mem = vpx_arena_alloc(arena, num * size, align);
+  if (mem != NULL) memset(mem, 0, num * size);
+  return mem;
+}
+
+void vpx_arena_reset(vpx_arena *arena) {
+  if (arena->chunks != NULL && arena->chunks->next != NULL) {
+    const size_t size = arena->reserved;
+    release_chunks(arena);
+    // On failure the arena is left empty and allocates on demand.
+    arena->chunks = alloc_chunk(arena, size);
+  }
+  if (arena->chunks != NULL) arena->chunks->used = 0;
+  arena->used = 0;
+}
+
+void vpx_arena_free(vpx_arena *arena) { release_chunks(arena); }
+
+void vpx_arena_add_stats(const vpx_arena *arena,
+                         vpx_memory_allocator_stats_t *stats) {
+  stats->bytes_reserved += arena->reserved;
+  stats->bytes_in_use += arena->used;
+  stats->num_allocs += arena->num_allocs;
+  stats->num_frees += arena->num_frees;
+}
@@ -0,0 +1,70 @@
+/*
+ *  Copyright (c) 2017 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef VPX_MEM_VPX_ARENA_H_
+#define VPX_MEM_VPX_ARENA_H_
+
+#include <stddef.h>
+
+#include "vpx/vpx_memory_allocator.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+// Largest alignment vpx_arena_alloc() supports.
+#define VPX_ARENA_MAX_ALIGN 64
+
+struct vpx_arena_chunk;
+
+// Bump allocator for buffers that are released together. Memory is taken in
+// chunks from |allocator|, or vpx_memalign() when it is not set. A zeroed
+// vpx_arena is empty and uses vpx_memalign(). An arena must only be used by
+// one thread at a time.
+typedef struct vpx_arena {
+  vpx_memory_allocator_t allocator;
+  // Most recent chunk first. Allocations are only made from the first one.
+  struct vpx_arena_chunk *chunks;
+  size_t reserved;  // Usable bytes in all chunks.
+  size_t used;      // Bytes handed out since the last reset, with padding.
+  unsigned int num_allocs;
+  unsigned int num_frees;
+} vpx_arena;
+
+// Releases the arena's chunks and takes further chunks from |allocator|, or
+// vpx_memalign() when it is NULL.
+void vpx_arena_set_allocator(vpx_arena *arena,
+                             const vpx_memory_allocator_t *allocator);
+
+// Returns |size| bytes aligned to |align|, a power of two no larger than
+// VPX_ARENA_MAX_ALIGN, or NULL on failure.
+void *vpx_arena_alloc(vpx_arena *arena, size_t size, size_t align);
+
+// As vpx_arena_alloc() for |num| zeroed elements of |size| bytes.
+void *vpx_arena_calloc(vpx_arena *arena, size_t num, size_t size,
+                       size_t align);
+
+// Invalidates all allocations but keeps the memory. When it is spread over
+// several chunks they are replaced by one, so that the same allocations made
+// again are served without calling the allocator.
+void vpx_arena_reset(vpx_arena *arena);
+
+// Invalidates all allocations and releases the memory.
+void vpx_arena_free(vpx_arena *arena);
+
+// Adds the arena's figures to |stats|.
+void vpx_arena_add_stats(const vpx_arena *arena,
+                         vpx_memory_allocator_stats_t *stats);
+
+#if defined(__cplusplus)
+}  // extern "C"
+#endif
+
+#endif  // VPX_MEM_VPX_ARENA_H_
@@ -19,9 +19,9 @@
 #include "vp9/common/vp9_common.h"
 #endif
 
-static void extend_plane(uint8_t *const src, int src_stride, int width,
-                         int height, int extend_top, int extend_left,
-                         int extend_bottom, int extend_right) {
+void vpx_extend_plane_c(uint8_t *src, int src_stride, int width, int height,
+                        int extend_top, int extend_left, int extend_bottom,
+                        int extend_right) {
   int i;
   const int linesize = extend_left + extend_right + width;
 
@@ -60,9 +60,9 @@ static void extend_plane(uint8_t *const src, int src_stride, int width,
 }
 
 #if CONFIG_VP9_HIGHBITDEPTH
-static void extend_plane_high(uint8_t *const src8, int src_stride, int width,
-                              int height, int extend_top, int extend_left,
-                              int extend_bottom, int extend_right) {
+void vpx_highbd_extend_plane_c(uint8_t *src8, int src_stride, int width,
+                               int height, int extend_top, int extend_left,
+                               int extend_bottom, int extend_right) {
   int i;
   const int linesize = extend_left + extend_right + width;
   uint16_t *src = CONVERT_TO_SHORTPTR(src8);
@@ -111,59 +111,71 @@ void vp8_yv12_extend_frame_borders_c(YV12_BUFFER_CONFIG *ybf) {
   assert(ybf->y_height - ybf->y_crop_height >= 0);
   assert(ybf->y_width - ybf->y_crop_width >= 0);
 
-  extend_plane(ybf->y_buffer, ybf->y_stride, ybf->y_crop_width,
-               ybf->y_crop_height, ybf->border, ybf->border,
-               ybf->border + ybf->y_height - ybf->y_crop_height,
-               ybf->border + ybf->y_width - ybf->y_crop_width);
+  vpx_extend_plane(ybf->y_buffer, ybf->y_stride, ybf->y_crop_width,
+                   ybf->y_crop_height, ybf->border, ybf->border,
+                   ybf->border + ybf->y_height - ybf->y_crop_height,
+                   ybf->border + ybf->y_width - ybf->y_crop_width);
 
-  extend_plane(ybf->u_buffer, ybf->uv_stride, ybf->uv_crop_width,
-               ybf->uv_crop_height, uv_border, uv_border,
-               uv_border + ybf->uv_height - ybf->uv_crop_height,
-               uv_border + ybf->uv_width - ybf->uv_crop_width);
+  vpx_extend_plane(ybf->u_buffer, ybf->uv_stride, ybf->uv_crop_width,
+                   ybf->uv_crop_height, uv_border, uv_border,
+                   uv_border + ybf->uv_height - ybf->uv_crop_height,
+                   uv_border + ybf->uv_width - ybf->uv_crop_width);
 
-  extend_plane(ybf->v_buffer, ybf->uv_stride, ybf->uv_crop_width,
-               ybf->uv_crop_height, uv_border, uv_border,
-               uv_border + ybf->uv_height - ybf->uv_crop_height,
-               uv_border + ybf->uv_width - ybf->uv_crop_width);
+  vpx_extend_plane(ybf->v_buffer, ybf->uv_stride, ybf->uv_crop_width,
+                   ybf->uv_crop_height, uv_border, uv_border,
+                   uv_border + ybf->uv_height - ybf->uv_crop_height,
+                   uv_border + ybf->uv_width - ybf->uv_crop_width);
 }
 
 #if CONFIG_VP9
-static void extend_frame(YV12_BUFFER_CONFIG *const ybf, int ext_size) {
-  const int c_w = ybf->uv_crop_width;
-  const int c_h = ybf->uv_crop_height;
-  const int ss_x = ybf->uv_width < ybf->y_width;
-  const int ss_y = ybf->uv_height < ybf->y_height;
-  const int c_et = ext_size >> ss_y;
-  const int c_el = ext_size >> ss_x;
-  const int c_eb = c_et + ybf->uv_height - ybf->uv_crop_height;
-  const int c_er = c_el + ybf->uv_width - ybf->uv_crop_width;
-
-  assert(ybf->y_height - ybf->y_crop_height < 16);
-  assert(ybf->y_width - ybf->y_crop_width < 16);
-  assert(ybf->y_height - ybf->y_crop_height >= 0);
-  assert(ybf->y_width - ybf->y_crop_width >= 0);
+// Extends the borders of rows [row_start, row_end) of one plane. The top border
+// is only written with the first row of the plane and the bottom border with
+// the last one, so extending consecutive row ranges gives the same result as a
+// single call for the whole plane.
+static void extend_plane_rows(YV12_BUFFER_CONFIG *const ybf, int ext_size,
+                              int plane, int row_start, int row_end) {
+  const int ss_x = plane && ybf->uv_width < ybf->y_width;
+  const int ss_y = plane && ybf->uv_height < ybf->y_height;
+  const int crop_w = plane ? ybf->uv_crop_width : ybf->y_crop_width;
+  const int crop_h = plane ? ybf->uv_crop_height : ybf->y_crop_height;
+  const int aligned_w = plane ? ybf->uv_width : ybf->y_width;
+  const int aligned_h = plane ? ybf->uv_height : ybf->y_height;
+  const int stride = plane ? ybf->uv_stride : ybf->y_stride;
+  uint8_t *const buf =
+      (plane == 0 ? ybf->y_buffer : plane == 1 ? ybf->u_buffer : ybf->v_buffer)
+      + row_start * stride;
+  const int et = row_start == 0 ? ext_size >> ss_y : 0;
+  const int el = ext_size >> ss_x;
+  const int eb = row_end == crop_h ? (ext_size >> ss_y) + aligned_h - crop_h : 0;
+  const int er = el + aligned_w - crop_w;
+
+  assert(row_start >= 0 && row_end <= crop_h);
+  if (row_start >= row_end) return;
 
 #if CONFIG_VP9_HIGHBITDEPTH
   if (ybf->flags & YV12_FLAG_HIGHBITDEPTH) {
-    extend_plane_high(ybf->y_buffer, ybf->y_stride, ybf->y_crop_width,
-                      ybf->y_crop_height, ext_size, ext_size,
-                      ext_size + ybf->y_height - ybf->y_crop_height,
-                      ext_size + ybf->y_width - ybf->y_crop_width);
-    extend_plane_high(ybf->u_buffer, ybf->uv_stride, c_w, c_h, c_et, c_el, c_eb,
-                      c_er);
-    extend_plane_high(ybf->v_buffer, ybf->uv_stride, c_w, c_h, c_et, c_el, c_eb,
-                      c_er);
+    vpx_highbd_extend_plane(buf, stride, crop_w, row_end - row_start, et, el,
+                            eb, er);
     return;
   }
 #endif
-  extend_plane(ybf->y_buffer, ybf->y_stride, ybf->y_crop_width,
-               ybf->y_crop_height, ext_size, ext_size,
-               ext_size + ybf->y_height - ybf->y_crop_height,
-               ext_size + ybf->y_width - ybf->y_crop_width);
+  vpx_extend_plane(buf, stride, crop_w, row_end - row_start, et, el, eb, er);
+}
+
+static void extend_frame(YV12_BUFFER_CONFIG *const ybf, int ext_size) {
+  assert(ybf->y_height - ybf->y_crop_height < 16);
+  assert(ybf->y_width - ybf->y_crop_width < 16);
+  assert(ybf->y_height - ybf->y_crop_height >= 0);
+  assert(ybf->y_width - ybf->y_crop_width >= 0);
 
-  extend_plane(ybf->u_buffer, ybf->uv_stride, c_w, c_h, c_et, c_el, c_eb, c_er);
+  extend_plane_rows(ybf, ext_size, 0, 0, ybf->y_crop_height);
+  extend_plane_rows(ybf, ext_size, 1, 0, ybf->uv_crop_height);
+  extend_plane_rows(ybf, ext_size, 2, 0, ybf->uv_crop_height);
+}
 
-  extend_plane(ybf->v_buffer, ybf->uv_stride, c_w, c_h, c_et, c_el, c_eb, c_er);
+static int get_inner_border(const YV12_BUFFER_CONFIG *ybf) {
+  return (ybf->border > VP9INNERBORDERINPIXELS) ? VP9INNERBORDERINPIXELS
+                                                : ybf->border;
 }
 
 void vpx_extend_frame_borders_c(YV12_BUFFER_CONFIG *ybf) {
@@ -171,10 +183,12 @@ void vpx_extend_frame_borders_c(YV12_BUFFER_CONFIG *ybf) {
 }
 
 void vpx_extend_frame_inner_borders_c(YV12_BUFFER_CONFIG *ybf) {
-  const int inner_bw = (ybf->border > VP9INNERBORDERINPIXELS)
-                           ? VP9INNERBORDERINPIXELS
-                           : ybf->border;
-  extend_frame(ybf, inner_bw);
+  extend_frame(ybf, get_inner_border(ybf));
+}
+
+void vpx_extend_frame_inner_borders_rows_c(YV12_BUFFER_CONFIG *ybf, int plane,
+                                           int row_start, int row_end) {
+  extend_plane_rows(ybf, get_inner_border(ybf), plane, row_start, row_end);
 }
 
 #if CONFIG_VP9_HIGHBITDEPTH
@@ -1,5 +1,7 @@
 sub vpx_scale_forward_decls() {
 print <<EOF
+#include "vpx/vpx_integer.h"
+
 struct yv12_buffer_config;
 EOF
 }
@@ -16,6 +18,14 @@ if (vpx_config("CONFIG_SPATIAL_RESAMPLING") eq "yes") {
     add_proto qw/void vp8_vertical_band_2_1_scale_i/, "unsigned char *source, unsigned int src_pitch, unsigned char *dest, unsigned int dest_pitch, unsigned int dest_width";
 }
 
+add_proto qw/void vpx_extend_plane/, "uint8_t *src, int src_stride, int width, int height, int extend_top, int extend_left, int extend_bottom, int extend_right";
+specialize qw/vpx_extend_plane sse2 avx2/;
+
+if (vpx_config("CONFIG_VP9_HIGHBITDEPTH") eq "yes") {
+    add_proto qw/void vpx_highbd_extend_plane/, "uint8_t *src8, int src_stride, int width, int height, int extend_top, int extend_left, int extend_bottom, int extend_right";
+    specialize qw/vpx_highbd_extend_plane sse2 avx2/;
+}
+
 add_proto qw/void vp8_yv12_extend_frame_borders/, "struct yv12_buffer_config *ybf";
 
 add_proto qw/void vp8_yv12_copy_frame/, "const struct yv12_buffer_config *src_ybc, struct yv12_buffer_config *dst_ybc";
@@ -30,5 +40,8 @@ if (vpx_config("CONFIG_VP9") eq "yes") {
 
     add_proto qw/void vpx_extend_frame_inner_borders/, "struct yv12_buffer_config *ybf";
     specialize qw/vpx_extend_frame_inner_borders dspr2/;
+
+    # Extends the inner borders of rows [row_start, row_end) of one plane.
+    add_proto qw/void vpx_extend_frame_inner_borders_rows/, "struct yv12_buffer_config *ybf, int plane, int row_start, int row_end";
 }
 1;
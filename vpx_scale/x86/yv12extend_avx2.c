@@ -0,0 +1,103 @@
+/*
+ *  Copyright (c) 2017 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <immintrin.h>
+#include <string.h>
+
+#include "./vpx_config.h"
+#include "./vpx_scale_rtcd.h"
+#include "vpx_ports/mem.h"
+
+// Same as the SSE2 version with 32 byte stores. Short runs, such as the chroma
+// borders of small frames, fall back to a single 16 byte store pair.
+static INLINE void fill_u8(uint8_t *dst, uint8_t value, int n) {
+  const __m256i v = _mm256_set1_epi8((char)value);
+  int i;
+
+  if (n < 32) {
+    if (n < 16) {
+      memset(dst, value, n);
+    } else {
+      _mm_storeu_si128((__m128i *)dst, _mm256_castsi256_si128(v));
+      _mm_storeu_si128((__m128i *)(dst + n - 16), _mm256_castsi256_si128(v));
+    }
+    return;
+  }
+  for (i = 0; i + 32 <= n; i += 32)
+    _mm256_storeu_si256((__m256i *)(dst + i), v);
+  if (i < n) _mm256_storeu_si256((__m256i *)(dst + n - 32), v);
+}
+
+void vpx_extend_plane_avx2(uint8_t *src, int src_stride, int width, int height,
+                           int extend_top, int extend_left, int extend_bottom,
+                           int extend_right) {
+  const int linesize = extend_left + extend_right + width;
+  uint8_t *row = src;
+  uint8_t *top_src, *bottom_src, *dst;
+  int i;
+
+  for (i = 0; i < height; ++i, row += src_stride) {
+    fill_u8(row - extend_left, row[0], extend_left);
+    fill_u8(row + width, row[width - 1], extend_right);
+  }
+
+  top_src = src - extend_left;
+  bottom_src = src + src_stride * (height - 1) - extend_left;
+  dst = top_src - src_stride * extend_top;
+  for (i = 0; i < extend_top; ++i, dst += src_stride)
+    memcpy(dst, top_src, linesize);
+  dst = bottom_src + src_stride;
+  for (i = 0; i < extend_bottom; ++i, dst += src_stride)
+    memcpy(dst, bottom_src, linesize);
+}
+
+#if CONFIG_VP9_HIGHBITDEPTH
+static INLINE void fill_u16(uint16_t *dst, uint16_t value, int n) {
+  const __m256i v = _mm256_set1_epi16((int16_t)value);
+  int i;
+
+  if (n < 16) {
+    if (n < 8) {
+      for (i = 0; i < n; ++i) dst[i] = value;
+    } else {
+      _mm_storeu_si128((__m128i *)dst, _mm256_castsi256_si128(v));
+      _mm_storeu_si128((__m128i *)(dst + n - 8), _mm256_castsi256_si128(v));
+    }
+    return;
+  }
+  for (i = 0; i + 16 <= n; i += 16)
+    _mm256_storeu_si256((__m256i *)(dst + i), v);
+  if (i < n) _mm256_storeu_si256((__m256i *)(dst + n - 16), v);
+}
+
+void vpx_highbd_extend_plane_avx2(uint8_t *src8, int src_stride, int width,
+                                  int height, int extend_top, int extend_left,
+                                  int extend_bottom, int extend_right) {
+  const int linesize = extend_left + extend_right + width;
+  uint16_t *const src = CONVERT_TO_SHORTPTR(src8);
+  uint16_t *row = src;
+  uint16_t *top_src, *bottom_src, *dst;
+  int i;
+
+  for (i = 0; i < height; ++i, row += src_stride) {
+    fill_u16(row - extend_left, row[0], extend_left);
+    fill_u16(row + width, row[width - 1], extend_right);
+  }
+
+  top_src = src - extend_left;
+  bottom_src = src + src_stride * (height - 1) - extend_left;
+  dst = top_src - src_stride * extend_top;
+  for (i = 0; i < extend_top; ++i, dst += src_stride)
+    memcpy(dst, top_src, linesize * sizeof(*dst));
+  dst = bottom_src + src_stride;
+  for (i = 0; i < extend_bottom; ++i, dst += src_stride)
+    memcpy(dst, bottom_src, linesize * sizeof(*dst));
+}
+#endif  // CONFIG_VP9_HIGHBITDEPTH
@@ -22,11 +22,14 @@
 #endif
 
 #include "./args.h"
+#include "./async_writer.h"
+#include "./bench_stats.h"
 #include "./ivfdec.h"
 
 #include "vpx/vpx_decoder.h"
 #include "vpx_ports/mem_ops.h"
 #include "vpx_ports/vpx_timer.h"
+#include "vpx_util/vpx_thread.h"
 
 #if CONFIG_VP8_DECODER || CONFIG_VP9_DECODER
 #include "vpx/vp8dx.h"
@@ -42,6 +45,10 @@
 
 static const char *exec_name;
 
+/* Number of decoded frames that may be queued for the output writer thread.
+ */
+#define OUTPUT_WRITER_JOBS 8
+
 struct VpxDecInputContext {
   struct VpxInputContext *vpx_input_ctx;
   struct WebmInputContext *webm_ctx;
@@ -95,7 +102,21 @@ static const arg_def_t outbitdeptharg =
 static const arg_def_t svcdecodingarg = ARG_DEF(
     NULL, "svc-decode-layer", 1, "Decode SVC stream up to given spatial layer");
 static const arg_def_t framestatsarg =
-    ARG_DEF(NULL, "framestats", 1, "Output per-frame stats (.csv format)");
+    ARG_DEF(NULL, "framestats", 1,
+            "Output per-frame stats, including decode timing when supported "
+            "(.csv format)");
+static const arg_def_t bencharg =
+    ARG_DEF(NULL, "bench", 0,
+            "Benchmark decoding from memory, without output");
+static const arg_def_t benchthreadsarg =
+    ARG_DEF(NULL, "bench-threads", 1,
+            "Comma separated thread counts to benchmark (default: --threads)");
+static const arg_def_t benchstreamsarg =
+    ARG_DEF(NULL, "bench-streams", 1,
+            "Number of concurrent decoders to benchmark (default: 1)");
+static const arg_def_t benchrunsarg =
+    ARG_DEF(NULL, "bench-runs", 1,
+            "Number of times to decode the input per benchmark (default: 1)");
 
 static const arg_def_t *all_args[] = {
   &codecarg,          &use_yv12,         &use_i420,
@@ -108,7 +129,9 @@ static const arg_def_t *all_args[] = {
 #if CONFIG_VP9_HIGHBITDEPTH
   &outbitdeptharg,
 #endif
-  &svcdecodingarg,    &framestatsarg,    NULL
+  &svcdecodingarg,    &framestatsarg,    &bencharg,
+  &benchthreadsarg,   &benchstreamsarg,  &benchrunsarg,
+  NULL
 };
 
 #if CONFIG_VP8_DECODER
@@ -336,13 +359,37 @@ struct ExternalFrameBuffer {
   uint8_t *data;
   size_t size;
   int in_use;
+  // Number of queued output frames that still read from the buffer.
+  int writer_refs;
 };
 
 struct ExternalFrameBufferList {
   int num_external_frame_buffers;
   struct ExternalFrameBuffer *ext_fb;
+#if CONFIG_MULTITHREAD
+  // Guards the buffer states, which the decoder and output threads update.
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+#endif
 };
 
+static void lock_frame_buffers(struct ExternalFrameBufferList *ext_fb_list) {
+#if CONFIG_MULTITHREAD
+  pthread_mutex_lock(&ext_fb_list->mutex);
+#else
+  (void)ext_fb_list;
+#endif
+}
+
+static void unlock_frame_buffers(struct ExternalFrameBufferList *ext_fb_list) {
+#if CONFIG_MULTITHREAD
+  pthread_cond_broadcast(&ext_fb_list->cond);
+  pthread_mutex_unlock(&ext_fb_list->mutex);
+#else
+  (void)ext_fb_list;
+#endif
+}
+
 // Callback used by libvpx to request an external frame buffer. |cb_priv|
 // Application private data passed into the set function. |min_size| is the
 // minimum size in bytes needed to decode the next frame. |fb| pointer to the
@@ -354,17 +401,36 @@ static int get_vp9_frame_buffer(void *cb_priv, size_t min_size,
       (struct ExternalFrameBufferList *)cb_priv;
   if (ext_fb_list == NULL) return -1;
 
-  // Find a free frame buffer.
-  for (i = 0; i < ext_fb_list->num_external_frame_buffers; ++i) {
-    if (!ext_fb_list->ext_fb[i].in_use) break;
+  lock_frame_buffers(ext_fb_list);
+  for (;;) {
+    int writer_refs = 0;
+
+    // Find a free frame buffer.
+    for (i = 0; i < ext_fb_list->num_external_frame_buffers; ++i) {
+      const struct ExternalFrameBuffer *const ext_fb = &ext_fb_list->ext_fb[i];
+      if (!ext_fb->in_use && !ext_fb->writer_refs) break;
+      writer_refs += ext_fb->writer_refs;
+    }
+    if (i < ext_fb_list->num_external_frame_buffers || !writer_refs) break;
+
+#if CONFIG_MULTITHREAD
+    // Wait for the output writer to finish with one of the buffers.
+    pthread_cond_wait(&ext_fb_list->cond, &ext_fb_list->mutex);
+#endif
   }
 
-  if (i == ext_fb_list->num_external_frame_buffers) return -1;
+  if (i == ext_fb_list->num_external_frame_buffers) {
+    unlock_frame_buffers(ext_fb_list);
+    return -1;
+  }
 
   if (ext_fb_list->ext_fb[i].size < min_size) {
     free(ext_fb_list->ext_fb[i].data);
     ext_fb_list->ext_fb[i].data = (uint8_t *)calloc(min_size, sizeof(uint8_t));
-    if (!ext_fb_list->ext_fb[i].data) return -1;
+    if (!ext_fb_list->ext_fb[i].data) {
+      unlock_frame_buffers(ext_fb_list);
+      return -1;
+    }
 
     ext_fb_list->ext_fb[i].size = min_size;
   }
@@ -372,6 +438,7 @@ static int get_vp9_frame_buffer(void *cb_priv, size_t min_size,
   fb->data = ext_fb_list->ext_fb[i].data;
   fb->size = ext_fb_list->ext_fb[i].size;
   ext_fb_list->ext_fb[i].in_use = 1;
+  unlock_frame_buffers(ext_fb_list);
 
   // Set the frame buffer's private data to point at the external frame buffer.
   fb->priv = &ext_fb_list->ext_fb[i];
@@ -383,13 +450,107 @@ static int get_vp9_frame_buffer(void *cb_priv, size_t min_size,
 // to the frame buffer.
 static int release_vp9_frame_buffer(void *cb_priv,
                                     vpx_codec_frame_buffer_t *fb) {
+  struct ExternalFrameBufferList *const ext_fb_list =
+      (struct ExternalFrameBufferList *)cb_priv;
   struct ExternalFrameBuffer *const ext_fb =
       (struct ExternalFrameBuffer *)fb->priv;
-  (void)cb_priv;
+  lock_frame_buffers(ext_fb_list);
   ext_fb->in_use = 0;
+  unlock_frame_buffers(ext_fb_list);
   return 0;
 }
 
+// A frame queued for the output writer. |img| describes the pixels to write,
+// which are either in the held external frame buffer |fb| or in |copy|.
+struct OutputFrame {
+  vpx_image_t img;
+  vpx_image_t *copy;
+  struct ExternalFrameBuffer *fb;
+  // Y4M file and frame headers written ahead of the image.
+  char header[2 * Y4M_BUFFER_SIZE];
+  size_t header_len;
+  int corrupted;
+};
+
+struct OutputContext {
+  FILE *file;
+  MD5Context *md5;
+  int flipuv;
+  struct ExternalFrameBufferList *ext_fb_list;
+};
+
+// Points |out| at the pixels of |img|. Images decoded into an external frame
+// buffer are written in place, holding the buffer until the writer is done
+// with it; anything else, such as decoder owned or scaled frames, is copied.
+static void set_output_image(struct OutputFrame *out, const vpx_image_t *img,
+                             struct ExternalFrameBufferList *ext_fb_list) {
+  int i;
+
+  out->fb = NULL;
+  if (ext_fb_list->num_external_frame_buffers > 0) {
+    lock_frame_buffers(ext_fb_list);
+    for (i = 0; i < ext_fb_list->num_external_frame_buffers; ++i) {
+      struct ExternalFrameBuffer *const ext_fb = &ext_fb_list->ext_fb[i];
+      if (ext_fb->in_use && img->planes[0] >= ext_fb->data &&
+          img->planes[0] < ext_fb->data + ext_fb->size) {
+        ++ext_fb->writer_refs;
+        out->fb = ext_fb;
+        break;
+      }
+    }
+    unlock_frame_buffers(ext_fb_list);
+  }
+
+  if (out->fb) {
+    out->img = *img;
+    return;
+  }
+
+  if (out->copy &&
+      (out->copy->fmt != img->fmt || out->copy->d_w != img->d_w ||
+       out->copy->d_h != img->d_h)) {
+    vpx_img_free(out->copy);
+    out->copy = NULL;
+  }
+  if (!out->copy) {
+    out->copy = vpx_img_alloc(NULL, img->fmt, img->d_w, img->d_h, 16);
+    if (!out->copy) fatal("Failed to allocate output frame");
+  }
+  out->copy->bit_depth = img->bit_depth;
+  vpx_img_copy(img, out->copy);
+  out->img = *out->copy;
+}
+
+// Runs on the output writer's thread.
+static void write_output_frame(void *priv, void *job) {
+  const int PLANES_YUV[] = { VPX_PLANE_Y, VPX_PLANE_U, VPX_PLANE_V };
+  const int PLANES_YVU[] = { VPX_PLANE_Y, VPX_PLANE_V, VPX_PLANE_U };
+  struct OutputContext *const output = (struct OutputContext *)priv;
+  struct OutputFrame *const out = (struct OutputFrame *)job;
+  const int *planes = output->flipuv ? PLANES_YVU : PLANES_YUV;
+
+  if (output->md5) {
+    MD5Update(output->md5, (md5byte *)out->header,
+              (unsigned int)out->header_len);
+    update_image_md5(&out->img, planes, output->md5);
+  } else {
+    fwrite(out->header, 1, out->header_len, output->file);
+    if (!out->corrupted) write_image_file(&out->img, planes, output->file);
+  }
+
+  if (out->fb) {
+    lock_frame_buffers(output->ext_fb_list);
+    --out->fb->writer_refs;
+    unlock_frame_buffers(output->ext_fb_list);
+  }
+}
+
+static void free_output_frame(void *priv, void *job) {
+  struct OutputFrame *const out = (struct OutputFrame *)job;
+  (void)priv;
+  if (out->copy) vpx_img_free(out->copy);
+}
+
 static void generate_filename(const char *pattern, char *out, size_t q_len,
                               unsigned int d_w, unsigned int d_h,
                               unsigned int frame_in) {
@@ -484,6 +645,292 @@ static int img_shifted_realloc_required(const vpx_image_t *img,
 }
 #endif
 
+static void write_int64_list(FILE *file, const int64_t *values, int count) {
+  int i;
+  fputc(',', file);
+  for (i = 0; i < count; ++i)
+    fprintf(file, "%s%" PRId64, i ? " " : "", values[i]);
+}
+
+// Writes a line of the --framestats file. The timing and work counters of
+// VP9D_GET_FRAME_STATS are added when the decoder supports them. Lists of
+// values (per block size, tile and worker) are space separated.
+static void write_frame_stats(FILE *file, vpx_codec_ctx_t *decoder, int bytes,
+                              int qp, int *has_stats) {
+  vpx_dec_frame_stats_t stats;
+  const int got_stats =
+      vpx_codec_control(decoder, VP9D_GET_FRAME_STATS, &stats) == VPX_CODEC_OK;
+
+  if (*has_stats < 0) {
+    *has_stats = got_stats;
+    fprintf(file, "bytes,qp%s\n",
+            got_stats ? ",header_us,tile_decode_us,loop_filter_us,postproc_us,"
+                        "skip_blocks,coeffs,blocks,tile_us,worker_us"
+                      : "");
+  }
+
+  fprintf(file, "%d,%d", bytes, qp);
+  if (*has_stats) {
+    int64_t blocks[VPX_DEC_STATS_BLOCK_SIZES];
+    int i;
+
+    if (!got_stats) memset(&stats, 0, sizeof(stats));
+    for (i = 0; i < VPX_DEC_STATS_BLOCK_SIZES; ++i) blocks[i] = stats.blocks[i];
+    fprintf(file, ",%" PRId64 ",%" PRId64 ",%" PRId64 ",%" PRId64 ",%u,%" PRIu64,
+            stats.header_us, stats.tile_decode_us, stats.loop_filter_us,
+            stats.postproc_us, (unsigned int)stats.skip_blocks, stats.coeffs);
+    write_int64_list(file, blocks, VPX_DEC_STATS_BLOCK_SIZES);
+    write_int64_list(file, stats.tile_us, stats.num_tiles);
+    write_int64_list(file, stats.worker_us, stats.num_workers);
+  }
+  fprintf(file, "\n");
+}
+
+#define MAX_BENCH_THREAD_COUNTS 16
+#define MAX_BENCH_STREAMS 16
+
+// Compressed frames preloaded for --bench.
+struct BenchInput {
+  uint8_t **data;
+  size_t *size;
+  int num_frames;
+};
+
+struct BenchConfig {
+  const VpxInterface *interface;
+  vpx_codec_flags_t flags;
+  int svc_decoding;
+  int svc_spatial_layer;
+#if CONFIG_VP8_DECODER
+  vp8_postproc_cfg_t vp8_pp_cfg;
+#endif
+  int threads[MAX_BENCH_THREAD_COUNTS];
+  int num_thread_counts;
+  int streams;
+  int runs;
+};
+
+struct BenchStream {
+  const struct BenchInput *input;
+  vpx_codec_ctx_t decoder;
+  struct latency_stats latency;
+  int frames_out;
+  int failed;
+};
+
+static void load_bench_input(struct VpxDecInputContext *input, uint8_t **buf,
+                             size_t *bytes_in_buffer, size_t *buffer_size,
+                             int skip, int limit,
+                             struct BenchInput *bench_input) {
+  int capacity = 0;
+
+  while (skip--) {
+    if (read_frame(input, buf, bytes_in_buffer, buffer_size)) return;
+  }
+  while (!limit || bench_input->num_frames < limit) {
+    uint8_t *data;
+    if (read_frame(input, buf, bytes_in_buffer, buffer_size)) break;
+
+    if (bench_input->num_frames == capacity) {
+      capacity = capacity ? 2 * capacity : 256;
+      bench_input->data = (uint8_t **)realloc(
+          bench_input->data, capacity * sizeof(*bench_input->data));
+      bench_input->size = (size_t *)realloc(
+          bench_input->size, capacity * sizeof(*bench_input->size));
+      if (!bench_input->data || !bench_input->size)
+        fatal("Failed to allocate benchmark input");
+    }
+    data = (uint8_t *)malloc(*bytes_in_buffer);
+    if (!data) fatal("Failed to allocate benchmark input");
+    memcpy(data, *buf, *bytes_in_buffer);
+    bench_input->data[bench_input->num_frames] = data;
+    bench_input->size[bench_input->num_frames] = *bytes_in_buffer;
+    ++bench_input->num_frames;
+  }
+}
+
+static void free_bench_input(struct BenchInput *bench_input) {
+  int i;
+  for (i = 0; i < bench_input->num_frames; ++i) free(bench_input->data[i]);
+  free(bench_input->data);
+  free(bench_input->size);
+}
+
+static int init_bench_decoder(const struct BenchConfig *config, int threads,
+                              vpx_codec_ctx_t *decoder) {
+  vpx_codec_dec_cfg_t cfg = { 0, 0, 0 };
+#if CONFIG_VP8_DECODER
+  vp8_postproc_cfg_t vp8_pp_cfg;
+#endif
+
+  cfg.threads = threads;
+  if (vpx_codec_dec_init(decoder, config->interface->codec_interface(), &cfg,
+                         config->flags)) {
+    fprintf(stderr, "Failed to initialize decoder: %s\n",
+            vpx_codec_error(decoder));
+    return 0;
+  }
+  if (config->svc_decoding &&
+      vpx_codec_control(decoder, VP9_DECODE_SVC_SPATIAL_LAYER,
+                        config->svc_spatial_layer)) {
+    fprintf(stderr, "Failed to set spatial layer for svc decode: %s\n",
+            vpx_codec_error(decoder));
+    vpx_codec_destroy(decoder);
+    return 0;
+  }
+#if CONFIG_VP8_DECODER
+  vp8_pp_cfg = config->vp8_pp_cfg;
+  if (vp8_pp_cfg.post_proc_flag &&
+      vpx_codec_control(decoder, VP8_SET_POSTPROC, &vp8_pp_cfg)) {
+    fprintf(stderr, "Failed to configure postproc: %s\n",
+            vpx_codec_error(decoder));
+    vpx_codec_destroy(decoder);
+    return 0;
+  }
+#endif
+  return 1;
+}
+
+// Decodes all of the preloaded frames, timing each call that consumes a frame
+// together with the retrieval of the frames it outputs.
+static void decode_bench_stream(struct BenchStream *stream) {
+  const struct BenchInput *const input = stream->input;
+  int i;
+
+  for (i = 0; i <= input->num_frames; ++i) {
+    const int flush = i == input->num_frames;
+    vpx_codec_iter_t iter = NULL;
+    struct vpx_usec_timer timer;
+
+    vpx_usec_timer_start(&timer);
+    if (vpx_codec_decode(&stream->decoder, flush ? NULL : input->data[i],
+                         flush ? 0 : (unsigned int)input->size[i], NULL, 0)) {
+      warn("Failed to decode frame %d: %s", i + 1,
+           vpx_codec_error(&stream->decoder));
+      stream->failed = 1;
+      return;
+    }
+    while (vpx_codec_get_frame(&stream->decoder, &iter)) ++stream->frames_out;
+    vpx_usec_timer_mark(&timer);
+    if (!flush)
+      latency_stats_add(&stream->latency, vpx_usec_timer_elapsed(&timer));
+  }
+}
+
+#if CONFIG_MULTITHREAD
+static THREADFN bench_stream_thread(void *arg) {
+  decode_bench_stream((struct BenchStream *)arg);
+  return THREAD_RETURN(NULL);
+}
+#endif
+
+// Decodes the input |config->runs| times with |threads| decoder threads in
+// each of |config->streams| concurrent decoders, and prints the throughput,
+// latency percentiles and CPU time of the decode calls.
+static int run_bench_config(const struct BenchConfig *config, int threads,
+                            const struct BenchInput *input,
+                            struct BenchStream *streams) {
+  struct latency_stats latency = { NULL, 0, 0 };
+  int64_t wall_usec = 0, cpu_usec = 0;
+  int frames_out = 0;
+  int run, i, ok = 1;
+
+  for (run = 0; ok && run < config->runs; ++run) {
+    struct vpx_usec_timer timer;
+    int64_t cpu_start;
+    int initialized = 0;
+#if CONFIG_MULTITHREAD
+    pthread_t thread[MAX_BENCH_STREAMS];
+    int started = 0;
+#endif
+
+    for (i = 0; i < config->streams; ++i) {
+      struct BenchStream *const stream = &streams[i];
+      stream->input = input;
+      stream->frames_out = 0;
+      stream->failed = 0;
+      latency_stats_reset(&stream->latency);
+      if (!init_bench_decoder(config, threads, &stream->decoder)) break;
+      ++initialized;
+    }
+    if (initialized < config->streams) {
+      for (i = 0; i < initialized; ++i) vpx_codec_destroy(&streams[i].decoder);
+      ok = 0;
+      break;
+    }
+
+    cpu_start = get_process_cpu_usec();
+    vpx_usec_timer_start(&timer);
+#if CONFIG_MULTITHREAD
+    // The first stream is decoded on this thread.
+    for (i = 1; i < config->streams; ++i) {
+      if (pthread_create(&thread[i], NULL, bench_stream_thread, &streams[i]))
+        break;
+      ++started;
+    }
+    decode_bench_stream(&streams[0]);
+    for (i = 1; i <= started; ++i) pthread_join(thread[i], NULL);
+    for (i = started + 1; i < config->streams; ++i)
+      decode_bench_stream(&streams[i]);
+#else
+    for (i = 0; i < config->streams; ++i) decode_bench_stream(&streams[i]);
+#endif
+    vpx_usec_timer_mark(&timer);
+    wall_usec += vpx_usec_timer_elapsed(&timer);
+    cpu_usec += get_process_cpu_usec() - cpu_start;
+
+    for (i = 0; i < config->streams; ++i) {
+      struct BenchStream *const stream = &streams[i];
+      ok &= !stream->failed;
+      frames_out += stream->frames_out;
+      latency_stats_merge(&latency, &stream->latency);
+      vpx_codec_destroy(&stream->decoder);
+    }
+  }
+
+  if (ok) {
+    const double seconds = (double)wall_usec / 1000000.0;
+    // The process CPU clock is much coarser than the wall clock, so a run
+    // that decoded nothing reports a meaningless core count.
+    const int timed = frames_out > 0 && wall_usec > 0;
+    printf("%7d %7d %7d %9.3f %9.2f %8" PRId64 " %8" PRId64 " %8" PRId64
+           " %9.3f %6.2f\n",
+           threads, config->streams, frames_out, seconds,
+           timed ? frames_out / seconds : 0.0,
+           latency_stats_percentile(&latency, 50),
+           latency_stats_percentile(&latency, 99),
+           latency_stats_percentile(&latency, 100),
+           (double)cpu_usec / 1000000.0,
+           timed ? (double)cpu_usec / wall_usec : 0.0);
+    fflush(stdout);
+  }
+  latency_stats_free(&latency);
+  return ok;
+}
+
+static int run_bench(const struct BenchConfig *config,
+                     const struct BenchInput *input) {
+  struct BenchStream streams[MAX_BENCH_STREAMS];
+  int i, ok = 1;
+
+  if (!input->num_frames) {
+    fprintf(stderr, "No frames to benchmark.\n");
+    return EXIT_FAILURE;
+  }
+  memset(streams, 0, sizeof(streams));
+  fprintf(stderr, "Benchmarking %s: %d frames, %d run%s per configuration.\n",
+          config->interface->name, input->num_frames, config->runs,
+          config->runs == 1 ? "" : "s");
+  printf("threads streams  frames   time(s)       fps  p50(us)  p99(us)"
+         "  max(us)    cpu(s)  cores\n");
+  for (i = 0; ok && i < config->num_thread_counts; ++i)
+    ok = run_bench_config(config, config->threads[i], input, streams);
+
+  for (i = 0; i < config->streams; ++i)
+    latency_stats_free(&streams[i].latency);
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
 static int main_loop(int argc, const char **argv_) {
   vpx_codec_ctx_t decoder;
   char *fn = NULL;
@@ -526,17 +973,27 @@ static int main_loop(int argc, const char **argv_) {
 #endif
   int frame_avail, got_data, flush_decoder = 0;
   int num_external_frame_buffers = 0;
-  struct ExternalFrameBufferList ext_fb_list = { 0, NULL };
+  struct ExternalFrameBufferList ext_fb_list;
 
   const char *outfile_pattern = NULL;
   char outfile_name[PATH_MAX] = { 0 };
   FILE *outfile = NULL;
 
   FILE *framestats_file = NULL;
+  int framestats_pending = 0;
+  int framestats_bytes = 0;
+  int framestats_qp = 0;
+  int framestats_has_stats = -1;
+
+  int bench = 0;
+  struct BenchConfig bench_config;
 
   MD5Context md5_ctx;
   unsigned char md5_digest[16];
 
+  struct OutputContext output;
+  struct async_writer *writer = NULL;
+
   struct VpxDecInputContext input = { NULL, NULL };
   struct VpxInputContext vpx_input_ctx;
 #if CONFIG_WEBM_IO
@@ -545,6 +1002,10 @@ static int main_loop(int argc, const char **argv_) {
   input.webm_ctx = &webm_ctx;
 #endif
   input.vpx_input_ctx = &vpx_input_ctx;
+  memset(&ext_fb_list, 0, sizeof(ext_fb_list));
+  memset(&bench_config, 0, sizeof(bench_config));
+  bench_config.streams = 1;
+  bench_config.runs = 1;
 
   /* Parse command line */
   exec_name = argv_[0];
@@ -617,6 +1078,22 @@ static int main_loop(int argc, const char **argv_) {
         die("Error: Could not open --framestats file (%s) for writing.\n",
             arg.val);
       }
+    } else if (arg_match(&arg, &bencharg, argi)) {
+      bench = 1;
+    } else if (arg_match(&arg, &benchthreadsarg, argi)) {
+      const int count = parse_bench_list(arg.val, bench_config.threads,
+                                         MAX_BENCH_THREAD_COUNTS);
+      if (count <= 0)
+        die("Error: Invalid --bench-threads list (%s)\n", arg.val);
+      for (i = 0; i < count; ++i) {
+        if (bench_config.threads[i] < 0)
+          die("Error: Invalid --bench-threads list (%s)\n", arg.val);
+      }
+      bench_config.num_thread_counts = count;
+    } else if (arg_match(&arg, &benchstreamsarg, argi)) {
+      bench_config.streams = arg_parse_uint(&arg);
+    } else if (arg_match(&arg, &benchrunsarg, argi)) {
+      bench_config.runs = arg_parse_uint(&arg);
     }
 #if CONFIG_VP8_DECODER
     else if (arg_match(&arg, &addnoise_level, argi)) {
@@ -646,6 +1123,19 @@ static int main_loop(int argc, const char **argv_) {
     if (argi[0][0] == '-' && strlen(argi[0]) > 1)
       die("Error: Unrecognized option %s\n", *argi);
 
+  if (bench) {
+    if (bench_config.streams < 1 || bench_config.streams > MAX_BENCH_STREAMS)
+      die("Error: --bench-streams must be between 1 and %d\n",
+          MAX_BENCH_STREAMS);
+    if (bench_config.runs < 1) die("Error: --bench-runs must be at least 1\n");
+    if (!bench_config.num_thread_counts) {
+      bench_config.threads[0] = cfg.threads;
+      bench_config.num_thread_counts = 1;
+    }
+    // Frames are decoded and dropped.
+    noblit = 1;
+  }
+
   /* Handle non-option arguments */
   fn = argv[0];
 
@@ -727,6 +1217,23 @@ static int main_loop(int argc, const char **argv_) {
 
   dec_flags = (postproc ? VPX_CODEC_USE_POSTPROC : 0) |
               (ec_enabled ? VPX_CODEC_USE_ERROR_CONCEALMENT : 0);
+
+  if (bench) {
+    struct BenchInput bench_input = { NULL, NULL, 0 };
+
+    bench_config.interface = interface;
+    bench_config.flags = dec_flags;
+    bench_config.svc_decoding = svc_decoding;
+    bench_config.svc_spatial_layer = svc_spatial_layer;
+#if CONFIG_VP8_DECODER
+    bench_config.vp8_pp_cfg = vp8_pp_cfg;
+#endif
+    load_bench_input(&input, &buf, &bytes_in_buffer, &buffer_size, arg_skip,
+                     stop_after, &bench_input);
+    ret = run_bench(&bench_config, &bench_input);
+    free_bench_input(&bench_input);
+    goto fail2;
+  }
   if (vpx_codec_dec_init(&decoder, interface->codec_interface(), &cfg,
                          dec_flags)) {
     fprintf(stderr, "Failed to initialize decoder: %s\n",
@@ -762,6 +1269,10 @@ static int main_loop(int argc, const char **argv_) {
     ext_fb_list.num_external_frame_buffers = num_external_frame_buffers;
     ext_fb_list.ext_fb = (struct ExternalFrameBuffer *)calloc(
         num_external_frame_buffers, sizeof(*ext_fb_list.ext_fb));
+#if CONFIG_MULTITHREAD
+    pthread_mutex_init(&ext_fb_list.mutex, NULL);
+    pthread_cond_init(&ext_fb_list.cond, NULL);
+#endif
     if (vpx_codec_set_frame_buffer_functions(&decoder, get_vp9_frame_buffer,
                                              release_vp9_frame_buffer,
                                              &ext_fb_list)) {
@@ -771,11 +1282,18 @@ static int main_loop(int argc, const char **argv_) {
     }
   }
 
+  if (!noblit && single_file) {
+    output.file = outfile;
+    output.md5 = do_md5 ? &md5_ctx : NULL;
+    output.flipuv = flipuv;
+    output.ext_fb_list = &ext_fb_list;
+    writer = async_writer_open(OUTPUT_WRITER_JOBS, sizeof(struct OutputFrame),
+                               write_output_frame, free_output_frame, &output);
+  }
+
   frame_avail = 1;
   got_data = 0;
 
-  if (framestats_file) fprintf(framestats_file, "bytes,qp\n");
-
   /* Decode file */
   while (frame_avail || got_data) {
     vpx_codec_iter_t iter = NULL;
@@ -808,7 +1326,10 @@ static int main_loop(int argc, const char **argv_) {
                  vpx_codec_error(&decoder));
             if (!keep_going) goto fail;
           }
-          fprintf(framestats_file, "%d,%d\n", (int)bytes_in_buffer, qp);
+          // The line is written once the frame has been post-processed.
+          framestats_bytes = (int)bytes_in_buffer;
+          framestats_qp = qp;
+          framestats_pending = 1;
         }
 
         vpx_usec_timer_mark(&timer);
@@ -840,6 +1361,12 @@ static int main_loop(int argc, const char **argv_) {
     vpx_usec_timer_mark(&timer);
     dx_time += (unsigned int)vpx_usec_timer_elapsed(&timer);
 
+    if (framestats_pending) {
+      write_frame_stats(framestats_file, &decoder, framestats_bytes,
+                        framestats_qp, &framestats_has_stats);
+      framestats_pending = 0;
+    }
+
     if (!corrupted &&
         vpx_codec_control(&decoder, VP8D_GET_FRAME_CORRUPTED, &corrupted)) {
       warn("Failed VP8_GET_FRAME_CORRUPTED: %s", vpx_codec_error(&decoder));
@@ -926,32 +1453,24 @@ static int main_loop(int argc, const char **argv_) {
 #endif
 
       if (single_file) {
+        struct OutputFrame *const out = async_writer_next_job(writer);
+        out->header_len = 0;
         if (use_y4m) {
-          char buf[Y4M_BUFFER_SIZE] = { 0 };
-          size_t len = 0;
           if (img->fmt == VPX_IMG_FMT_I440 || img->fmt == VPX_IMG_FMT_I44016) {
             fprintf(stderr, "Cannot produce y4m output for 440 sampling.\n");
             goto fail;
           }
           if (frame_out == 1) {
             // Y4M file header
-            len = y4m_write_file_header(
-                buf, sizeof(buf), vpx_input_ctx.width, vpx_input_ctx.height,
-                &vpx_input_ctx.framerate, img->fmt, img->bit_depth);
-            if (do_md5) {
-              MD5Update(&md5_ctx, (md5byte *)buf, (unsigned int)len);
-            } else {
-              fputs(buf, outfile);
-            }
+            out->header_len = y4m_write_file_header(
+                out->header, Y4M_BUFFER_SIZE, vpx_input_ctx.width,
+                vpx_input_ctx.height, &vpx_input_ctx.framerate, img->fmt,
+                img->bit_depth);
           }
 
           // Y4M frame header
-          len = y4m_write_frame_header(buf, sizeof(buf));
-          if (do_md5) {
-            MD5Update(&md5_ctx, (md5byte *)buf, (unsigned int)len);
-          } else {
-            fputs(buf, outfile);
-          }
+          out->header_len += y4m_write_frame_header(
+              out->header + out->header_len, Y4M_BUFFER_SIZE);
         } else {
           if (frame_out == 1) {
             // Check if --yv12 or --i420 options are consistent with the
@@ -974,11 +1493,9 @@ static int main_loop(int argc, const char **argv_) {
           }
         }
 
-        if (do_md5) {
-          update_image_md5(img, planes, &md5_ctx);
-        } else {
-          if (!corrupted) write_image_file(img, planes, outfile);
-        }
+        out->corrupted = corrupted;
+        set_output_image(out, img, &ext_fb_list);
+        async_writer_submit(writer);
       } else {
         generate_filename(outfile_pattern, outfile_name, PATH_MAX, img->d_w,
                           img->d_h, frame_in);
@@ -1016,6 +1533,8 @@ fail:
 
 fail2:
 
+  async_writer_close(writer);
+
   if (!noblit && single_file) {
     if (do_md5) {
       MD5Final(md5_digest, &md5_ctx);
@@ -1041,6 +1560,12 @@ fail2:
     free(ext_fb_list.ext_fb[i].data);
   }
   free(ext_fb_list.ext_fb);
+#if CONFIG_MULTITHREAD
+  if (ext_fb_list.num_external_frame_buffers > 0) {
+    pthread_cond_destroy(&ext_fb_list.cond);
+    pthread_mutex_destroy(&ext_fb_list.mutex);
+  }
+#endif
 
   fclose(infile);
   if (framestats_file) fclose(framestats_file);
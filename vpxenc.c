@@ -26,9 +26,13 @@
 #include "vpx/vpx_encoder.h"
 #if CONFIG_DECODERS
 #include "vpx/vpx_decoder.h"
+#include "vpx/vpx_frame_metrics.h"
 #endif
 
 #include "./args.h"
+#include "./async_reader.h"
+#include "./async_writer.h"
+#include "./bench_stats.h"
 #include "./ivfenc.h"
 #include "./tools_common.h"
 
@@ -95,19 +99,15 @@ static void warn_or_exit_on_error(vpx_codec_ctx_t *ctx, int fatal,
   va_end(ap);
 }
 
-static int read_frame(struct VpxInputContext *input_ctx, vpx_image_t *img) {
-  FILE *f = input_ctx->file;
-  y4m_input *y4m = &input_ctx->y4m;
-  int shortread = 0;
-
-  if (input_ctx->file_type == FILE_TYPE_Y4M) {
-    if (y4m_input_fetch_frame(y4m, f, img) < 1) return 0;
-  } else {
-    shortread = read_yuv_frame(input_ctx, img);
-  }
+/* Number of input frames the reader thread may hold, including the one being
+ * encoded.
+ */
+#define INPUT_READER_BUFFERS 3
 
-  return !shortread;
-}
+/* Number of compressed frames that may be queued for the output writer
+ * thread.
+ */
+#define OUTPUT_WRITER_JOBS 8
 
 static int file_is_y4m(const char detect[4]) {
   if (memcmp(detect, "YUV4", 4) == 0) {
@@ -165,7 +165,10 @@ static const arg_def_t quietarg =
 static const arg_def_t verbosearg =
     ARG_DEF("v", "verbose", 0, "Show encoder parameters");
 static const arg_def_t psnrarg =
-    ARG_DEF(NULL, "psnr", 0, "Show PSNR in status line");
+    ARG_DEF(NULL, "psnr", 0,
+            "Show PSNR in status line and SSIM metrics at the end");
+static const arg_def_t stage_timing_arg =
+    ARG_DEF(NULL, "stage-timing", 0, "Show time spent in each encoder stage");
 
 static const struct arg_enum_list test_decode_enum[] = {
   { "off", TEST_DECODE_OFF },
@@ -194,6 +197,25 @@ static const arg_def_t disable_warning_prompt =
     ARG_DEF("y", "disable-warning-prompt", 0,
             "Display warnings, but do not prompt user to continue.");
 
+static const arg_def_t bencharg =
+    ARG_DEF(NULL, "bench", 0,
+            "Benchmark encoding from memory, without output");
+static const arg_def_t bench_cpu_used =
+    ARG_DEF(NULL, "bench-cpu-used", 1,
+            "Comma separated --cpu-used values to benchmark");
+static const arg_def_t bench_threads =
+    ARG_DEF(NULL, "bench-threads", 1,
+            "Comma separated thread counts to benchmark");
+static const arg_def_t bench_row_mt =
+    ARG_DEF(NULL, "bench-row-mt", 1,
+            "Comma separated --row-mt values to benchmark (VP9)");
+static const arg_def_t bench_tile_columns =
+    ARG_DEF(NULL, "bench-tile-columns", 1,
+            "Comma separated --tile-columns values to benchmark (VP9)");
+static const arg_def_t bench_tile_rows =
+    ARG_DEF(NULL, "bench-tile-rows", 1,
+            "Comma separated --tile-rows values to benchmark (VP9)");
+
 #if CONFIG_VP9_HIGHBITDEPTH
 static const arg_def_t test16bitinternalarg = ARG_DEF(
     NULL, "test-16bit-internal", 0, "Force use of 16 bit internal buffer");
@@ -214,6 +236,7 @@ static const arg_def_t *main_args[] = { &debugmode,
                                         &quietarg,
                                         &verbosearg,
                                         &psnrarg,
+                                        &stage_timing_arg,
                                         &use_webm,
                                         &use_ivf,
                                         &out_part,
@@ -222,6 +245,12 @@ static const arg_def_t *main_args[] = { &debugmode,
                                         &disable_warnings,
                                         &disable_warning_prompt,
                                         &recontest,
+                                        &bencharg,
+                                        &bench_cpu_used,
+                                        &bench_threads,
+                                        &bench_row_mt,
+                                        &bench_tile_columns,
+                                        &bench_tile_rows,
                                         NULL };
 
 static const arg_def_t usage =
@@ -474,6 +503,22 @@ static const arg_def_t target_level = ARG_DEF(
 static const arg_def_t row_mt =
     ARG_DEF(NULL, "row-mt", 1,
             "Enable row based non-deterministic multi-threading in VP9");
+
+static const struct arg_enum_list memory_profile_enum[] = {
+  { "default", VP9E_MEMORY_PROFILE_DEFAULT },
+  { "low", VP9E_MEMORY_PROFILE_LOW },
+  { NULL, 0 }
+};
+
+static const arg_def_t memory_profile =
+    ARG_DEF_ENUM(NULL, "memory-profile", 1,
+                 "Memory profile (low requires one pass and no lag)",
+                 memory_profile_enum);
+
+static const arg_def_t lookahead_pass =
+    ARG_DEF(NULL, "lookahead-pass", 1,
+            "Run the first pass arg frames ahead in a single pass "
+            "(32..600, requires --passes=1)");
 #endif
 
 #if CONFIG_VP9_ENCODER
@@ -503,6 +548,8 @@ static const arg_def_t *vp9_args[] = { &cpu_used_vp9,
                                        &max_gf_interval,
                                        &target_level,
                                        &row_mt,
+                                       &memory_profile,
+                                       &lookahead_pass,
 #if CONFIG_VP9_HIGHBITDEPTH
                                        &bitdeptharg,
                                        &inbitdeptharg,
@@ -534,6 +581,8 @@ static const int vp9_arg_ctrl_map[] = { VP8E_SET_CPUUSED,
                                         VP9E_SET_MAX_GF_INTERVAL,
                                         VP9E_SET_TARGET_LEVEL,
                                         VP9E_SET_ROW_MT,
+                                        VP9E_SET_MEMORY_PROFILE,
+                                        VP9E_SET_LOOKAHEAD_PASS,
                                         0 };
 #endif
 
@@ -838,6 +887,14 @@ struct stream_config {
 #endif
 };
 
+#if CONFIG_DECODERS
+struct metrics_source {
+  vpx_codec_pts_t pts;
+  vpx_image_t img;
+  struct metrics_source *next;
+};
+#endif
+
 struct stream_state {
   int index;
   struct stream_state *next;
@@ -861,6 +918,21 @@ struct stream_state {
   struct vpx_image *img;
   vpx_codec_ctx_t decoder;
   int mismatch_seen;
+#if CONFIG_DECODERS
+  // With --psnr the metrics are measured on the decoded frames, which are
+  // matched with the queued source frames by pts.
+  int decode_metrics;
+  struct metrics_source *metrics_queue;
+  struct metrics_source *metrics_free;
+  double ssim_total;
+  double fastssim_total;
+  double psnrhvs_total;
+  int metrics_count;
+#endif
+#if CONFIG_VP9_ENCODER
+  vpx_stage_timing_t stage_timing;
+  int stage_timing_count;
+#endif
 };
 
 static void validate_positive_rational(const char *msg,
@@ -875,6 +947,13 @@ static void validate_positive_rational(const char *msg,
   if (!rat->den) die("Error: %s has zero denominator\n", msg);
 }
 
+static void parse_bench_values(const struct arg *arg, const char *name,
+                               struct VpxBenchList *list) {
+  list->count = parse_bench_list(arg->val, list->values, MAX_BENCH_VALUES);
+  if (list->count <= 0)
+    die("Error: Invalid list for --%s (%s)\n", name, arg->val);
+}
+
 static void parse_global_config(struct VpxEncoderConfig *global, char **argv) {
   char **argi, **argj;
   struct arg arg;
@@ -937,6 +1016,8 @@ static void parse_global_config(struct VpxEncoderConfig *global, char **argv) {
       global->skip_frames = arg_parse_uint(&arg);
     else if (arg_match(&arg, &psnrarg, argi))
       global->show_psnr = 1;
+    else if (arg_match(&arg, &stage_timing_arg, argi))
+      global->show_stage_timing = 1;
     else if (arg_match(&arg, &recontest, argi))
       global->test_decode = arg_parse_enum_or_int(&arg);
     else if (arg_match(&arg, &framerate, argi)) {
@@ -955,10 +1036,33 @@ static void parse_global_config(struct VpxEncoderConfig *global, char **argv) {
       global->disable_warnings = 1;
     else if (arg_match(&arg, &disable_warning_prompt, argi))
       global->disable_warning_prompt = 1;
+    else if (arg_match(&arg, &bencharg, argi))
+      global->bench = 1;
+    else if (arg_match(&arg, &bench_cpu_used, argi))
+      parse_bench_values(&arg, "bench-cpu-used", &global->bench_cpu_used);
+    else if (arg_match(&arg, &bench_threads, argi)) {
+      int i;
+      parse_bench_values(&arg, "bench-threads", &global->bench_threads);
+      for (i = 0; i < global->bench_threads.count; i++) {
+        if (global->bench_threads.values[i] < 0)
+          die("Error: Invalid list for --bench-threads (%s)\n", arg.val);
+      }
+    } else if (arg_match(&arg, &bench_row_mt, argi))
+      parse_bench_values(&arg, "bench-row-mt", &global->bench_row_mt);
+    else if (arg_match(&arg, &bench_tile_columns, argi))
+      parse_bench_values(&arg, "bench-tile-columns",
+                         &global->bench_tile_columns);
+    else if (arg_match(&arg, &bench_tile_rows, argi))
+      parse_bench_values(&arg, "bench-tile-rows", &global->bench_tile_rows);
     else
       argj++;
   }
 
+  if (global->bench && strcmp(global->codec->name, "vp9") != 0 &&
+      (global->bench_row_mt.count || global->bench_tile_columns.count ||
+       global->bench_tile_rows.count))
+    die("Error: --bench-row-mt and --bench-tile-* require VP9\n");
+
   if (global->pass) {
     /* DWIM: Assume the user meant passes=2 if pass=2 is specified */
     if (global->pass > global->passes) {
@@ -1285,10 +1389,25 @@ static int parse_stream_params(struct VpxEncoderConfig *global,
     }                                                       \
   } while (0)
 
+/* Returns the frames the lookahead pass of the stream runs ahead, 0 if it is
+ * off.
+ */
+static int stream_lookahead_pass(const struct stream_state *stream) {
+#if CONFIG_VP9_ENCODER
+  int j;
+
+  for (j = 0; j < stream->config.arg_ctrl_cnt; j++)
+    if (stream->config.arg_ctrls[j][0] == VP9E_SET_LOOKAHEAD_PASS)
+      return stream->config.arg_ctrls[j][1];
+#else
+  (void)stream;
+#endif
+  return 0;
+}
+
 static void validate_stream_config(const struct stream_state *stream,
                                    const struct VpxEncoderConfig *global) {
   const struct stream_state *streami;
-  (void)global;
 
   if (!stream->config.cfg.g_w || !stream->config.cfg.g_h)
     fatal(
@@ -1304,9 +1423,12 @@ static void validate_stream_config(const struct stream_state *stream,
           stream->config.cfg.g_input_bit_depth);
   }
 
+  if (stream_lookahead_pass(stream) && global->passes != 1)
+    fatal("Stream %d: --lookahead-pass requires --passes=1", stream->index);
+
   for (streami = stream; streami; streami = streami->next) {
-    /* All streams require output files */
-    if (!streami->config.out_fn)
+    /* All streams require output files, except when benchmarking */
+    if (!streami->config.out_fn && !global->bench)
       fatal("Stream %d: Output file is required (specify with -o)",
             streami->index);
 
@@ -1481,9 +1603,19 @@ static void close_output_file(struct stream_state *stream,
   fclose(stream->file);
 }
 
+// VP9 reads a second pass statistics file on demand rather than in full.
+static int stream_stats_file(const struct stream_state *stream,
+                             const struct VpxEncoderConfig *global, int pass) {
+  return pass && stream->config.stats_fn &&
+         strcmp(global->codec->name, "vp9") == 0;
+}
+
 static void setup_pass(struct stream_state *stream,
                        struct VpxEncoderConfig *global, int pass) {
-  if (stream->config.stats_fn) {
+  if (stream_stats_file(stream, global, pass)) {
+    if (!stats_open_file_streamed(&stream->stats, stream->config.stats_fn))
+      fatal("Failed to open statistics store");
+  } else if (stream->config.stats_fn) {
     if (!stats_open_file(&stream->stats, stream->config.stats_fn, pass))
       fatal("Failed to open statistics store");
   } else {
@@ -1504,8 +1636,13 @@ static void setup_pass(struct stream_state *stream,
 
   stream->config.cfg.g_pass = global->passes == 2
                                   ? pass ? VPX_RC_LAST_PASS : VPX_RC_FIRST_PASS
-                                  : VPX_RC_ONE_PASS;
-  if (pass) {
+                                  : stream_lookahead_pass(stream)
+                                        ? VPX_RC_LAST_PASS
+                                        : VPX_RC_ONE_PASS;
+  if (stream_stats_file(stream, global, pass)) {
+    stream->config.cfg.rc_twopass_stats_in.buf = NULL;
+    stream->config.cfg.rc_twopass_stats_in.sz = 0;
+  } else if (pass) {
     stream->config.cfg.rc_twopass_stats_in = stats_get(&stream->stats);
 #if CONFIG_FP_MB_STATS
     stream->config.cfg.rc_firstpass_mb_stats_in =
@@ -1516,6 +1653,10 @@ static void setup_pass(struct stream_state *stream,
   stream->cx_time = 0;
   stream->nbytes = 0;
   stream->frames_out = 0;
+#if CONFIG_VP9_ENCODER
+  memset(&stream->stage_timing, 0, sizeof(stream->stage_timing));
+  stream->stage_timing_count = 0;
+#endif
 }
 
 static void initialize_encoder(struct stream_state *stream,
@@ -1523,7 +1664,16 @@ static void initialize_encoder(struct stream_state *stream,
   int i;
   int flags = 0;
 
+#if CONFIG_DECODERS
+  // --psnr measures the decoded frames when there is a decoder for the codec
+  // and only falls back to the encoder's PSNR packets otherwise.
+  stream->decode_metrics =
+      global->show_psnr && get_vpx_decoder_by_name(global->codec->name);
+  flags |= global->show_psnr && !stream->decode_metrics ? VPX_CODEC_USE_PSNR
+                                                         : 0;
+#else
   flags |= global->show_psnr ? VPX_CODEC_USE_PSNR : 0;
+#endif
   flags |= global->out_part ? VPX_CODEC_USE_OUTPUT_PARTITION : 0;
 #if CONFIG_VP9_HIGHBITDEPTH
   flags |= stream->config.use_16bit_internal ? VPX_CODEC_USE_HIGHBITDEPTH : 0;
@@ -1547,14 +1697,136 @@ static void initialize_encoder(struct stream_state *stream,
     ctx_exit_on_error(&stream->encoder, "Failed to control codec");
   }
 
+#if CONFIG_VP9_ENCODER
+  if (stream->config.cfg.g_pass == VPX_RC_LAST_PASS &&
+      stream->config.cfg.rc_twopass_stats_in.buf == NULL &&
+      !stream_lookahead_pass(stream)) {
+    vpx_twopass_stats_source_t source;
+    source.read = stats_read;
+    source.sz = stream->stats.buf.sz;
+    source.priv = &stream->stats;
+    vpx_codec_control(&stream->encoder, VP9E_SET_TWOPASS_STATS_SOURCE,
+                      &source);
+    ctx_exit_on_error(&stream->encoder, "Failed to read first pass stats");
+  }
+#endif
+
 #if CONFIG_DECODERS
-  if (global->test_decode != TEST_DECODE_OFF) {
+  if (global->test_decode != TEST_DECODE_OFF || stream->decode_metrics) {
     const VpxInterface *decoder = get_vpx_decoder_by_name(global->codec->name);
     vpx_codec_dec_init(&stream->decoder, decoder->codec_interface(), NULL, 0);
   }
 #endif
 }
 
+#if CONFIG_DECODERS
+static void copy_image(vpx_image_t *dst, const vpx_image_t *src) {
+  const int bytes_per_sample = (src->fmt & VPX_IMG_FMT_HIGHBITDEPTH) ? 2 : 1;
+  int plane;
+
+  for (plane = 0; plane < 3; ++plane) {
+    const unsigned int w =
+        plane ? (src->d_w + src->x_chroma_shift) >> src->x_chroma_shift
+              : src->d_w;
+    const unsigned int h =
+        plane ? (src->d_h + src->y_chroma_shift) >> src->y_chroma_shift
+              : src->d_h;
+    unsigned int y;
+
+    for (y = 0; y < h; ++y) {
+      memcpy(dst->planes[plane] + y * dst->stride[plane],
+             src->planes[plane] + y * src->stride[plane],
+             w * bytes_per_sample);
+    }
+  }
+  dst->bit_depth = src->bit_depth;
+}
+
+// Keeps a copy of a frame passed to the encoder until the decoder outputs it.
+// The input reader owns the source buffers, so they cannot be kept.
+static void queue_metrics_source(struct stream_state *stream,
+                                 const vpx_image_t *img, vpx_codec_pts_t pts) {
+  struct metrics_source *source = stream->metrics_free;
+  struct metrics_source **tail = &stream->metrics_queue;
+
+  if (source) {
+    stream->metrics_free = source->next;
+  } else {
+    source = calloc(1, sizeof(*source));
+    if (!source || !vpx_img_alloc(&source->img, img->fmt, img->d_w,
+                                  img->d_h, 16))
+      fatal("Failed to allocate metrics source frame");
+  }
+  copy_image(&source->img, img);
+  source->pts = pts;
+  source->next = NULL;
+  while (*tail) tail = &(*tail)->next;
+  *tail = source;
+}
+
+static void free_metrics_sources(struct metrics_source *source) {
+  while (source) {
+    struct metrics_source *const next = source->next;
+    vpx_img_free(&source->img);
+    free(source);
+    source = next;
+  }
+}
+
+static void stop_decode_metrics(struct stream_state *stream) {
+  stream->decode_metrics = 0;
+  free_metrics_sources(stream->metrics_queue);
+  free_metrics_sources(stream->metrics_free);
+  stream->metrics_queue = stream->metrics_free = NULL;
+}
+
+// Measures the frames the decoder output for the packet with the given pts.
+static void measure_decoded_frames(struct stream_state *stream,
+                                   const struct VpxEncoderConfig *global,
+                                   vpx_codec_pts_t pts) {
+  const struct vpx_codec_enc_cfg *const cfg = &stream->config.cfg;
+  const unsigned int input_bit_depth =
+      global->codec->fourcc == VP9_FOURCC ? cfg->g_input_bit_depth : 0;
+  const int threads = cfg->g_threads > 0 ? (int)cfg->g_threads : 1;
+  vpx_codec_iter_t iter = NULL;
+  const vpx_image_t *img;
+
+  while ((img = vpx_codec_get_frame(&stream->decoder, &iter)) != NULL) {
+    struct metrics_source *source;
+    vpx_frame_metrics_t metrics;
+    int i;
+
+    // Frames dropped by the encoder never come out of the decoder.
+    while ((source = stream->metrics_queue) != NULL && source->pts < pts) {
+      stream->metrics_queue = source->next;
+      source->next = stream->metrics_free;
+      stream->metrics_free = source;
+    }
+    if (!source || source->pts != pts) continue;
+
+    if (vpx_calc_frame_metrics(&source->img, img, input_bit_depth,
+                               VPX_METRIC_ALL, threads,
+                               &metrics) != VPX_CODEC_OK) {
+      warn("Stream %d: Failed to measure the decoded frames", stream->index);
+      stop_decode_metrics(stream);
+      return;
+    }
+
+    stream->psnr_sse_total += metrics.sse[0];
+    stream->psnr_samples_total += metrics.samples[0];
+    for (i = 0; i < 4; i++) {
+      if (!global->quiet) fprintf(stderr, "%.3f ", metrics.psnr[i]);
+      stream->psnr_totals[i] += metrics.psnr[i];
+    }
+    stream->psnr_count++;
+    stream->ssim_total += metrics.ssim;
+    stream->fastssim_total += metrics.fastssim[0];
+    stream->psnrhvs_total += metrics.psnrhvs[0];
+    stream->metrics_count++;
+  }
+}
+#endif
+
 static void encode_frame(struct stream_state *stream,
                          struct VpxEncoderConfig *global, struct vpx_image *img,
                          unsigned int frames_in) {
@@ -1634,6 +1906,11 @@ static void encode_frame(struct stream_state *stream,
 #endif
   }
 
+#if CONFIG_DECODERS
+  if (img && stream->decode_metrics)
+    queue_metrics_source(stream, img, frame_start);
+#endif
+
   vpx_usec_timer_start(&timer);
   vpx_codec_encode(&stream->encoder, img, frame_start,
                    (unsigned long)(next_frame_start - frame_start), 0,
@@ -1654,17 +1931,134 @@ static void update_quantizer_histogram(struct stream_state *stream) {
   }
 }
 
+#if CONFIG_VP9_ENCODER
+static void update_stage_timing(struct stream_state *stream,
+                                struct VpxEncoderConfig *global) {
+  vpx_stage_timing_t t;
+  int i;
+
+  if (global->codec->fourcc != VP9_FOURCC || !global->show_stage_timing)
+    return;
+
+  if (vpx_codec_control(&stream->encoder, VP9E_GET_STAGE_TIMING, &t) !=
+      VPX_CODEC_OK) {
+    warn("Stream %d: stage timing not supported by this build",
+         stream->index);
+    global->show_stage_timing = 0;
+    return;
+  }
+
+  for (i = 0; i < VPX_ENC_STAGE_COUNT; i++)
+    stream->stage_timing.stage_us[i] += t.stage_us[i];
+  stream->stage_timing.total_us += t.total_us;
+  if (t.num_threads > stream->stage_timing.num_threads)
+    stream->stage_timing.num_threads = t.num_threads;
+  for (i = 0; i < t.num_threads; i++)
+    stream->stage_timing.thread_us[i] += t.thread_us[i];
+  stream->stage_timing_count++;
+}
+
+static void show_stage_timing(struct stream_state *stream) {
+  static const char *const stage_names[VPX_ENC_STAGE_COUNT] = {
+    "lookahead",        "temporal filter", "encode frame",
+    "pick loop filter", "loop filter",     "pack bitstream"
+  };
+  const vpx_stage_timing_t *const t = &stream->stage_timing;
+  int i;
+
+  if (!stream->stage_timing_count) return;
+
+  fprintf(stderr, "Stream %d stage timing (%d calls):\n", stream->index,
+          stream->stage_timing_count);
+  for (i = 0; i < VPX_ENC_STAGE_COUNT; i++) {
+    fprintf(stderr, "  %-16s %10.3f ms  %5.1f%%\n", stage_names[i],
+            t->stage_us[i] / 1000.0,
+            t->total_us ? 100.0 * t->stage_us[i] / t->total_us : 0.0);
+  }
+  fprintf(stderr, "  %-16s %10.3f ms\n", "total", t->total_us / 1000.0);
+  for (i = 0; i < t->num_threads; i++) {
+    fprintf(stderr, "  thread %-9d %10.3f ms\n", i, t->thread_us[i] / 1000.0);
+  }
+}
+#endif
+
+/* A compressed frame queued for the output writer. The packet's data points
+ * into |buf|, which is owned by the job and reused by later jobs.
+ */
+struct output_packet {
+  struct stream_state *stream;
+  vpx_codec_cx_pkt_t pkt;
+  void *buf;
+  size_t buf_sz;
+};
+
+static void write_packet(void *priv, void *job) {
+  struct output_packet *const out = (struct output_packet *)job;
+  struct stream_state *const stream = out->stream;
+  const vpx_codec_cx_pkt_t *const pkt = &out->pkt;
+  static size_t fsize = 0;
+  static FileOffset ivf_header_pos = 0;
+  (void)priv;
+
+#if CONFIG_WEBM_IO
+  if (stream->config.write_webm) {
+    write_webm_block(&stream->webm_ctx, &stream->config.cfg, pkt);
+  }
+#endif
+  if (!stream->config.write_webm) {
+    if (pkt->data.frame.partition_id <= 0) {
+      ivf_header_pos = ftello(stream->file);
+      fsize = pkt->data.frame.sz;
+
+      ivf_write_frame_header(stream->file, pkt->data.frame.pts, fsize);
+    } else {
+      fsize += pkt->data.frame.sz;
+
+      if (!(pkt->data.frame.flags & VPX_FRAME_IS_FRAGMENT)) {
+        const FileOffset currpos = ftello(stream->file);
+        fseeko(stream->file, ivf_header_pos, SEEK_SET);
+        ivf_write_frame_size(stream->file, fsize);
+        fseeko(stream->file, currpos, SEEK_SET);
+      }
+    }
+
+    (void)fwrite(pkt->data.frame.buf, 1, pkt->data.frame.sz, stream->file);
+  }
+}
+
+static void free_packet(void *priv, void *job) {
+  (void)priv;
+  free(((struct output_packet *)job)->buf);
+}
+
+static void queue_packet(struct async_writer *writer,
+                         struct stream_state *stream,
+                         const vpx_codec_cx_pkt_t *pkt) {
+  struct output_packet *const out =
+      (struct output_packet *)async_writer_next_job(writer);
+
+  if (out->buf_sz < pkt->data.frame.sz) {
+    free(out->buf);
+    out->buf = malloc(pkt->data.frame.sz);
+    if (!out->buf) fatal("Failed to allocate output packet");
+    out->buf_sz = pkt->data.frame.sz;
+  }
+  memcpy(out->buf, pkt->data.frame.buf, pkt->data.frame.sz);
+  out->stream = stream;
+  out->pkt = *pkt;
+  out->pkt.data.frame.buf = out->buf;
+  async_writer_submit(writer);
+}
+
 static void get_cx_data(struct stream_state *stream,
-                        struct VpxEncoderConfig *global, int *got_data) {
+                        struct VpxEncoderConfig *global,
+                        struct async_writer *writer, int *got_data) {
   const vpx_codec_cx_pkt_t *pkt;
   const struct vpx_codec_enc_cfg *cfg = &stream->config.cfg;
   vpx_codec_iter_t iter = NULL;
 
   *got_data = 0;
   while ((pkt = vpx_codec_get_cx_data(&stream->encoder, &iter))) {
-    static size_t fsize = 0;
-    static FileOffset ivf_header_pos = 0;
-
     switch (pkt->kind) {
       case VPX_CODEC_CX_FRAME_PKT:
         if (!(pkt->data.frame.flags & VPX_FRAME_IS_FRAGMENT)) {
@@ -1674,36 +2068,14 @@ static void get_cx_data(struct stream_state *stream,
           fprintf(stderr, " %6luF", (unsigned long)pkt->data.frame.sz);
 
         update_rate_histogram(stream->rate_hist, cfg, pkt);
-#if CONFIG_WEBM_IO
-        if (stream->config.write_webm) {
-          write_webm_block(&stream->webm_ctx, cfg, pkt);
-        }
-#endif
-        if (!stream->config.write_webm) {
-          if (pkt->data.frame.partition_id <= 0) {
-            ivf_header_pos = ftello(stream->file);
-            fsize = pkt->data.frame.sz;
-
-            ivf_write_frame_header(stream->file, pkt->data.frame.pts, fsize);
-          } else {
-            fsize += pkt->data.frame.sz;
-
-            if (!(pkt->data.frame.flags & VPX_FRAME_IS_FRAGMENT)) {
-              const FileOffset currpos = ftello(stream->file);
-              fseeko(stream->file, ivf_header_pos, SEEK_SET);
-              ivf_write_frame_size(stream->file, fsize);
-              fseeko(stream->file, currpos, SEEK_SET);
-            }
-          }
-
-          (void)fwrite(pkt->data.frame.buf, 1, pkt->data.frame.sz,
-                       stream->file);
-        }
+        queue_packet(writer, stream, pkt);
         stream->nbytes += pkt->data.raw.sz;
 
         *got_data = 1;
 #if CONFIG_DECODERS
-        if (global->test_decode != TEST_DECODE_OFF && !stream->mismatch_seen) {
+        if ((global->test_decode != TEST_DECODE_OFF &&
+             !stream->mismatch_seen) ||
+            stream->decode_metrics) {
           vpx_codec_decode(&stream->decoder, pkt->data.frame.buf,
                            (unsigned int)pkt->data.frame.sz, NULL, 0);
           if (stream->decoder.err) {
@@ -1712,6 +2084,9 @@ static void get_cx_data(struct stream_state *stream,
                                   "Failed to decode frame %d in stream %d",
                                   stream->frames_out + 1, stream->index);
             stream->mismatch_seen = stream->frames_out + 1;
+            stop_decode_metrics(stream);
+          } else if (stream->decode_metrics) {
+            measure_decoded_frames(stream, global, pkt->data.frame.pts);
           }
         }
 #endif
@@ -1765,6 +2140,15 @@ static void show_psnr(struct stream_state *stream, double peak) {
     fprintf(stderr, " %.3f", stream->psnr_totals[i] / stream->psnr_count);
   }
   fprintf(stderr, "\n");
+
+#if CONFIG_DECODERS
+  if (stream->metrics_count) {
+    fprintf(stderr, "Stream %d SSIM/FastSSIM/PSNR-HVS (Avg) %.4f %.3f %.3f\n",
+            stream->index, stream->ssim_total / stream->metrics_count,
+            stream->fastssim_total / stream->metrics_count,
+            stream->psnrhvs_total / stream->metrics_count);
+  }
+#endif
 }
 
 static float usec_to_fps(uint64_t usec, unsigned int frames) {
@@ -1867,6 +2251,297 @@ static void print_time(const char *label, int64_t etl) {
   }
 }
 
+/* Input frames preloaded for --bench, in the format the encoder takes. */
+struct bench_frames {
+  vpx_image_t **images;
+  int count;
+};
+
+static void load_bench_frames(struct VpxInputContext *input,
+                              const struct VpxEncoderConfig *global,
+                              const struct stream_state *stream,
+                              struct bench_frames *frames) {
+  struct async_reader *const reader =
+      async_reader_open(input, INPUT_READER_BUFFERS, global->limit);
+  vpx_image_t *img;
+  int frames_in = 0, capacity = 0;
+#if CONFIG_VP9_HIGHBITDEPTH
+  const struct vpx_codec_enc_cfg *const cfg = &stream->config.cfg;
+  const int input_shift =
+      strcmp(global->codec->name, "vp9") == 0 && cfg->g_profile
+          ? (int)cfg->g_bit_depth - (int)cfg->g_input_bit_depth
+          : 0;
+  const int upshift = input_shift || (stream->config.use_16bit_internal &&
+                                      input->bit_depth == 8);
+#else
+  (void)stream;
+#endif
+
+  while ((img = async_reader_read_frame(reader))) {
+    vpx_image_t *frame;
+
+    if (++frames_in <= global->skip_frames) continue;
+    if (frames->count == capacity) {
+      capacity = capacity ? 2 * capacity : 64;
+      frames->images = (vpx_image_t **)realloc(
+          frames->images, capacity * sizeof(*frames->images));
+      if (!frames->images) fatal("Failed to allocate benchmark frames");
+    }
+#if CONFIG_VP9_HIGHBITDEPTH
+    if (upshift) {
+      frame = vpx_img_alloc(NULL, img->fmt | VPX_IMG_FMT_HIGHBITDEPTH,
+                            input->width, input->height, 32);
+      if (!frame) fatal("Failed to allocate benchmark frames");
+      vpx_img_upshift(frame, img, input_shift);
+    } else {
+#endif
+      frame = vpx_img_alloc(NULL, img->fmt, img->d_w, img->d_h, 32);
+      if (!frame) fatal("Failed to allocate benchmark frames");
+      frame->bit_depth = img->bit_depth;
+      vpx_img_copy(img, frame);
+#if CONFIG_VP9_HIGHBITDEPTH
+    }
+#endif
+    frames->images[frames->count++] = frame;
+  }
+  async_reader_close(reader);
+}
+
+static void free_bench_frames(struct bench_frames *frames) {
+  int i;
+  for (i = 0; i < frames->count; ++i) vpx_img_free(frames->images[i]);
+  free(frames->images);
+}
+
+/* Sets a control applied by initialize_encoder(), replacing any value given
+ * on the command line.
+ */
+static void set_stream_ctrl(struct stream_config *config, int ctrl,
+                            int value) {
+  int j;
+
+  for (j = 0; j < config->arg_ctrl_cnt; j++)
+    if (config->arg_ctrls[j][0] == ctrl) break;
+  if (j == (int)ARG_CTRL_CNT_MAX) fatal("Too many encoder controls");
+  config->arg_ctrls[j][0] = ctrl;
+  config->arg_ctrls[j][1] = value;
+  if (j == config->arg_ctrl_cnt) config->arg_ctrl_cnt++;
+}
+
+/* Prints the value of a control, or "-" if the codec default is used. */
+static void print_stream_ctrl(const struct stream_config *config, int ctrl,
+                              int width) {
+  int j;
+
+  for (j = 0; j < config->arg_ctrl_cnt; j++) {
+    if (config->arg_ctrls[j][0] == ctrl) {
+      printf("%*d", width, config->arg_ctrls[j][1]);
+      return;
+    }
+  }
+  printf("%*s", width, "-");
+}
+
+static void get_bench_data(struct stream_state *stream, int *got_data) {
+  const vpx_codec_cx_pkt_t *pkt;
+  vpx_codec_iter_t iter = NULL;
+
+  *got_data = 0;
+  while ((pkt = vpx_codec_get_cx_data(&stream->encoder, &iter))) {
+    switch (pkt->kind) {
+      case VPX_CODEC_CX_FRAME_PKT:
+        if (!(pkt->data.frame.flags & VPX_FRAME_IS_FRAGMENT))
+          stream->frames_out++;
+        stream->nbytes += pkt->data.frame.sz;
+        *got_data = 1;
+        break;
+      case VPX_CODEC_STATS_PKT:
+        stream->frames_out++;
+        stats_write(&stream->stats, pkt->data.twopass_stats.buf,
+                    pkt->data.twopass_stats.sz);
+        stream->nbytes += pkt->data.raw.sz;
+        break;
+#if CONFIG_FP_MB_STATS
+      case VPX_CODEC_FPMB_STATS_PKT:
+        stats_write(&stream->fpmb_stats, pkt->data.firstpass_mb_stats.buf,
+                    pkt->data.firstpass_mb_stats.sz);
+        stream->nbytes += pkt->data.raw.sz;
+        break;
+#endif
+      default: break;
+    }
+  }
+}
+
+/* Returns the memory held by the encoder in bytes: its frame sized buffers and
+ * the scratch blocks of its threads. Returns 0 if the codec does not report
+ * it.
+ */
+static size_t get_encoder_memory(struct stream_state *stream,
+                                 const struct VpxEncoderConfig *global) {
+  size_t size = 0;
+#if CONFIG_VP9_ENCODER
+  vpx_memory_allocator_stats_t stats;
+
+  if (global->codec->fourcc != VP9_FOURCC) return 0;
+  if (vpx_codec_control(&stream->encoder, VP9E_GET_MEMORY_FOOTPRINT, &size) !=
+      VPX_CODEC_OK)
+    return 0;
+  if (vpx_codec_control(&stream->encoder, VP9E_GET_MEMORY_ALLOCATOR_STATS,
+                        &stats) == VPX_CODEC_OK)
+    size += stats.bytes_reserved;
+#else
+  (void)stream;
+  (void)global;
+#endif
+  return size;
+}
+
+/* Encodes the preloaded frames with the stream's current settings, one line
+ * per pass. Latencies are taken for each vpx_codec_encode() call that takes a
+ * frame or, when flushing, returns one, together with the retrieval of its
+ * packets. The pass time includes flushing the encoder but not its
+ * initialization.
+ */
+static void run_bench_config(struct stream_state *stream,
+                             struct VpxEncoderConfig *global,
+                             const struct bench_frames *frames) {
+  struct latency_stats latency = { NULL, 0, 0 };
+  int pass;
+
+  for (pass = 0; pass < global->passes; pass++) {
+    const struct stream_config *const config = &stream->config;
+    struct vpx_usec_timer timer;
+    int64_t wall_usec, cpu_usec, cpu_start;
+    double seconds, cores;
+    size_t memory;
+    int i, got_data;
+
+    setup_pass(stream, global, pass);
+    initialize_encoder(stream, global);
+    latency_stats_reset(&latency);
+
+    cpu_start = get_process_cpu_usec();
+    vpx_usec_timer_start(&timer);
+    for (i = 0; i < frames->count; i++) {
+      struct vpx_usec_timer frame_timer;
+      vpx_usec_timer_start(&frame_timer);
+      encode_frame(stream, global, frames->images[i], i + 1);
+      get_bench_data(stream, &got_data);
+      vpx_usec_timer_mark(&frame_timer);
+      latency_stats_add(&latency, vpx_usec_timer_elapsed(&frame_timer));
+    }
+    do {
+      struct vpx_usec_timer frame_timer;
+      vpx_usec_timer_start(&frame_timer);
+      encode_frame(stream, global, NULL, frames->count);
+      get_bench_data(stream, &got_data);
+      vpx_usec_timer_mark(&frame_timer);
+      if (got_data)
+        latency_stats_add(&latency, vpx_usec_timer_elapsed(&frame_timer));
+    } while (got_data);
+    vpx_usec_timer_mark(&timer);
+    wall_usec = vpx_usec_timer_elapsed(&timer);
+    cpu_usec = get_process_cpu_usec() - cpu_start;
+
+    memory = get_encoder_memory(stream, global);
+    vpx_codec_destroy(&stream->encoder);
+    stats_close(&stream->stats, global->passes - 1);
+#if CONFIG_FP_MB_STATS
+    stats_close(&stream->fpmb_stats, global->passes - 1);
+#endif
+
+    seconds = (double)wall_usec / 1000000.0;
+    cores = wall_usec ? (double)cpu_usec / wall_usec : 0.0;
+    print_stream_ctrl(config, VP8E_SET_CPUUSED, 8);
+    printf(" %7u", config->cfg.g_threads);
+    print_stream_ctrl(config, VP9E_SET_ROW_MT, 7);
+    print_stream_ctrl(config, VP9E_SET_TILE_COLUMNS, 10);
+    print_stream_ctrl(config, VP9E_SET_TILE_ROWS, 10);
+    printf(" %4d %6d %9.3f %9.2f %8" PRId64 " %8" PRId64 " %8" PRId64
+           " %9.3f %6.2f %6.1f",
+           pass + 1, frames->count, seconds,
+           wall_usec ? frames->count / seconds : 0.0,
+           latency_stats_percentile(&latency, 50),
+           latency_stats_percentile(&latency, 99),
+           latency_stats_percentile(&latency, 100),
+           (double)cpu_usec / 1000000.0, cores,
+           100.0 * cores /
+               (config->cfg.g_threads > 1 ? config->cfg.g_threads : 1));
+    if (memory)
+      printf(" %8.1f\n", memory / (1024.0 * 1024.0));
+    else
+      printf(" %8s\n", "-");
+    fflush(stdout);
+  }
+  latency_stats_free(&latency);
+}
+
+/* Benchmarks the first stream on every combination of the --bench-* lists.
+ * The last list varies fastest.
+ */
+static void run_bench(struct stream_state *stream,
+                      struct VpxEncoderConfig *global,
+                      struct VpxInputContext *input) {
+  const struct VpxBenchList *const lists[] = {
+    &global->bench_cpu_used, &global->bench_threads, &global->bench_row_mt,
+    &global->bench_tile_columns, &global->bench_tile_rows
+  };
+  const int ctrls[] = { VP8E_SET_CPUUSED, 0, VP9E_SET_ROW_MT,
+                        VP9E_SET_TILE_COLUMNS, VP9E_SET_TILE_ROWS };
+  const int num_lists = (int)(sizeof(lists) / sizeof(lists[0]));
+  struct stream_state bench_stream = *stream;
+  struct bench_frames frames = { NULL, 0 };
+  int64_t peak_rss_kb;
+  int num_configs = 1, i, j;
+
+  /* Statistics are kept in memory and no output is written. */
+  bench_stream.config.stats_fn = NULL;
+#if CONFIG_FP_MB_STATS
+  bench_stream.config.fpmb_stats_fn = NULL;
+#endif
+  for (i = 0; i < num_lists; i++)
+    num_configs *= lists[i]->count ? lists[i]->count : 1;
+
+  load_bench_frames(input, global, stream, &frames);
+  fprintf(stderr, "Benchmarking %s: %d frames, %d pass%s, %d configuration%s.\n",
+          global->codec->name, frames.count, global->passes,
+          global->passes == 1 ? "" : "es", num_configs,
+          num_configs == 1 ? "" : "s");
+  printf("cpu-used threads row-mt tile-cols tile-rows pass frames   time(s)"
+         "       fps  p50(us)  p99(us)  max(us)    cpu(s)  cores  util%%"
+         "  mem(MB)\n");
+
+  for (i = 0; i < num_configs; i++) {
+    int index = i;
+
+    bench_stream.config.cfg = stream->config.cfg;
+    memcpy(bench_stream.config.arg_ctrls, stream->config.arg_ctrls,
+           sizeof(stream->config.arg_ctrls));
+    bench_stream.config.arg_ctrl_cnt = stream->config.arg_ctrl_cnt;
+    for (j = num_lists - 1; j >= 0; j--) {
+      const int count = lists[j]->count;
+      int value;
+
+      if (!count) continue;
+      value = lists[j]->values[index % count];
+      index /= count;
+      if (lists[j] == &global->bench_threads)
+        bench_stream.config.cfg.g_threads = value;
+      else
+        set_stream_ctrl(&bench_stream.config, ctrls[j], value);
+    }
+    run_bench_config(&bench_stream, global, &frames);
+  }
+  /* The high-water mark covers the loaded frames and every configuration. */
+  peak_rss_kb = get_peak_rss_kb();
+  if (peak_rss_kb >= 0)
+    fprintf(stderr, "Peak process RSS: %.1f MB\n", peak_rss_kb / 1024.0);
+
+  if (bench_stream.img) vpx_img_free(bench_stream.img);
+  free_bench_frames(&frames);
+}
+
 int main(int argc, const char **argv_) {
   int pass;
   vpx_image_t raw;
@@ -1879,6 +2554,8 @@ int main(int argc, const char **argv_) {
   int frame_avail, got_data;
 
   struct VpxInputContext input;
+  struct async_reader *reader;
+  struct async_writer *writer;
   struct VpxEncoderConfig global;
   struct stream_state *streams = NULL;
   char **argv, **argi;
@@ -1934,6 +2611,9 @@ int main(int argc, const char **argv_) {
   FOREACH_STREAM(check_encoder_config(global.disable_warning_prompt, &global,
                                       &stream->config.cfg););
 
+  if (global.bench && stream_cnt > 1)
+    die("Error: --bench supports a single stream\n");
+
   /* Handle non-option arguments */
   input.filename = argv[0];
 
@@ -2027,14 +2707,18 @@ int main(int argc, const char **argv_) {
     if (global.verbose && pass == 0)
       FOREACH_STREAM(show_stream_config(stream, &global, &input));
 
+    if (global.bench) {
+      run_bench(streams, &global, &input);
+      close_input_file(&input);
+      break;
+    }
+
     if (pass == (global.pass ? global.pass - 1 : 0)) {
-      if (input.file_type == FILE_TYPE_Y4M)
-        /*The Y4M reader does its own allocation.
-          Just initialize this here to avoid problems if we never read any
-           frames.*/
-        memset(&raw, 0, sizeof(raw));
-      else
-        vpx_img_alloc(&raw, input.fmt, input.width, input.height, 32);
+      /* The input reader owns the frame buffers, |raw| only describes the
+       * current frame. Initialize it here to avoid problems if we never read
+       * any frames.
+       */
+      memset(&raw, 0, sizeof(raw));
 
       FOREACH_STREAM(stream->rate_hist = init_rate_histogram(
                          &stream->config.cfg, &global.framerate));
@@ -2044,6 +2728,8 @@ int main(int argc, const char **argv_) {
     FOREACH_STREAM(
         open_output_file(stream, &global, &input.pixel_aspect_ratio));
     FOREACH_STREAM(initialize_encoder(stream, &global));
+    writer = async_writer_open(OUTPUT_WRITER_JOBS, sizeof(struct output_packet),
+                               write_packet, free_packet, NULL);
 
 #if CONFIG_VP9_HIGHBITDEPTH
     if (strcmp(global.codec->name, "vp9") == 0) {
@@ -2064,6 +2750,7 @@ int main(int argc, const char **argv_) {
     }
 #endif
 
+    reader = async_reader_open(&input, INPUT_READER_BUFFERS, global.limit);
     frame_avail = 1;
     got_data = 0;
 
@@ -2071,9 +2758,13 @@ int main(int argc, const char **argv_) {
       struct vpx_usec_timer timer;
 
       if (!global.limit || frames_in < global.limit) {
-        frame_avail = read_frame(&input, &raw);
+        const vpx_image_t *const img = async_reader_read_frame(reader);
 
-        if (frame_avail) frames_in++;
+        frame_avail = img != NULL;
+        if (frame_avail) {
+          raw = *img;
+          frames_in++;
+        }
         seen_frames =
             frames_in > global.skip_frames ? frames_in - global.skip_frames : 0;
 
@@ -2139,13 +2830,17 @@ int main(int argc, const char **argv_) {
         cx_time += vpx_usec_timer_elapsed(&timer);
 
         FOREACH_STREAM(update_quantizer_histogram(stream));
+#if CONFIG_VP9_ENCODER
+        FOREACH_STREAM(update_stage_timing(stream, &global));
+#endif
 
         got_data = 0;
-        FOREACH_STREAM(get_cx_data(stream, &global, &got_data));
+        FOREACH_STREAM(get_cx_data(stream, &global, writer, &got_data));
 
         if (!got_data && input.length && streams != NULL &&
             !streams->frames_out) {
-          lagged_count = global.limit ? seen_frames : ftello(input.file);
+          lagged_count =
+              global.limit ? seen_frames : async_reader_position(reader);
         } else if (input.length) {
           int64_t remaining;
           int64_t rate;
@@ -2157,7 +2852,7 @@ int main(int argc, const char **argv_) {
             remaining = 1000 * (global.limit - global.skip_frames -
                                 seen_frames + lagged_count);
           } else {
-            const int64_t input_pos = ftello(input.file);
+            const int64_t input_pos = async_reader_position(reader);
             const int64_t input_pos_lagged = input_pos - lagged_count;
             const int64_t limit = input.length;
 
@@ -2206,17 +2901,26 @@ int main(int argc, const char **argv_) {
       }
     }
 
+#if CONFIG_VP9_ENCODER
+    if (global.show_stage_timing) FOREACH_STREAM(show_stage_timing(stream));
+#endif
+
     FOREACH_STREAM(vpx_codec_destroy(&stream->encoder));
 
-    if (global.test_decode != TEST_DECODE_OFF) {
+    if (global.test_decode != TEST_DECODE_OFF || global.show_psnr) {
       FOREACH_STREAM(vpx_codec_destroy(&stream->decoder));
     }
+#if CONFIG_DECODERS
+    FOREACH_STREAM(stop_decode_metrics(stream));
+#endif
 
+    async_reader_close(reader);
     close_input_file(&input);
 
     if (global.test_decode == TEST_DECODE_FATAL) {
       FOREACH_STREAM(res |= stream->mismatch_seen);
     }
+    async_writer_close(writer);
     FOREACH_STREAM(close_output_file(stream, global.codec->fourcc));
 
     FOREACH_STREAM(stats_close(&stream->stats, global.passes - 1));
@@ -2257,7 +2961,6 @@ int main(int argc, const char **argv_) {
 #if CONFIG_VP9_HIGHBITDEPTH
   if (allocated_raw_shift) vpx_img_free(&raw_shift);
 #endif
-  vpx_img_free(&raw);
   free(argv);
   free(streams);
   return res ? EXIT_FAILURE : EXIT_SUCCESS;
@@ -32,6 +32,14 @@ typedef enum {
 
 struct VpxInterface;
 
+#define MAX_BENCH_VALUES 16
+
+/* Settings swept by --bench. An empty list keeps the stream's setting. */
+struct VpxBenchList {
+  int values[MAX_BENCH_VALUES];
+  int count;
+};
+
 /* Configuration elements common to all streams. */
 struct VpxEncoderConfig {
   const struct VpxInterface *codec;
@@ -45,6 +53,7 @@ struct VpxEncoderConfig {
   int limit;
   int skip_frames;
   int show_psnr;
+  int show_stage_timing;
   enum TestDecodeFatality test_decode;
   int have_framerate;
   struct vpx_rational framerate;
@@ -55,6 +64,12 @@ struct VpxEncoderConfig {
   int disable_warnings;
   int disable_warning_prompt;
   int experimental_bitstream;
+  int bench;
+  struct VpxBenchList bench_cpu_used;
+  struct VpxBenchList bench_threads;
+  struct VpxBenchList bench_row_mt;
+  struct VpxBenchList bench_tile_columns;
+  struct VpxBenchList bench_tile_rows;
 };
 
 #ifdef __cplusplus
@@ -51,6 +51,33 @@ int stats_open_file(stats_io_t *stats, const char *fpf, int pass) {
   return res;
 }
 
+int stats_open_file_streamed(stats_io_t *stats, const char *fpf) {
+  FileOffset sz;
+  stats->pass = 1;
+  stats->buf.buf = NULL;
+  stats->buf_alloc_sz = 0;
+
+  stats->file = fopen(fpf, "rb");
+
+  if (stats->file == NULL) fatal("First-pass stats file does not exist!");
+
+  if (fseeko(stats->file, 0, SEEK_END))
+    fatal("First-pass stats file must be seekable!");
+
+  sz = ftello(stats->file);
+  stats->buf.sz = (size_t)sz;
+  return sz >= 0;
+}
+
+size_t stats_read(void *stats, uint64_t offset, void *buf, size_t size) {
+  FILE *const file = ((stats_io_t *)stats)->file;
+
+  if (ftello(file) != (FileOffset)offset &&
+      fseeko(file, (FileOffset)offset, SEEK_SET))
+    return 0;
+  return fread(buf, 1, size, file);
+}
+
 int stats_open_mem(stats_io_t *stats, int pass) {
   int res;
   stats->pass = pass;
@@ -32,6 +32,12 @@ typedef struct {
 
 int stats_open_file(stats_io_t *stats, const char *fpf, int pass);
 int stats_open_mem(stats_io_t *stats, int pass);
+/* Opens the second pass statistics file fpf without reading it. The contents
+ * are then fetched on demand by stats_read(), and stats_get() returns a NULL
+ * buffer of the file size.
+ */
+int stats_open_file_streamed(stats_io_t *stats, const char *fpf);
+size_t stats_read(void *stats, uint64_t offset, void *buf, size_t size);
 void stats_close(stats_io_t *stats, int last_pass);
 void stats_write(stats_io_t *stats, const void *pkt, size_t len);
 vpx_fixed_buf_t stats_get(stats_io_t *stats);